@@ -36,38 +36,107 @@
   
 /* Includes ------------------------------------------------------------------*/
 #include "s2lp.h"
+#include <string.h>
 
 
 /* Private typedef -----------------------------------------------------------*/
 
 
 /* Private define ------------------------------------------------------------*/
+#define REG_BIT_GET(map, reg)   ((map)[(reg) >> 3] & (1 << ((reg) & 7)))
+#define REG_BIT_SET(map, reg)   ((map)[(reg) >> 3] |= (uint8_t)(1 << ((reg) & 7)))
+#define BUS_MONITOR(header, len)  do { if(pS2LP->pfnMonitor != NULL) { pS2LP->pfnMonitor((header), (len)); } } while(0)
 /* Private variables -------------------------------------------------------------*/
 volatile S2LPStatus g_xStatus;
 /*!
- * @brief IO function pointer structure
+ * @brief Device the library calls go to, see S2LP_SelectObject
  */
-static S2LP_IO_t IO_func;
+static S2LP_Object_t S2LP_DefaultObject;
+static S2LP_Object_t *pS2LP = &S2LP_DefaultObject;
+/*!
+ * @brief Interrupt masking around S2LP_SelectObject, see S2LP_RegisterCriticalSection
+ */
+static S2LP_Critical_Func pfnCriticalEnter;
+static S2LP_Critical_Func pfnCriticalExit;
 /* -------- Static functions prototypes --------------------------------------------- */
+static void S2LP_ShadowStore(uint8_t cRegAddress, uint8_t cNbBytes, const uint8_t* pcBuffer);
+static uint8_t S2LP_ShadowLoad(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer);
+static void S2LP_BatchStage(uint8_t cRegAddress, uint8_t cNbBytes, const uint8_t* pcBuffer);
+static uint8_t S2LP_BatchLoad(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer);
+static StatusBytes S2LP_BatchFlush(void);
 /* Exported functions ---------------------------------------------------------*/
 int32_t S2LP_RegisterBusIO(S2LP_IO_t *pIO)
 {
   
-  IO_func.Init            = pIO->Init;
-  IO_func.DeInit          = pIO->DeInit;
-  IO_func.WriteBuffer     = pIO->WriteBuffer;
-  IO_func.Delay           = pIO->Delay;
+  pS2LP->IO.Init            = pIO->Init;
+  pS2LP->IO.DeInit          = pIO->DeInit;
+  pS2LP->IO.WriteBuffer     = pIO->WriteBuffer;
+  pS2LP->IO.Delay           = pIO->Delay;
   
-  if(!IO_func.Init)
+  if(!pS2LP->IO.Init)
+  {
+    return S2LP_ERROR;
+  }
+  return S2LP_OK;
+}
+
+S2LP_Object_t *S2LP_SelectObject(S2LP_Object_t *pObj)
+{
+  S2LP_Object_t *pPrevious;
+
+  if(pObj == NULL)
+  {
+    pObj = &S2LP_DefaultObject;
+  }
+  if(pfnCriticalEnter != NULL)
+  {
+    pfnCriticalEnter();
+  }
+  pPrevious = pS2LP;
+  if(pObj != pS2LP)
+  {
+    pPrevious->xStatus = g_xStatus;
+    pPrevious->lXtalFrequency = S2LP_RADIO_GetXtalFrequency();
+    pS2LP = pObj;
+    g_xStatus = pObj->xStatus;
+    if(pObj->lXtalFrequency != 0)
+    {
+      S2LP_RADIO_SetXtalFrequency(pObj->lXtalFrequency);
+    }
+  }
+  if(pfnCriticalExit != NULL)
+  {
+    pfnCriticalExit();
+  }
+  return pPrevious;
+}
+
+int32_t S2LP_RegisterCriticalSection(S2LP_Critical_Func pfnEnter, S2LP_Critical_Func pfnExit)
+{
+  if((pfnEnter == NULL) != (pfnExit == NULL))
   {
     return S2LP_ERROR;
   }
+  pfnCriticalEnter = pfnEnter;
+  pfnCriticalExit = pfnExit;
+  return S2LP_OK;
+}
+
+int32_t S2LP_RegisterBusIOAsync(S2LPBus_WriteBufAsync_Func pfnWriteBufferAsync)
+{
+  pS2LP->pfnWriteBufferAsync = pfnWriteBufferAsync;
+  return S2LP_OK;
+}
+
+int32_t S2LP_RegisterBusMonitor(S2LPBus_Monitor_Func pfnMonitor)
+{
+  pS2LP->pfnMonitor = pfnMonitor;
   return S2LP_OK;
 }
 
 int32_t S2LP_Init( void )
 {
-  if (IO_func.Init()<0)
+  if (pS2LP->IO.Init()<0)
   {
     return S2LP_ERROR;
   }
@@ -87,10 +156,23 @@ StatusBytes S2LP_WriteRegister(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* p
 	uint8_t header[S2LP_CMD_SIZE]={WRITE_HEADER,cRegAddress};
     StatusBytes status;
   
-    IO_func.WriteBuffer( header, pcBuffer, cNbBytes );
+    if(pS2LP->cBatchActive)
+    {
+      if((uint16_t)cRegAddress + cNbBytes <= S2LP_SHADOW_SIZE)
+      {
+        S2LP_BatchStage(cRegAddress, cNbBytes, pcBuffer);
+        return pS2LP->xShadowStatus;
+      }
+      S2LP_BatchFlush();
+    }
+    /* Before the transfer: the bus overwrites pcBuffer with the data it receives */
+    S2LP_ShadowStore(cRegAddress, cNbBytes, pcBuffer);
+    BUS_MONITOR(header[0], cNbBytes);
+    pS2LP->IO.WriteBuffer( header, pcBuffer, cNbBytes );
 
     ((uint8_t*)&status)[1]=header[0];
     ((uint8_t*)&status)[0]=header[1]; 
+    pS2LP->xShadowStatus = status;
   
     return status;
 }
@@ -107,10 +189,21 @@ StatusBytes S2LP_ReadRegister(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pc
     uint8_t header[S2LP_CMD_SIZE]={READ_HEADER,cRegAddress};
     StatusBytes status;
 
-    IO_func.WriteBuffer( header, pcBuffer, cNbBytes );
+    if(pS2LP->cBatchActive && S2LP_BatchLoad(cRegAddress, cNbBytes, pcBuffer))
+    {
+      return pS2LP->xShadowStatus;
+    }
+    if(S2LP_ShadowLoad(cRegAddress, cNbBytes, pcBuffer))
+    {
+      return pS2LP->xShadowStatus;
+    }
+    BUS_MONITOR(header[0], cNbBytes);
+    pS2LP->IO.WriteBuffer( header, pcBuffer, cNbBytes );
+    S2LP_ShadowStore(cRegAddress, cNbBytes, pcBuffer);
 
     ((uint8_t*)&status)[1]=header[0];
     ((uint8_t*)&status)[0]=header[1]; 
+    pS2LP->xShadowStatus = status;
   
     return status;
 }
@@ -125,7 +218,17 @@ StatusBytes S2LP_SendCommand(uint8_t cCommandCode)
   uint8_t header[S2LP_CMD_SIZE]={COMMAND_HEADER,cCommandCode};
   StatusBytes status;
 
-  IO_func.WriteBuffer( header, NULL, 0 );
+  if(pS2LP->cBatchActive)
+  {
+    S2LP_BatchFlush();
+  }
+  BUS_MONITOR(header[0], 0);
+  pS2LP->IO.WriteBuffer( header, NULL, 0 );
+  if(cCommandCode == CMD_SRES)
+  {
+    /* The digital part is back to its reset values */
+    S2LP_ShadowInvalidate();
+  }
   
   ((uint8_t*)&status)[1]=header[0];
   ((uint8_t*)&status)[0]=header[1];
@@ -144,7 +247,12 @@ StatusBytes S2LP_WriteFIFO(uint8_t cNbBytes, uint8_t* pcBuffer)
   uint8_t header[S2LP_CMD_SIZE]={WRITE_HEADER,LINEAR_FIFO_ADDRESS};
   StatusBytes status;
 
-  IO_func.WriteBuffer( header, pcBuffer, cNbBytes );
+  if(pS2LP->cBatchActive)
+  {
+    S2LP_BatchFlush();
+  }
+  BUS_MONITOR(header[0], cNbBytes);
+  pS2LP->IO.WriteBuffer( header, pcBuffer, cNbBytes );
   
   ((uint8_t*)&status)[1]=header[0];
   ((uint8_t*)&status)[0]=header[1];
@@ -164,7 +272,12 @@ StatusBytes S2LP_ReadFIFO(uint8_t cNbBytes, uint8_t* pcBuffer)
   uint8_t header[S2LP_CMD_SIZE]={READ_HEADER,LINEAR_FIFO_ADDRESS};
   StatusBytes status;
 
-  IO_func.WriteBuffer( header, pcBuffer, cNbBytes );
+  if(pS2LP->cBatchActive)
+  {
+    S2LP_BatchFlush();
+  }
+  BUS_MONITOR(header[0], cNbBytes);
+  pS2LP->IO.WriteBuffer( header, pcBuffer, cNbBytes );
   
   ((uint8_t*)&status)[1]=header[0];
   ((uint8_t*)&status)[0]=header[1];
@@ -172,6 +285,312 @@ StatusBytes S2LP_ReadFIFO(uint8_t cNbBytes, uint8_t* pcBuffer)
   return status;
 }
 
+/**
+* @brief  Start a FIFO transfer on the asynchronous bus, or run it blocking
+*         and complete it immediately when no such bus is registered.
+* @param  cHeader: READ_HEADER or WRITE_HEADER
+* @param  cNbBytes: number of bytes to transfer
+* @param  pcBuffer: data buffer, it must stay valid until pfnCallback is called
+* @param  pfnCallback: completion callback, called from the bus interrupt. Can be NULL.
+* @retval S2LP_OK if the transfer has been started, S2LP_ERROR otherwise
+*/
+static int32_t S2LP_FIFOAsync(uint8_t cHeader, uint8_t cNbBytes, uint8_t* pcBuffer, S2LPBus_Callback pfnCallback)
+{
+  uint8_t header[S2LP_CMD_SIZE]={cHeader,LINEAR_FIFO_ADDRESS};
+
+  if(pS2LP->cBatchActive)
+  {
+    S2LP_BatchFlush();
+  }
+  if(pS2LP->pfnWriteBufferAsync == NULL)
+  {
+    BUS_MONITOR(header[0], cNbBytes);
+
+    pS2LP->IO.WriteBuffer( header, pcBuffer, cNbBytes );
+    if(pfnCallback != NULL)
+    {
+      pfnCallback();
+    }
+    return S2LP_OK;
+  }
+
+  /* The wrapper takes the header before it returns, the previous transfer
+   * being over: a header of its own for each transfer, on the stack */
+  BUS_MONITOR(cHeader, cNbBytes);
+  if(pS2LP->pfnWriteBufferAsync( header, pcBuffer, cNbBytes, pfnCallback ) != 0)
+  {
+    return S2LP_ERROR;
+  }
+  return S2LP_OK;
+}
+
+/**
+* @brief  Write data into TX FIFO without waiting for the end of the transfer.
+* @param  cNbBytes: number of bytes to be written into TX FIFO
+* @param  pcBuffer: pointer to data to write
+* @param  pfnCallback: called when the transfer is over. Can be NULL.
+* @retval S2LP_OK if the transfer has been started, S2LP_ERROR otherwise
+*/
+int32_t S2LP_WriteFIFOAsync(uint8_t cNbBytes, uint8_t* pcBuffer, S2LPBus_Callback pfnCallback)
+{
+  return S2LP_FIFOAsync(WRITE_HEADER, cNbBytes, pcBuffer, pfnCallback);
+}
+
+/**
+* @brief  Read data from RX FIFO without waiting for the end of the transfer.
+* @param  cNbBytes: number of bytes to read from RX FIFO
+* @param  pcBuffer: pointer to data read from RX FIFO, valid once pfnCallback is called
+* @param  pfnCallback: called when the transfer is over. Can be NULL.
+* @retval S2LP_OK if the transfer has been started, S2LP_ERROR otherwise
+*/
+int32_t S2LP_ReadFIFOAsync(uint8_t cNbBytes, uint8_t* pcBuffer, S2LPBus_Callback pfnCallback)
+{
+  return S2LP_FIFOAsync(READ_HEADER, cNbBytes, pcBuffer, pfnCallback);
+}
+
+/**
+* @brief  Copy registers to the shadow, marking them valid.
+*         Only the part of the range within the configuration registers is kept.
+* @param  cRegAddress: base register's address
+* @param  cNbBytes: number of registers
+* @param  pcBuffer: values of the registers
+* @retval None
+*/
+static void S2LP_ShadowStore(uint8_t cRegAddress, uint8_t cNbBytes, const uint8_t* pcBuffer)
+{
+  uint16_t i;
+
+  if(!pS2LP->cShadowEnabled)
+  {
+    return;
+  }
+  for(i = cRegAddress; i < (uint16_t)cRegAddress + cNbBytes && i < S2LP_SHADOW_SIZE; i++)
+  {
+    pS2LP->vectcShadowRegs[i] = pcBuffer[i - cRegAddress];
+    REG_BIT_SET(pS2LP->vectcShadowValid, i);
+  }
+}
+
+/**
+* @brief  Read registers from the shadow.
+* @param  cRegAddress: base register's address
+* @param  cNbBytes: number of registers
+* @param  pcBuffer: filled with the values of the registers
+* @retval 1 if all of them are valid in the shadow, 0 if the device has to be read
+*/
+static uint8_t S2LP_ShadowLoad(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer)
+{
+  uint16_t i;
+
+  if(!pS2LP->cShadowEnabled || (uint16_t)cRegAddress + cNbBytes > S2LP_SHADOW_SIZE)
+  {
+    return 0;
+  }
+  for(i = cRegAddress; i < (uint16_t)cRegAddress + cNbBytes; i++)
+  {
+    if(!REG_BIT_GET(pS2LP->vectcShadowValid, i))
+    {
+      return 0;
+    }
+  }
+  memcpy(pcBuffer, &pS2LP->vectcShadowRegs[cRegAddress], cNbBytes);
+  return 1;
+}
+
+/**
+* @brief  Enable or disable the shadow of the configuration registers.
+*         When enabled, the configuration registers are read from the device only
+*         once: the application must call S2LP_ShadowInvalidate after the device
+*         lost them (shutdown) or changed them behind the driver.
+* @param  xNewState: S_ENABLE or S_DISABLE
+* @retval None
+*/
+void S2LP_ShadowEnable(SFunctionalState xNewState)
+{
+  S2LP_ShadowInvalidate();
+  pS2LP->cShadowEnabled = (xNewState == S_ENABLE);
+}
+
+/**
+* @brief  Forget the content of the shadow registers.
+* @param  None
+* @retval None
+*/
+void S2LP_ShadowInvalidate(void)
+{
+  memset(pS2LP->vectcShadowValid, 0, sizeof(pS2LP->vectcShadowValid));
+}
+
+/**
+* @brief  Reload all the shadow registers from the device, in a single transaction.
+* @param  None
+* @retval None
+*/
+void S2LP_ShadowResync(void)
+{
+  S2LP_ShadowInvalidate();
+  S2LP_ReadRegister(0x00, S2LP_SHADOW_SIZE, pS2LP->vectcShadowRegs);
+}
+
+/**
+* @brief  Keep configuration registers to be written by S2LP_BatchFlush.
+* @param  cRegAddress: base register's address
+* @param  cNbBytes: number of registers, all of them below S2LP_SHADOW_SIZE
+* @param  pcBuffer: values of the registers
+* @retval None
+*/
+static void S2LP_BatchStage(uint8_t cRegAddress, uint8_t cNbBytes, const uint8_t* pcBuffer)
+{
+  uint16_t i;
+
+  for(i = cRegAddress; i < (uint16_t)cRegAddress + cNbBytes; i++)
+  {
+    pS2LP->vectcBatchRegs[i] = pcBuffer[i - cRegAddress];
+    REG_BIT_SET(pS2LP->vectcBatchPending, i);
+  }
+  S2LP_ShadowStore(cRegAddress, cNbBytes, pcBuffer);
+}
+
+/**
+* @brief  Read registers whose write is still deferred.
+*         A read covering only part of them flushes the batch first.
+* @param  cRegAddress: base register's address
+* @param  cNbBytes: number of registers
+* @param  pcBuffer: filled with the values of the registers
+* @retval 1 if all of them are pending, 0 if the registers have to be read
+*/
+static uint8_t S2LP_BatchLoad(uint8_t cRegAddress, uint8_t cNbBytes, uint8_t* pcBuffer)
+{
+  uint16_t i, nPending = 0;
+
+  for(i = cRegAddress; i < (uint16_t)cRegAddress + cNbBytes && i < S2LP_SHADOW_SIZE; i++)
+  {
+    if(REG_BIT_GET(pS2LP->vectcBatchPending, i))
+    {
+      nPending++;
+    }
+  }
+  if(nPending == cNbBytes)
+  {
+    memcpy(pcBuffer, &pS2LP->vectcBatchRegs[cRegAddress], cNbBytes);
+    return 1;
+  }
+  if(nPending)
+  {
+    S2LP_BatchFlush();
+  }
+  return 0;
+}
+
+/**
+* @brief  Write the pending registers, one burst per run of adjacent addresses.
+*         A hole of up to S2LP_CMD_SIZE registers known by the shadow is written
+*         with its current value, which is cheaper than a new header.
+* @param  None
+* @retval Device status of the last transaction
+*/
+static StatusBytes S2LP_BatchFlush(void)
+{
+  uint8_t cWasActive = pS2LP->cBatchActive;
+  uint16_t i = 0, end, gap;
+
+  pS2LP->cBatchActive = 0;
+  while(i < S2LP_SHADOW_SIZE)
+  {
+    if(!REG_BIT_GET(pS2LP->vectcBatchPending, i))
+    {
+      i++;
+      continue;
+    }
+    end = i + 1;
+    for(;;)
+    {
+      while(end < S2LP_SHADOW_SIZE && REG_BIT_GET(pS2LP->vectcBatchPending, end))
+      {
+        end++;
+      }
+      gap = end;
+      while(pS2LP->cShadowEnabled && gap < S2LP_SHADOW_SIZE && gap - end < S2LP_CMD_SIZE
+            && !REG_BIT_GET(pS2LP->vectcBatchPending, gap) && REG_BIT_GET(pS2LP->vectcShadowValid, gap))
+      {
+        gap++;
+      }
+      if(gap == end || gap == S2LP_SHADOW_SIZE || !REG_BIT_GET(pS2LP->vectcBatchPending, gap))
+      {
+        break;
+      }
+      memcpy(&pS2LP->vectcBatchRegs[end], &pS2LP->vectcShadowRegs[end], gap - end);
+      end = gap;
+    }
+    S2LP_WriteRegister((uint8_t)i, (uint8_t)(end - i), &pS2LP->vectcBatchRegs[i]);
+    i = end;
+  }
+  memset(pS2LP->vectcBatchPending, 0, sizeof(pS2LP->vectcBatchPending));
+  pS2LP->cBatchActive = cWasActive;
+  return pS2LP->xShadowStatus;
+}
+
+/**
+* @brief  Write a list of registers, e.g. a configuration image.
+*         Configuration registers are sorted and written in bursts of adjacent
+*         addresses (joining the current batch if S2LP_BatchBegin was called), the
+*         other ones are written one by one after them. When an address appears
+*         twice, the last value is written.
+* @param  pxRegs: list of (address, value)
+* @param  nCount: number of entries
+* @retval Device status of the last transaction
+*/
+StatusBytes S2LP_WriteRegisterBatch(const S2LPRegValue* pxRegs, uint16_t nCount)
+{
+  uint8_t tmp;
+  StatusBytes status;
+  uint16_t i;
+
+  for(i = 0; i < nCount; i++)
+  {
+    if(pxRegs[i].cAddress < S2LP_SHADOW_SIZE)
+    {
+      S2LP_BatchStage(pxRegs[i].cAddress, 1, &pxRegs[i].cValue);
+    }
+  }
+  status = pS2LP->cBatchActive ? pS2LP->xShadowStatus : S2LP_BatchFlush();
+  for(i = 0; i < nCount; i++)
+  {
+    if(pxRegs[i].cAddress >= S2LP_SHADOW_SIZE)
+    {
+      tmp = pxRegs[i].cValue;
+      status = S2LP_WriteRegister(pxRegs[i].cAddress, 1, &tmp);
+    }
+  }
+  return status;
+}
+
+/**
+* @brief  Start deferring the writes of configuration registers.
+*         They are kept in RAM, where the library reads them back from, and sent
+*         by S2LP_BatchEnd, or earlier before any command, FIFO access or write
+*         of other registers. Reads of the status registers do not send them.
+* @param  None
+* @retval None
+*/
+void S2LP_BatchBegin(void)
+{
+  pS2LP->cBatchActive = 1;
+}
+
+/**
+* @brief  Write the registers deferred since S2LP_BatchBegin.
+* @param  None
+* @retval Device status of the last transaction
+*/
+StatusBytes S2LP_BatchEnd(void)
+{
+  StatusBytes status = S2LP_BatchFlush();
+
+  pS2LP->cBatchActive = 0;
+  return status;
+}
+
 /**
  * @brief  Set External Reference.
  * @param  xExtMode new state for the external reference.
@@ -281,7 +700,7 @@ int32_t S2LP_RcoCalibration(void)
   S2LP_WriteRegister(XO_RCO_CONF0_ADDR, 1, &tmp2);  /* Enable the RCO CALIB setting bit to 1 */
 
   S2LP_CMD_StrobeStandby();
-  IO_func.Delay(50);
+  pS2LP->IO.Delay(50);
   S2LP_CMD_StrobeReady();
 
   do
@@ -123,6 +123,10 @@ typedef S2LPStatus StatusBytes;
 #define S2LP_CMD_SIZE   2
 #define S2LP_BUF_SIZE   S2LP_TX_FIFO_SIZE
 
+/* Configuration registers (0x00 - PM_CONF0) kept in the shadow register file.
+ * The status registers above them are always read from the device. */
+#define S2LP_SHADOW_SIZE   (PM_CONF0_ADDR + 1)
+
 
 #define BUILT_HEADER(add_comm, w_r) (add_comm | w_r)  /*!< macro to build the header byte*/
 #define WRITE_HEADER    BUILT_HEADER(HEADER_ADDRESS_MASK, HEADER_WRITE_MASK) /*!< macro to build the write header byte*/
@@ -143,6 +147,10 @@ typedef int32_t     (*S2LPBus_Init_Func)(void);
 typedef int32_t     (*S2LPBus_DeInit_Func)(void); 
 typedef int32_t     (*S2LPBus_WriteBuf_Func)( uint8_t *, uint8_t *, uint16_t );
 typedef void        (*S2LPBus_Delay)(uint32_t );   
+typedef void        (*S2LPBus_Callback)(void);
+typedef int32_t     (*S2LPBus_WriteBufAsync_Func)( uint8_t *, uint8_t *, uint16_t, S2LPBus_Callback );
+typedef void        (*S2LPBus_Monitor_Func)( uint8_t, uint16_t );
+typedef void        (*S2LP_Critical_Func)(void);
 
 typedef struct
 {
@@ -152,6 +160,37 @@ typedef struct
   S2LPBus_Delay                Delay;
 } S2LP_IO_t;
 
+/**
+ * @brief  State the library keeps for one S2-LP device: its bus, the status
+ *         bytes of its last transaction, its shadow registers and deferred
+ *         writes. Every library call works on the object selected with
+ *         S2LP_SelectObject, a built-in one when there is a single radio.
+ */
+typedef struct
+{
+  S2LP_IO_t                    IO;
+  S2LPBus_WriteBufAsync_Func   pfnWriteBufferAsync;
+  S2LPBus_Monitor_Func         pfnMonitor;
+  S2LPStatus                   xStatus;                      /*!< g_xStatus while the object is not selected */
+  uint32_t                     lXtalFrequency;               /*!< 0 until the object has been selected once */
+  uint8_t                      cShadowEnabled;               /*!< Configuration registers read once, see S2LP_ShadowEnable */
+  uint8_t                      vectcShadowRegs[S2LP_SHADOW_SIZE];
+  uint8_t                      vectcShadowValid[(S2LP_SHADOW_SIZE + 7) / 8];
+  S2LPStatus                   xShadowStatus;                /*!< Status bytes of the last transaction */
+  uint8_t                      cBatchActive;                 /*!< Writes deferred by S2LP_BatchBegin */
+  uint8_t                      vectcBatchRegs[S2LP_SHADOW_SIZE];
+  uint8_t                      vectcBatchPending[(S2LP_SHADOW_SIZE + 7) / 8];
+} S2LP_Object_t;
+
+/**
+ * @brief  One entry of a register image, see S2LP_WriteRegisterBatch.
+ */
+typedef struct
+{
+  uint8_t cAddress;  /*!< Register address */
+  uint8_t cValue;    /*!< Value to be written */
+} S2LPRegValue;
+
 typedef enum {
   MODE_EXT_XO  = 0,
   MODE_EXT_XIN = 0x80,
@@ -202,6 +241,60 @@ typedef enum
   * @retval error status
   */
 int32_t S2LP_RegisterBusIO (S2LP_IO_t *pIO);
+
+ /**
+  * @brief  Select the S2-LP device the library calls go to. The other objects
+  *         keep their state, g_xStatus included. Code driving a second radio
+  *         selects it and gives back the previous object before returning,
+  *         interrupt handlers included. The swap runs inside the critical
+  *         section registered with S2LP_RegisterCriticalSection.
+  *         Only the library state is kept per object. The BSP state (SPI
+  *         buffer, DMA state, IRQ mask counter) exists once per expansion
+  *         board, so two radios are two different boards (e.g. S2868A1 and
+  *         S2915A1) wired to their own SPI bus, NSS and EXTI lines, their
+  *         BSP headers included from separate files. The WMBus submode of S2LP_PktWMbus
+  *         and the S2LP_WMBUS_LL layer exist once and belong to one radio.
+  * @param  pointer to the object of the device, NULL for the built-in one.
+  *         A new object must be zeroed, then given its bus with
+  *         S2LP_RegisterBusIO once selected.
+  * @retval the object selected before
+  */
+S2LP_Object_t *S2LP_SelectObject (S2LP_Object_t *pObj);
+
+ /**
+  * @brief  Register a non-blocking (e.g. DMA) bus transfer, used by the
+  *         S2LP_WriteFIFOAsync/S2LP_ReadFIFOAsync functions. The function
+  *         waits for the transfer in progress and reads the header before
+  *         returning; the data buffer stays in use until the callback.
+  *         The BSP wrappers cannot wait from an ISR, the completion IRQ
+  *         being unable to preempt it: any bus access made there while a
+  *         transfer runs fails. Start the transfers from thread mode, or go
+  *         on with the radio from the callback.
+  * @param  pointer to the asynchronous WriteBuffer function, NULL to remove it
+  * @retval error status
+  */
+int32_t S2LP_RegisterBusIOAsync (S2LPBus_WriteBufAsync_Func pfnWriteBufferAsync);
+
+ /**
+  * @brief  Register a function called before every bus transaction with its
+  *         header byte (READ_HEADER, WRITE_HEADER or COMMAND_HEADER) and the
+  *         number of bytes after the two header bytes.
+  * @param  pointer to the monitor function, NULL to remove it
+  * @retval error status
+  */
+int32_t S2LP_RegisterBusMonitor (S2LPBus_Monitor_Func pfnMonitor);
+
+ /**
+  * @brief  Register the functions masking and unmasking the interrupts that
+  *         select an object, so that S2LP_SelectObject cannot be interrupted
+  *         halfway. They are common to all the objects: with several radios
+  *         they must mask the GPIO IRQ of every one of them, not only the
+  *         radio registering them (e.g. PRIMASK), and they must nest.
+  * @param  pointer to the enter function, NULL to remove it
+  * @param  pointer to the exit function, NULL to remove it
+  * @retval error status
+  */
+int32_t S2LP_RegisterCriticalSection (S2LP_Critical_Func pfnEnter, S2LP_Critical_Func pfnExit);
         
 /*!
  * @brief Initialises the bus for S2LP driver communication
@@ -221,6 +314,22 @@ StatusBytes S2LP_WriteFIFO(uint8_t cNbBytes, uint8_t* pcBuffer);
 
 StatusBytes S2LP_ReadFIFO(uint8_t cNbBytes, uint8_t* pcBuffer);
 
+int32_t S2LP_WriteFIFOAsync(uint8_t cNbBytes, uint8_t* pcBuffer, S2LPBus_Callback pfnCallback);
+
+int32_t S2LP_ReadFIFOAsync(uint8_t cNbBytes, uint8_t* pcBuffer, S2LPBus_Callback pfnCallback);
+
+void S2LP_ShadowEnable(SFunctionalState xNewState);
+
+void S2LP_ShadowInvalidate(void);
+
+void S2LP_ShadowResync(void);
+
+StatusBytes S2LP_WriteRegisterBatch(const S2LPRegValue* pxRegs, uint16_t nCount);
+
+void S2LP_BatchBegin(void);
+
+StatusBytes S2LP_BatchEnd(void);
+
 
 uint8_t S2LP_GetDevicePN(void);
 uint8_t S2LP_GetVersion(void);
@@ -92,6 +92,7 @@
  * @defgroup PktWMbus_Private_Variables                  Pkt WMBUS Private Variables
  * @{
  */
+/* One radio only: not part of S2LP_Object_t */
 static WMbusSubmode s_cWMbusSubmode = WMBUS_SUBMODE_NOT_CONFIGURED;
 
 /**
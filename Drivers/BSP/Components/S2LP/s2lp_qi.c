@@ -315,6 +315,26 @@ uint8_t S2LP_RADIO_QI_GetLqi(void)
   return ((tempRegValue & 0xF0)>> 4);
 }
 
+/**
+ * @brief  Returns the RSSI, the LQI and the length of the last received packet.
+ *         LINK_QUALIF2 to RX_PCKT_LEN0 are adjacent: one burst replaces the
+ *         three reads of S2LP_RADIO_QI_GetRssidBm, S2LP_RADIO_QI_GetLqi and
+ *         S2LP_PCKT_BASIC_GetReceivedPktLength.
+ * @param  pxInfo pointer to the @ref SRxPacketInfo to fill.
+ * @retval None.
+ */
+void S2LP_RADIO_QI_GetRxPacketInfo(SRxPacketInfo* pxInfo)
+{
+  uint8_t tmpBuffer[RX_PCKT_LEN0_ADDR - LINK_QUALIF2_ADDR + 1];
+
+  g_xStatus = S2LP_ReadRegister(LINK_QUALIF2_ADDR, sizeof(tmpBuffer), tmpBuffer);
+
+  pxInfo->cLqi = (tmpBuffer[0] & 0xF0) >> 4;
+  pxInfo->lRssidBm = RADIO_QI_RegToRssidBm((int32_t)tmpBuffer[RSSI_LEVEL_ADDR - LINK_QUALIF2_ADDR]);
+  pxInfo->nPacketLength = ((uint16_t)tmpBuffer[RX_PCKT_LEN1_ADDR - LINK_QUALIF2_ADDR] << 8) |
+                          tmpBuffer[RX_PCKT_LEN0_ADDR - LINK_QUALIF2_ADDR];
+}
+
 /**
  *@}
  */
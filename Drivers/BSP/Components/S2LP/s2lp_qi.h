@@ -115,6 +115,17 @@ typedef struct {
 } SRssiInit;
 
 
+/**
+ * @brief  S2LP quality and length of the last received packet,
+ *         read in one transaction by S2LP_RADIO_QI_GetRxPacketInfo.
+ */
+typedef struct {
+  int32_t      lRssidBm;       /*!< RSSI captured at the sync word, in dBm. */
+  uint8_t      cLqi;           /*!< Link quality indicator. From 0 to 15. */
+  uint16_t     nPacketLength;  /*!< RX_PCKT_LEN: the payload plus the address and STack control fields. */
+} SRxPacketInfo;
+
+
 /**
   *@}
   */
@@ -159,6 +170,7 @@ void S2LP_RADIO_QI_SetSQIThreshold(uint8_t cSQIThreshold);
 void S2LP_RADIO_QI_EnableSQI(SFunctionalState xSQIEnable);
 SFlagStatus S2LP_RADIO_QI_GetCs(void);
 uint8_t S2LP_RADIO_QI_GetLqi(void);
+void S2LP_RADIO_QI_GetRxPacketInfo(SRxPacketInfo* pxInfo);
 
 /**
  *@}
@@ -39,6 +39,7 @@
 /* Includes ------------------------------------------------------------------*/
 
 #include "s2lp.h"
+#include <string.h>
 
 /** @addtogroup S2LP_Libraries
 * @{
@@ -565,10 +566,81 @@ void S2LP_RADIO_SearchWCP(uint8_t* cp_isel, uint8_t* pfd_split, uint32_t lFc, ui
 */
 uint8_t S2LP_RADIO_Init(SRadioInit* pxSRadioInitStruct)
 {
-  uint8_t tmpBuffer[6], tmp8, dr_e, fdev_m, fdev_e, bw_m, bw_e;
+  SRadioInitWords xWords;
+
+  S2LP_RADIO_ComputeInitWords(pxSRadioInitStruct, &xWords);
+  return S2LP_RADIO_InitWords(&xWords);
+}
+
+
+/**
+* @brief  Computes the register words that S2LP_RADIO_Init writes for the specified
+*         parameters. The result depends only on them and on the XTAL frequency
+*         (@ref S2LP_RADIO_SetXtalFrequency), so it can be computed once, or offline.
+* @param  pxSRadioInitStruct pointer to a SRadioInit structure that
+*         contains the configuration information for the analog radio part of S2LP.
+* @param  pxWords pointer to the returned register words.
+* @retval None.
+*/
+void S2LP_RADIO_ComputeInitWords(SRadioInit* pxSRadioInitStruct, SRadioInitWords* pxWords)
+{
+  uint8_t dr_e, fdev_m, fdev_e, bw_m, bw_e;
   uint16_t dr_m;
-  SFunctionalState xState;
 
+  /* Intermediate Frequency setting */
+  S2LP_RADIO_ComputeIF(300000, &pxWords->cIfOffsetAna, &pxWords->cIfOffsetDig);
+
+  /* Calculates the datarate register values */
+  S2LP_RADIO_SearchDatarateME(pxSRadioInitStruct->lDatarate, &dr_m, &dr_e);
+  pxWords->cMod[0] = (uint8_t)(dr_m>>8);
+  pxWords->cMod[1] = (uint8_t)dr_m;
+  pxWords->cMod[2] = (uint8_t)(pxSRadioInitStruct->xModulationSelect | dr_e);
+
+  /* Calculates the frequency deviation register values */
+  S2LP_RADIO_SearchFreqDevME(pxSRadioInitStruct->lFreqDev, &fdev_m, &fdev_e);
+  pxWords->cMod[3] = fdev_e;
+  pxWords->cMod[4] = fdev_m;
+
+  /* Calculates the channel filter register values */
+  S2LP_RADIO_SearchChannelBwME(pxSRadioInitStruct->lBandwidth, &bw_m, &bw_e);
+  pxWords->cMod[5] = (bw_m<<4) | bw_e;
+
+  /* if OOK is selected enable the PA_FC */
+  pxWords->cPaOok = ((pxSRadioInitStruct->xModulationSelect)==MOD_ASK_OOK);
+
+  /* Bessel filter config */
+  if(pxSRadioInitStruct->lDatarate<16000)
+  {
+    pxWords->cPaBessel = 0x00;
+  }
+  else if(pxSRadioInitStruct->lDatarate<32000)
+  {
+    pxWords->cPaBessel = 0x01;
+  }
+  else if(pxSRadioInitStruct->lDatarate<62500)
+  {
+    pxWords->cPaBessel = 0x02;
+  }
+  else
+  {
+    pxWords->cPaBessel = 0x03;
+  }
+
+  S2LP_RADIO_ComputeSynthWords(pxSRadioInitStruct->lFrequencyBase, &pxWords->xSynth);
+}
+
+
+/**
+* @brief  Initializes the S2LP analog and digital radio part with register words
+*         computed by S2LP_RADIO_ComputeInitWords, without any arithmetic.
+* @param  pxWords pointer to the register words.
+* @retval Error code: 0=no error, 1=error during calibration of VCO.
+*/
+uint8_t S2LP_RADIO_InitWords(const SRadioInitWords* pxWords)
+{
+  uint8_t tmpBuffer[6], tmp8;
+  SFunctionalState xState;
+  
   /* Configure the digital, ADC, SMPS reference clock divider */
   xState = S2LP_RADIO_GetDigDiv();
   if(((s_lXtalFrequency<S2LP_DIG_DOMAIN_XTAL_THRESH) && (xState==S_ENABLE)) || ((s_lXtalFrequency>S2LP_DIG_DOMAIN_XTAL_THRESH) && (xState==S_DISABLE))) {
@@ -589,27 +661,15 @@ uint8_t S2LP_RADIO_Init(SRadioInit* pxSRadioInitStruct)
   }  
   
   /* Intermediate Frequency setting */  
-  S2LP_RADIO_ComputeIF(300000, &tmpBuffer[0], &tmpBuffer[1]);
+  tmpBuffer[0] = pxWords->cIfOffsetAna;
+  tmpBuffer[1] = pxWords->cIfOffsetDig;
   S2LP_WriteRegister(IF_OFFSET_ANA_ADDR, 2, tmpBuffer);
 
-  /* Calculates the datarate register values */
-  S2LP_RADIO_SearchDatarateME(pxSRadioInitStruct->lDatarate, &dr_m, &dr_e);
-  tmpBuffer[0] = (uint8_t)(dr_m>>8);
-  tmpBuffer[1] = (uint8_t)dr_m;
-  tmpBuffer[2] = (uint8_t)(pxSRadioInitStruct->xModulationSelect | dr_e);
-
-  
-  
-  /* Calculates the frequency deviation register values */
-  S2LP_RADIO_SearchFreqDevME(pxSRadioInitStruct->lFreqDev, &fdev_m, &fdev_e);
+  /* Datarate, frequency deviation and channel filter */
+  memcpy(tmpBuffer, pxWords->cMod, 6);
   S2LP_ReadRegister(MOD1_ADDR, 1, &tmpBuffer[3]);
   tmpBuffer[3] &= ~FDEV_E_REGMASK;
-  tmpBuffer[3] |= fdev_e;  
-  tmpBuffer[4] = fdev_m;
-  
-  /* Calculates the channel filter register values */
-  S2LP_RADIO_SearchChannelBwME(pxSRadioInitStruct->lBandwidth, &bw_m, &bw_e);
-  tmpBuffer[5] = (bw_m<<4) | bw_e;  
+  tmpBuffer[3] |= pxWords->cMod[3];
   
   /* Configures the radio registers */
   S2LP_WriteRegister(MOD4_ADDR, 6, tmpBuffer);
@@ -617,7 +677,7 @@ uint8_t S2LP_RADIO_Init(SRadioInit* pxSRadioInitStruct)
   S2LP_ReadRegister(PA_POWER0_ADDR, 3, &tmpBuffer[0]);
   
   /* if OOK is selected enable the PA_FC else enable it */
-  if((pxSRadioInitStruct->xModulationSelect)!=MOD_ASK_OOK)
+  if(!pxWords->cPaOok)
   {
     tmpBuffer[0] &= 0x7F;
     tmpBuffer[1] &= 0xFD;
@@ -632,29 +692,15 @@ uint8_t S2LP_RADIO_Init(SRadioInit* pxSRadioInitStruct)
   tmpBuffer[2]&=0xFC;
   
   /* Bessel filter config */
-  if(pxSRadioInitStruct->lDatarate<16000)
-  {
-    tmpBuffer[2]|=0x00;
-  }
-  else if(pxSRadioInitStruct->lDatarate<32000)
-  {
-    tmpBuffer[2]|=0x01;
-  }
-  else if(pxSRadioInitStruct->lDatarate<62500)
-  {
-    tmpBuffer[2]|=0x02;
-  }
-  else
-  {
-    tmpBuffer[2]|=0x03;
-  }
+  tmpBuffer[2]|=pxWords->cPaBessel;
   S2LP_WriteRegister(PA_POWER0_ADDR, 3, &tmpBuffer[0]);
   
   /* Enable the freeze option of the AFC on the SYNC word */  
   S2LP_ReadRegister(AFC2_ADDR, 1, &tmp8);
   tmp8 |= AFC_FREEZE_ON_SYNC_REGMASK; S2LP_WriteRegister(AFC2_ADDR, 1, &tmp8);
   
-  return S2LP_RADIO_SetFrequencyBase(pxSRadioInitStruct->lFrequencyBase);
+  S2LP_RADIO_SetSynthWords(&pxWords->xSynth);
+  return 0;
   
 }
 
@@ -893,9 +939,28 @@ uint32_t S2LP_RADIO_GetChannelSpace(void)
 * @retval Error code: 0=no error, 1=error during calibration of VCO.
 */
 uint8_t S2LP_RADIO_SetFrequencyBase(uint32_t lFBase)
+{
+  SRadioSynthWords xWords;
+
+  S2LP_RADIO_ComputeSynthWords(lFBase, &xWords);
+  S2LP_RADIO_SetSynthWords(&xWords);
+  
+  return 0;
+}
+
+
+/**
+* @brief  Computes the synthesizer register words of a carrier frequency.
+*         A table of them, one per frequency, makes a frequency change a couple
+*         of register writes, with the charge pump word matching the frequency.
+* @param  lFBase the carrier frequency expressed in Hz as unsigned word.
+* @param  pxWords pointer to the returned register words.
+* @retval None.
+*/
+void S2LP_RADIO_ComputeSynthWords(uint32_t lFBase, SRadioSynthWords* pxWords)
 {
   uint32_t tmp32;
-  uint8_t tmpBuffer[4], cp_isel, bs = 1, pfd_split, tmp, cRefDiv;
+  uint8_t cp_isel, bs = 1, pfd_split, cRefDiv;
   
   tmp32 = S2LP_RADIO_ComputeSynthWord(lFBase, ((uint8_t)S2LP_RADIO_GetRefDiv()+1));
   
@@ -905,23 +970,34 @@ uint8_t S2LP_RADIO_SetFrequencyBase(uint32_t lFBase)
   
   cRefDiv = (uint8_t)S2LP_RADIO_GetRefDiv() + 1;
 
-  /* Search the VCO charge pump word and set the corresponding register */
+  /* Search the VCO charge pump word */
   S2LP_RADIO_SearchWCP(&cp_isel, &pfd_split, lFBase, cRefDiv);
+  pxWords->cPfdSplit = pfd_split;
+    
+  /* Build the array of registers values for the analog part */
+  pxWords->cSynt[0] = (((uint8_t)(tmp32>>24)) & SYNT_27_24_REGMASK) | cp_isel<<5 | (bs<<4) ;
+  pxWords->cSynt[1] = (uint8_t)(tmp32>>16);
+  pxWords->cSynt[2] = (uint8_t)(tmp32>>8);
+  pxWords->cSynt[3] = (uint8_t)tmp32;
+}
+
+
+/**
+* @brief  Writes synthesizer register words computed by S2LP_RADIO_ComputeSynthWords.
+* @param  pxWords pointer to the register words.
+* @retval None.
+*/
+void S2LP_RADIO_SetSynthWords(const SRadioSynthWords* pxWords)
+{
+  uint8_t tmpBuffer[4], tmp;
   
   S2LP_ReadRegister(SYNTH_CONFIG2_ADDR, 1, &tmp);
   tmp &= ~PLL_PFD_SPLIT_EN_REGMASK;
-  tmp |= (pfd_split<<2);
+  tmp |= (pxWords->cPfdSplit<<2);
   S2LP_WriteRegister(SYNTH_CONFIG2_ADDR, 1, &tmp);
-    
-  /* Build the array of registers values for the analog part */
-  tmpBuffer[0] = (((uint8_t)(tmp32>>24)) & SYNT_27_24_REGMASK) | cp_isel<<5 | (bs<<4) ;
-  tmpBuffer[1] = (uint8_t)(tmp32>>16);
-  tmpBuffer[2] = (uint8_t)(tmp32>>8);
-  tmpBuffer[3] = (uint8_t)tmp32;
   
+  memcpy(tmpBuffer, pxWords->cSynt, 4);
   g_xStatus = S2LP_WriteRegister(SYNT3_ADDR, 4, tmpBuffer);
-  
-  return 0;
 }
 
 
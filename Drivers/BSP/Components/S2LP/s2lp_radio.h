@@ -143,6 +143,31 @@ typedef struct {
 } SRadioInit;
 
 
+/**
+ * @brief  S2LP synthesizer register words of a carrier frequency,
+ *         see S2LP_RADIO_ComputeSynthWords
+ */
+typedef struct {
+  uint8_t           cPfdSplit;          /*!< PLL_PFD_SPLIT_EN bit of SYNTH_CONFIG2 (0 or 1) */
+  uint8_t           cSynt[4];           /*!< SYNT3..SYNT0: charge pump, band select and synth word */
+} SRadioSynthWords;
+
+
+/**
+ * @brief  S2LP radio register words of a SRadioInit, see S2LP_RADIO_ComputeInitWords.
+ *         They can be computed offline (host or generator) for a fixed crystal
+ *         frequency and given to S2LP_RADIO_InitWords, which does no arithmetic.
+ */
+typedef struct {
+  uint8_t           cIfOffsetAna;       /*!< IF_OFFSET_ANA register */
+  uint8_t           cIfOffsetDig;       /*!< IF_OFFSET_DIG register */
+  uint8_t           cMod[6];            /*!< MOD4..MOD0 and CHFLT registers, only the FDEV_E field of MOD1 */
+  uint8_t           cPaOok;             /*!< 1 if the PA is configured for OOK */
+  uint8_t           cPaBessel;          /*!< Bessel filter field of PA_CONFIG0 */
+  SRadioSynthWords  xSynth;             /*!< Base carrier frequency */
+} SRadioInitWords;
+
+
 /**
  * @brief  S2LP AFC mode enumeration
  */
@@ -208,6 +233,8 @@ typedef struct {
  */
 
 uint8_t S2LP_RADIO_Init(SRadioInit* pxSRadioInitStruct);
+void S2LP_RADIO_ComputeInitWords(SRadioInit* pxSRadioInitStruct, SRadioInitWords* pxWords);
+uint8_t S2LP_RADIO_InitWords(const SRadioInitWords* pxWords);
 void S2LP_RADIO_GetInfo(SRadioInit* pxSRadioInitStruct);
 void S2LP_RADIO_SetSynthWord(uint32_t lSynthWord);
 uint32_t S2LP_RADIO_GetSynthWord(void);
@@ -220,6 +247,8 @@ SFunctionalState S2LP_RADIO_GetDigDiv(void);
 void S2LP_RADIO_SetChannelSpace(uint32_t lChannelSpace);
 uint32_t S2LP_RADIO_GetChannelSpace(void);
 uint8_t S2LP_RADIO_SetFrequencyBase(uint32_t lFBase);
+void S2LP_RADIO_ComputeSynthWords(uint32_t lFBase, SRadioSynthWords* pxWords);
+void S2LP_RADIO_SetSynthWords(const SRadioSynthWords* pxWords);
 uint32_t S2LP_RADIO_GetFrequencyBase(void);
 void S2LP_RADIO_SetDatarate(uint32_t lDatarate);
 uint32_t S2LP_RADIO_GetDatarate(void);
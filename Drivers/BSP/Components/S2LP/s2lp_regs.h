@@ -1265,7 +1265,7 @@
 #define VCO_CONFIG_ADDR			((uint8_t)0x68)
 
 #define VCO_CALAMP_EXT_SEL_REGMASK			((uint8_t)0x20)
-#define VCO_CALFREQ_EXT_SEL_REGMASK			((uint8_t)0x20)
+#define VCO_CALFREQ_EXT_SEL_REGMASK			((uint8_t)0x10)
 
 
 /**
@@ -0,0 +1,846 @@
+/**
+ * @file    s2lp_wmbus_ll.c
+ * @author  SRA Application Team
+ * @brief   Wireless M-Bus (EN 13757-4) link layer of the S2-LP.
+  ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2019 STMicroelectronics</center></h2>
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of STMicroelectronics nor the names of its contributors 
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * <h2><center>&copy; COPYRIGHT 2019 STMicroelectronics</center></h2>
+ */
+
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "s2lp_wmbus_ll.h"
+#include "s2lp.h"
+
+/**
+ * @addtogroup S2LP_Libraries
+ * @{
+ */
+
+
+/**
+ * @addtogroup S2LP_WMbusLL
+ * @{
+ */
+
+
+/**
+ * @defgroup WMbusLL_Private_Defines                    WMbus Link Layer Private Defines
+ * @{
+ */
+
+/* C mode: the sync word is followed by the frame type, received as data */
+#define WMBUS_C_SYNC_WORD               (uint32_t)0x543D0000
+#define WMBUS_C_SYNC_LEN                16
+#define WMBUS_C_PREAMBLE_LEN            16      /* "01" chip pairs */
+#define WMBUS_C_TYPE_0                  0x54
+#define WMBUS_C_TYPE_A                  0xCD
+#define WMBUS_C_TYPE_B                  0x3D
+
+/* Bytes left in the RX FIFO when it interrupts, and in the TX FIFO when it asks for more */
+#ifndef S2LP_WMBUS_LL_FIFO_MARGIN
+#define S2LP_WMBUS_LL_FIFO_MARGIN       32
+#endif
+
+/**
+ *@}
+ */
+
+
+/**
+ * @defgroup WMbusLL_Private_Variables                  WMbus Link Layer Private Variables
+ * @{
+ */
+
+/* CRC-16 of EN 13757-4: x^16+x^13+x^12+x^11+x^10+x^8+x^6+x^5+x^2+1, MSB first, no reflection */
+static const uint16_t s_vectnCrcTable[256] = {
+  0x0000, 0x3D65, 0x7ACA, 0x47AF, 0xF594, 0xC8F1, 0x8F5E, 0xB23B,
+  0xD64D, 0xEB28, 0xAC87, 0x91E2, 0x23D9, 0x1EBC, 0x5913, 0x6476,
+  0x91FF, 0xAC9A, 0xEB35, 0xD650, 0x646B, 0x590E, 0x1EA1, 0x23C4,
+  0x47B2, 0x7AD7, 0x3D78, 0x001D, 0xB226, 0x8F43, 0xC8EC, 0xF589,
+  0x1E9B, 0x23FE, 0x6451, 0x5934, 0xEB0F, 0xD66A, 0x91C5, 0xACA0,
+  0xC8D6, 0xF5B3, 0xB21C, 0x8F79, 0x3D42, 0x0027, 0x4788, 0x7AED,
+  0x8F64, 0xB201, 0xF5AE, 0xC8CB, 0x7AF0, 0x4795, 0x003A, 0x3D5F,
+  0x5929, 0x644C, 0x23E3, 0x1E86, 0xACBD, 0x91D8, 0xD677, 0xEB12,
+  0x3D36, 0x0053, 0x47FC, 0x7A99, 0xC8A2, 0xF5C7, 0xB268, 0x8F0D,
+  0xEB7B, 0xD61E, 0x91B1, 0xACD4, 0x1EEF, 0x238A, 0x6425, 0x5940,
+  0xACC9, 0x91AC, 0xD603, 0xEB66, 0x595D, 0x6438, 0x2397, 0x1EF2,
+  0x7A84, 0x47E1, 0x004E, 0x3D2B, 0x8F10, 0xB275, 0xF5DA, 0xC8BF,
+  0x23AD, 0x1EC8, 0x5967, 0x6402, 0xD639, 0xEB5C, 0xACF3, 0x9196,
+  0xF5E0, 0xC885, 0x8F2A, 0xB24F, 0x0074, 0x3D11, 0x7ABE, 0x47DB,
+  0xB252, 0x8F37, 0xC898, 0xF5FD, 0x47C6, 0x7AA3, 0x3D0C, 0x0069,
+  0x641F, 0x597A, 0x1ED5, 0x23B0, 0x918B, 0xACEE, 0xEB41, 0xD624,
+  0x7A6C, 0x4709, 0x00A6, 0x3DC3, 0x8FF8, 0xB29D, 0xF532, 0xC857,
+  0xAC21, 0x9144, 0xD6EB, 0xEB8E, 0x59B5, 0x64D0, 0x237F, 0x1E1A,
+  0xEB93, 0xD6F6, 0x9159, 0xAC3C, 0x1E07, 0x2362, 0x64CD, 0x59A8,
+  0x3DDE, 0x00BB, 0x4714, 0x7A71, 0xC84A, 0xF52F, 0xB280, 0x8FE5,
+  0x64F7, 0x5992, 0x1E3D, 0x2358, 0x9163, 0xAC06, 0xEBA9, 0xD6CC,
+  0xB2BA, 0x8FDF, 0xC870, 0xF515, 0x472E, 0x7A4B, 0x3DE4, 0x0081,
+  0xF508, 0xC86D, 0x8FC2, 0xB2A7, 0x009C, 0x3DF9, 0x7A56, 0x4733,
+  0x2345, 0x1E20, 0x598F, 0x64EA, 0xD6D1, 0xEBB4, 0xAC1B, 0x917E,
+  0x475A, 0x7A3F, 0x3D90, 0x00F5, 0xB2CE, 0x8FAB, 0xC804, 0xF561,
+  0x9117, 0xAC72, 0xEBDD, 0xD6B8, 0x6483, 0x59E6, 0x1E49, 0x232C,
+  0xD6A5, 0xEBC0, 0xAC6F, 0x910A, 0x2331, 0x1E54, 0x59FB, 0x649E,
+  0x00E8, 0x3D8D, 0x7A22, 0x4747, 0xF57C, 0xC819, 0x8FB6, 0xB2D3,
+  0x59C1, 0x64A4, 0x230B, 0x1E6E, 0xAC55, 0x9130, 0xD69F, 0xEBFA,
+  0x8F8C, 0xB2E9, 0xF546, 0xC823, 0x7A18, 0x477D, 0x00D2, 0x3DB7,
+  0xC83E, 0xF55B, 0xB2F4, 0x8F91, 0x3DAA, 0x00CF, 0x4760, 0x7A05,
+  0x1E73, 0x2316, 0x64B9, 0x59DC, 0xEBE7, 0xD682, 0x912D, 0xAC48
+};
+
+/* 3-out-of-6 chips of every byte: 12 bits, high nibble first */
+static const uint16_t s_vectnEncode3of6[256] = {
+  0x596, 0x58D, 0x58E, 0x58B, 0x59C, 0x599, 0x59A, 0x593,
+  0x5AC, 0x5A5, 0x5A6, 0x5A3, 0x5B4, 0x5B1, 0x5B2, 0x5A9,
+  0x356, 0x34D, 0x34E, 0x34B, 0x35C, 0x359, 0x35A, 0x353,
+  0x36C, 0x365, 0x366, 0x363, 0x374, 0x371, 0x372, 0x369,
+  0x396, 0x38D, 0x38E, 0x38B, 0x39C, 0x399, 0x39A, 0x393,
+  0x3AC, 0x3A5, 0x3A6, 0x3A3, 0x3B4, 0x3B1, 0x3B2, 0x3A9,
+  0x2D6, 0x2CD, 0x2CE, 0x2CB, 0x2DC, 0x2D9, 0x2DA, 0x2D3,
+  0x2EC, 0x2E5, 0x2E6, 0x2E3, 0x2F4, 0x2F1, 0x2F2, 0x2E9,
+  0x716, 0x70D, 0x70E, 0x70B, 0x71C, 0x719, 0x71A, 0x713,
+  0x72C, 0x725, 0x726, 0x723, 0x734, 0x731, 0x732, 0x729,
+  0x656, 0x64D, 0x64E, 0x64B, 0x65C, 0x659, 0x65A, 0x653,
+  0x66C, 0x665, 0x666, 0x663, 0x674, 0x671, 0x672, 0x669,
+  0x696, 0x68D, 0x68E, 0x68B, 0x69C, 0x699, 0x69A, 0x693,
+  0x6AC, 0x6A5, 0x6A6, 0x6A3, 0x6B4, 0x6B1, 0x6B2, 0x6A9,
+  0x4D6, 0x4CD, 0x4CE, 0x4CB, 0x4DC, 0x4D9, 0x4DA, 0x4D3,
+  0x4EC, 0x4E5, 0x4E6, 0x4E3, 0x4F4, 0x4F1, 0x4F2, 0x4E9,
+  0xB16, 0xB0D, 0xB0E, 0xB0B, 0xB1C, 0xB19, 0xB1A, 0xB13,
+  0xB2C, 0xB25, 0xB26, 0xB23, 0xB34, 0xB31, 0xB32, 0xB29,
+  0x956, 0x94D, 0x94E, 0x94B, 0x95C, 0x959, 0x95A, 0x953,
+  0x96C, 0x965, 0x966, 0x963, 0x974, 0x971, 0x972, 0x969,
+  0x996, 0x98D, 0x98E, 0x98B, 0x99C, 0x999, 0x99A, 0x993,
+  0x9AC, 0x9A5, 0x9A6, 0x9A3, 0x9B4, 0x9B1, 0x9B2, 0x9A9,
+  0x8D6, 0x8CD, 0x8CE, 0x8CB, 0x8DC, 0x8D9, 0x8DA, 0x8D3,
+  0x8EC, 0x8E5, 0x8E6, 0x8E3, 0x8F4, 0x8F1, 0x8F2, 0x8E9,
+  0xD16, 0xD0D, 0xD0E, 0xD0B, 0xD1C, 0xD19, 0xD1A, 0xD13,
+  0xD2C, 0xD25, 0xD26, 0xD23, 0xD34, 0xD31, 0xD32, 0xD29,
+  0xC56, 0xC4D, 0xC4E, 0xC4B, 0xC5C, 0xC59, 0xC5A, 0xC53,
+  0xC6C, 0xC65, 0xC66, 0xC63, 0xC74, 0xC71, 0xC72, 0xC69,
+  0xC96, 0xC8D, 0xC8E, 0xC8B, 0xC9C, 0xC99, 0xC9A, 0xC93,
+  0xCAC, 0xCA5, 0xCA6, 0xCA3, 0xCB4, 0xCB1, 0xCB2, 0xCA9,
+  0xA56, 0xA4D, 0xA4E, 0xA4B, 0xA5C, 0xA59, 0xA5A, 0xA53,
+  0xA6C, 0xA65, 0xA66, 0xA63, 0xA74, 0xA71, 0xA72, 0xA69
+};
+
+/* Nibble of every 6-chip code, 0xFF for the codes the standard does not use */
+static const uint8_t s_vectcDecode3of6[64] = {
+  0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x03, 0xFF, 0x01, 0x02, 0xFF,
+  0xFF, 0xFF, 0xFF, 0x07, 0xFF, 0xFF, 0x00, 0xFF, 0xFF, 0x05, 0x06, 0xFF, 0x04, 0xFF, 0xFF, 0xFF,
+  0xFF, 0xFF, 0xFF, 0x0B, 0xFF, 0x09, 0x0A, 0xFF, 0xFF, 0x0F, 0xFF, 0xFF, 0x08, 0xFF, 0xFF, 0xFF,
+  0xFF, 0x0D, 0x0E, 0xFF, 0x0C, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+};
+
+typedef struct {
+  uint8_t           vectcRaw[WMBUS_FRAME_MAX_LEN];
+  uint16_t          nOffset;        /* where the L field is: 2 in C mode, after the frame type */
+  uint16_t          nLength;        /* bytes received */
+  WMbusFrameFormat  xFormat;
+  WMbusFrame        xFrame;         /* filled when the frame is checked */
+} WMbusSlot;
+
+static WMbusSlot s_vectxRxRing[S2LP_WMBUS_LL_RX_SLOTS];
+static volatile uint8_t s_cRxHead;      /* written by the IRQ handler only */
+static volatile uint8_t s_cRxTail;      /* written by S2LP_WMBUS_LL_Release only */
+static uint16_t s_nRxExpected;          /* 0 until the L field is read */
+static uint8_t s_cRxActive;             /* a frame is being received in the head slot */
+
+static uint8_t s_vectcTxFrame[WMBUS_FRAME_MAX_LEN];
+static uint16_t s_nTxLength, s_nTxSent;
+static volatile uint8_t s_cTxActive;
+
+static WMbusMode s_xMode;
+static WMbusStats s_xStats;
+
+/**
+ *@}
+ */
+
+
+/**
+ * @defgroup WMbusLL_Private_Functions                  WMbus Link Layer Private Functions
+ * @{
+ */
+
+/**
+ * @brief  Return the data bytes of the frame: what follows the CI field, CRCs excluded.
+ */
+static uint8_t WMbusDataLength(uint8_t cL, WMbusFrameFormat xFormat)
+{
+  uint16_t nLength = cL;
+
+  if(xFormat == WMBUS_FRAME_B) {
+    nLength -= (cL + 1 > WMBUS_FORMAT_B_BLOCK12_LEN + WMBUS_CRC_LEN) ? 2 * WMBUS_CRC_LEN : WMBUS_CRC_LEN;
+  }
+  /* C, M, A and CI fields */
+  return (nLength > WMBUS_L_MIN) ? (uint8_t)(nLength - WMBUS_L_MIN - 1) : 0;
+}
+
+/**
+ * @brief  Check the CRC that follows nLength bytes.
+ */
+static uint8_t WMbusCheckBlock(const uint8_t* pcBlock, uint16_t nLength)
+{
+  uint16_t nCrc = S2LP_WMBUS_Crc(pcBlock, nLength);
+
+  return (pcBlock[nLength] == (uint8_t)(nCrc >> 8)) && (pcBlock[nLength + 1] == (uint8_t)nCrc);
+}
+
+/**
+ * @brief  Append the CRC of the nLength bytes before it.
+ */
+static void WMbusAddCrc(uint8_t* pcBlock, uint16_t nLength)
+{
+  uint16_t nCrc = S2LP_WMBUS_Crc(pcBlock, nLength);
+
+  pcBlock[nLength] = (uint8_t)(nCrc >> 8);
+  pcBlock[nLength + 1] = (uint8_t)nCrc;
+}
+
+/**
+ * @brief  Program the length of the frame being received or sent, frame type included.
+ */
+static void WMbusSetPacketLength(uint16_t nLength)
+{
+  S2LP_PACKET_WMBUS_SetPayloadLength(nLength);
+}
+
+/**
+ * @brief  Move the bytes of the RX FIFO into the head slot of the ring.
+ *         Read the L field as soon as it is there, to program the length of
+ *         the frame and to interrupt every S2LP_RX_FIFO_SIZE - margin bytes.
+ * @retval 0 if the frame has to be dropped.
+ */
+static uint8_t WMbusRxDrain(void)
+{
+  WMbusSlot* pxSlot = &s_vectxRxRing[s_cRxHead % S2LP_WMBUS_LL_RX_SLOTS];
+  uint8_t cAvailable = S2LP_FIFO_ReadNumberBytesRxFifo();
+  uint16_t nRoom = WMBUS_FRAME_MAX_LEN - pxSlot->nLength;
+
+  if(s_nRxExpected != 0 && s_nRxExpected - pxSlot->nLength < nRoom) {
+    nRoom = s_nRxExpected - pxSlot->nLength;
+  }
+  if(cAvailable > nRoom) {
+    s_xStats.lLengthErrors++;
+    return 0;
+  }
+  if(cAvailable != 0) {
+    S2LP_ReadFIFO(cAvailable, &pxSlot->vectcRaw[pxSlot->nLength]);
+    pxSlot->nLength += cAvailable;
+  }
+
+  if(s_nRxExpected == 0 && pxSlot->nLength > pxSlot->nOffset) {
+    uint16_t nFrameLength;
+
+    if(s_xMode == WMBUS_MODE_C1) {
+      if(pxSlot->vectcRaw[0] != WMBUS_C_TYPE_0) {
+        s_xStats.lLengthErrors++;
+        return 0;
+      }
+      if(pxSlot->vectcRaw[1] == WMBUS_C_TYPE_A) {
+        pxSlot->xFormat = WMBUS_FRAME_A;
+      }
+      else if(pxSlot->vectcRaw[1] == WMBUS_C_TYPE_B) {
+        pxSlot->xFormat = WMBUS_FRAME_B;
+      }
+      else {
+        s_xStats.lLengthErrors++;
+        return 0;
+      }
+    }
+
+    nFrameLength = S2LP_WMBUS_FrameLength(pxSlot->vectcRaw[pxSlot->nOffset], pxSlot->xFormat);
+    if(nFrameLength == 0 || pxSlot->nLength > pxSlot->nOffset + nFrameLength) {
+      s_xStats.lLengthErrors++;
+      return 0;
+    }
+    s_nRxExpected = pxSlot->nOffset + nFrameLength;
+    WMbusSetPacketLength(s_nRxExpected);
+    S2LP_FIFO_SetAlmostFullThresholdRx(S2LP_WMBUS_LL_FIFO_MARGIN);
+  }
+  return 1;
+}
+
+/**
+ * @brief  Write the next bytes of the frame being sent in the TX FIFO.
+ */
+static void WMbusTxFill(uint8_t cRoom)
+{
+  uint16_t nChunk = s_nTxLength - s_nTxSent;
+
+  if(nChunk > cRoom) {
+    nChunk = cRoom;
+  }
+  if(nChunk != 0) {
+    S2LP_WriteFIFO((uint8_t)nChunk, &s_vectcTxFrame[s_nTxSent]);
+    s_nTxSent += nChunk;
+  }
+  if(s_nTxSent == s_nTxLength) {
+    S2LP_GPIO_IrqConfig(TX_FIFO_ALMOST_EMPTY, S_DISABLE);
+  }
+}
+
+/**
+ *@}
+ */
+
+
+/**
+ * @defgroup WMbusLL_Public_Functions                  WMbus Link Layer Public Functions
+ * @{
+ */
+
+/**
+ * @brief  Compute the CRC of EN 13757-4 (polynomial 0x3D65, complemented).
+ * @param  pcData the bytes covered by the CRC.
+ * @param  nLength number of bytes.
+ * @retval uint16_t the CRC, sent MSB first.
+ */
+uint16_t S2LP_WMBUS_Crc(const uint8_t* pcData, uint16_t nLength)
+{
+  uint16_t nCrc = 0;
+
+  while(nLength--) {
+    nCrc = (uint16_t)(nCrc << 8) ^ s_vectnCrcTable[(uint8_t)(nCrc >> 8) ^ *pcData++];
+  }
+  return (uint16_t)~nCrc;
+}
+
+/**
+ * @brief  Code bytes in 3-out-of-6 chips, as sent in T mode.
+ * @param  pcData the bytes to code.
+ * @param  nLength number of bytes.
+ * @param  pcChips the chips, (3 * nLength + 1) / 2 bytes. With an odd nLength
+ *         the last 4 chips are "0101", as the postamble.
+ * @retval uint16_t number of bytes written in pcChips.
+ */
+uint16_t S2LP_WMBUS_Encode3of6(const uint8_t* pcData, uint16_t nLength, uint8_t* pcChips)
+{
+  uint8_t* pcOut = pcChips;
+
+  for(; nLength >= 2; nLength -= 2, pcData += 2) {
+    uint16_t nHigh = s_vectnEncode3of6[pcData[0]];
+    uint16_t nLow = s_vectnEncode3of6[pcData[1]];
+
+    *pcOut++ = (uint8_t)(nHigh >> 4);
+    *pcOut++ = (uint8_t)((nHigh << 4) | (nLow >> 8));
+    *pcOut++ = (uint8_t)nLow;
+  }
+  if(nLength) {
+    uint16_t nHigh = s_vectnEncode3of6[pcData[0]];
+
+    *pcOut++ = (uint8_t)(nHigh >> 4);
+    *pcOut++ = (uint8_t)((nHigh << 4) | 0x05);
+  }
+  return (uint16_t)(pcOut - pcChips);
+}
+
+/**
+ * @brief  Decode 3-out-of-6 chips.
+ * @param  pcChips the chips.
+ * @param  nLength number of bytes of chips; 3 bytes give 2 data bytes, the
+ *         chips left over (less than 12) are ignored.
+ * @param  pcData the decoded bytes, nLength * 2 / 3 bytes. It can be pcChips.
+ * @retval int32_t number of decoded bytes, -1 if a code is not valid.
+ */
+int32_t S2LP_WMBUS_Decode3of6(const uint8_t* pcChips, uint16_t nLength, uint8_t* pcData)
+{
+  uint8_t* pcOut = pcData;
+  uint8_t cError = 0;
+
+  /* 24 chips, 4 codes, 2 bytes at a time; the errors are checked once at the end */
+  for(; nLength >= 3; nLength -= 3, pcChips += 3) {
+    uint32_t lChips = ((uint32_t)pcChips[0] << 16) | ((uint32_t)pcChips[1] << 8) | pcChips[2];
+    uint8_t c0 = s_vectcDecode3of6[lChips >> 18];
+    uint8_t c1 = s_vectcDecode3of6[(lChips >> 12) & 0x3F];
+    uint8_t c2 = s_vectcDecode3of6[(lChips >> 6) & 0x3F];
+    uint8_t c3 = s_vectcDecode3of6[lChips & 0x3F];
+
+    cError |= c0 | c1 | c2 | c3;
+    *pcOut++ = (uint8_t)((c0 << 4) | (c1 & 0x0F));
+    *pcOut++ = (uint8_t)((c2 << 4) | (c3 & 0x0F));
+  }
+  if(nLength == 2) {
+    uint16_t nChips = ((uint16_t)pcChips[0] << 8) | pcChips[1];
+    uint8_t c0 = s_vectcDecode3of6[nChips >> 10];
+    uint8_t c1 = s_vectcDecode3of6[(nChips >> 4) & 0x3F];
+
+    cError |= c0 | c1;
+    *pcOut++ = (uint8_t)((c0 << 4) | (c1 & 0x0F));
+  }
+  /* The valid codes decode to 0x00..0x0F, the others to 0xFF */
+  if(cError & 0xF0) {
+    return -1;
+  }
+  return (int32_t)(pcOut - pcData);
+}
+
+/**
+ * @brief  Return the length of a frame on air from its L field.
+ * @param  cL the L field.
+ * @param  xFormat the frame format.
+ * @retval uint16_t bytes from the L field to the last CRC, 0 if cL is not valid.
+ */
+uint16_t S2LP_WMBUS_FrameLength(uint8_t cL, WMbusFrameFormat xFormat)
+{
+  if(xFormat == WMBUS_FRAME_B) {
+    /* L counts the CRCs: a 3rd block is there only beyond the 2nd CRC */
+    if(cL < WMBUS_L_MIN + WMBUS_CRC_LEN ||
+       (cL + 1 > WMBUS_FORMAT_B_BLOCK12_LEN + WMBUS_CRC_LEN && cL + 1 < WMBUS_FORMAT_B_BLOCK12_LEN + 2 * WMBUS_CRC_LEN + 1)) {
+      return 0;
+    }
+    return (uint16_t)cL + 1;
+  }
+
+  if(cL < WMBUS_L_MIN) {
+    return 0;
+  }
+  return (uint16_t)cL + 1 + WMBUS_CRC_LEN * (1 + (cL - WMBUS_L_MIN + WMBUS_BLOCK_LEN - 1) / WMBUS_BLOCK_LEN);
+}
+
+/**
+ * @brief  Build a frame to send: set the L field and add the CRCs.
+ * @param  pcTelegram the telegram from the L field (its value is ignored) to
+ *         the last data byte, without CRCs.
+ * @param  nLength number of bytes of pcTelegram, L field included.
+ * @param  xFormat the frame format.
+ * @param  pcFrame the frame, S2LP_WMBUS_FrameLength(L, xFormat) bytes; it cannot be pcTelegram.
+ * @retval uint16_t number of bytes written in pcFrame, 0 if the telegram is too short or too long.
+ */
+uint16_t S2LP_WMBUS_BuildFrame(const uint8_t* pcTelegram, uint16_t nLength, WMbusFrameFormat xFormat, uint8_t* pcFrame)
+{
+  uint16_t nIn, nOut, nBlock;
+
+  if(nLength < WMBUS_BLOCK1_LEN) {
+    return 0;
+  }
+
+  if(xFormat == WMBUS_FRAME_B) {
+    if(nLength <= WMBUS_FORMAT_B_BLOCK12_LEN) {
+      nOut = nLength + WMBUS_CRC_LEN;
+      memcpy(pcFrame, pcTelegram, nLength);
+      pcFrame[0] = (uint8_t)(nOut - 1);
+      WMbusAddCrc(pcFrame, nLength);
+      return nOut;
+    }
+    nOut = nLength + 2 * WMBUS_CRC_LEN;
+    if(nOut - 1 > 255) {
+      return 0;
+    }
+    memcpy(pcFrame, pcTelegram, WMBUS_FORMAT_B_BLOCK12_LEN);
+    pcFrame[0] = (uint8_t)(nOut - 1);
+    WMbusAddCrc(pcFrame, WMBUS_FORMAT_B_BLOCK12_LEN);
+    memcpy(&pcFrame[WMBUS_FORMAT_B_BLOCK12_LEN + WMBUS_CRC_LEN], &pcTelegram[WMBUS_FORMAT_B_BLOCK12_LEN],
+           nLength - WMBUS_FORMAT_B_BLOCK12_LEN);
+    WMbusAddCrc(&pcFrame[WMBUS_FORMAT_B_BLOCK12_LEN + WMBUS_CRC_LEN], nLength - WMBUS_FORMAT_B_BLOCK12_LEN);
+    return nOut;
+  }
+
+  if(nLength - 1 > 255) {
+    return 0;
+  }
+  memcpy(pcFrame, pcTelegram, WMBUS_BLOCK1_LEN);
+  pcFrame[0] = (uint8_t)(nLength - 1);
+  WMbusAddCrc(pcFrame, WMBUS_BLOCK1_LEN);
+  nOut = WMBUS_BLOCK1_LEN + WMBUS_CRC_LEN;
+  for(nIn = WMBUS_BLOCK1_LEN; nIn < nLength; nIn += nBlock) {
+    nBlock = nLength - nIn;
+    if(nBlock > WMBUS_BLOCK_LEN) {
+      nBlock = WMBUS_BLOCK_LEN;
+    }
+    memcpy(&pcFrame[nOut], &pcTelegram[nIn], nBlock);
+    WMbusAddCrc(&pcFrame[nOut], nBlock);
+    nOut += nBlock + WMBUS_CRC_LEN;
+  }
+  return nOut;
+}
+
+/**
+ * @brief  Check the CRCs of a frame and read its link layer header. Nothing
+ *         is copied: pxFrame points into pcFrame.
+ * @param  pcFrame the frame, from the L field.
+ * @param  nLength bytes available in pcFrame; they can be more than the frame.
+ * @param  xFormat the frame format.
+ * @param  pxFrame the header fields, valid only if WMBUS_OK is returned.
+ * @retval WMbusResult the outcome of the checks.
+ */
+WMbusResult S2LP_WMBUS_ParseFrame(const uint8_t* pcFrame, uint16_t nLength, WMbusFrameFormat xFormat, WMbusFrame* pxFrame)
+{
+  uint16_t nFrameLength = S2LP_WMBUS_FrameLength(pcFrame[0], xFormat);
+  uint16_t nOffset, nBlock;
+  const uint8_t* pcData;
+
+  if(nLength == 0 || nFrameLength == 0 || nFrameLength > nLength) {
+    return WMBUS_ERR_LENGTH;
+  }
+
+  if(xFormat == WMBUS_FRAME_B) {
+    nBlock = (nFrameLength > WMBUS_FORMAT_B_BLOCK12_LEN + WMBUS_CRC_LEN) ? WMBUS_FORMAT_B_BLOCK12_LEN
+                                                                       : nFrameLength - WMBUS_CRC_LEN;
+    if(!WMbusCheckBlock(pcFrame, nBlock)) {
+      return WMBUS_ERR_CRC;
+    }
+    nOffset = nBlock + WMBUS_CRC_LEN;
+    if(nOffset < nFrameLength && !WMbusCheckBlock(&pcFrame[nOffset], nFrameLength - nOffset - WMBUS_CRC_LEN)) {
+      return WMBUS_ERR_CRC;
+    }
+    pcData = &pcFrame[WMBUS_BLOCK1_LEN];
+  }
+  else {
+    for(nOffset = 0, nBlock = WMBUS_BLOCK1_LEN; nOffset < nFrameLength; nOffset += nBlock + WMBUS_CRC_LEN) {
+      if(nOffset != 0) {
+        nBlock = nFrameLength - nOffset - WMBUS_CRC_LEN;
+        if(nBlock > WMBUS_BLOCK_LEN) {
+          nBlock = WMBUS_BLOCK_LEN;
+        }
+      }
+      if(!WMbusCheckBlock(&pcFrame[nOffset], nBlock)) {
+        return WMBUS_ERR_CRC;
+      }
+    }
+    pcData = &pcFrame[WMBUS_BLOCK1_LEN + WMBUS_CRC_LEN];
+  }
+
+  pxFrame->pcRaw = pcFrame;
+  pxFrame->nRawLen = nFrameLength;
+  pxFrame->xFormat = xFormat;
+  pxFrame->cL = pcFrame[0];
+  pxFrame->cC = pcFrame[1];
+  pxFrame->nManufacturer = (uint16_t)pcFrame[2] | ((uint16_t)pcFrame[3] << 8);
+  pxFrame->lId = (uint32_t)pcFrame[4] | ((uint32_t)pcFrame[5] << 8) | ((uint32_t)pcFrame[6] << 16) | ((uint32_t)pcFrame[7] << 24);
+  pxFrame->cVersion = pcFrame[8];
+  pxFrame->cDevType = pcFrame[9];
+  pxFrame->cDataLen = WMbusDataLength(pxFrame->cL, xFormat);
+  /* A frame with L = 9 has no CI field */
+  pxFrame->cCI = (pcData < &pcFrame[nFrameLength - WMBUS_CRC_LEN]) ? pcData[0] : 0;
+  pxFrame->cRssidBm = 0;
+  return WMBUS_OK;
+}
+
+/**
+ * @brief  Return a data segment of a frame parsed by S2LP_WMBUS_ParseFrame:
+ *         the data between two CRCs, the CI field excluded.
+ * @param  pxFrame the frame.
+ * @param  cIndex the segment, from 0.
+ * @param  ppcData where the segment starts, in the frame.
+ * @retval uint8_t number of bytes of the segment, 0 past the last one.
+ */
+uint8_t S2LP_WMBUS_GetDataBlock(const WMbusFrame* pxFrame, uint8_t cIndex, const uint8_t** ppcData)
+{
+  uint16_t nSkip, nLength, nStart;
+
+  if(pxFrame->xFormat == WMBUS_FRAME_B) {
+    /* The 2nd block ends at the 2nd CRC, the 3rd one holds the rest */
+    nLength = WMBUS_FORMAT_B_BLOCK12_LEN - WMBUS_BLOCK1_LEN - 1;
+    if(cIndex == 0) {
+      nStart = WMBUS_BLOCK1_LEN + 1;
+    }
+    else if(cIndex == 1 && pxFrame->cDataLen > nLength) {
+      nStart = WMBUS_FORMAT_B_BLOCK12_LEN + WMBUS_CRC_LEN;
+      *ppcData = &pxFrame->pcRaw[nStart];
+      return (uint8_t)(pxFrame->cDataLen - nLength);
+    }
+    else {
+      return 0;
+    }
+    nSkip = 0;
+  }
+  else {
+    /* The CI field takes the first byte of the 2nd block */
+    nStart = WMBUS_BLOCK1_LEN + WMBUS_CRC_LEN + (uint16_t)cIndex * (WMBUS_BLOCK_LEN + WMBUS_CRC_LEN);
+    nSkip = cIndex ? (uint16_t)cIndex * WMBUS_BLOCK_LEN - 1 : 0;
+    nLength = cIndex ? WMBUS_BLOCK_LEN : WMBUS_BLOCK_LEN - 1;
+    if(cIndex == 0) {
+      nStart++;
+    }
+  }
+
+  if(nSkip >= pxFrame->cDataLen) {
+    return 0;
+  }
+  if(nLength > pxFrame->cDataLen - nSkip) {
+    nLength = pxFrame->cDataLen - nSkip;
+  }
+  *ppcData = &pxFrame->pcRaw[nStart];
+  return (uint8_t)nLength;
+}
+
+/**
+ * @brief  Configure the S2-LP for a Wireless M-Bus mode, meter to other direction.
+ *         The S2-LP must be initialized and its IRQ GPIO configured.
+ * @param  xMode the mode.
+ * @param  lFrequencyOffset the frequency offset of the board, in Hz.
+ * @retval None.
+ */
+void S2LP_WMBUS_LL_Init(WMbusMode xMode, int32_t lFrequencyOffset)
+{
+  SRadioInit xRadioInit = {868950000, MOD_2FSK, 100000, 50000, 250000};
+  PktWMbusInit xPktInit = {WMBUS_SUBMODE_T1_T2_METER_TO_OTHER, 0, 4};
+  uint8_t i;
+
+  if(xMode == WMBUS_MODE_S1) {
+    xRadioInit.lFrequencyBase = 868300000;
+    xRadioInit.lDatarate = 32768;
+    xPktInit.xWMbusSubmode = WMBUS_SUBMODE_S1_S2_LONG_HEADER;
+  }
+  else if(xMode == WMBUS_MODE_C1) {
+    xRadioInit.lFreqDev = 45000;
+    xPktInit.xWMbusSubmode = WMBUS_SUBMODE_NOT_CONFIGURED;
+  }
+  xRadioInit.lFrequencyBase += lFrequencyOffset;
+
+  S2LP_CMD_StrobeSabort();
+  S2LP_RADIO_Init(&xRadioInit);
+  S2LP_PACKET_WMBUS_Init(&xPktInit);
+  if(xMode == WMBUS_MODE_C1) {
+    /* No submode of the S2-LP: NRZ chips with the sync word of the C mode */
+    S2LP_PCKT_HNDL_SetPreambleLength(WMBUS_C_PREAMBLE_LEN);
+    S2LP_PCKT_HNDL_SetSyncLength(WMBUS_C_SYNC_LEN);
+    S2LP_PCKT_HNDL_SetSyncWords(WMBUS_C_SYNC_WORD, WMBUS_C_SYNC_LEN);
+  }
+
+  s_xMode = xMode;
+  s_cRxHead = s_cRxTail = 0;
+  s_cRxActive = 0;
+  s_cTxActive = 0;
+  for(i = 0; i < S2LP_WMBUS_LL_RX_SLOTS; i++) {
+    s_vectxRxRing[i].nOffset = (xMode == WMBUS_MODE_C1) ? 2 : 0;
+    s_vectxRxRing[i].xFormat = WMBUS_FRAME_A;
+  }
+  memset(&s_xStats, 0, sizeof(s_xStats));
+
+  S2LP_GPIO_IrqDeInit(NULL);
+  S2LP_GPIO_IrqClearStatus();
+  S2LP_GPIO_IrqConfig(VALID_SYNC, S_ENABLE);
+  S2LP_GPIO_IrqConfig(RX_FIFO_ALMOST_FULL, S_ENABLE);
+  S2LP_GPIO_IrqConfig(RX_DATA_READY, S_ENABLE);
+  S2LP_GPIO_IrqConfig(RX_FIFO_ERROR, S_ENABLE);
+  S2LP_GPIO_IrqConfig(TX_DATA_SENT, S_ENABLE);
+  S2LP_GPIO_IrqConfig(TX_FIFO_ERROR, S_ENABLE);
+  S2LP_FIFO_SetAlmostEmptyThresholdTx(S2LP_WMBUS_LL_FIFO_MARGIN);
+  S2LP_FIFO_MuxRxFifoIrqEnable(S_ENABLE);
+}
+
+/**
+ * @brief  Listen for the next frame. Called by the link layer after every
+ *         frame, received or sent.
+ * @param  None.
+ * @retval None.
+ */
+void S2LP_WMBUS_LL_StartRx(void)
+{
+  uint16_t nOffset = (s_xMode == WMBUS_MODE_C1) ? 2 : 0;
+
+  S2LP_CMD_StrobeSabort();
+  S2LP_CMD_StrobeFlushRxFifo();
+  s_cRxActive = 0;
+  s_nRxExpected = 0;
+  /* The longest frame until the L field is read, which then programs its length */
+  WMbusSetPacketLength(WMBUS_FRAME_MAX_LEN);
+  S2LP_FIFO_SetAlmostFullThresholdRx(S2LP_RX_FIFO_SIZE - (nOffset + 1));
+  S2LP_GPIO_IrqClearStatus();
+  S2LP_CMD_StrobeRx();
+}
+
+/**
+ * @brief  Serve the IRQs of the S2-LP. To be called by the IRQ handler of its GPIO.
+ * @param  pxIrqStatus the IRQ status read by S2LP_GPIO_IrqGetStatus.
+ * @retval None.
+ */
+void S2LP_WMBUS_LL_IrqHandler(S2LPIrqs* pxIrqStatus)
+{
+  if(s_cTxActive) {
+    if(pxIrqStatus->IRQ_TX_FIFO_ERROR) {
+      s_cTxActive = 0;
+      S2LP_GPIO_IrqConfig(TX_FIFO_ALMOST_EMPTY, S_DISABLE);
+      S2LP_CMD_StrobeFlushTxFifo();
+      S2LP_WMBUS_LL_StartRx();
+    }
+    else if(pxIrqStatus->IRQ_TX_DATA_SENT) {
+      s_cTxActive = 0;
+      s_xStats.lTxFrames++;
+      S2LP_WMBUS_LL_StartRx();
+    }
+    else if(pxIrqStatus->IRQ_TX_FIFO_ALMOST_EMPTY) {
+      WMbusTxFill(S2LP_TX_FIFO_SIZE - S2LP_WMBUS_LL_FIFO_MARGIN);
+    }
+    return;
+  }
+
+  if(pxIrqStatus->IRQ_RX_FIFO_ERROR) {
+    s_xStats.lFifoErrors++;
+    S2LP_WMBUS_LL_StartRx();
+    return;
+  }
+
+  if(pxIrqStatus->IRQ_VALID_SYNC && !s_cRxActive) {
+    if((uint8_t)(s_cRxHead - s_cRxTail) >= S2LP_WMBUS_LL_RX_SLOTS) {
+      s_xStats.lOverflows++;
+      S2LP_WMBUS_LL_StartRx();
+      return;
+    }
+    s_vectxRxRing[s_cRxHead % S2LP_WMBUS_LL_RX_SLOTS].nLength = 0;
+    s_vectxRxRing[s_cRxHead % S2LP_WMBUS_LL_RX_SLOTS].xFrame.cRssidBm = (int8_t)S2LP_RADIO_QI_GetRssidBm();
+    s_cRxActive = 1;
+  }
+
+  if(!s_cRxActive) {
+    return;
+  }
+
+  if(pxIrqStatus->IRQ_RX_FIFO_ALMOST_FULL || pxIrqStatus->IRQ_RX_DATA_READY) {
+    if(!WMbusRxDrain()) {
+      S2LP_WMBUS_LL_StartRx();
+      return;
+    }
+  }
+
+  if(pxIrqStatus->IRQ_RX_DATA_READY) {
+    WMbusSlot* pxSlot = &s_vectxRxRing[s_cRxHead % S2LP_WMBUS_LL_RX_SLOTS];
+    int8_t cRssidBm = pxSlot->xFrame.cRssidBm;
+
+    if(s_nRxExpected == 0 || pxSlot->nLength != s_nRxExpected) {
+      s_xStats.lLengthErrors++;
+    }
+    else if(S2LP_WMBUS_ParseFrame(&pxSlot->vectcRaw[pxSlot->nOffset], pxSlot->nLength - pxSlot->nOffset,
+                                  pxSlot->xFormat, &pxSlot->xFrame) != WMBUS_OK) {
+      s_xStats.lCrcErrors++;
+    }
+    else {
+      pxSlot->xFrame.cRssidBm = cRssidBm;
+      s_xStats.lRxFrames++;
+      s_cRxHead++;
+    }
+    S2LP_WMBUS_LL_StartRx();
+  }
+}
+
+/**
+ * @brief  Return the oldest frame received. It stays in the ring, and
+ *         pxFrame points into it, until S2LP_WMBUS_LL_Release is called.
+ * @param  pxFrame the frame.
+ * @retval uint8_t 1 if a frame was returned, 0 if none was received.
+ */
+uint8_t S2LP_WMBUS_LL_Receive(WMbusFrame* pxFrame)
+{
+  if(s_cRxTail == s_cRxHead) {
+    return 0;
+  }
+  /* Parsed by the IRQ handler: its fields point into the slot */
+  *pxFrame = s_vectxRxRing[s_cRxTail % S2LP_WMBUS_LL_RX_SLOTS].xFrame;
+  return 1;
+}
+
+/**
+ * @brief  Give the frame returned by S2LP_WMBUS_LL_Receive back to the ring.
+ * @param  None.
+ * @retval None.
+ */
+void S2LP_WMBUS_LL_Release(void)
+{
+  if(s_cRxTail != s_cRxHead) {
+    s_cRxTail++;
+  }
+}
+
+/**
+ * @brief  Send a telegram; the S2-LP goes back to RX when it is sent.
+ *         Frames longer than the TX FIFO are refilled from the IRQ handler.
+ * @param  pcTelegram the telegram, see S2LP_WMBUS_BuildFrame.
+ * @param  nLength number of bytes of pcTelegram, L field included.
+ * @retval int32_t 0 if the frame is on its way, -1 if the link layer is busy or the telegram not valid.
+ */
+int32_t S2LP_WMBUS_LL_Send(const uint8_t* pcTelegram, uint16_t nLength)
+{
+  uint16_t nOffset = 0;
+  uint16_t nFrameLength;
+
+  if(s_cTxActive || s_cRxActive) {
+    return -1;
+  }
+  if(s_xMode == WMBUS_MODE_C1) {
+    s_vectcTxFrame[nOffset++] = WMBUS_C_TYPE_0;
+    s_vectcTxFrame[nOffset++] = WMBUS_C_TYPE_A;
+  }
+  nFrameLength = S2LP_WMBUS_BuildFrame(pcTelegram, nLength, WMBUS_FRAME_A, &s_vectcTxFrame[nOffset]);
+  if(nFrameLength == 0) {
+    return -1;
+  }
+
+  S2LP_CMD_StrobeSabort();
+  S2LP_CMD_StrobeFlushTxFifo();
+  S2LP_GPIO_IrqClearStatus();
+  s_nTxLength = nOffset + nFrameLength;
+  s_nTxSent = 0;
+  s_cTxActive = 1;
+  WMbusSetPacketLength(s_nTxLength);
+  WMbusTxFill(S2LP_TX_FIFO_SIZE);
+  if(s_nTxSent < s_nTxLength) {
+    S2LP_GPIO_IrqConfig(TX_FIFO_ALMOST_EMPTY, S_ENABLE);
+  }
+  S2LP_CMD_StrobeTx();
+  return 0;
+}
+
+/**
+ * @brief  Tell if a frame is being sent or received.
+ * @param  None.
+ * @retval uint8_t 1 if busy.
+ */
+uint8_t S2LP_WMBUS_LL_Busy(void)
+{
+  return s_cTxActive || s_cRxActive;
+}
+
+/**
+ * @brief  Return the counters of the link layer.
+ * @param  pxStats the counters.
+ * @retval None.
+ */
+void S2LP_WMBUS_LL_GetStats(WMbusStats* pxStats)
+{
+  *pxStats = s_xStats;
+}
+
+/**
+ *@}
+ */
+
+/**
+ *@}
+ */
+
+
+/**
+ *@}
+ */
+
+
+/******************* (C) COPYRIGHT 2019 STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,242 @@
+/**
+ * @file    s2lp_wmbus_ll.h
+ * @author  SRA Application Team
+ * @brief   Wireless M-Bus (EN 13757-4) link layer of the S2-LP: S1, T1 and C1
+ *          modes, block CRC, 3-out-of-6 codec and frame parser.
+  ******************************************************************************
+ * @attention
+ *
+ * <h2><center>&copy; COPYRIGHT(c) 2019 STMicroelectronics</center></h2>
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *   1. Redistributions of source code must retain the above copyright notice,
+ *      this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright notice,
+ *      this list of conditions and the following disclaimer in the documentation
+ *      and/or other materials provided with the distribution.
+ *   3. Neither the name of STMicroelectronics nor the names of its contributors 
+ *      may be used to endorse or promote products derived from this software
+ *      without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ * AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ * IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ * FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE 
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * This module sits on top of the WMbus packet format of the S2-LP
+ * (<i>@ref S2LP_PktWMbus</i>). The packet handler sends the preamble, the
+ * sync word and the postamble and codes the chips (Manchester for the S mode,
+ * 3-out-of-6 for the T mode), but knows nothing of the telegrams: this layer
+ * reads the L field while the frame is being received to program its length,
+ * checks and adds the CRC of every block and parses the link layer header.
+ *
+ * The frames are handled as they are on air, from the L field to the last
+ * CRC (format A: a CRC after the first 10 bytes and after every 16 bytes,
+ * format B: a CRC at the end of the second and of the optional third block).
+ * The parser checks them in place and the data are read block by block
+ * (S2LP_WMBUS_GetDataBlock): a received telegram is never copied.
+ *
+ * The software 3-out-of-6 codec is not needed by the S2-LP: it decodes the
+ * chips of T mode telegrams taken from other receivers or in direct mode.
+ *
+ * The receive ring and the frame state are static: the layer drives one
+ * S2-LP, whatever object is selected with S2LP_SelectObject.
+ *
+ * <b>Example:</b>
+ * @code
+ *
+ * S2LP_WMBUS_LL_Init(WMBUS_MODE_T1, S2LP_ManagementGetOffset());
+ * S2LP_WMBUS_LL_StartRx();
+ *
+ * ...
+ *
+ * // IRQ handler of the S2-LP GPIO
+ * S2LP_GPIO_IrqGetStatus(&xIrqStatus);
+ * S2LP_WMBUS_LL_IrqHandler(&xIrqStatus);
+ *
+ * ...
+ *
+ * WMbusFrame xFrame;
+ * while(S2LP_WMBUS_LL_Receive(&xFrame)) {
+ *   // xFrame points into the receive ring until S2LP_WMBUS_LL_Release()
+ *   S2LP_WMBUS_LL_Release();
+ * }
+ *
+ * @endcode
+ * <h2><center>&copy; COPYRIGHT 2019 STMicroelectronics</center></h2>
+ */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __S2LP_WMBUS_LL_H
+#define __S2LP_WMBUS_LL_H
+
+
+/* Includes ------------------------------------------------------------------*/
+
+#include "s2lp_types.h"
+#include "s2lp_gpio.h"
+#include "s2lp_pktwmbus.h"
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+
+/**
+ * @addtogroup S2LP_Libraries
+ * @{
+ */
+
+
+/**
+ * @defgroup S2LP_WMbusLL     WMbus Link Layer
+ * @brief Wireless M-Bus link layer on top of the S2-LP WMbus packets.
+ * @details See the file <i>@ref s2lp_wmbus_ll.h</i> for more details.
+ * @{
+ */
+
+/**
+ * @defgroup WMbusLL_Exported_Constants     WMbus Link Layer Exported Constants
+ * @{
+ */
+
+#define WMBUS_BLOCK1_LEN            10      /*!< L, C, M and A fields */
+#define WMBUS_BLOCK_LEN             16      /*!< Data bytes of the next blocks, format A */
+#define WMBUS_CRC_LEN               2
+#define WMBUS_FORMAT_B_BLOCK12_LEN  126     /*!< Format B: first two blocks, CRC excluded */
+#define WMBUS_L_MIN                 9       /*!< C, M and A fields */
+
+/** Longest frame on air: format A with L = 255, the 2 frame type bytes of the C mode included */
+#define WMBUS_FRAME_MAX_LEN         (2 + 1 + 255 + WMBUS_CRC_LEN * 17)
+
+/** Number of received frames the link layer can hold */
+#ifndef S2LP_WMBUS_LL_RX_SLOTS
+#define S2LP_WMBUS_LL_RX_SLOTS      4
+#endif
+
+/**
+ *@}
+ */
+
+
+/**
+ * @defgroup WMbusLL_Exported_Types     WMbus Link Layer Exported Types
+ * @{
+ */
+
+/**
+ * @brief  Wireless M-Bus mode (meter to other direction).
+ */
+typedef enum {
+  WMBUS_MODE_S1 = 0,          /*!< 868.3 MHz, 32.768 kcps Manchester, format A */
+  WMBUS_MODE_T1,              /*!< 868.95 MHz, 100 kcps 3-out-of-6, format A */
+  WMBUS_MODE_C1               /*!< 868.95 MHz, 100 kcps NRZ, format A or B */
+} WMbusMode;
+
+
+/**
+ * @brief  Frame format: where the CRCs are and what the L field counts.
+ */
+typedef enum {
+  WMBUS_FRAME_A = 0,          /*!< CRC after every block, not counted by L */
+  WMBUS_FRAME_B               /*!< CRC after the 2nd and 3rd blocks, counted by L */
+} WMbusFrameFormat;
+
+
+/**
+ * @brief  Outcome of the frame checks.
+ */
+typedef enum {
+  WMBUS_OK = 0,
+  WMBUS_ERR_LENGTH,           /*!< L field out of range or frame truncated */
+  WMBUS_ERR_CRC               /*!< a block CRC does not match */
+} WMbusResult;
+
+
+/**
+ * @brief  A frame checked by S2LP_WMBUS_ParseFrame: the header fields, the
+ *         data are left in the frame (S2LP_WMBUS_GetDataBlock).
+ */
+typedef struct {
+  const uint8_t*    pcRaw;          /*!< L field of the frame, CRCs still in place */
+  uint16_t          nRawLen;        /*!< bytes from the L field to the last CRC */
+  WMbusFrameFormat  xFormat;
+  uint8_t           cL;             /*!< L field */
+  uint8_t           cC;             /*!< C field */
+  uint16_t          nManufacturer;  /*!< M field, 3 letters coded on 15 bits */
+  uint32_t          lId;            /*!< identification number of the A field (BCD) */
+  uint8_t           cVersion;       /*!< version of the A field */
+  uint8_t           cDevType;       /*!< device type of the A field */
+  uint8_t           cCI;            /*!< CI field */
+  uint8_t           cDataLen;       /*!< data bytes after the CI field */
+  int8_t            cRssidBm;       /*!< RSSI of the frame, filled by the link layer */
+} WMbusFrame;
+
+
+/**
+ * @brief  Link layer counters.
+ */
+typedef struct {
+  uint32_t          lRxFrames;      /*!< frames received and checked */
+  uint32_t          lCrcErrors;     /*!< frames dropped for a block CRC */
+  uint32_t          lLengthErrors;  /*!< frames dropped for their L field or frame type */
+  uint32_t          lOverflows;     /*!< frames dropped because the ring was full */
+  uint32_t          lFifoErrors;    /*!< RX FIFO overflows */
+  uint32_t          lTxFrames;      /*!< frames sent */
+} WMbusStats;
+
+/**
+ *@}
+ */
+
+
+/**
+ * @defgroup WMbusLL_Exported_Functions     WMbus Link Layer Exported Functions
+ * @{
+ */
+
+uint16_t S2LP_WMBUS_Crc(const uint8_t* pcData, uint16_t nLength);
+uint16_t S2LP_WMBUS_Encode3of6(const uint8_t* pcData, uint16_t nLength, uint8_t* pcChips);
+int32_t S2LP_WMBUS_Decode3of6(const uint8_t* pcChips, uint16_t nLength, uint8_t* pcData);
+uint16_t S2LP_WMBUS_FrameLength(uint8_t cL, WMbusFrameFormat xFormat);
+uint16_t S2LP_WMBUS_BuildFrame(const uint8_t* pcTelegram, uint16_t nLength, WMbusFrameFormat xFormat, uint8_t* pcFrame);
+WMbusResult S2LP_WMBUS_ParseFrame(const uint8_t* pcFrame, uint16_t nLength, WMbusFrameFormat xFormat, WMbusFrame* pxFrame);
+uint8_t S2LP_WMBUS_GetDataBlock(const WMbusFrame* pxFrame, uint8_t cIndex, const uint8_t** ppcData);
+
+void S2LP_WMBUS_LL_Init(WMbusMode xMode, int32_t lFrequencyOffset);
+void S2LP_WMBUS_LL_StartRx(void);
+void S2LP_WMBUS_LL_IrqHandler(S2LPIrqs* pxIrqStatus);
+uint8_t S2LP_WMBUS_LL_Receive(WMbusFrame* pxFrame);
+void S2LP_WMBUS_LL_Release(void);
+int32_t S2LP_WMBUS_LL_Send(const uint8_t* pcTelegram, uint16_t nLength);
+uint8_t S2LP_WMBUS_LL_Busy(void);
+void S2LP_WMBUS_LL_GetStats(WMbusStats* pxStats);
+
+/**
+ *@}
+ */
+
+/**
+ *@}
+ */
+
+
+/**
+ *@}
+ */
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+/******************* (C) COPYRIGHT 2019 STMicroelectronics *****END OF FILE****/
@@ -30,6 +30,10 @@
 #include "s2868a1_conf.h"
 #include "s2lp.h"
 
+#ifndef S2868A1_USE_SPI_DMA
+#define S2868A1_USE_SPI_DMA                             0
+#endif
+
    
 /** 
   * @brief Define for SX1276MB1XAS board  
@@ -276,11 +280,18 @@ int32_t S2868A1_EEPROM_Init(uint32_t Instance);
   */
 int32_t S2868A1_EEPROM_DeInit(uint32_t Instance);
 
-uint8_t BSP_EEPROM_SetSrwd(uint32_t Instance);
+uint8_t S2868A1_EEPROM_SetSrwd(uint32_t Instance);
 
-uint8_t BSP_EEPROM_ResetSrwd(uint32_t Instance);
+uint8_t S2868A1_EEPROM_ResetSrwd(uint32_t Instance);
 
-int32_t BSP_EEPROM_WriteEnable(uint32_t Instance);
+int32_t S2868A1_EEPROM_WriteEnable(uint32_t Instance);
+
+/* Former names, for the applications with a single expansion board */
+#ifndef BSP_EEPROM_SetSrwd
+#define BSP_EEPROM_SetSrwd            S2868A1_EEPROM_SetSrwd
+#define BSP_EEPROM_ResetSrwd          S2868A1_EEPROM_ResetSrwd
+#define BSP_EEPROM_WriteEnable        S2868A1_EEPROM_WriteEnable
+#endif
 
 /**
   * @brief  EEPROM Write Page.
@@ -313,6 +324,14 @@ int32_t S2868A1_EEPROM_IsReady(uint32_t Instance);
   */
 void S2868A1_RADIO_GPIO_Init( S2868A1_RADIO_GPIO_TypeDef xGpio, S2868A1_RADIO_GPIO_Mode xGpioMode , S2868A1_RADIO_GPIO_EDGE_Mode xGpioEdge); 
 
+#if (S2868A1_USE_SPI_DMA == 1)
+/**
+  * @brief  End of a radio SPI DMA transfer, to be called from HAL_SPI_TxRxCpltCallback
+  * @retval None
+  */
+void S2868A1_SPI_DMA_TxRxCplt(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
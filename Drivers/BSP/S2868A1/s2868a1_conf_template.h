@@ -31,6 +31,7 @@
 /* Global configuration ---------------------------------------------------*/   
 #define S2868A1_USE_EEPROM                         0
 #define S2868A1_USE_WMBUS                          1
+#define S2868A1_USE_SPI_DMA                        0
                                 
 /* Defines ---------------------------------------------------------------*/
 #define S2868A1_RADIO_GPIO_0_IT_PRIO                        0
@@ -45,6 +46,7 @@
 #define S2868A1_SPI_Init                          BSP_SPI1_Init
 #define S2868A1_SPI_DeInit                        BSP_SPI1_DeInit
 #define S2868A1_SPI_SendRecv                      BSP_SPI1_SendRecv
+#define S2868A1_SPI_SendRecv_DMA                  BSP_SPI1_SendRecv_DMA
 
 /* SPIx Bus Pin mapping */ 
 #define S2868A1_RADIO_SPI_NSS_CLK_ENABLE()                    __HAL_RCC_GPIOA_CLK_ENABLE()
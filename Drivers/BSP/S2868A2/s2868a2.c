@@ -20,6 +20,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "s2868a2.h"
 #include "s2lp.h"
+#include <string.h>
     
 /* Private typedef -----------------------------------------------------------*/
 /* Private define ------------------------------------------------------------*/
@@ -27,10 +28,18 @@
     
 /* Private macro -------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
-volatile int irq_disable_cnt = 0;
+/* Header and payload of a radio access, clocked out with a single SPI transfer */
+static uint8_t aSpiBuffer[S2LP_CMD_SIZE + S2LP_BUF_SIZE];
+#if (S2868A2_USE_SPI_DMA == 1)
+static volatile uint8_t SpiDmaBusy = 0;
+static uint8_t *pSpiDmaBuff;
+static uint16_t SpiDmaLength;
+static S2LPBus_Callback SpiDmaCallback;
+#endif
+volatile int S2868A2_irq_disable_cnt = 0;
 
-GPIO_TypeDef*  aLED_GPIO_PORT[S2868A2_LEDn] = {S2868A2_LED_GPIO_PORT};
-const uint16_t aLED_GPIO_PIN[S2868A2_LEDn] = {S2868A2_LED_GPIO_PIN};
+static GPIO_TypeDef*  aLED_GPIO_PORT[S2868A2_LEDn] = {S2868A2_LED_GPIO_PORT};
+static const uint16_t aLED_GPIO_PIN[S2868A2_LEDn] = {S2868A2_LED_GPIO_PIN};
 
 EXTI_HandleTypeDef S2868A2_RADIO_GPIO_hexti[S2868A2_RADIO_GPIOn - 1] = {
 #if (USE_S2868A2_RADIO_GPIO_0 == 1) 
@@ -129,6 +138,9 @@ static const uint16_t S2868A2_RADIO_GPIO_PIN[S2868A2_RADIO_GPIOn] = {
 static void S2868A2_SPI_CS_Init(void);
 static void GPIO_DeInit(void);
 static int32_t S2868A2_SPI_SendRecvWrapper(uint8_t *pTxData, uint8_t *pRxData, uint16_t Length);
+#if (S2868A2_USE_SPI_DMA == 1)
+static int32_t S2868A2_SPI_SendRecvWrapper_DMA(uint8_t *pHeader, uint8_t *pBuff, uint16_t Length, S2LPBus_Callback Callback);
+#endif
 static int32_t EEPROM_WaitEndWriteOperation(uint32_t Instance);
 
 /* Exported functions ---------------------------------------------------------*/
@@ -258,12 +270,38 @@ static void S2868A2_SPI_CS_Init()
 int32_t S2868A2_SPI_SendRecvWrapper(uint8_t *pHeader, uint8_t *pBuff, uint16_t Length)
 {
   int32_t status;
+#if (S2868A2_USE_SPI_DMA == 1)
+  /* A FIFO transfer started by S2868A2_SPI_SendRecvWrapper_DMA still owns the bus.
+   * Its completion IRQ cannot preempt an ISR of the same priority: there the
+   * access is refused instead of waited for */
+  if(SpiDmaBusy && (__get_IPSR() != 0U))
+  {
+    return S2868A2_ERROR_BUS_FAILURE;
+  }
+  while(SpiDmaBusy);
+#endif
   S2868A2_ENTER_CRITICAL();
   S2868A2_RADIO_SPI_NSS_PIN_LOW();
-  status = S2868A2_SPI_SendRecv ( pHeader, pHeader, 2 );
-  if (!status)
+  if(Length <= S2LP_BUF_SIZE)
   {
+    aSpiBuffer[0] = pHeader[0];
+    aSpiBuffer[1] = pHeader[1];
     if(Length)
+    {
+      memcpy(&aSpiBuffer[S2LP_CMD_SIZE], pBuff, Length);
+    }
+    status = S2868A2_SPI_SendRecv( aSpiBuffer, aSpiBuffer, S2LP_CMD_SIZE + Length );
+    pHeader[0] = aSpiBuffer[0];
+    pHeader[1] = aSpiBuffer[1];
+    if(Length)
+    {
+      memcpy(pBuff, &aSpiBuffer[S2LP_CMD_SIZE], Length);
+    }
+  }
+  else
+  {
+    status = S2868A2_SPI_SendRecv( pHeader, pHeader, S2LP_CMD_SIZE );
+    if (!status)
     {
       status = S2868A2_SPI_SendRecv( pBuff, pBuff, Length );
     }
@@ -273,6 +311,74 @@ int32_t S2868A2_SPI_SendRecvWrapper(uint8_t *pHeader, uint8_t *pBuff, uint16_t L
   return status;  
 }
 
+#if (S2868A2_USE_SPI_DMA == 1)
+/**
+  * @brief  Non-blocking wrapper Function for S2868A2 SPI.
+  *         The radio IRQ stays masked until S2868A2_SPI_DMA_TxRxCplt closes the transfer.
+  * @param  pHeader is the header to send, copied before the call returns:
+  *         its status bytes are not returned
+  * @param  pBuff is the buffer to write/read, valid up to the callback
+  * @param  Length of data to be read, up to S2LP_BUF_SIZE
+  * @param  Callback called at the end of the transfer, can be NULL
+  * @retval 0 if the transfer has been started, an error if the previous one
+  *         is still running and the caller is an ISR
+  */
+int32_t S2868A2_SPI_SendRecvWrapper_DMA(uint8_t *pHeader, uint8_t *pBuff, uint16_t Length, S2LPBus_Callback Callback)
+{
+  int32_t status;
+  
+  if(Length > S2LP_BUF_SIZE)
+  {
+    return S2868A2_ERROR_FEATURE_NOT_SUPPORTED;
+  }
+  if(SpiDmaBusy && (__get_IPSR() != 0U))
+  {
+    return S2868A2_ERROR_BUS_FAILURE;
+  }
+  while(SpiDmaBusy);
+  S2868A2_ENTER_CRITICAL();
+  SpiDmaBusy = 1;
+  pSpiDmaBuff = pBuff;
+  SpiDmaLength = Length;
+  SpiDmaCallback = Callback;
+  aSpiBuffer[0] = pHeader[0];
+  aSpiBuffer[1] = pHeader[1];
+  memcpy(&aSpiBuffer[S2LP_CMD_SIZE], pBuff, Length);
+  S2868A2_RADIO_SPI_NSS_PIN_LOW();
+  status = S2868A2_SPI_SendRecv_DMA( aSpiBuffer, aSpiBuffer, S2LP_CMD_SIZE + Length );
+  if(status)
+  {
+    S2868A2_RADIO_SPI_NSS_PIN_HIGH();
+    SpiDmaBusy = 0;
+    S2868A2_EXIT_CRITICAL();
+  }
+  return status;
+}
+
+/**
+  * @brief  End of a S2868A2_SPI_SendRecvWrapper_DMA transfer.
+  *         To be called from the SPI TxRx complete callback.
+  * @retval None
+  */
+void S2868A2_SPI_DMA_TxRxCplt(void)
+{
+  S2LPBus_Callback Callback = SpiDmaCallback;
+  
+  if(!SpiDmaBusy)
+  {
+    return;
+  }
+  S2868A2_RADIO_SPI_NSS_PIN_HIGH();
+  memcpy(pSpiDmaBuff, &aSpiBuffer[S2LP_CMD_SIZE], SpiDmaLength);
+  SpiDmaBusy = 0;
+  S2868A2_EXIT_CRITICAL();
+  if(Callback != NULL)
+  {
+    Callback();
+  }
+}
+#endif /*S2868A2_USE_SPI_DMA*/
+
 /**
 * @brief  Wait polling the SPI until the internal WIP flag is RESET.
 *         The flag is SET when a write operation is running.
@@ -390,6 +496,9 @@ int32_t S2868A2_RADIO_Init( void )
    IOCtx.Delay = S2868A2_Delay;
    
    S2LP_RegisterBusIO(&IOCtx);
+#if (S2868A2_USE_SPI_DMA == 1)
+   S2LP_RegisterBusIOAsync(S2868A2_SPI_SendRecvWrapper_DMA);
+#endif
    S2868A2_RADIO_GPIO_Init(S2868A2_RADIO_GPIO_SDN, RADIO_MODE_GPIO_OUT, DEFAULT);
    S2868A2_SPI_CS_Init();
    S2868A2_RADIO_GPIO_Init(S2868A2_RADIO_GPIO, RADIO_MODE_EXTI_IN, FALLING);
@@ -568,7 +677,7 @@ int32_t  S2868A2_EEPROM_DeInit(uint32_t Instance)
 * @param  None
 * @retval Status
 */
-uint8_t BSP_EEPROM_SetSrwd(uint32_t Instance)
+uint8_t S2868A2_EEPROM_SetSrwd(uint32_t Instance)
 {
   uint8_t status[2];
   uint8_t cmd[] = {EEPROM_CMD_WRSR, EEPROM_STATUS_SRWD};
@@ -590,12 +699,12 @@ uint8_t BSP_EEPROM_SetSrwd(uint32_t Instance)
 * @param  None
 * @retval Status
 */
-uint8_t BSP_EEPROM_ResetSrwd(uint32_t Instance)
+uint8_t S2868A2_EEPROM_ResetSrwd(uint32_t Instance)
 {
   uint8_t status[2];
   uint8_t cmd[] = {EEPROM_CMD_WRSR, 0};
   
-  BSP_EEPROM_WriteEnable(Instance);
+  S2868A2_EEPROM_WriteEnable(Instance);
   EEPROM_WaitEndWriteOperation(Instance);
   /* Put the SPI chip select low to start the transaction */
   EEPROM_NSS_PIN_LOW();
@@ -615,7 +724,7 @@ uint8_t BSP_EEPROM_ResetSrwd(uint32_t Instance)
 * @param  None
 * @retval None
 */
-int32_t BSP_EEPROM_WriteEnable(uint32_t Instance)
+int32_t S2868A2_EEPROM_WriteEnable(uint32_t Instance)
 {
   UNUSED(Instance); 
   uint8_t cmd = EEPROM_CMD_WREN;
@@ -658,7 +767,7 @@ int32_t S2868A2_EEPROM_WritePage(uint32_t Instance, uint16_t nAddress, uint16_t
   EEPROM_WaitEndWriteOperation(Instance);
   
   /* SET the WREN flag */
-  BSP_EEPROM_WriteEnable(Instance);
+  S2868A2_EEPROM_WriteEnable(Instance);
   
    for(uint8_t k=0; k<2; k++) {
     address[k] = (uint8_t)(nAddress>>((1-k)*8));
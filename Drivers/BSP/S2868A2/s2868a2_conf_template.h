@@ -30,6 +30,7 @@
 /* Global configuration ---------------------------------------------------*/   
 #define S2868A2_USE_EEPROM                         0
 #define S2868A2_USE_WMBUS                          1
+#define S2868A2_USE_SPI_DMA                        0
                                 
 /* Defines ---------------------------------------------------------------*/
 #define S2868A2_RADIO_GPIO_0_IT_PRIO                        0
@@ -44,6 +45,7 @@
 #define S2868A2_SPI_Init                          BSP_SPI1_Init
 #define S2868A2_SPI_DeInit                        BSP_SPI1_DeInit
 #define S2868A2_SPI_SendRecv                      BSP_SPI1_SendRecv
+#define S2868A2_SPI_SendRecv_DMA                  BSP_SPI1_SendRecv_DMA
 
 /* SPIx Bus Pin mapping */ 
 #define S2868A2_RADIO_SPI_NSS_CLK_ENABLE()                    __HAL_RCC_GPIOA_CLK_ENABLE()
@@ -30,6 +30,10 @@
 #include "s2915a1_conf.h"
 #include "s2lp.h"
 
+#ifndef S2915A1_USE_SPI_DMA
+#define S2915A1_USE_SPI_DMA                             0
+#endif
+
 /** 
   * @brief Define for SX1276MB1XAS board  
   */ 
@@ -281,11 +285,18 @@ int32_t S2915A1_EEPROM_Init(uint32_t Instance);
   */
 int32_t S2915A1_EEPROM_DeInit(uint32_t Instance);
 
-uint8_t BSP_EEPROM_SetSrwd(uint32_t Instance);
+uint8_t S2915A1_EEPROM_SetSrwd(uint32_t Instance);
 
-uint8_t BSP_EEPROM_ResetSrwd(uint32_t Instance);
+uint8_t S2915A1_EEPROM_ResetSrwd(uint32_t Instance);
 
-int32_t BSP_EEPROM_WriteEnable(uint32_t Instance);
+int32_t S2915A1_EEPROM_WriteEnable(uint32_t Instance);
+
+/* Former names, for the applications with a single expansion board */
+#ifndef BSP_EEPROM_SetSrwd
+#define BSP_EEPROM_SetSrwd            S2915A1_EEPROM_SetSrwd
+#define BSP_EEPROM_ResetSrwd          S2915A1_EEPROM_ResetSrwd
+#define BSP_EEPROM_WriteEnable        S2915A1_EEPROM_WriteEnable
+#endif
 
 /**
   * @brief  EEPROM Write Page.
@@ -352,6 +363,14 @@ void S2915A1_FEM_SetBypass(uint8_t bypass_mode);
   */
 uint8_t S2915A1_FEM_GetBypass(void);
 
+#if (S2915A1_USE_SPI_DMA == 1)
+/**
+  * @brief  End of a radio SPI DMA transfer, to be called from HAL_SPI_TxRxCpltCallback
+  * @retval None
+  */
+void S2915A1_SPI_DMA_TxRxCplt(void);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
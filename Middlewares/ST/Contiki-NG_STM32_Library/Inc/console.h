@@ -28,6 +28,24 @@
 /* Exported functions ------------------------------------------------------- */
 uint8_t uart_send_char(uint8_t ch);
 
+uint8_t uart_queue_char(uint8_t ch);
+
+void uart_send_urgent(uint8_t ch);
+
+uint16_t uart_send(const uint8_t *buf, uint16_t len);
+
+void uart_rx_start(void);
+
+uint32_t uart_tx_dropped(void);
+
+void uart_tx_flow_control(uint8_t enable);
+
+void uart_tx_pause(uint8_t pause);
+
+uint8_t uart_tx_idle(void);
+
+void uart_set_baudrate(uint32_t baudrate);
+
 uint8_t uart_receive_char(void);
 #endif /*CONSOLE_H_*/
 
@@ -24,6 +24,11 @@
 #include "contiki-conf.h"
 #include "dev/leds.h"
 #include "main.h"
+#if MCU_LOW_POWER
+#include "sys/etimer.h"
+#include "sys/energest.h"
+#include "sys/int-master.h"
+#endif /*MCU_LOW_POWER*/
 
 /** @defgroup clock
 * @ingroup Contiki-NG_STM32_Library
@@ -37,13 +42,44 @@
 
 /* Private typedef -----------------------------------------------------------*/
 /* Private defines -----------------------------------------------------------*/
+#if MCU_LOW_POWER
+/* The RTC calendar measures the time spent in STOP mode: its sub-second
+ * counter runs at RTCCLK / (CLOCK_RTC_ASYNCH_PREDIV + 1), about 4 kHz */
+#define CLOCK_RTC_ASYNCH_PREDIV   7U
+/* The wake-up timer counts RTCCLK / 16 on 16 bits: up to 32 s of STOP */
+#define CLOCK_WAKEUP_DIV          16U
+#define CLOCK_WAKEUP_MAX          0x10000U
+/* Below this, restarting the PLL costs more than it saves: plain SLEEP */
+#define CLOCK_STOP_MIN_TICKS      ((clock_time_t)3)
+#define CLOCK_RTC_DAY             86400U
+/* LSI calibration: the RTC counts measured over this many SysTick ticks */
+#define CLOCK_RTC_CAL_TICKS       ((clock_time_t)(CLOCK_SECOND / 4))
+#endif /*MCU_LOW_POWER*/
 /* Private macros ------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+#if MCU_LOW_POWER
+static uint32_t rtc_clock_hz;   /* RTCCLK, measured when it is the LSI */
+static uint32_t rtc_count_hz;   /* sub-second counts per second */
+static uint32_t rtc_count_mod;  /* sub-second counts per calendar second */
+static uint32_t rtc_remainder;  /* STOP time not yet in ticks, in counts * CLOCK_SECOND */
+static uint32_t rtimer_remainder; /* and in rtimer ticks, in counts * RTIMER_ARCH_SECOND */
+#endif /*MCU_LOW_POWER*/
 /* Global variables ----------------------------------------------------------*/
 /* MISRA C-2012 Dir-4.6_a violation for purpose: Contiki-NG API */
 volatile unsigned long seconds;
 volatile clock_time_t ticks;
+#if MCU_LOW_POWER
+extern RTC_HandleTypeDef hrtc;
+extern TIM_HandleTypeDef contiki_rtimer;
+#endif /*MCU_LOW_POWER*/
 /* Private function prototypes -----------------------------------------------*/
+#if MCU_LOW_POWER
+void SystemClock_Config(void);
+static void clock_rtc_init(void);
+static uint32_t clock_rtc_read(void);
+static uint32_t clock_rtc_calibrate(void);
+static void clock_advance(uint32_t rtc_counts);
+#endif /*MCU_LOW_POWER*/
 /* Functions Definition ------------------------------------------------------*/
 /**
  * @brief  clock_init
@@ -57,6 +93,9 @@ void clock_init(void)
   seconds = 0;
   HAL_SYSTICK_CLKSourceConfig(SYSTICK_CLKSOURCE_HCLK);
   (void) HAL_SYSTICK_Config(HAL_RCC_GetHCLKFreq()/((uint32_t)CLOCK_SECOND));
+#if MCU_LOW_POWER
+  clock_rtc_init();
+#endif /*MCU_LOW_POWER*/
 }
 /*---------------------------------------------------------------------------*/
 /**
@@ -117,9 +156,189 @@ void clock_wait(clock_time_t t)
   clock_time_t start;
   start = clock_time();
   while((clock_time() - start) < (clock_time_t)t ){
+    /* Woken up by the next SysTick at the latest */
+    __WFI();
   }
 }
 /*---------------------------------------------------------------------------*/
+#if MCU_LOW_POWER
+/**
+ * @brief  clock_rtc_init
+ * 		sets the RTC prescalers for a fine sub-second counter and enables
+ * 		the wake-up timer interrupt. An LSI RTCCLK is measured against the
+ * 		SysTick, the LSI being only specified within 17 to 47 kHz
+ * @param  none
+ * @retval none
+ */
+static void clock_rtc_init(void)
+{
+  if(__HAL_RCC_GET_RTC_SOURCE() == RCC_RTCCLKSOURCE_LSE) {
+    rtc_clock_hz = LSE_VALUE;
+  } else {
+    rtc_clock_hz = LSI_VALUE;
+  }
+  hrtc.Init.AsynchPrediv = CLOCK_RTC_ASYNCH_PREDIV;
+  hrtc.Init.SynchPrediv = (rtc_clock_hz / (CLOCK_RTC_ASYNCH_PREDIV + 1U)) - 1U;
+  rtc_count_mod = hrtc.Init.SynchPrediv + 1U;
+  rtc_count_hz = rtc_count_mod;
+  rtc_remainder = 0;
+  rtimer_remainder = 0;
+  if(HAL_RTC_Init(&hrtc) != HAL_OK) {
+    Error_Handler();
+  }
+  if(__HAL_RCC_GET_RTC_SOURCE() != RCC_RTCCLKSOURCE_LSE) {
+    rtc_count_hz = clock_rtc_calibrate();
+    rtc_clock_hz = rtc_count_hz * (CLOCK_RTC_ASYNCH_PREDIV + 1U);
+  }
+  HAL_NVIC_SetPriority(RTC_WKUP_IRQn, 0, 0);
+  HAL_NVIC_EnableIRQ(RTC_WKUP_IRQn);
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * @brief  clock_rtc_read
+ * 		reads the RTC calendar
+ * @param  none
+ * @retval uint32_t time of the day in sub-second counts
+ */
+static uint32_t clock_rtc_read(void)
+{
+  RTC_TimeTypeDef time;
+  RTC_DateTypeDef date;
+
+  (void) HAL_RTC_GetTime(&hrtc, &time, RTC_FORMAT_BIN);
+  /* Reading the date unlocks the shadow registers */
+  (void) HAL_RTC_GetDate(&hrtc, &date, RTC_FORMAT_BIN);
+
+  return ((((uint32_t)time.Hours * 60U) + time.Minutes) * 60U + time.Seconds) * rtc_count_mod
+         + (hrtc.Init.SynchPrediv - time.SubSeconds);
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * @brief  clock_rtc_calibrate
+ * 		counts the RTC sub-second ticks during CLOCK_RTC_CAL_TICKS SysTick
+ * 		periods, started on a SysTick edge. The SysTick runs from the HSI
+ * 		(1 % accuracy), the result is within 0.2 % of it. The LSI still
+ * 		drifts with the temperature and the supply after this measurement
+ * @param  none
+ * @retval uint32_t sub-second counts per second
+ */
+static uint32_t clock_rtc_calibrate(void)
+{
+  clock_time_t start_ticks;
+  uint32_t start;
+  uint32_t counts;
+
+  start_ticks = ticks;
+  while(ticks == start_ticks) {
+  }
+  start_ticks = ticks;
+  start = clock_rtc_read();
+  while((clock_time_t)(ticks - start_ticks) < CLOCK_RTC_CAL_TICKS) {
+  }
+  counts = (clock_rtc_read() + (CLOCK_RTC_DAY * rtc_count_mod) - start) % (CLOCK_RTC_DAY * rtc_count_mod);
+
+  return (uint32_t)(((uint64_t)counts * CLOCK_SECOND) / CLOCK_RTC_CAL_TICKS);
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * @brief  clock_advance
+ * 		adds the time spent in STOP mode to the Contiki-NG clock, the HAL
+ * 		tick and the rtimer, whose timer did not count meanwhile
+ * @param  uint32_t rtc_counts time in sub-second counts
+ * @retval none
+ */
+static void clock_advance(uint32_t rtc_counts)
+{
+  clock_time_t old_ticks = ticks;
+  clock_time_t elapsed;
+  clock_time_t next;
+  uint64_t rtimer_elapsed;
+
+  rtc_remainder += rtc_counts * (uint32_t)CLOCK_SECOND;
+  elapsed = rtc_remainder / rtc_count_hz;
+  rtc_remainder -= elapsed * rtc_count_hz;
+
+  ticks += elapsed;
+  seconds += (ticks / CLOCK_SECOND) - (old_ticks / CLOCK_SECOND);
+  uwTick += elapsed * (uint32_t)uwTickFreq;
+  rtimer_elapsed = ((uint64_t)rtc_counts * RTIMER_ARCH_SECOND) + rtimer_remainder;
+  rtimer_remainder = (uint32_t)(rtimer_elapsed % rtc_count_hz);
+  __HAL_TIM_SET_COUNTER(&contiki_rtimer, __HAL_TIM_GET_COUNTER(&contiki_rtimer)
+                        + (uint32_t)(rtimer_elapsed / rtc_count_hz));
+
+  next = etimer_next_expiration_time();
+  if(etimer_pending() && ((int32_t)(ticks - next) >= 0)) {
+    etimer_request_poll();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+ * @brief  clock_arch_idle
+ * 		tickless idle: stops the MCU (STOP mode, SysTick off) until the next
+ * 		etimer expiration, programmed on the RTC wake-up timer, or an EXTI
+ * 		interrupt (radio, button), then corrects the clock. Falls back to
+ * 		SLEEP when an rtimer is scheduled or the next etimer is too close.
+ * 		The caller makes sure no peripheral needing its clock is busy.
+ * @param  none
+ * @retval none
+ */
+void clock_arch_idle(void)
+{
+  int_master_status_t status;
+  clock_time_t idle = ((CLOCK_WAKEUP_MAX - 1U) / (rtc_clock_hz / CLOCK_WAKEUP_DIV)) * (uint32_t)CLOCK_SECOND;
+  uint32_t wakeup;
+  uint32_t start;
+  uint32_t elapsed;
+
+  status = int_master_read_and_disable();
+  if(process_nevents() > 0) {
+    int_master_status_set(status);
+    return;
+  }
+  if(etimer_pending()) {
+    idle = etimer_next_expiration_time() - ticks;
+    if((int32_t)idle <= 0) {
+      etimer_request_poll();
+      int_master_status_set(status);
+      return;
+    }
+  }
+  if((idle < CLOCK_STOP_MIN_TICKS)
+     || ((__HAL_TIM_GET_IT_SOURCE(&contiki_rtimer, TIM_IT_CC1) != RESET)
+         && ((int32_t)(__HAL_TIM_GET_COMPARE(&contiki_rtimer, TIM_CHANNEL_1)
+                       - __HAL_TIM_GET_COUNTER(&contiki_rtimer)) > 0))) {
+    /* The pending interrupt wakes the core and runs once enabled */
+    __WFI();
+    int_master_status_set(status);
+    return;
+  }
+
+  wakeup = (uint32_t)(((uint64_t)idle * (rtc_clock_hz / CLOCK_WAKEUP_DIV)) / CLOCK_SECOND);
+  if(wakeup > CLOCK_WAKEUP_MAX) {
+    wakeup = CLOCK_WAKEUP_MAX;
+  }
+  start = clock_rtc_read();
+  (void) HAL_RTCEx_SetWakeUpTimer_IT(&hrtc, wakeup - 1U, RTC_WAKEUPCLOCK_RTCCLK_DIV16);
+  HAL_SuspendTick();
+  ENERGEST_SWITCH(ENERGEST_TYPE_CPU, ENERGEST_TYPE_DEEP_LPM);
+
+  HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+
+  /* Back on the reset clock: restore the PLL before anything else */
+  SystemClock_Config();
+  (void) HAL_RTCEx_DeactivateWakeUpTimer(&hrtc);
+  /* The calendar shadow registers are stale after STOP */
+  __HAL_RTC_WRITEPROTECTION_DISABLE(&hrtc);
+  (void) HAL_RTC_WaitForSynchro(&hrtc);
+  __HAL_RTC_WRITEPROTECTION_ENABLE(&hrtc);
+  elapsed = clock_rtc_read() + (CLOCK_RTC_DAY * rtc_count_mod) - start;
+  clock_advance(elapsed % (CLOCK_RTC_DAY * rtc_count_mod));
+  ENERGEST_SWITCH(ENERGEST_TYPE_DEEP_LPM, ENERGEST_TYPE_CPU);
+  HAL_ResumeTick();
+  int_master_status_set(status);
+}
+#endif /*MCU_LOW_POWER*/
+/*---------------------------------------------------------------------------*/
 /**
 * @}
 */
@@ -20,42 +20,411 @@
 /* Includes ------------------------------------------------------------------*/
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include "console.h"
 #include "main.h"
 #include "subg2_bsp_ip_conf.h"
+#if (USE_BSP_COM1_DMA == 1U)
+#include "contiki-platform.h"
+#endif /*USE_BSP_COM1_DMA*/
 /* Private typedef -----------------------------------------------------------*/
 /* Private defines -----------------------------------------------------------*/
+#if (USE_BSP_COM1_DMA == 1U)
+/* Large enough for a 1280 bytes IPv6 packet once SLIP escaped */
+#ifndef UART_TX_BUFFER_SIZE
+#define UART_TX_BUFFER_SIZE    2048U
+#endif /*UART_TX_BUFFER_SIZE*/
+/* The DMA interrupts every half buffer: input_handler has to keep up with
+ * UART_RX_BUFFER_SIZE/2 characters */
+#ifndef UART_RX_BUFFER_SIZE
+#define UART_RX_BUFFER_SIZE    256U
+#endif /*UART_RX_BUFFER_SIZE*/
+/* With flow control, the longest DMA transfer: what still leaves after XOFF */
+#ifndef UART_TX_FLOW_CHUNK
+#define UART_TX_FLOW_CHUNK     128U
+#endif /*UART_TX_FLOW_CHUNK*/
+#endif /*USE_BSP_COM1_DMA*/
 /* Private macros ------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+#if (USE_BSP_COM1_DMA == 1U)
+static uint8_t tx_buffer[UART_TX_BUFFER_SIZE];
+static volatile uint16_t tx_head;     /* first free byte */
+static volatile uint16_t tx_tail;     /* first byte not sent yet */
+static volatile uint16_t tx_dma_len;  /* bytes of the running transfer, 0 if idle */
+static volatile uint32_t tx_dropped;
+static uint16_t tx_dma_max = UART_TX_BUFFER_SIZE;
+static uint8_t rx_buffer[UART_RX_BUFFER_SIZE];
+static uint16_t rx_read;              /* first byte not consumed yet */
+static uint8_t tx_urgent;             /* uart_send_urgent, ahead of the ring */
+static uint8_t tx_urgent_dma;         /* copy the DMA reads */
+static volatile uint8_t tx_urgent_pending;
+static volatile uint8_t tx_dma_urgent; /* the running transfer is tx_urgent_dma */
+#endif /*USE_BSP_COM1_DMA*/
+static volatile uint8_t tx_paused;
 /* Global variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
 /* Functions Definition ------------------------------------------------------*/
 
+#if (USE_BSP_COM1_DMA == 1U)
+/** @brief Starts the DMA on the bytes queued, if it is idle.
+ *         A character of uart_send_urgent goes first, even when paused.
+ *         The part of the ring up to its end or to the head is sent at once,
+ *         the rest by HAL_UART_TxCpltCallback. Called with the IRQs disabled.
+ * @retval None
+ */
+static void uart_tx_start(void)
+{
+  uint16_t len;
+
+  if((tx_dma_len != 0U) || (tx_dma_urgent != 0U)) {
+    return;
+  }
+  if(tx_urgent_pending != 0U) {
+    tx_urgent_pending = 0U;
+    tx_urgent_dma = tx_urgent;
+    tx_dma_urgent = 1U;
+    if(HAL_UART_Transmit_DMA(&UartHandle, &tx_urgent_dma, 1U) != HAL_OK) {
+      tx_dma_urgent = 0U;
+      tx_urgent_pending = 1U;
+    }
+    return;
+  }
+  if((tx_head == tx_tail) || (tx_paused != 0U)) {
+    return;
+  }
+  len = (tx_head > tx_tail) ? (tx_head - tx_tail) : (UART_TX_BUFFER_SIZE - tx_tail);
+  if(len > tx_dma_max) {
+    len = tx_dma_max;
+  }
+  tx_dma_len = len;
+  if(HAL_UART_Transmit_DMA(&UartHandle, &tx_buffer[tx_tail], len) != HAL_OK) {
+    /* Retried by the next send */
+    tx_dma_len = 0U;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Copies characters to the TX ring.
+ *         When the ring is full the caller waits for the DMA to free some
+ *         space, unless it runs in an ISR or with the IRQs disabled: the
+ *         characters left are then dropped.
+ * @param buf Characters to send
+ * @param len Number of characters
+ * @param start Start the DMA once the characters are queued
+ * @retval Number of characters queued
+ */
+static uint16_t uart_queue(const uint8_t *buf, uint16_t len, uint8_t start)
+{
+  uint16_t done = 0U;
+  uint16_t room;
+  uint32_t primask;
+
+  while(done < len) {
+    primask = __get_PRIMASK();
+    __disable_irq();
+    room = (uint16_t) ((tx_tail + UART_TX_BUFFER_SIZE - tx_head - 1U) % UART_TX_BUFFER_SIZE);
+    if(room == 0U) {
+      uart_tx_start();
+      __set_PRIMASK(primask);
+      if((primask != 0U) || (__get_IPSR() != 0U)) {
+        tx_dropped += (uint32_t) (len - done);
+        break;
+      }
+      continue;
+    }
+    if(room > (len - done)) {
+      room = len - done;
+    }
+    if(room > (UART_TX_BUFFER_SIZE - tx_head)) {
+      room = UART_TX_BUFFER_SIZE - tx_head;
+    }
+    memcpy(&tx_buffer[tx_head], &buf[done], room);
+    tx_head = (uint16_t) ((tx_head + room) % UART_TX_BUFFER_SIZE);
+    done += room;
+    if(start != 0U) {
+      uart_tx_start();
+    }
+    __set_PRIMASK(primask);
+  }
+  return done;
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Position of the DMA in the RX ring, read from its counter: HT, TC
+ *         and idle line events may come in any order around the end of the ring.
+ * @retval First byte the DMA has not written yet
+ */
+static uint16_t uart_rx_pos(void)
+{
+  return (uint16_t) ((UART_RX_BUFFER_SIZE -
+                      __HAL_DMA_GET_COUNTER(UartHandle.hdmarx)) % UART_RX_BUFFER_SIZE);
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Gives input_handler the characters the DMA wrote since the last call.
+ *         Without input_handler they stay in the ring for uart_receive_char.
+ * @retval None
+ */
+static void uart_rx_poll(void)
+{
+  uint16_t pos = uart_rx_pos();
+
+  if(input_handler == NULL) {
+    return;
+  }
+  while(rx_read != pos) {
+    (void) input_handler(rx_buffer[rx_read]);
+    rx_read = (uint16_t) ((rx_read + 1U) % UART_RX_BUFFER_SIZE);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Starts the reception: the DMA fills the RX ring in circular mode,
+ *         its half/full transfer and the idle line of the UART hand the
+ *         characters to input_handler.
+ * @retval None
+ */
+void uart_rx_start(void)
+{
+  rx_read = 0U;
+  (void) HAL_UARTEx_ReceiveToIdle_DMA(&UartHandle, rx_buffer, UART_RX_BUFFER_SIZE);
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Number of characters dropped because the TX ring was full
+ * @retval Characters dropped since reset
+ */
+uint32_t uart_tx_dropped(void)
+{
+  return tx_dropped;
+}
+/*---------------------------------------------------------------------------*/
+/** @brief UART transmission complete: the next part of the ring follows
+ * @param huart UART handle
+ * @retval None
+ */
+void HAL_UART_TxCpltCallback(UART_HandleTypeDef *huart)
+{
+  if(huart == &UartHandle) {
+    if(tx_dma_urgent != 0U) {
+      tx_dma_urgent = 0U;
+    } else {
+      tx_tail = (uint16_t) ((tx_tail + tx_dma_len) % UART_TX_BUFFER_SIZE);
+      tx_dma_len = 0U;
+    }
+    uart_tx_start();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Half buffer, full buffer or idle line on the reception
+ * @param huart UART handle
+ * @param Size Position in the ring, unused: see uart_rx_poll
+ * @retval None
+ */
+void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t Size)
+{
+  UNUSED(Size);
+  if(huart == &UartHandle) {
+    uart_rx_poll();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** @brief UART error. With the DMA, an overrun or a framing/noise error
+ *         aborts the reception, that is restarted here; an aborted
+ *         transmission is sent again.
+ * @param huart UART handle
+ * @retval None
+ */
+void HAL_UART_ErrorCallback(UART_HandleTypeDef *huart)
+{
+  if(huart != &UartHandle) {
+    return;
+  }
+  if(huart->RxState == HAL_UART_STATE_READY) {
+    /* The counter still tells what was received before the error */
+    uart_rx_poll();
+    uart_rx_start();
+  }
+  if((huart->gState == HAL_UART_STATE_READY) &&
+     ((tx_dma_len != 0U) || (tx_dma_urgent != 0U))) {
+    if(tx_dma_urgent != 0U) {
+      tx_dma_urgent = 0U;
+      tx_urgent_pending = 1U;
+    }
+    tx_dma_len = 0U;
+    uart_tx_start();
+  }
+}
+/*---------------------------------------------------------------------------*/
+#endif /*USE_BSP_COM1_DMA*/
+
+/** @brief Enables the flow control of the transmission (uart_tx_pause).
+ *         With the DMA, the transfers are then shortened so that little
+ *         is still sent once the peer asked to stop.
+ * @param enable 1 to enable, 0 to disable
+ * @retval None
+ */
+void uart_tx_flow_control(uint8_t enable)
+{
+#if (USE_BSP_COM1_DMA == 1U)
+  tx_dma_max = (enable != 0U) ? UART_TX_FLOW_CHUNK : UART_TX_BUFFER_SIZE;
+#endif /*USE_BSP_COM1_DMA*/
+  if(enable == 0U) {
+    uart_tx_pause(0U);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Suspends or resumes the transmission, as asked by the peer (XOFF,
+ *         XON). Suspended, the characters stay in the TX ring; without the
+ *         DMA a thread sending waits, an ISR sends anyway.
+ * @param pause 1 to suspend, 0 to resume
+ * @retval None
+ */
+void uart_tx_pause(uint8_t pause)
+{
+#if (USE_BSP_COM1_DMA == 1U)
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  tx_paused = pause;
+  uart_tx_start();
+  __set_PRIMASK(primask);
+#else
+  tx_paused = pause;
+#endif /*USE_BSP_COM1_DMA*/
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Tells whether everything queued has left the UART
+ * @retval 1 if the transmission is over, 0 otherwise
+ */
+uint8_t uart_tx_idle(void)
+{
+#if (USE_BSP_COM1_DMA == 1U)
+  if((tx_head != tx_tail) || (tx_dma_len != 0U) ||
+     (tx_urgent_pending != 0U) || (tx_dma_urgent != 0U)) {
+    return 0U;
+  }
+#endif /*USE_BSP_COM1_DMA*/
+  return (__HAL_UART_GET_FLAG(&UartHandle, UART_FLAG_TC) != RESET) ? 1U : 0U;
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Changes the baudrate. The transmission has to be over
+ *         (uart_tx_idle), what is being received is lost.
+ * @param baudrate New baudrate
+ * @retval None
+ */
+void uart_set_baudrate(uint32_t baudrate)
+{
+#if (USE_BSP_COM1_DMA == 1U)
+  (void) HAL_UART_AbortReceive(&UartHandle);
+#endif /*USE_BSP_COM1_DMA*/
+  UartHandle.Init.BaudRate = baudrate;
+  /* The handle is initialized: HAL_UART_Init only programs the new divider */
+  (void) HAL_UART_Init(&UartHandle);
+#if (USE_BSP_COM1_DMA == 1U)
+  uart_rx_start();
+#endif /*USE_BSP_COM1_DMA*/
+}
+/*---------------------------------------------------------------------------*/
 /** @brief Sends a character to serial port
  * @param ch Character to send
  * @retval Character sent
  */
 uint8_t uart_send_char(uint8_t ch)
 {
+#if (USE_BSP_COM1_DMA == 1U)
+  (void) uart_queue(&ch, 1U, 1U);
+#else
+  while((tx_paused != 0U) && (__get_IPSR() == 0U)) {
+  }
   (void) HAL_UART_Transmit(&UartHandle, (uint8_t *)&ch, 1, HAL_MAX_DELAY);
+#endif /*USE_BSP_COM1_DMA*/
   return ch;
 }
 /*---------------------------------------------------------------------------*/
-/** @brief Receives a character from serial port
+/** @brief Sends a flow control character (XON, XOFF) ahead of the TX ring
+ *         and even when the transmission is paused. With the DMA it follows
+ *         the transfer running, at most UART_TX_FLOW_CHUNK characters with
+ *         flow control; a character not sent yet is replaced by the new one.
+ * @param ch Character to send
+ * @retval None
+ */
+void uart_send_urgent(uint8_t ch)
+{
+#if (USE_BSP_COM1_DMA == 1U)
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  tx_urgent = ch;
+  tx_urgent_pending = 1U;
+  uart_tx_start();
+  __set_PRIMASK(primask);
+#else
+  (void) HAL_UART_Transmit(&UartHandle, &ch, 1, HAL_MAX_DELAY);
+#endif /*USE_BSP_COM1_DMA*/
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Queues a character without starting the transmission: it leaves
+ *         with the next uart_send_char/uart_send, or when the ring is full.
+ *         Without the DMA the character is sent at once.
+ * @param ch Character to send
+ * @retval Character queued
+ */
+uint8_t uart_queue_char(uint8_t ch)
+{
+#if (USE_BSP_COM1_DMA == 1U)
+  (void) uart_queue(&ch, 1U, 0U);
+  return ch;
+#else
+  return uart_send_char(ch);
+#endif /*USE_BSP_COM1_DMA*/
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Sends a block of characters to serial port
+ * @param buf Characters to send
+ * @param len Number of characters
+ * @retval Number of characters sent (queued with the DMA)
+ */
+uint16_t uart_send(const uint8_t *buf, uint16_t len)
+{
+#if (USE_BSP_COM1_DMA == 1U)
+  return uart_queue(buf, len, 1U);
+#else
+  while((tx_paused != 0U) && (__get_IPSR() == 0U)) {
+  }
+  (void) HAL_UART_Transmit(&UartHandle, (uint8_t *)buf, len, HAL_MAX_DELAY);
+  return len;
+#endif /*USE_BSP_COM1_DMA*/
+}
+/*---------------------------------------------------------------------------*/
+/** @brief Receives a character from serial port.
+ *         With the DMA, the UART belongs to the circular reception: the
+ *         character is taken from the RX ring, waiting until the DMA wrote
+ *         one. The characters go to input_handler first when it is set.
  * @retval Character received
  */
 uint8_t uart_receive_char(void)
 {
   uint8_t ch;
+#if (USE_BSP_COM1_DMA == 1U)
+  uint32_t primask;
+  uint8_t got = 0U;
+
+  while(got == 0U) {
+    primask = __get_PRIMASK();
+    __disable_irq();
+    if(rx_read != uart_rx_pos()) {
+      ch = rx_buffer[rx_read];
+      rx_read = (uint16_t) ((rx_read + 1U) % UART_RX_BUFFER_SIZE);
+      got = 1U;
+    }
+    __set_PRIMASK(primask);
+  }
+#else
   (void) HAL_UART_Receive(&UartHandle, &ch, 1, HAL_MAX_DELAY);
+#endif /*USE_BSP_COM1_DMA*/
 	
   /* Echo character back to console */
-  (void) HAL_UART_Transmit(&UartHandle, &ch, 1, HAL_MAX_DELAY);
+  (void) uart_send_char(ch);
 
   /* And cope with Windows */
   if(ch == (uint8_t) '\r'){
-    uint8_t ret = (uint8_t) '\n';
-    (void) HAL_UART_Transmit(&UartHandle, &ret, 1, HAL_MAX_DELAY);
+    (void) uart_send_char((uint8_t) '\n');
   }
 
   return ch;
@@ -96,14 +465,20 @@ size_t __read(int handle, unsigned char *buf, size_t bufsize)
 /* MISRA C-2012 Dir-4.6_a violation for purpose */
 size_t __write(int handle, const unsigned char * buf, size_t bufsize)
 {
+#if (USE_BSP_COM1_DMA == 0U)
   uint32_t i;
+#endif /*USE_BSP_COM1_DMA*/
   size_t retval = (size_t) -1;
   
   if ((handle == 1) || (handle == 2)) {
     retval = bufsize;
+#if (USE_BSP_COM1_DMA == 1U)
+    (void) uart_send(buf, (uint16_t) bufsize);
+#else
     for(i=0; i< bufsize; i++) {
       (void) uart_send_char(buf[i]);
     }
+#endif /*USE_BSP_COM1_DMA*/
   }  
   return retval;
 }
@@ -42,12 +42,222 @@
 #include "console.h"
 /* Private typedef -----------------------------------------------------------*/
 /* Private defines -----------------------------------------------------------*/
+#define SLIP_END      0xC0U
+#define SLIP_ESC      0xDBU
+#define SLIP_ESC_XON  0xDEU
+#define SLIP_ESC_XOFF 0xDFU
+#define XON           0x11U
+#define XOFF          0x13U
+
+/* Highest baudrate tunslip6 may ask for ("?B"): the ST-LINK VCP one */
+#ifdef SLIP_ARCH_CONF_MAX_BAUDRATE
+#define SLIP_ARCH_MAX_BAUDRATE  SLIP_ARCH_CONF_MAX_BAUDRATE
+#else
+#define SLIP_ARCH_MAX_BAUDRATE  2000000UL
+#endif /*SLIP_ARCH_CONF_MAX_BAUDRATE*/
+
+/* Start of a frame kept to recognize the host requests */
+#define SLIP_ARCH_CMD_LEN       12U
 /* Private macros ------------------------------------------------------------*/
 /* Private variables ---------------------------------------------------------*/
+#if BUILD_WITH_RPL_BORDER_ROUTER
+static uint8_t cmd[SLIP_ARCH_CMD_LEN];
+static uint8_t cmd_len;
+static uint8_t rx_esc;
+static volatile uint8_t xonxoff;
+static volatile uint8_t rx_held;
+static volatile uint8_t xonxoff_request;
+static volatile uint32_t baudrate_request;
+#endif /*BUILD_WITH_RPL_BORDER_ROUTER*/
 /* Global variables ----------------------------------------------------------*/
 /* Private function prototypes -----------------------------------------------*/
+#if BUILD_WITH_RPL_BORDER_ROUTER
+PROCESS(slip_arch_process, "SLIP arch");
+#endif /*BUILD_WITH_RPL_BORDER_ROUTER*/
 /* Functions Definition ------------------------------------------------------*/
 
+#if BUILD_WITH_RPL_BORDER_ROUTER
+/**
+ * @brief  slip_arch_baudrate_valid
+ * 		checks that the UART can run at a baudrate asked by the host
+ * @param  uint32_t baudrate
+ * @retval 1 if the divider gives it within 2%, 0 otherwise
+ */
+static uint8_t
+slip_arch_baudrate_valid(uint32_t baudrate)
+{
+  /* USART2 (COM1) is on APB1, oversampling by 16 */
+  uint32_t pclk = HAL_RCC_GetPCLK1Freq();
+  uint32_t div;
+  uint32_t actual;
+
+  if((baudrate == 0U) || (baudrate > SLIP_ARCH_MAX_BAUDRATE)) {
+    return 0U;
+  }
+  div = (pclk + (baudrate / 2U)) / baudrate;
+  if(div < 16U) {
+    return 0U;
+  }
+  actual = pclk / div;
+  if(actual > baudrate) {
+    return ((actual - baudrate) * 50U <= baudrate) ? 1U : 0U;
+  }
+  return ((baudrate - actual) * 50U <= baudrate) ? 1U : 0U;
+}
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @brief  slip_arch_command
+ * 		looks for the requests of tunslip6 in a frame received:
+ * 		"?B<baudrate>" and "?X" (XON/XOFF flow control). The answer
+ * 		comes from slip_arch_process, that owns slip_write
+ * @param  None
+ * @retval None
+ */
+static void
+slip_arch_command(void)
+{
+  uint32_t baudrate = 0U;
+  uint8_t i;
+
+  if((cmd_len < 2U) || (cmd[0] != (uint8_t) '?')) {
+    return;
+  }
+  if(cmd[1] == (uint8_t) 'B') {
+    for(i = 2U; i < cmd_len; i++) {
+      if((cmd[i] < (uint8_t) '0') || (cmd[i] > (uint8_t) '9')) {
+        return;
+      }
+      baudrate = (baudrate * 10U) + (uint32_t) (cmd[i] - (uint8_t) '0');
+    }
+    baudrate_request = baudrate;
+    process_poll(&slip_arch_process);
+  } else if((cmd[1] == (uint8_t) 'X') && (cmd_len == 2U)) {
+    xonxoff_request = 1U;
+    process_poll(&slip_arch_process);
+  }
+}
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @brief  slip_arch_input_byte
+ * 		UART input in front of slip_input_byte: XON/XOFF from the host
+ * 		and its escaped XON/XOFF data, host requests, and XOFF sent while
+ * 		slip.c holds a packet the stack did not take yet
+ * @param  unsigned char c
+ * @retval 1 if a packet was completed, 0 otherwise
+ */
+static int
+slip_arch_input_byte(unsigned char c)
+{
+  int ret;
+
+  if(xonxoff != 0U) {
+    if(c == XOFF) {
+      uart_tx_pause(1U);
+      return 0;
+    }
+    if(c == XON) {
+      uart_tx_pause(0U);
+      return 0;
+    }
+  }
+
+  /* slip.c only knows the ESC_END and ESC_ESC sequences */
+  if(rx_esc != 0U) {
+    rx_esc = 0U;
+    if(c == SLIP_ESC_XON) {
+      c = XON;
+    } else if(c == SLIP_ESC_XOFF) {
+      c = XOFF;
+    } else {
+      (void) slip_input_byte(SLIP_ESC);
+    }
+  } else if(c == SLIP_ESC) {
+    rx_esc = 1U;
+    return 0;
+  }
+
+  if(c == SLIP_END) {
+    slip_arch_command();
+    cmd_len = 0U;
+  } else if(cmd_len < SLIP_ARCH_CMD_LEN) {
+    cmd[cmd_len] = c;
+    cmd_len++;
+  }
+
+  ret = slip_input_byte(c);
+  if((ret != 0) && (xonxoff != 0U) && (rx_held == 0U)) {
+    /* Until slip_process gave the packet to the stack */
+    rx_held = 1U;
+    uart_send_urgent(XOFF);
+    process_poll(&slip_arch_process);
+  }
+  return ret;
+}
+/*--------------------------------------------------------------------------*/
+
+/**
+ * @brief  slip_arch_process
+ * 		answers the host requests and sends XON once slip_process ran
+ */
+PROCESS_THREAD(slip_arch_process, ev, data)
+{
+  static struct etimer et;
+  static uint32_t baudrate;
+  static char answer[16];
+  int len;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_WAIT_EVENT();
+
+    if((ev == PROCESS_EVENT_CONTINUE) && (rx_held != 0U)) {
+      rx_held = 0U;
+      uart_send_urgent(XON);
+    }
+    if(ev != PROCESS_EVENT_POLL) {
+      continue;
+    }
+    if(rx_held != 0U) {
+      /* slip_process, polled with us, has run when this event comes */
+      (void) process_post(PROCESS_CURRENT(), PROCESS_EVENT_CONTINUE, NULL);
+    }
+    if(xonxoff_request != 0U) {
+      xonxoff_request = 0U;
+      slip_write("!X", 2);
+      xonxoff = 1U;
+      uart_tx_flow_control(1U);
+    }
+    if(baudrate_request != 0U) {
+      baudrate = baudrate_request;
+      baudrate_request = 0U;
+      if(slip_arch_baudrate_valid(baudrate) == 0U) {
+        baudrate = UartHandle.Init.BaudRate;
+      }
+      len = snprintf(answer, sizeof(answer), "!B%lu", (unsigned long) baudrate);
+      slip_write(answer, len);
+      /* The answer leaves at the current baudrate */
+      while(uart_tx_idle() == 0U) {
+        etimer_set(&et, 1);
+        PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+      }
+      if(baudrate != UartHandle.Init.BaudRate) {
+        uart_set_baudrate(baudrate);
+      }
+      if(rx_held != 0U) {
+        /* The wait above may have taken the event posted for the XON */
+        (void) process_post(PROCESS_CURRENT(), PROCESS_EVENT_CONTINUE, NULL);
+      }
+    }
+  }
+
+  PROCESS_END();
+}
+/*--------------------------------------------------------------------------*/
+#endif /*BUILD_WITH_RPL_BORDER_ROUTER*/
+
 /**
  * @brief  slip_arch_init
  * 		initialises slip device
@@ -58,7 +268,8 @@ void
 slip_arch_init(void)
 {
 #if BUILD_WITH_RPL_BORDER_ROUTER
-  uart_set_input(0, slip_input_byte);
+  uart_set_input(0, slip_arch_input_byte);
+  process_start(&slip_arch_process, NULL);
 #endif /*BUILD_WITH_RPL_BORDER_ROUTER*/
 }
 /*--------------------------------------------------------------------------*/
@@ -72,7 +283,20 @@ slip_arch_init(void)
 void
 slip_arch_writeb(uint8_t c)
 {
-  (void) uart_send_char(c);
+#if BUILD_WITH_RPL_BORDER_ROUTER
+  /* With XON/XOFF, those bytes of the packets are escaped as tunslip6 does */
+  if((xonxoff != 0U) && ((c == XON) || (c == XOFF))) {
+    (void) uart_queue_char(SLIP_ESC);
+    c = (c == XON) ? SLIP_ESC_XON : SLIP_ESC_XOFF;
+  }
+#endif /*BUILD_WITH_RPL_BORDER_ROUTER*/
+  /* slip_write() ends every frame with SLIP_END: the bytes before it are only
+   * queued, so that the whole frame is handed to the DMA at once */
+  if(c == SLIP_END) {
+    (void) uart_send_char(c);
+  } else {
+    (void) uart_queue_char(c);
+  }
 }
 /*--------------------------------------------------------------------------*/
 /** @} */
@@ -20,8 +20,6 @@
 #ifndef PROJECT_CONF_H_
 #define PROJECT_CONF_H_
 
-#include "radio-driver.h"
-
 #define RTIMER_ARCH_SECOND 96000
 
 #if BUILD_WITH_SERIAL_SNIFFER
@@ -35,13 +33,37 @@
 
 #define WATCHDOG_ENABLE 0
 #define RADIO_HW_CSMA 1
-#define RADIO_SNIFF_MODE 0
+#define RADIO_ASYNC_TX 1
+#define RADIO_RX_QUEUE_LEN 4
+#define RADIO_ISR_ACK 1
+/* Opt-in, see readme.txt: frames of up to 2047 bytes, sent with a 2 bytes
+   length field and a 16 bits CRC that nodes built without it cannot read */
+#define RADIO_FIFO_STREAMING 0
+#define RADIO_SHADOW_REGS 1
+#define RADIO_BATCH_INIT 1
+/* Opt-in, see readme.txt: STack packet format, not understood by nodes
+   using the Basic one */
+#define RADIO_HW_ACK 0
 #define RADIO_ADDRESS_FILTERING 1
+/* Opt-in as well, see readme.txt for their cost */
+#define RADIO_HOPPING 0
+#define RADIO_SNIFF_MODE 0
+#define RADIO_ENERGY_SCAN 0
+#define RADIO_ADAPTIVE_CCA 0
+#define RADIO_STATS 0
 #define CONTIKI_VERSION_STRING "Contiki-NG"
+/* Tickless idle: STOP mode until the next etimer or an EXTI (radio, button).
+   The UART cannot wake the MCU: keep it off on nodes driven over the UART.
+   The RTC measures the time in STOP. From the LSI (F401) it is calibrated
+   against the HSI at boot, so the clock is only good to about 1 % and then
+   drifts with the LSI over temperature; an LSE (L152) keeps it exact */
 #define MCU_LOW_POWER 0
 #define RADIO_LOW_POWER 0
 #define RADIO_LONG_PREAMBLE 0
 
+/* After the RADIO_* settings, which select the packet format and length */
+#include "radio-driver.h"
+
 #if !BUILD_WITH_RPL_BORDER_ROUTER
 #define LOG_CONF_LEVEL_MAC      LOG_LEVEL_DBG
 #define LOG_CONF_LEVEL_RPL   LOG_LEVEL_DBG
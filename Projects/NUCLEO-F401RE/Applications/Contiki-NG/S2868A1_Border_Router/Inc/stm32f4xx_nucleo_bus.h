@@ -68,6 +68,10 @@
 #ifndef BUS_SPI1_BAUDRATE
    #define BUS_SPI1_BAUDRATE   10000000U /* baud rate of SPIn = 10 Mbps*/
 #endif
+/* SPI1 transfers through DMA  */
+#ifndef USE_BSP_SPI1_DMA
+   #define USE_BSP_SPI1_DMA    0U
+#endif
 
 /**
   * @}
@@ -92,6 +96,10 @@ typedef struct
   */
 
 extern SPI_HandleTypeDef hspi1;
+#if (USE_BSP_SPI1_DMA == 1U)
+extern DMA_HandleTypeDef hdma_spi1_rx;
+extern DMA_HandleTypeDef hdma_spi1_tx;
+#endif /* USE_BSP_SPI1_DMA */
 
 /**
   * @}
@@ -108,6 +116,9 @@ int32_t BSP_SPI1_DeInit(void);
 int32_t BSP_SPI1_Send(uint8_t *pData, uint16_t Length);
 int32_t BSP_SPI1_Recv(uint8_t *pData, uint16_t Length);
 int32_t BSP_SPI1_SendRecv(uint8_t *pTxData, uint8_t *pRxData, uint16_t Length);
+#if (USE_BSP_SPI1_DMA == 1U)
+int32_t BSP_SPI1_SendRecv_DMA(uint8_t *pTxData, uint8_t *pRxData, uint16_t Length);
+#endif /* USE_BSP_SPI1_DMA */
 #if (USE_HAL_SPI_REGISTER_CALLBACKS == 1U)
 int32_t BSP_SPI1_RegisterDefaultMspCallbacks (void);
 int32_t BSP_SPI1_RegisterMspCallbacks (BSP_SPI_Cb_t *Callbacks);
@@ -149,6 +149,21 @@ static void packet_sent(struct neighbor_queue *n,
     int status,
     int num_transmissions);
 static void transmit_from_queue(void *ptr);
+#if RADIO_ASYNC_TX
+/* SRA: packet handed to the radio, its outcome is reported by csma_tx_done() */
+static struct {
+  struct neighbor_queue *n;
+  struct packet_queue *q;
+  uint8_t dsn;
+  uint8_t is_broadcast;
+} tx_in_flight;
+#endif /* RADIO_ASYNC_TX */
+#if RADIO_HW_ACK
+/* SRA: the S2-LP retransmits the frame by itself until it is acknowledged */
+#define RADIO_TX_ATTEMPTS() radio_get_tx_attempts()
+#else /* RADIO_HW_ACK */
+#define RADIO_TX_ATTEMPTS() 1
+#endif /* RADIO_HW_ACK */
 /*---------------------------------------------------------------------------*/
 static struct neighbor_queue *
 neighbor_queue_from_addr(const linkaddr_t *addr)
@@ -178,6 +193,86 @@ backoff_period(void)
 }
 /*---------------------------------------------------------------------------*/
 static int
+radio_tx_result(int radio_status, int is_broadcast, uint8_t dsn)
+{
+  int ret;
+
+  switch(radio_status) {
+  case RADIO_TX_OK:
+    if(is_broadcast) {
+      ret = MAC_TX_OK;
+    } else {
+#if RADIO_ISR_ACK
+      /* SRA: the radio driver has already matched the ACK */
+      ret = MAC_TX_OK;
+#else /* RADIO_ISR_ACK */
+      /* Check for ack */
+
+      /* Wait for max CSMA_ACK_WAIT_TIME */
+      //RTIMER_BUSYWAIT_UNTIL(NETSTACK_RADIO.pending_packet(), CSMA_ACK_WAIT_TIME);
+      LOCAL_BUSYWAIT_UNTIL(NETSTACK_RADIO.pending_packet(), CSMA_ACK_WAIT_TIME);
+
+      ret = MAC_TX_NOACK;
+      if(NETSTACK_RADIO.receiving_packet() ||
+         NETSTACK_RADIO.pending_packet() ||
+         NETSTACK_RADIO.channel_clear() == 0) {
+        int len;
+        uint8_t ackbuf[CSMA_ACK_LEN];
+
+        /* Wait an additional CSMA_AFTER_ACK_DETECTED_WAIT_TIME to complete reception */
+        //RTIMER_BUSYWAIT_UNTIL(NETSTACK_RADIO.pending_packet(), CSMA_AFTER_ACK_DETECTED_WAIT_TIME);
+        LOCAL_BUSYWAIT_UNTIL(NETSTACK_RADIO.pending_packet(), CSMA_AFTER_ACK_DETECTED_WAIT_TIME);
+
+        if(NETSTACK_RADIO.pending_packet()) {
+          len = NETSTACK_RADIO.read(ackbuf, CSMA_ACK_LEN);
+          if(len == CSMA_ACK_LEN && ackbuf[2] == dsn) {
+            /* Ack received */
+            ret = MAC_TX_OK;
+          } else {
+            /* Not an ack or ack not for us: collision */
+            ret = MAC_TX_COLLISION;
+          }
+        }
+      }
+#endif /* RADIO_ISR_ACK */
+    }
+    break;
+  case RADIO_TX_NOACK:
+    ret = MAC_TX_NOACK;
+    break;
+  case RADIO_TX_COLLISION:
+    ret = MAC_TX_COLLISION;
+    break;
+  default:
+    ret = MAC_TX_ERR;
+    break;
+  }
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+#if RADIO_ASYNC_TX
+/* SRA: called by the radio process once the frame handed over by
+ * send_one_packet() has been sent */
+static void
+csma_tx_done(int radio_status)
+{
+  struct neighbor_queue *n = tx_in_flight.n;
+  struct packet_queue *q = tx_in_flight.q;
+  int ret;
+
+  if(n == NULL) {
+    return;
+  }
+  tx_in_flight.n = NULL;
+
+  /* The packetbuf may have been reused during the airtime */
+  queuebuf_to_packetbuf(q->buf);
+  ret = radio_tx_result(radio_status, tx_in_flight.is_broadcast, tx_in_flight.dsn);
+  packet_sent(n, q, ret, RADIO_TX_ATTEMPTS());
+}
+#endif /* RADIO_ASYNC_TX */
+/*---------------------------------------------------------------------------*/
+static int
 send_one_packet(struct neighbor_queue *n, struct packet_queue *q)
 {
   int ret;
@@ -199,6 +294,7 @@ send_one_packet(struct neighbor_queue *n, struct packet_queue *q)
     ret = MAC_TX_ERR_FATAL;
   } else {
     int is_broadcast;
+    int radio_status;
     uint8_t dsn;
     dsn = ((uint8_t *)packetbuf_hdrptr())[2] & 0xff;
 
@@ -214,56 +310,33 @@ send_one_packet(struct neighbor_queue *n, struct packet_queue *q)
          sending with auto ack. */
       ret = MAC_TX_COLLISION;
     } else {
-
-      switch(NETSTACK_RADIO.transmit(packetbuf_totlen())) {
-      case RADIO_TX_OK:
-        if(is_broadcast) {
-          ret = MAC_TX_OK;
-        } else {
-          /* Check for ack */
-
-          /* Wait for max CSMA_ACK_WAIT_TIME */
-          //RTIMER_BUSYWAIT_UNTIL(NETSTACK_RADIO.pending_packet(), CSMA_ACK_WAIT_TIME);
-          LOCAL_BUSYWAIT_UNTIL(NETSTACK_RADIO.pending_packet(), CSMA_ACK_WAIT_TIME);
-
-          ret = MAC_TX_NOACK;
-          if(NETSTACK_RADIO.receiving_packet() ||
-             NETSTACK_RADIO.pending_packet() ||
-             NETSTACK_RADIO.channel_clear() == 0) {
-            int len;
-            uint8_t ackbuf[CSMA_ACK_LEN];
-
-            /* Wait an additional CSMA_AFTER_ACK_DETECTED_WAIT_TIME to complete reception */
-            //RTIMER_BUSYWAIT_UNTIL(NETSTACK_RADIO.pending_packet(), CSMA_AFTER_ACK_DETECTED_WAIT_TIME);
-            LOCAL_BUSYWAIT_UNTIL(NETSTACK_RADIO.pending_packet(), CSMA_AFTER_ACK_DETECTED_WAIT_TIME);
-
-            if(NETSTACK_RADIO.pending_packet()) {
-              len = NETSTACK_RADIO.read(ackbuf, CSMA_ACK_LEN);
-              if(len == CSMA_ACK_LEN && ackbuf[2] == dsn) {
-                /* Ack received */
-                ret = MAC_TX_OK;
-              } else {
-                /* Not an ack or ack not for us: collision */
-                ret = MAC_TX_COLLISION;
-              }
-            }
-          }
-        }
-        break;
-      case RADIO_TX_COLLISION:
-        ret = MAC_TX_COLLISION;
-        break;
-      default:
-        ret = MAC_TX_ERR;
-        break;
+#if RADIO_ASYNC_TX
+      tx_in_flight.n = n;
+      tx_in_flight.q = q;
+      tx_in_flight.dsn = dsn;
+      tx_in_flight.is_broadcast = is_broadcast;
+      radio_set_tx_done_callback(csma_tx_done);
+#endif /* RADIO_ASYNC_TX */
+
+      radio_status = NETSTACK_RADIO.transmit(packetbuf_totlen());
+
+#if RADIO_ASYNC_TX
+      if(radio_status == RADIO_TX_OK && radio_tx_in_progress()) {
+        /* The outcome is reported by csma_tx_done() */
+        return 0;
       }
+      radio_set_tx_done_callback(NULL);
+      tx_in_flight.n = NULL;
+#endif /* RADIO_ASYNC_TX */
+
+      ret = radio_tx_result(radio_status, is_broadcast, dsn);
     }
   }
   if(ret == MAC_TX_OK) {
     last_sent_ok = 1;
   }
 
-  packet_sent(n, q, ret, 1);
+  packet_sent(n, q, ret, RADIO_TX_ATTEMPTS());
   return last_sent_ok;
 }
 /*---------------------------------------------------------------------------*/
@@ -271,6 +344,13 @@ static void
 transmit_from_queue(void *ptr)
 {
   struct neighbor_queue *n = ptr;
+#if RADIO_ASYNC_TX
+  if(n && tx_in_flight.n != NULL) {
+    /* The radio is still sending another packet: try again later */
+    schedule_transmission(n);
+    return;
+  }
+#endif /* RADIO_ASYNC_TX */
   if(n) {
     struct packet_queue *q = list_head(n->packet_queue);
     if(q != NULL) {
@@ -292,7 +372,14 @@ schedule_transmission(struct neighbor_queue *n)
   clock_time_t delay;
   int backoff_exponent; /* BE in IEEE 802.15.4 */
 
+#if RADIO_ADAPTIVE_CCA
+  /* SRA: the radio driver widens the window of a channel where frames
+   * collide, both exponents are raised */
+  backoff_exponent = MIN(n->collisions + CSMA_MIN_BE + radio_cca_backoff_boost(),
+                         CSMA_MAX_BE + radio_cca_backoff_boost());
+#else /* RADIO_ADAPTIVE_CCA */
   backoff_exponent = MIN(n->collisions + CSMA_MIN_BE, CSMA_MAX_BE);
+#endif /* RADIO_ADAPTIVE_CCA */
 
   /* Compute max delay as per IEEE 802.15.4: 2^BE-1 backoff periods  */
   delay = ((1 << backoff_exponent) - 1) * backoff_period();
@@ -37,6 +37,7 @@ void MX_SUBG2_Contiki_NG_Process(void);
 void Stack_6LoWPAN_Init(void);
 void uart_set_input(uint8_t uart, int (* input)(unsigned char c));
 void platform_idle(void);
+void clock_arch_idle(void);
 void UART_Platform_Transmit(uint8_t * msg);
 void UART_Platform_init(void);
 
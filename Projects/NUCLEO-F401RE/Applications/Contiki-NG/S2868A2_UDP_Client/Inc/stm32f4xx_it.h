@@ -56,6 +56,14 @@ void DebugMon_Handler(void);
 void SysTick_Handler(void);
 void EXTI0_IRQHandler(void);
 void SPI1_IRQHandler(void);
+#if (USE_BSP_SPI1_DMA == 1U)
+void DMA2_Stream0_IRQHandler(void);
+void DMA2_Stream3_IRQHandler(void);
+#endif /* USE_BSP_SPI1_DMA */
+#if (USE_BSP_COM1_DMA == 1U)
+void DMA1_Stream5_IRQHandler(void);
+void DMA1_Stream6_IRQHandler(void);
+#endif /* USE_BSP_COM1_DMA */
 void EXTI15_10_IRQHandler(void);
 void TIM5_IRQHandler(void);
 /* USER CODE BEGIN EFP */
@@ -160,6 +160,10 @@
   #define USE_COM_LOG                           1U
 #endif
 
+#ifndef USE_BSP_COM1_DMA
+  #define USE_BSP_COM1_DMA                      0U
+#endif
+
 #ifndef BSP_BUTTON_USER_IT_PRIORITY
   #define BSP_BUTTON_USER_IT_PRIORITY            15U
 #endif
@@ -250,6 +254,10 @@ typedef struct
 #define COM_POLL_TIMEOUT                 1000
 extern UART_HandleTypeDef hcom_uart[COMn];
 #define  huart2 hcom_uart[COM1]
+#if (USE_BSP_COM1_DMA == 1U)
+extern DMA_HandleTypeDef hdma_usart2_rx;
+extern DMA_HandleTypeDef hdma_usart2_tx;
+#endif /* USE_BSP_COM1_DMA */
 
 /**
  * @}
@@ -101,6 +101,7 @@
 #include "main.h"
 #include "contiki-platform.h"
 #include "subg2_bsp_ip_conf.h"
+#include "console.h"
 
 #ifdef WITH_IP64
 #include "ip64.h"
@@ -287,7 +288,7 @@ void Stack_6LoWPAN_Init(void) //former "main()" in contiki-main.c
 */
 void UART_Platform_Transmit(uint8_t * msg)
 {
-    HAL_UART_Transmit(&UartHandle, (uint8_t*)msg, 1, 5000);
+    (void) uart_send_char(*msg);
 }
 /*----------------------------------------------------------------------------*/
 /**
@@ -298,7 +299,11 @@ void UART_Platform_Transmit(uint8_t * msg)
 */
 void UART_Platform_init(void)
 {
+#if (USE_BSP_COM1_DMA == 1U)
+  uart_rx_start();
+#else
   __HAL_UART_ENABLE_IT(&UartHandle, UART_IT_RXNE);
+#endif /*USE_BSP_COM1_DMA*/
 }
 /*---------------------------------------------------------------------------*/
 /**
@@ -430,6 +435,7 @@ static void print_parameters(void)
   PRINT_PARAMETER(COAP_OBSERVE_REFRESH_INTERVAL, "%d");
 #endif /*BUILD_WITH_COAP*/
 
+  PRINT_PARAMETER(MCU_LOW_POWER, "%d");
   PRINT_PARAMETER(RADIO_LOW_POWER, "%d");
   PRINT_PARAMETER(RADIO_SNIFF_MODE, "%d");
 #ifdef RADIO_LONG_PREAMBLE
@@ -541,6 +547,14 @@ platform_init_stage_three()
 void
 platform_idle()
 {
+#if MCU_LOW_POWER
+  /* STOP mode freezes the SPI with its DMA and the UART: only when they are
+   * done, the UART RX being unable to wake the MCU anyway */
+  if(!radio_spi_busy() && (__HAL_UART_GET_FLAG(&UartHandle, UART_FLAG_TC) != RESET)) {
+    clock_arch_idle();
+    return;
+  }
+#endif /*MCU_LOW_POWER*/
   __WFI();
 }
 /*---------------------------------------------------------------------------*/
@@ -24,6 +24,8 @@
 #include "net/linkaddr.h"
 #include "net/mac/framer/frame802154.h"
 #include "sys/rtimer.h"
+#include "sys/ctimer.h"
+#include "sys/energest.h"
 #include "net/ipv6/uip.h"
 #include "net/ipv6/uip-ds6.h"
 
@@ -36,10 +38,21 @@
 #include "s2lp_types.h"
 
 #include "s2lp_pktbasic.h"
+#if RADIO_HW_ACK
+#include "s2lp_pktstack.h"
+#endif /*RADIO_HW_ACK*/
 
-#if RADIO_ADDRESS_FILTERING
+/* Shell commands of the driver */
+#define RADIO_SHELL   (BUILD_WITH_SHELL && (RADIO_ENERGY_SCAN || RADIO_STATS))
+#if RADIO_SHELL
+#include <stdlib.h>
+#include "services/shell/shell.h"
+#include "services/shell/shell-commands.h"
+#endif /*RADIO_SHELL*/
+
+#if RADIO_ADDRESS_FILTERING || RADIO_ISR_ACK
 #define ACK_LEN 3
-#endif /*RADIO_ADDRESS_FILTERING*/
+#endif /*RADIO_ADDRESS_FILTERING || RADIO_ISR_ACK*/
 
 /**
 * @defgroup ST_Radio
@@ -61,20 +74,77 @@
 /*Change LOG_LEVEL for example to LOG_LEVEL_MAC to change it at runtime      */
 /*---------------------------------------------------------------------------*/
 #define RADIO_WAIT_TIMEOUT (100 * RTIMER_SECOND/1000)
+#if RADIO_STATS
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+/* Cortex-M3/M4: the cycle counter, started by Radio_init */
+#define RADIO_STATS_NOW()         (DWT->CYCCNT)
+#define RADIO_STATS_US(t)         ((t) / stats_cycles_per_us)
+#else /*!DWT_CTRL_CYCCNTENA_Msk*/
+#define RADIO_STATS_NOW()         ((uint32_t)RTIMER_NOW())
+#define RADIO_STATS_US(t)         ((uint32_t)(((uint64_t)(t) * 1000000) / RTIMER_SECOND))
+#endif /*DWT_CTRL_CYCCNTENA_Msk*/
+/* The condition is not evaluated again at the end: it may read the radio */
+#define BUSYWAIT_UNTIL(cond, max_time)                                 \
+do {                                                                   \
+  rtimer_clock_t t0;                                                   \
+  uint32_t stats_t0 = RADIO_STATS_NOW();                               \
+  uint8_t stats_late = 0;                                              \
+  t0 = RTIMER_NOW();                                                   \
+  while(!(cond)) {                                                     \
+    if(!RTIMER_CLOCK_LT(RTIMER_NOW(), t0 + (max_time))) {              \
+      stats_late = 1;                                                  \
+      break;                                                           \
+    }                                                                  \
+  }                                                                    \
+  radio_stats_wait(stats_t0, stats_late);                              \
+} while(0)
+#else /*!RADIO_STATS*/
 #define BUSYWAIT_UNTIL(cond, max_time)                                 \
 do {                                                                   \
   rtimer_clock_t t0;                                                   \
   t0 = RTIMER_NOW();                                                   \
   while(!(cond) && RTIMER_CLOCK_LT(RTIMER_NOW(), t0 + (max_time)));    \
 } while(0)
+#endif /*RADIO_STATS*/
 /*---------------------------------------------------------------------------*/
-/* The buffer which holds incoming data. */
-static uint32_t rx_num_bytes =0;
-static uint8_t radio_rxbuf[PACKETBUF_SIZE];
+/* The ring which holds incoming frames: filled by Radio_interrupt_callback
+ * (head), emptied by Radio_read (tail). Each side only writes its own index,
+ * so no critical section is needed. A slot with len == 0 between tail and
+ * head has already been read out of order (see rx_ring_ack_wait). */
+#ifndef RADIO_RX_QUEUE_LEN
+#define RADIO_RX_QUEUE_LEN      4
+#endif /*RADIO_RX_QUEUE_LEN*/
+#if (RADIO_RX_QUEUE_LEN & (RADIO_RX_QUEUE_LEN - 1)) || RADIO_RX_QUEUE_LEN > 128
+#error RADIO_RX_QUEUE_LEN must be a power of two, at most 128
+#endif
+#define RX_RING_MASK            (RADIO_RX_QUEUE_LEN - 1)
+
+typedef struct {
+  uint16_t len;
+  radio_value_t rssi;
+  packetbuf_attr_t lqi;
+  rtimer_clock_t timestamp;
+  uint8_t data[PACKETBUF_SIZE];
+} radio_rx_slot_t;
+
+static radio_rx_slot_t rx_ring[RADIO_RX_QUEUE_LEN];
+static volatile uint8_t rx_ring_head = 0;
+static volatile uint8_t rx_ring_tail = 0;
+/* Frames received before the last transmission are hidden while the MAC
+ * waits for the ACK, so that they are neither taken for it nor consumed. */
+static uint8_t rx_ring_ack_mark = 0;
+static uint8_t rx_ring_ack_wait = 0;
+static radio_rx_queue_stats_t rx_ring_stats;
 /*---------------------------------------------------------------------------*/
-#define CLEAR_RXBUF()           (rx_num_bytes = 0)
-#define IS_RXBUF_EMPTY()        (rx_num_bytes == 0)
-#define IS_RXBUF_FULL()         (rx_num_bytes != 0)
+#define RX_RING_COUNT()         ((uint8_t)(rx_ring_head - rx_ring_tail))
+#define CLEAR_RXBUF()           (rx_ring_tail = rx_ring_head)
+#define IS_RXBUF_EMPTY()        (rx_ring_head == rx_ring_tail)
+#define IS_RXBUF_FULL()         (RX_RING_COUNT() >= RADIO_RX_QUEUE_LEN)
+/*---------------------------------------------------------------------------*/
+/* The S2-LP of this driver. Radio_init selects it and it stays selected: the
+ * code driving another S2-LP selects its own and gives this one back, and the
+ * interrupt contexts of the driver select it themselves. */
+static S2LP_Object_t radio_s2lp;
 /*---------------------------------------------------------------------------*/
 /* transceiver state. */
 #define ON     1
@@ -88,13 +158,73 @@ static volatile uint8_t packet_is_prepared = 0;
 static radio_value_t last_packet_rssi = 0 ;
 static packetbuf_attr_t last_packet_lqi = 0 ;
 static int interrupt_callback_in_progress = 0;
-static int interrupt_callback_wants_poll = 0;
+static volatile int interrupt_callback_wants_poll = 0;
+/*---------------------------------------------------------------------------*/
+/* RADIO_PARAM_LAST_PACKET_TIMESTAMP is the end of the sync word, where the
+ * SFD ends in 802.15.4. It is taken at the edge of IRQ_VALID_SYNC; without it
+ * (sniff mode, or a poll coming after the end of the frame) it is worked back
+ * from IRQ_RX_DATA_READY, which comes after the length field, the payload and
+ * the CRC. */
+#ifndef RADIO_IRQ_LATENCY_US
+#define RADIO_IRQ_LATENCY_US      0       /* from the radio event to RTIMER_NOW() in the ISR */
+#endif /*RADIO_IRQ_LATENCY_US*/
+#define RADIO_BITS_TO_RTIMER(bits) ((rtimer_clock_t)((((uint64_t)(bits) * RTIMER_SECOND) + DATARATE / 2) / DATARATE))
+/* From the end of the sync word to IRQ_RX_DATA_READY, for a RX_PCKT_LEN */
+#define RADIO_SYNC_TO_RX_END(pckt_len) \
+  RADIO_BITS_TO_RTIMER(8UL * (LENGTH_FIELD_BYTES + (pckt_len) + CRC_BYTES))
+
+static volatile rtimer_clock_t last_packet_timestamp = 0;
+static volatile rtimer_clock_t irq_timestamp = 0;   /* edge of the IRQ line */
+static volatile rtimer_clock_t sync_timestamp = 0;
+static volatile uint8_t sync_timestamp_valid = 0;
 /*---------------------------------------------------------------------------*/
-static volatile uint32_t last_packet_timestamp = 0;
+/* TSCH timeslot for this PHY (RADIO_CONST_TSCH_TIMING), built on the timing
+ * of radio-driver.h: a 127 bytes frame does not fit the 10 ms template of
+ * the 2.4 GHz radios. RADIO_TSCH_PREPARE_US covers the SPI transfer of a
+ * frame, before its TX and after its RX, when the ACK is built. */
+#define RADIO_TSCH_PREPARE_US       1000
+#define RADIO_TSCH_MAX_FRAME        127
+#define RADIO_TSCH_MAX_ACK          40     /* with the sync IE and a MIC */
+#define RADIO_TSCH_RX_WAIT_US       2200
+#define RADIO_TSCH_ACK_WAIT_US      400
+#define RADIO_TSCH_CCA_US           RADIO_BYTE_AIR_TIME_US
+#define RADIO_TSCH_AIR_US(len)      (((len) + RADIO_PHY_OVERHEAD_BYTES) * RADIO_BYTE_AIR_TIME_US)
+#define RADIO_TSCH_TX_OFFSET_US     (RADIO_DELAY_BEFORE_TX_US + RADIO_TSCH_PREPARE_US)
+#define RADIO_TSCH_TX_ACK_DELAY_US  (RADIO_DELAY_BEFORE_TX_US + RADIO_TSCH_PREPARE_US)
+#define RADIO_TSCH_TIMESLOT_US      (RADIO_TSCH_TX_OFFSET_US +                        \
+                                     RADIO_TSCH_AIR_US(RADIO_TSCH_MAX_FRAME) +        \
+                                     RADIO_TSCH_TX_ACK_DELAY_US +                     \
+                                     RADIO_TSCH_AIR_US(RADIO_TSCH_MAX_ACK) +          \
+                                     RADIO_TSCH_PREPARE_US)
+/* Past the int32_t range of US_TO_RTIMERTICKS() at 96 kHz */
+#define RADIO_TSCH_TIMESLOT_TICKS   ((rtimer_clock_t)(((uint64_t)RADIO_TSCH_TIMESLOT_US * RTIMER_SECOND) / 1000000))
+#if RADIO_TSCH_TIMESLOT_US <= 0xFFFF
+/* In the order of enum tsch_timeslot_timing_elements */
+const uint16_t radio_tsch_timing_us[] = {
+  RADIO_TSCH_PREPARE_US - RADIO_TSCH_CCA_US,                    /* CCAOffset */
+  RADIO_TSCH_CCA_US,                                            /* CCA */
+  RADIO_TSCH_TX_OFFSET_US,                                      /* TxOffset */
+  RADIO_TSCH_TX_OFFSET_US - RADIO_TSCH_RX_WAIT_US / 2,          /* RxOffset */
+  RADIO_TSCH_TX_ACK_DELAY_US - RADIO_TSCH_ACK_WAIT_US / 2,      /* RxAckDelay */
+  RADIO_TSCH_TX_ACK_DELAY_US,                                   /* TxAckDelay */
+  RADIO_TSCH_RX_WAIT_US,                                        /* RxWait */
+  RADIO_TSCH_ACK_WAIT_US,                                       /* AckWait */
+  RADIO_SYNTH_SETUP_US,                                         /* RxTx */
+  RADIO_TSCH_AIR_US(RADIO_TSCH_MAX_ACK),                        /* MaxAck */
+  RADIO_TSCH_AIR_US(RADIO_TSCH_MAX_FRAME),                      /* MaxTx */
+  RADIO_TSCH_TIMESLOT_US,                                       /* TimeslotLength */
+};
+#elif MAC_CONF_WITH_TSCH
+#error The TSCH timeslot does not fit 16 bits: RADIO_LONG_PREAMBLE is not for TSCH
+#endif /*RADIO_TSCH_TIMESLOT_US*/
 /*---------------------------------------------------------------------------*/
 static int csma_tx_threshold = RSSI_TX_THRESHOLD;
 /* Poll mode disabled by default */
 /*static*/ uint8_t polling_mode = 0;
+/* In poll mode no IRQ is routed to the GPIO: the status, cleared on read, is
+ * gathered here until the events are consumed. The masks are kept aside. */
+static uint32_t poll_irqs = 0;
+static S2LPIrqs poll_saved_mask;
 /* (Software) frame filtering enabled by default */
 #if RADIO_ADDRESS_FILTERING
 static uint8_t auto_pkt_filter = 1;
@@ -111,6 +241,234 @@ static uint8_t csma_enabled = 0;
 static int conf_channel = CHANNEL_NUMBER;
 static int conf_tx_power = (int)POWER_DBM;//@TODO: validate
 /*---------------------------------------------------------------------------*/
+#if RADIO_ASYNC_TX
+/* Asynchronous transmission: Radio_transmit() returns as soon as the TX
+ * command is issued, the end of the transmission is handled by the radio
+ * process and reported through a one-shot callback. */
+#define RADIO_TX_ASYNC_TIMEOUT          CLOCK_SECOND
+static radio_tx_done_callback_t tx_done_callback = NULL;
+static radio_tx_done_callback_t tx_async_callback = NULL;
+static volatile uint8_t tx_async_pending = 0;
+static volatile uint8_t tx_async_timeout = 0;
+static uint8_t tx_async_notify = 0;
+static uint8_t tx_async_radio_state = OFF;
+static int tx_async_retval = RADIO_TX_ERR;
+static int tx_async_status = RADIO_TX_ERR;
+static struct ctimer tx_async_timer;
+#endif /*RADIO_ASYNC_TX*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_ISR_ACK
+/* Software ACKs handled in Radio_interrupt_callback: the ACK of a received
+ * frame is sent right after the frame is read, the ACK of a sent frame is
+ * matched on reception. An rtimer bounds the wait, which is the ACK air time
+ * plus the turnaround of the peer ISR. */
+#define RADIO_ACK_TURNAROUND_US   2000
+#define RADIO_ACK_AIR_TIME_US     (((PREAMBLE_LENGTH / 4) + (SYNC_LENGTH / 8) + ACK_LEN + 3) \
+                                   * 8000000UL / DATARATE)
+#define RADIO_ACK_WAIT_TIME       US_TO_RTIMERTICKS(RADIO_ACK_TURNAROUND_US + RADIO_ACK_AIR_TIME_US)
+enum {
+  ACK_IDLE,
+  ACK_WAITING,
+  ACK_RECEIVED,
+  ACK_TIMEOUT
+};
+static int16_t ack_seqno = -1;  /* of the prepared frame, -1 if it wants no ACK */
+static volatile uint8_t ack_state = ACK_IDLE;
+static volatile uint8_t ack_wait_extended = 0;
+static volatile uint8_t ack_sending = 0;
+static uint8_t ack_radio_off = 0;
+static struct rtimer ack_timer;
+#endif /*RADIO_ISR_ACK*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_HW_ACK
+#if !RADIO_ISR_ACK || !RADIO_ADDRESS_FILTERING
+#error RADIO_HW_ACK needs RADIO_ISR_ACK and RADIO_ADDRESS_FILTERING
+#endif /*!RADIO_ISR_ACK || !RADIO_ADDRESS_FILTERING*/
+/* Hardware ACKs: with the STack packet format the link layer protocol of the
+ * packet handler acknowledges the frames addressed to this node and, for a
+ * frame sent with an ACK request, waits for the ACK in RX (RX timer) and
+ * sends the frame again up to RADIO_HW_ACK_RETX times. IRQ_TX_DATA_SENT then
+ * comes with the ACK, IRQ_MAX_RE_TX_REACH without it. A retransmission is
+ * taken from the TX FIFO again: longer frames keep the software ACK. */
+#define RADIO_HW_ACK_TURNAROUND_US  500
+#define RADIO_HW_ACK_WAIT_US      (RADIO_HW_ACK_TURNAROUND_US + RADIO_ACK_AIR_TIME_US)
+#define RADIO_HW_ACK_FRAME(len)   ((len) <= S2LP_TX_FIFO_SIZE)
+#define RADIO_HW_ACKED()          (hw_ack_request != 0)
+#define SET_PAYLOAD_LENGTH(len)   S2LP_PCKT_STACK_SetPayloadLength(len)
+/* RX_PCKT_LEN counts the address and control fields, which are not in the FIFO */
+#define RX_PCKT_LEN_EXTRA         ((EN_ADDRESS == S_ENABLE) + 1)
+static uint8_t hw_ack_request = 0;  /* NACK_TX is clear: the prepared frame asks for an ACK */
+static volatile uint8_t hw_ack_missed = 0;
+static uint8_t tx_attempts = 1;
+#else /*!RADIO_HW_ACK*/
+#define RADIO_HW_ACK_FRAME(len)   0
+#define RADIO_HW_ACKED()          0
+#define SET_PAYLOAD_LENGTH(len)   S2LP_PCKT_BASIC_SetPayloadLength(len)
+#define RX_PCKT_LEN_EXTRA         (EN_ADDRESS == S_ENABLE)
+#endif /*RADIO_HW_ACK*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_FIFO_STREAMING
+/* Frames longer than the FIFOs are streamed by Radio_interrupt_callback: the
+ * TX FIFO is refilled on IRQ_TX_FIFO_ALMOST_EMPTY, the RX FIFO is drained into
+ * the head slot of the ring on IRQ_RX_FIFO_ALMOST_FULL. Both thresholds leave
+ * RADIO_FIFO_MARGIN bytes to serve the IRQ (3.3 ms at 38.4 kbps), so each
+ * chunk is moved without reading the FIFO level first. */
+#define RADIO_FIFO_MARGIN         16
+#define RADIO_FIFO_CHUNK          (S2LP_TX_FIFO_SIZE - RADIO_FIFO_MARGIN)
+/* The SPI transfers overwrite the buffer they send: the frame is copied here */
+static uint8_t tx_stream_buf[MAX_PACKET_LEN];
+static uint16_t tx_stream_len = 0;
+static volatile uint16_t tx_stream_pos = 0;  /* the IRQ is on while < tx_stream_len */
+static volatile uint16_t rx_stream_len = 0;  /* bytes of the incoming frame already drained */
+static volatile uint8_t rx_stream_drop = 0;  /* the incoming frame does not fit in the ring */
+#endif /*RADIO_FIFO_STREAMING*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_HOPPING
+/* Channel table of the frequency hopping: the synthesizer words and the VCO
+ * calibration words of each channel are measured once by Radio_init, so that
+ * a channel switch is two register bursts and no VCO calibration.
+ * CHNUM stays 0, the channel is carried by the SYNT words. */
+#define HOP_CHANNELS              (CHANNEL_NUMBER_MAX - CHANNEL_NUMBER_MIN + 1)
+typedef struct {
+  SRadioSynthWords synth;
+  uint8_t vco_cal[3];       /* VCO_CALIBR_IN2..IN0: TX|RX amplitude, TX freq, RX freq */
+} radio_hop_words_t;
+static radio_hop_words_t hop_words[HOP_CHANNELS];
+static uint8_t hop_pfd_split = 0;  /* REFCLK_DIV of the last SYNT words written */
+static const uint8_t *hop_sequence = NULL;
+static uint16_t hop_sequence_len = 0;
+static uint16_t hop_index = 0;
+#endif /*RADIO_HOPPING*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_SNIFF_MODE
+/* Low duty cycle RX: in LDC mode the radio sleeps and wakes up every
+ * sniff_period_ms for a carrier sense window (fast RX termination), staying
+ * in RX only if a preamble is on air. The senders make their preamble last
+ * one sniff period (tx_wakeup_ms, radio_set_tx_wakeup). */
+#ifndef RADIO_SNIFF_PERIOD_MS
+#define RADIO_SNIFF_PERIOD_MS     0       /* at init, 0: continuous RX */
+#endif /*RADIO_SNIFF_PERIOD_MS*/
+/* RX on time of a wake up without carrier: oscillator and synthesizer start,
+ * then the carrier sense window. Used to account the listen time. */
+#define RADIO_SNIFF_WAKEUP_US     400
+#define RADIO_SNIFFING()          (sniff_period_ms != 0)
+static uint16_t sniff_period_ms = RADIO_SNIFF_PERIOD_MS;
+static uint16_t tx_wakeup_ms = 0;
+static rtimer_clock_t sniff_since = 0;
+static uint64_t sniff_ticks = 0;
+static uint64_t sniff_listen_ticks = 0;
+static uint64_t tx_wakeup_ticks = 0;
+static uint32_t sniff_rx_timeout_us = 0;
+static radio_sniff_stats_t sniff_stats;
+#else /*!RADIO_SNIFF_MODE*/
+#define RADIO_SNIFFING()          0
+#endif /*RADIO_SNIFF_MODE*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_ENERGY_SCAN
+/* Channel energy scan: an rtimer polls the scan process every
+ * RADIO_SCAN_SAMPLE_US, the process reads the running RSSI into a ring (head),
+ * folds the ring into the histogram of the channel (tail) and moves to the
+ * next channel every RADIO_SCAN_DWELL_SAMPLES periods. The SPI is never used
+ * from the rtimer interrupt: the BSP only masks the radio IRQ around its
+ * transactions. The rtimer has a single instance, shared with the ACK wait:
+ * no frame is sent while scanning. */
+#define SCAN_RING_LEN             64      /* power of 2, up to 128 */
+#define SCAN_CHANNELS             (CHANNEL_NUMBER_MAX - CHANNEL_NUMBER_MIN + 1)
+/* 2 dB bins from -128 dBm, the last one also takes anything stronger */
+#define SCAN_HIST_MIN_DBM         (-128)
+#define SCAN_HIST_BIN_DB          2
+#define SCAN_HIST_BINS            48
+#define SCAN_EXPORT_VERSION       1
+#define SCAN_EXPORT_HEADER_LEN    18
+#define SCAN_EXPORT_CHANNEL_LEN   11
+#define RADIO_SCANNING()          (scan_active != 0)
+typedef struct {
+  uint16_t hist[SCAN_HIST_BINS];  /* halved when a bin is full */
+  int64_t sum;
+  uint32_t count;
+  uint32_t busy;
+  int8_t min;
+  int8_t max;
+} radio_scan_channel_t;
+static radio_scan_channel_t scan_table[SCAN_CHANNELS];
+static int8_t scan_ring[SCAN_RING_LEN];
+static volatile uint8_t scan_head = 0;
+static volatile uint8_t scan_tail = 0;
+static volatile uint8_t scan_active = 0;
+static volatile uint8_t scan_settle = 0;   /* the next sample is the first after a tune */
+static volatile uint16_t scan_taken = 0;   /* periods of the current dwell */
+static uint16_t scan_served = 0;           /* of which seen by the process */
+static uint8_t scan_channel = 0;
+static int scan_home_channel = 0;          /* channel and state restored at the end */
+static uint8_t scan_home_off = 0;
+static uint16_t scan_sweeps_max = 0;       /* 0: until radio_scan_stop() */
+static uint16_t scan_sweeps = 0;
+static volatile uint32_t scan_skipped = 0;
+static volatile uint32_t scan_overflows = 0;
+static struct rtimer scan_timer;
+PROCESS(radio_scan_process, "subGHz energy scan");
+#else /*!RADIO_ENERGY_SCAN*/
+#define RADIO_SCANNING()          0
+#endif /*RADIO_ENERGY_SCAN*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_ADAPTIVE_CCA
+#if !RADIO_HW_CSMA
+#error RADIO_ADAPTIVE_CCA needs RADIO_HW_CSMA
+#endif /*!RADIO_HW_CSMA*/
+/* CCA threshold of every channel set RADIO_CCA_MARGIN_DB above its noise
+ * floor: a ctimer reads the running RSSI while the radio idles in RX (the
+ * energy scan feeds its samples too), the minimum of RADIO_CCA_WINDOW samples
+ * goes into a moving average. Every RADIO_CCA_ADAPT_TX frames sent with CSMA,
+ * the share of frames dropped on busy CCAs and of frames not acknowledged
+ * moves the threshold around that value, and the backoff exponents of the
+ * MAC (radio_cca_backoff_boost). */
+#define CCA_CHANNELS              (CHANNEL_NUMBER_MAX - CHANNEL_NUMBER_MIN + 1)
+#define CCA_THRESHOLD_MIN_DBM     ((int)RSSI_TX_THRESHOLD - 15)
+#define CCA_THRESHOLD_MAX_DBM     ((int)RSSI_TX_THRESHOLD + 30)
+#define CCA_OFFSET_STEP_DB        3
+#define CCA_OFFSET_MIN_DB         (-6)
+#define CCA_OFFSET_MAX_DB         12
+#define CCA_BOOST_MAX             3
+#define CCA_BUSY_HIGH_PCT         50
+#define CCA_NOACK_HIGH_PCT        30
+typedef struct {
+  int16_t floor_q4;        /* noise floor in 1/16 dB, 0: not measured yet */
+  int8_t window_min;
+  uint8_t window_len;
+  int8_t offset_db;        /* threshold correction from the TX outcomes */
+  uint8_t boost;
+  uint8_t period_tx;       /* TX outcomes since the last check */
+  uint8_t period_busy;
+  uint8_t period_noack;
+  uint32_t samples;
+  uint32_t tx_frames;
+  uint32_t cca_busy;
+  uint32_t noack;
+  uint32_t adaptations;
+} radio_cca_channel_t;
+static radio_cca_channel_t cca_table[CCA_CHANNELS];
+static uint8_t cca_adaptive = 1;   /* cleared when RADIO_PARAM_CCA_THRESHOLD is set */
+static struct ctimer cca_timer;
+#endif /*RADIO_ADAPTIVE_CCA*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_STATS
+/* Driver instrumentation, see radio_stats_t. The ISR and the main context
+ * update it without locking: a count may be lost when both do at once. */
+static radio_stats_t stats;
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+static uint32_t stats_cycles_per_us = 1;
+#endif /*DWT_CTRL_CYCCNTENA_Msk*/
+static uint32_t stats_irq_edge = 0;   /* first call for the pending IRQ edge */
+static uint32_t stats_tx_start = 0;
+static uint32_t stats_rx_start = 0;
+static volatile uint8_t stats_tx_on = 0;
+static uint8_t stats_rx_on = 0;
+#endif /*RADIO_STATS*/
+#if RADIO_SHELL
+static struct ctimer radio_shell_timer;
+static void radio_shell_register(void *ptr);
+#endif /*RADIO_SHELL*/
+/*---------------------------------------------------------------------------*/
 /**
 * @brief GPIO structure fitting
 */
@@ -131,6 +489,21 @@ SRadioInit xRadioInit = {
   BANDWIDTH
 };
 /*---------------------------------------------------------------------------*/
+#if RADIO_HW_ACK
+/**
+* @brief Packet STack structure fitting (the address field is always on)
+*/
+PktStackInit xStackInit={
+  PREAMBLE_LENGTH,
+  SYNC_LENGTH,
+  SYNC_WORD,
+  VARIABLE_LENGTH,
+  EXTENDED_LENGTH_FIELD,
+  CRC_MODE,
+  EN_FEC,
+  EN_WHITENING
+};
+#else /*!RADIO_HW_ACK*/
 /**
 * @brief Packet Basic structure fitting
 */
@@ -145,6 +518,7 @@ PktBasicInit xBasicInit={
   EN_FEC,
   EN_WHITENING
 };
+#endif /*RADIO_HW_ACK*/
 
 #if RADIO_ADDRESS_FILTERING
 PktBasicAddressesInit xAddressInit={
@@ -194,6 +568,9 @@ static int Radio_init(void);
 static int Radio_prepare(const void *payload, unsigned short payload_len);
 static int Radio_transmit(unsigned short payload_len);
 static int Radio_send(const void *data, unsigned short len);
+/* Not in radio-driver.h: Contiki-NG TSCH schedules Radio_transmit() from its
+ * own rtimer. Used by the radio bench to check RADIO_DELAY_BEFORE_TX_US */
+int radio_transmit_at(unsigned short payload_len, uint32_t sfd_time);
 static int Radio_read(void *buf, unsigned short bufsize);
 static int Radio_channel_clear(void);
 static int Radio_receiving_packet(void);
@@ -206,8 +583,67 @@ static radio_result_t Radio_get_object(radio_param_t parameter, void *destinatio
 static radio_result_t Radio_set_object(radio_param_t parameter, const void *source, size_t size);
 /*---------------------------------------------------------------------------*/
 static void radio_set_polling_mode(uint8_t enable);
-static int Radio_read_from_fifo (uint8_t* buf, unsigned short bufsize);
+static uint32_t radio_poll_irqs(void);
+static uint32_t radio_irq_status(void);
+static int Radio_read_from_fifo (uint8_t* buf, unsigned short bufsize, uint16_t drained);
+static radio_rx_slot_t *radio_rx_ring_push(void);
+static uint8_t radio_rx_ring_peek(void);
+static void radio_rx_ring_release(uint8_t index);
+static int radio_tx_end(int retval, uint8_t radio_state);
+#if RADIO_ISR_ACK
+static int16_t radio_ack_request_seqno(const uint8_t *frame, unsigned short len);
+static uint8_t radio_frame_wants_ack(const uint8_t *frame, unsigned short len);
+static void radio_ack_send(uint8_t seqno);
+static void radio_ack_sent(void);
+static void radio_ack_wait_start(uint8_t radio_state);
+static int radio_ack_result(void);
+#endif /*RADIO_ISR_ACK*/
+#if RADIO_HW_ACK
+static void radio_hw_ack_request(uint8_t enable);
+static void radio_hw_ack_rx_timer(uint8_t ack_wait);
+static void radio_hw_ack_auto(void);
+#endif /*RADIO_HW_ACK*/
+#if RADIO_FIFO_STREAMING
+static void radio_tx_stream_refill(void);
+static void radio_tx_stream_stop(void);
+static void radio_rx_stream_drain(void);
+#endif /*RADIO_FIFO_STREAMING*/
+#if RADIO_ASYNC_TX
+static void radio_tx_async_timeout_handler(void *ptr);
+static void radio_tx_async_complete(void);
+#endif /*RADIO_ASYNC_TX*/
+#if RADIO_HOPPING
+static void radio_hop_calibrate(void);
+static void radio_hop_write(int channel);
+#endif /*RADIO_HOPPING*/
+#if RADIO_SNIFF_MODE
+static void radio_sniff_configure(void);
+static void radio_sniff_ldc(uint8_t enable);
+static void radio_sniff_account(void);
+#endif /*RADIO_SNIFF_MODE*/
+#if RADIO_ENERGY_SCAN
+static void radio_scan_timer(struct rtimer *t, void *ptr);
+static void radio_scan_sample(uint16_t taken);
+static void radio_scan_tune(uint8_t channel);
+static void radio_scan_drain(void);
+static void radio_scan_end(void);
+#endif /*RADIO_ENERGY_SCAN*/
+#if RADIO_ADAPTIVE_CCA
+static void radio_cca_sample(void *ptr);
+static void radio_cca_feed(uint8_t channel, int32_t rssi);
+static void radio_cca_account(int status);
+#endif /*RADIO_ADAPTIVE_CCA*/
+static int radio_cca_threshold(int channel);
+#if RADIO_STATS
+static void radio_stats_record(uint8_t hist, uint32_t elapsed);
+static void radio_stats_wait(uint32_t start, uint8_t timeout);
+static void radio_stats_tx_done(void);
+static void radio_stats_bus(uint8_t header, uint16_t len);
+#endif /*RADIO_STATS*/
+static void radio_energest_listen(void);
 static S2LPState radio_refresh_status(void);
+static void radio_select_lock(void);
+static void radio_select_unlock(void);
 /*---------------------------------------------------------------------------*/
 /* Radio Driver Structure as per Contiki-NG definition                          */
 const struct radio_driver subGHz_radio_driver =
@@ -240,6 +676,35 @@ static S2LPState radio_refresh_status(void)
   return g_xStatus.MC_STATE;
 }
 /*---------------------------------------------------------------------------*/
+static uint32_t radio_select_primask;
+static uint8_t radio_select_depth;
+/**
+* @brief  radio_select_lock, radio_select_unlock
+* 	critical section of S2LP_SelectObject: the IRQ handler of every radio
+* 	selects its own object and must not come in the middle of a swap, so
+* 	all the interrupts are masked, not only the EXTI line of this radio.
+* 	The PRIMASK found at the outermost entry is restored at its exit
+* @param  none
+* @retval None
+*/
+static void
+radio_select_lock(void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  if(radio_select_depth++ == 0) {
+    radio_select_primask = primask;
+  }
+}
+static void
+radio_select_unlock(void)
+{
+  if(--radio_select_depth == 0) {
+    __set_PRIMASK(radio_select_primask);
+  }
+}
+/*---------------------------------------------------------------------------*/
 /**
 * @brief  radio_print_status
 * 	prints to the UART the status of the radio
@@ -298,9 +763,10 @@ void radio_set_ready_state(void)
   S2LP_GPIO_IrqClearStatus();
 
 #if RADIO_SNIFF_MODE
-  S2LP_GPIO_IrqConfig(RX_DATA_READY,S_DISABLE);
-  S2LP_TIM_LdcrMode(S_DISABLE);
-  S2LP_TIM_FastRxTermTimer(S_DISABLE);
+  if(RADIO_SNIFFING()) {
+    /* Else the wake-up timer takes the radio out of READY */
+    radio_sniff_ldc(0);
+  }
 #endif /*RADIO_SNIFF_MODE*/
 
   if (radio_refresh_status()==MC_STATE_RX){
@@ -313,7 +779,11 @@ void radio_set_ready_state(void)
   S2LP_CMD_StrobeCommand(CMD_FLUSHRXFIFO);
   receiving_packet = 0;
   pending_packet=0;
-  CLEAR_RXBUF();
+  poll_irqs = 0;
+#if RADIO_FIFO_STREAMING
+  rx_stream_len = 0;
+  rx_stream_drop = 0;
+#endif /*RADIO_FIFO_STREAMING*/
 
   S2LP_GPIO_IrqClearStatus();
   RADIO_IRQ_ENABLE();
@@ -333,13 +803,40 @@ Radio_init(void)
 {
   LOG_DBG("RADIO INIT IN\n");
 
+  /* The BSP registers its bus on the object selected */
+  S2LP_RegisterCriticalSection(radio_select_lock, radio_select_unlock);
+  S2LP_SelectObject(&radio_s2lp);
   S2LPInterfaceInit();
+#if RADIO_STATS
+#if defined(DWT_CTRL_CYCCNTENA_Msk)
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  stats_cycles_per_us = SystemCoreClock / 1000000;
+#endif /*DWT_CTRL_CYCCNTENA_Msk*/
+  S2LP_RegisterBusMonitor(radio_stats_bus);
+#endif /*RADIO_STATS*/
+#if RADIO_SHELL
+  /* shell_commands_init() empties the command list, after the radio init */
+  ctimer_set(&radio_shell_timer, 0, radio_shell_register, NULL);
+#endif /*RADIO_SHELL*/
 
   /* Configures the Radio library */
   S2LP_RADIO_SetXtalFrequency(XTAL_FREQUENCY);
 
   S2LP_CMD_StrobeSres();
 
+#if RADIO_SHADOW_REGS
+  /* One burst read of the configuration registers: from now on the library
+   * setters only write them */
+  S2LP_ShadowEnable(S_ENABLE);
+  S2LP_ShadowResync();
+#endif /*RADIO_SHADOW_REGS*/
+
+#if RADIO_BATCH_INIT
+  /* The configuration below reaches the radio as a few bursts */
+  S2LP_BatchBegin();
+#endif /*RADIO_BATCH_INIT*/
+
   /* S2LP Radio config */
   S2LP_RADIO_Init(&xRadioInit);
 
@@ -362,17 +859,35 @@ Radio_init(void)
   S2LP_RADIO_SetPALevelMaxIndex(POWER_INDEX);
 
 /* Configures the Radio packet handler part*/
+#if RADIO_HW_ACK
+  S2LP_PCKT_STACK_Init(&xStackInit);
+#else /*!RADIO_HW_ACK*/
   S2LP_PCKT_BASIC_Init(&xBasicInit);
+#endif /*RADIO_HW_ACK*/
 
 #if RADIO_ADDRESS_FILTERING
   S2LP_PCKT_HNDL_SetAutoPcktFilter(S_ENABLE);
   S2LP_PCKT_HNDL_SelectSecondarySync(S_DISABLE);
   xAddressInit.cMyAddress = linkaddr_node_addr.u8[LINKADDR_SIZE-1];
+  /* Same filtering registers for the STack format */
   S2LP_PCKT_BASIC_AddressesInit(&xAddressInit);
   LOG_DBG("Node Source address %2X\n", xAddressInit.cMyAddress);
 #endif /*RADIO_ADDRESS_FILTERING*/
 
+#if RADIO_HW_ACK
+  /* NACK_TX is set at reset: no frame asks for an ACK until prepared so.
+   * No piggybacking, the ACKs carry no payload. */
+  S2LP_PCKT_STACK_NRetx(RADIO_HW_ACK_RETX);
+  radio_hw_ack_auto();
+#endif /*RADIO_HW_ACK*/
+
 #if RADIO_HW_CSMA
+  /* Nodes booted together would draw the same backoffs from the same seed */
+  xCsmaInit.nBuCounterSeed = BU_COUNTER_SEED ^
+    ((linkaddr_node_addr.u8[LINKADDR_SIZE-2] << 8) | linkaddr_node_addr.u8[LINKADDR_SIZE-1]);
+  if(xCsmaInit.nBuCounterSeed == 0) {
+    xCsmaInit.nBuCounterSeed = BU_COUNTER_SEED;
+  }
   S2LP_CSMA_Init(&xCsmaInit);
   S2LP_RADIO_QI_RssiInit(&xSRssiInit);
 #endif /*RADIO_HW_CSMA*/
@@ -382,15 +897,19 @@ Radio_init(void)
   S2LP_GPIO_IrqClearStatus();
   S2LP_GPIO_IrqConfig(TX_DATA_SENT, S_ENABLE);
   S2LP_GPIO_IrqConfig(RX_DATA_READY, S_ENABLE);
+#if RADIO_HW_ACK
+  S2LP_GPIO_IrqConfig(MAX_RE_TX_REACH, S_ENABLE);
+#endif /*RADIO_HW_ACK*/
+
+#if RADIO_FIFO_STREAMING
+  /* IRQ_TX_FIFO_ALMOST_EMPTY is enabled only while a long frame is sent */
+  S2LP_FIFO_SetAlmostEmptyThresholdTx(RADIO_FIFO_MARGIN);
+  S2LP_FIFO_SetAlmostFullThresholdRx(RADIO_FIFO_MARGIN);
+  S2LP_GPIO_IrqConfig(RX_FIFO_ALMOST_FULL, S_ENABLE);
+#endif /*RADIO_FIFO_STREAMING*/
 
-#if RADIO_SNIFF_MODE
-  S2LP_GPIO_IrqConfig(VALID_SYNC,S_DISABLE);
-  S2LP_GPIO_IrqConfig(RX_DATA_DISC, S_DISABLE);
-  S2LP_GPIO_IrqConfig(RX_TIMEOUT, S_DISABLE);
-#else /*!RADIO_SNIFF_MODE*/
   S2LP_GPIO_IrqConfig(VALID_SYNC, S_ENABLE);
   S2LP_GPIO_IrqConfig(RX_DATA_DISC, S_ENABLE);
-#endif /*RADIO_SNIFF_MODE*/
 
 #if RADIO_HW_CSMA
   S2LP_GPIO_IrqConfig(MAX_BO_CCA_REACH , S_ENABLE);
@@ -399,30 +918,17 @@ Radio_init(void)
   S2LP_GPIO_IrqConfig(MAX_BO_CCA_REACH , S_DISABLE);
 #endif /*RADIO_HW_CSMA*/
 
-#if RADIO_SNIFF_MODE
-  SRssiInit xSRssiInit = {
-    .cRssiFlt = 14,
-    .xRssiMode = RSSI_STATIC_MODE,
-    .cRssiThreshdBm = RSSI_TX_THRESHOLD
-  };
-  S2LP_RADIO_QI_RssiInit(&xSRssiInit);
-
-  S2LP_TIM_SetWakeUpTimerUs(1000*MIN_PERIOD_WAKEUP_MS); //12 ms
-  /* set the rx timeout */
-  S2LP_TIM_SetRxTimerUs(1000*RX_TIMEOUT_MS); //30 ms
-
-  S2LP_TIM_SleepB(S_ENABLE);
-
-  /* enable LDC mode, FAST RX TERM and start Rx */
-  S2LP_TIM_LdcrMode(S_ENABLE);
-  /* enable the fast rx timer */
-  S2LP_TIM_FastRxTermTimer(S_ENABLE);
-#else /*!RADIO_SNIFF_MODE*/
-
   S2LP_RADIO_QI_SetRssiThreshdBm(RSSI_RX_THRESHOLD);
   SET_INFINITE_RX_TIMEOUT();
   /* Configure Radio */
   S2LP_PCKT_HNDL_SetRxPersistentMode(S_ENABLE);
+
+#if RADIO_SNIFF_MODE
+  /* The FIFOs are kept while the radio sleeps between two wake ups */
+  S2LP_TIM_SleepB(S_ENABLE);
+  if(RADIO_SNIFFING()) {
+    radio_sniff_configure();
+  }
 #endif /*RADIO_SNIFF_MODE*/
 
   CLEAR_RXBUF();
@@ -430,14 +936,39 @@ Radio_init(void)
   /* Configure the radio to route the IRQ signal to its GPIO 3 */
   S2LP_GPIO_Init(&xGpioIRQ);
 
-  radio_set_polling_mode(polling_mode);
+#if RADIO_BATCH_INIT
+  S2LP_BatchEnd();
+#endif /*RADIO_BATCH_INIT*/
+
+#if RADIO_HOPPING
+  radio_hop_calibrate();
+#endif /*RADIO_HOPPING*/
+
+  if(polling_mode) {
+    /* Asked before init: the masks configured above are put aside */
+    polling_mode = 0;
+    radio_set_polling_mode(1);
+  }
 
+#if RADIO_SNIFF_MODE
+  if(RADIO_SNIFFING()) {
+    radio_sniff_ldc(1);
+  }
+  sniff_since = RTIMER_NOW();
+#endif /*RADIO_SNIFF_MODE*/
   S2LP_ConfigRangeExt(PA_RX);
   /* This is ok for normal or SNIFF (RX command triggers the LDC in fast RX termination mode) */
   S2LP_CMD_StrobeRx();
   radio_on = ON;
+  radio_energest_listen();
 
   process_start(&subGHz_radio_process, NULL);
+#if RADIO_ENERGY_SCAN
+  process_start(&radio_scan_process, NULL);
+#endif /*RADIO_ENERGY_SCAN*/
+#if RADIO_ADAPTIVE_CCA
+  ctimer_set(&cca_timer, RADIO_CCA_SAMPLE_MS * CLOCK_SECOND / 1000, radio_cca_sample, NULL);
+#endif /*RADIO_ADAPTIVE_CCA*/
 
   LOG_DBG("Radio init done\n");
   return 0;
@@ -454,7 +985,27 @@ static int
 Radio_prepare(const void *payload, unsigned short payload_len)
 {
   LOG_DBG("Radio: prepare %u\n", payload_len);
+#if RADIO_FIFO_STREAMING
+  uint8_t *tmpbuff = tx_stream_buf;
+#else /*!RADIO_FIFO_STREAMING*/
   uint8_t tmpbuff[PACKETBUF_SIZE]; //@TODO: see below
+#endif /*RADIO_FIFO_STREAMING*/
+
+  if(RADIO_SCANNING()) {
+    LOG_DBG("Radio: no TX while scanning\n");
+    return RADIO_TX_ERR;
+  }
+
+#if RADIO_ASYNC_TX
+  /* A new frame can be loaded only once the previous one is on air */
+  radio_tx_async_complete();
+#endif /*RADIO_ASYNC_TX*/
+#if RADIO_ISR_ACK
+  /* Do not abort an ACK the ISR is sending */
+  BUSYWAIT_UNTIL(!ack_sending, RADIO_WAIT_TIMEOUT);
+  ack_seqno = -1;
+#endif /*RADIO_ISR_ACK*/
+
   packet_is_prepared = 0;
 
   /* Checks if the payload length is supported: actually this can't happen, by
@@ -465,6 +1016,14 @@ Radio_prepare(const void *payload, unsigned short payload_len)
     LOG_DBG("Payload len too big (> %d), error.\n", PACKETBUF_SIZE);
     return RADIO_TX_ERR;
   }
+#if RADIO_FIFO_STREAMING
+  /* The poll mode has no TX_FIFO_ALMOST_EMPTY IRQ to stream the rest with */
+  if(payload_len > S2LP_TX_FIFO_SIZE && polling_mode)
+  {
+    LOG_DBG("Payload bigger than FIFO size in poll mode, error.\n");
+    return RADIO_TX_ERR;
+  }
+#endif /*RADIO_FIFO_STREAMING*/
 
   /* Sets the length of the packet to send */
   RADIO_IRQ_DISABLE();
@@ -475,9 +1034,9 @@ Radio_prepare(const void *payload, unsigned short payload_len)
     radio_print_status();
     S2LP_CMD_StrobeSabort();
 #if RADIO_SNIFF_MODE
-    S2LP_TIM_LdcrMode(S_ENABLE);
-    S2LP_TIM_FastRxTermTimer(S_ENABLE);
-    S2LP_GPIO_IrqConfig(RX_DATA_READY,S_ENABLE);
+    if(RADIO_SNIFFING()) {
+      radio_sniff_ldc(1);
+    }
 #endif /*RADIO_SNIFF_MODE*/
     S2LP_ConfigRangeExt(PA_RX);
     S2LP_CMD_StrobeRx();
@@ -485,10 +1044,14 @@ Radio_prepare(const void *payload, unsigned short payload_len)
     RADIO_IRQ_ENABLE();
     return   RADIO_TX_ERR;
   }
+#if RADIO_FIFO_STREAMING
+  radio_tx_stream_stop();
+#endif /*RADIO_FIFO_STREAMING*/
 
 #if RADIO_ADDRESS_FILTERING
   const linkaddr_t *addr;
-  if(auto_pkt_filter){
+  /* The hardware ACK comes only from the node the frame is addressed to */
+  if(auto_pkt_filter || RADIO_HW_ACK_FRAME(payload_len)){
     if (payload_len == ACK_LEN || packetbuf_holds_broadcast()) {
       LOG_DBG("Preparing to send to broadcast (%02X) address\n", BROADCAST_ADDRESS);
       S2LP_PCKT_HNDL_SetRxSourceReferenceAddress(BROADCAST_ADDRESS);
@@ -502,16 +1065,29 @@ Radio_prepare(const void *payload, unsigned short payload_len)
 
   S2LP_CMD_StrobeCommand(CMD_FLUSHTXFIFO);
 
-  S2LP_PCKT_BASIC_SetPayloadLength(payload_len);
+  SET_PAYLOAD_LENGTH(payload_len);
   //@TODO change IO implementation to avoid the copy here
   memcpy(tmpbuff, payload, payload_len);
 
-  /* Currently does no happen since S2LP_RX_FIFO_SIZE == MAX_PACKET_LEN
+#if RADIO_FIFO_STREAMING
+  if(payload_len > S2LP_TX_FIFO_SIZE && !polling_mode)
+  {
+    /* The rest is written by Radio_interrupt_callback while on air */
+    S2LP_WriteFIFO(S2LP_TX_FIFO_SIZE, tmpbuff);
+    tx_stream_pos = S2LP_TX_FIFO_SIZE;
+    tx_stream_len = payload_len;
+    S2LP_GPIO_IrqConfig(TX_FIFO_ALMOST_EMPTY, S_ENABLE);
+    packet_is_prepared = 1;
+  }
+  else
+#endif /*RADIO_FIFO_STREAMING*/
+  /* Without RADIO_FIFO_STREAMING, does not happen since
+   * S2LP_RX_FIFO_SIZE == MAX_PACKET_LEN
    * also note that S2LP_RX_FIFO_SIZE == S2LP_TX_FIFO_SIZE
    */
   if(payload_len > S2LP_TX_FIFO_SIZE)
   {
-    LOG_DBG("Payload bigger than FIFO size.'n");
+    LOG_DBG("Payload bigger than FIFO size.\n");
   }
   else
   {
@@ -519,6 +1095,16 @@ Radio_prepare(const void *payload, unsigned short payload_len)
 //    S2LP_WriteFIFO(payload_len, (uint8_t *)payload);
     packet_is_prepared = 1;
   }
+#if RADIO_ISR_ACK
+  /* tmpbuff now holds what the SPI read back */
+  if(packet_is_prepared) {
+    ack_seqno = radio_ack_request_seqno(payload, payload_len);
+  }
+#endif /*RADIO_ISR_ACK*/
+#if RADIO_HW_ACK
+  radio_hw_ack_request(ack_seqno >= 0 && RADIO_HW_ACK_FRAME(payload_len));
+  tx_attempts = 1;
+#endif /*RADIO_HW_ACK*/
 
   RADIO_IRQ_ENABLE();
 
@@ -538,10 +1124,13 @@ Radio_transmit(unsigned short payload_len)
 {
   int retval = RADIO_TX_ERR;
   uint8_t radio_state = radio_on;
+#if RADIO_STATS
+  uint32_t stats_t0 = RADIO_STATS_NOW();
+#endif /*RADIO_STATS*/
 
   /* This function blocks until the packet has been transmitted */
   LOG_DBG("TRANSMIT IN\n");
-  if(!packet_is_prepared)
+  if(!packet_is_prepared || RADIO_SCANNING())
   {
     LOG_DBG("Radio TRANSMIT: ERROR, packet is NOT prepared.\n");
     return RADIO_TX_ERR;
@@ -555,35 +1144,120 @@ Radio_transmit(unsigned short payload_len)
 
   transmitting_packet = 1;
   S2LP_GPIO_IrqClearStatus();
+  poll_irqs = 0;
   RADIO_IRQ_ENABLE();
 
 #if RADIO_HW_CSMA
   if (csma_enabled) { //@TODO: add an API to enable/disable CSMA
 	S2LP_CSMA_Enable(S_ENABLE);
-	S2LP_RADIO_QI_SetRssiThreshdBm(RSSI_TX_THRESHOLD);
+	S2LP_RADIO_QI_SetRssiThreshdBm(radio_cca_threshold(conf_channel));
 	retval = RADIO_TX_COLLISION;
   }
 #endif  /*RADIO_HW_CSMA*/
 
+#if RADIO_SNIFF_MODE
+  if(tx_wakeup_ms) {
+    /* The preamble lasts a sniff period of the receivers */
+    S2LP_PCKT_HNDL_SetPreambleLength(RADIO_WAKEUP_PREAMBLE(tx_wakeup_ms));
+    sniff_stats.tx_frames++;
+    tx_wakeup_ticks += US_TO_RTIMERTICKS(1000UL * tx_wakeup_ms);
+  }
+#endif /*RADIO_SNIFF_MODE*/
+  ENERGEST_ON(ENERGEST_TYPE_TRANSMIT);
+
   xTxDoneFlag = RESET;
+#if RADIO_HW_ACK
+  hw_ack_missed = 0;
+#endif /*RADIO_HW_ACK*/
+
+#if RADIO_ASYNC_TX
+  if(tx_done_callback != NULL && !polling_mode) {
+    /* Completion is handled by the radio process on IRQ_TX_DATA_SENT (or on
+     * timeout): the flag must be set before the IRQ can fire. */
+    tx_async_callback = tx_done_callback;
+    tx_done_callback = NULL;
+    tx_async_radio_state = radio_state;
+    tx_async_retval = retval;
+    tx_async_timeout = 0;
+    tx_async_pending = 1;
+    ctimer_set(&tx_async_timer, RADIO_TX_ASYNC_TIMEOUT, radio_tx_async_timeout_handler, NULL);
+    S2LP_ConfigRangeExt(PA_TX);
+#if RADIO_STATS
+    stats_tx_start = RADIO_STATS_NOW();
+    stats_tx_on = 1;
+#endif /*RADIO_STATS*/
+    S2LP_CMD_StrobeTx();
+#if RADIO_STATS
+    radio_stats_record(RADIO_STATS_TRANSMIT, RADIO_STATS_NOW() - stats_t0);
+#endif /*RADIO_STATS*/
+    LOG_DBG("TRANSMIT OUT (async)\n");
+    return RADIO_TX_OK;
+  }
+#endif /*RADIO_ASYNC_TX*/
+
   S2LP_ConfigRangeExt(PA_TX);
+#if RADIO_STATS
+  stats_tx_start = RADIO_STATS_NOW();
+  stats_tx_on = 1;
+#endif /*RADIO_STATS*/
   S2LP_CMD_StrobeTx();
    /* wait for TX done */
-  if (polling_mode) { //@TODO: To be validated
-    while(!xTxDoneFlag) {
-      uint8_t tmp;
-      BUSYWAIT_UNTIL(0, 2 * RTIMER_SECOND/1000);
-      S2LP_ReadRegister(TX_FIFO_STATUS_ADDR, 1, &tmp);
-      if ((tmp & NELEM_TXFIFO_REGMASK) == 0 ){
-        xTxDoneFlag = SET;
-        transmitting_packet = 0;
-      }
+  if (polling_mode) {
+    /* The packet handler is done with the frame (and its ACK) when it
+     * raises IRQ_TX_DATA_SENT, or IRQ_MAX_RE_TX_REACH */
+    BUSYWAIT_UNTIL(radio_poll_irqs() & (TX_DATA_SENT | MAX_RE_TX_REACH), 10* RADIO_WAIT_TIMEOUT);
+    if(poll_irqs & (TX_DATA_SENT | MAX_RE_TX_REACH)) {
+#if RADIO_HW_ACK
+      hw_ack_missed = ((poll_irqs & MAX_RE_TX_REACH) != 0);
+#endif /*RADIO_HW_ACK*/
+      poll_irqs &= ~(TX_DATA_SENT | MAX_RE_TX_REACH);
+      transmitting_packet = 0;
+      xTxDoneFlag = SET;
+#if RADIO_STATS
+      radio_stats_tx_done();
+#endif /*RADIO_STATS*/
     }
-    BUSYWAIT_UNTIL(0, 2 * RTIMER_SECOND/1000); //@TODO: we need a delay here, validate.
   } else {
 	/*To be on the safe side we put a timeout. */
     BUSYWAIT_UNTIL(xTxDoneFlag, 10* RADIO_WAIT_TIMEOUT);
   }
+
+  retval = radio_tx_end(retval, radio_state);
+#if RADIO_ISR_ACK
+  if(ack_state != ACK_IDLE) {
+    /* Bounded by the rtimer, the ACK is matched by the ISR. The radio
+     * process cannot run meanwhile: an IRQ the ISR deferred is served here */
+    do {
+      BUSYWAIT_UNTIL(ack_state != ACK_WAITING || interrupt_callback_wants_poll,
+                     2 * RADIO_ACK_WAIT_TIME);
+      if(!interrupt_callback_wants_poll) {
+        break;
+      }
+      Radio_interrupt_callback();
+    } while(ack_state == ACK_WAITING);
+    retval = radio_ack_result();
+  }
+#endif /*RADIO_ISR_ACK*/
+#if RADIO_ADAPTIVE_CCA
+  radio_cca_account(retval);
+#endif /*RADIO_ADAPTIVE_CCA*/
+#if RADIO_STATS
+  radio_stats_record(RADIO_STATS_TRANSMIT, RADIO_STATS_NOW() - stats_t0);
+#endif /*RADIO_STATS*/
+  return retval;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_tx_end
+* 	checks the outcome of the transmission and puts the radio back in RX
+* @param  int retval: value to return if the packet has not been sent
+* @param  uint8_t radio_state: radio state before the transmission
+* @retval int result(RADIO_TX_OK if the packet has been sent)
+*/
+static int
+radio_tx_end(int retval, uint8_t radio_state)
+{
+  ENERGEST_OFF(ENERGEST_TYPE_TRANSMIT);
   if (transmitting_packet){
     S2LP_CMD_StrobeSabort();
     if (xTxDoneFlag==RESET) {
@@ -596,45 +1270,80 @@ Radio_transmit(unsigned short payload_len)
     retval = RADIO_TX_OK;
   }
   xTxDoneFlag = RESET;
+#if RADIO_HW_ACK
+  if(RADIO_HW_ACKED()) {
+    /* The ACK wait and the retransmissions are over */
+    tx_attempts = S2LP_PCKT_STACK_GetNReTx() + 1;
+    if(retval == RADIO_TX_OK && hw_ack_missed) {
+      retval = RADIO_TX_NOACK;
+    }
+    radio_hw_ack_rx_timer(0);
+  }
+#endif /*RADIO_HW_ACK*/
 
 #if RADIO_HW_CSMA
   if (csma_enabled) {
     S2LP_CSMA_Enable(S_DISABLE);
-#  if !RADIO_SNIFF_MODE
-    S2LP_RADIO_QI_SetRssiThreshdBm(RSSI_RX_THRESHOLD);
-#  endif /*!RADIO_SNIFF_MODE*/
+    /* When sniffing, RSSI_TX_THRESHOLD is also the carrier sense threshold */
+    if(!RADIO_SNIFFING()) {
+      S2LP_RADIO_QI_SetRssiThreshdBm(RSSI_RX_THRESHOLD);
+    } else if(radio_cca_threshold(conf_channel) != (int)RSSI_TX_THRESHOLD) {
+      S2LP_RADIO_QI_SetRssiThreshdBm(RSSI_TX_THRESHOLD);
+    }
   }
 #endif /*RADIO_HW_CSMA*/
-
-  if(!IS_RXBUF_EMPTY()){
-    CLEAR_RXBUF();
+#if RADIO_SNIFF_MODE
+  if(tx_wakeup_ms) {
+    S2LP_PCKT_HNDL_SetPreambleLength(PREAMBLE_LENGTH);
   }
+#endif /*RADIO_SNIFF_MODE*/
+
+  /* Whatever is queued now came before the frame just sent */
+  rx_ring_ack_mark = rx_ring_head;
+  rx_ring_ack_wait = 1;
 
   RADIO_IRQ_DISABLE();
 
+#if RADIO_FIFO_STREAMING
+  radio_tx_stream_stop();
+#endif /*RADIO_FIFO_STREAMING*/
 #if RADIO_SNIFF_MODE
-  S2LP_TIM_LdcrMode(S_ENABLE);
-  S2LP_TIM_FastRxTermTimer(S_ENABLE);
-  S2LP_GPIO_IrqConfig(RX_DATA_READY,S_ENABLE);
+  /* An ACK has a short preamble: the radio listens until the wait is over */
+  if(RADIO_SNIFFING()
+#if RADIO_ISR_ACK
+     && (retval != RADIO_TX_OK || ack_seqno < 0 || RADIO_HW_ACKED())
+#endif /*RADIO_ISR_ACK*/
+    ) {
+    radio_sniff_ldc(1);
+  }
 #endif /*RADIO_SNIFF_MODE*/
 
   S2LP_ConfigRangeExt(PA_RX);
   S2LP_CMD_StrobeRx();
-  BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_RX
-#if RADIO_SNIFF_MODE
-                 || radio_refresh_status() == MC_STATE_SLEEP_NOFIFO
-#endif /*RADIO_SNIFF_MODE*/
-                 , RADIO_WAIT_TIMEOUT);
+  /* When sniffing the radio may already be back to sleep */
+  BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_RX ||
+                 (RADIO_SNIFFING() && (g_xStatus.MC_STATE == MC_STATE_SLEEP ||
+                                       g_xStatus.MC_STATE == MC_STATE_SLEEP_NOFIFO)),
+                 RADIO_WAIT_TIMEOUT);
 
   packet_is_prepared = 0;
 
   S2LP_CMD_StrobeCommand(CMD_FLUSHTXFIFO);
 
   S2LP_GPIO_IrqClearStatus();
+  poll_irqs = 0;
   RADIO_IRQ_ENABLE();
 
   LOG_DBG("TRANSMIT OUT\n");
 
+#if RADIO_ISR_ACK
+  if(retval == RADIO_TX_OK && ack_seqno >= 0 && !RADIO_HW_ACKED()) {
+    /* The radio is turned off, if needed, once the ACK wait is over */
+    radio_ack_wait_start(radio_state);
+    return retval;
+  }
+#endif /*RADIO_ISR_ACK*/
+
   if(radio_state==OFF){
     /*If the radio was OFF before transmitting the packet, we must turn it
     * OFF (legacy for ContikiMAC like upper layer) */
@@ -655,12 +1364,15 @@ static int Radio_send(const void *payload, unsigned short payload_len)
 {
   LOG_DBG("Radio Send\r\n");
 
+  if(RADIO_SCANNING()) {
+    return RADIO_TX_ERR;
+  }
   if(Radio_prepare(payload, payload_len) != RADIO_TX_OK)
   {
 #if RADIO_SNIFF_MODE
-    S2LP_TIM_LdcrMode(S_ENABLE);
-    S2LP_TIM_FastRxTermTimer(S_ENABLE);
-    S2LP_GPIO_IrqConfig(RX_DATA_READY,S_ENABLE);
+    if(RADIO_SNIFFING()) {
+      radio_sniff_ldc(1);
+    }
 #endif /*RADIO_SNIFF_MODE*/
     S2LP_ConfigRangeExt(PA_RX);
     S2LP_CMD_StrobeRx();
@@ -671,274 +1383,2151 @@ static int Radio_send(const void *payload, unsigned short payload_len)
 }
 /*---------------------------------------------------------------------------*/
 /**
-* @brief  Radio_read
-* 	reads a packet received with the subGHz radio
-* @param  void *buf, unsigned short bufsize
-* @retval int bufsize
+* @brief  radio_transmit_at
+* 	sends the prepared frame with the end of its sync word at sfd_time:
+* 	busy-waits until RADIO_DELAY_BEFORE_TX_US before it, then runs a
+* 	synchronous Radio_transmit(), an armed tx_done_callback being kept for
+* 	the next one. The wait is bounded by one TSCH timeslot. The radio must
+* 	be on, else the XO start up comes on top. Precise in poll mode, where
+* 	no ISR can run meanwhile.
+* @param  unsigned short payload_len
+* @param  uint32_t sfd_time: in rtimer ticks
+* @retval int result(RADIO_TX_OK if sent, RADIO_TX_ERR if sfd_time is missed
+* 	or more than a timeslot away)
 */
-static int Radio_read(void *buf, unsigned short bufsize)
+int
+radio_transmit_at(unsigned short payload_len, uint32_t sfd_time)
 {
-    int retval = 0;
-    S2LPIrqs x_irq_status;
+  rtimer_clock_t start = (rtimer_clock_t)sfd_time - US_TO_RTIMERTICKS(RADIO_DELAY_BEFORE_TX_US);
+  rtimer_clock_t now = RTIMER_NOW();
+  int retval;
+#if RADIO_ASYNC_TX
+  radio_tx_done_callback_t callback = tx_done_callback;
+#endif /*RADIO_ASYNC_TX*/
 
-    if (polling_mode) {
-       S2LP_GPIO_IrqGetStatus(&x_irq_status);
-       if (x_irq_status.IRQ_RX_DATA_READY)
-         retval = Radio_read_from_fifo (buf, bufsize);
-    } else if (pending_packet && (rx_num_bytes!=0)) {
-      if (rx_num_bytes <= bufsize) {
-        memcpy(buf, radio_rxbuf, rx_num_bytes);
-        retval = rx_num_bytes;
-      } else {
-        LOG_DBG("Buf too small (%d bytes to hold %u bytes)\n", bufsize,rx_num_bytes );
-      }
-      pending_packet = 0;
-    }
-    /* RX command - to ensure the device will be ready for the next reception */
-#if RADIO_SNIFF_MODE
-      S2LP_CMD_StrobeSleep();
-#else /*!RADIO_SNIFF_MODE*/
-      S2LP_ConfigRangeExt(PA_RX);
-      S2LP_CMD_StrobeRx();
-#endif /*RADIO_SNIFF_MODE*/
-    CLEAR_RXBUF();
-    LOG_DBG("READ OUT: %d\n", retval);
-    return retval;
+  if(!packet_is_prepared || RTIMER_CLOCK_LT(start, now)) {
+    LOG_DBG("Radio TRANSMIT AT: too late\n");
+    return RADIO_TX_ERR;
+  }
+  if(RTIMER_CLOCK_LT(now + RADIO_TSCH_TIMESLOT_TICKS, start)) {
+    LOG_DBG("Radio TRANSMIT AT: too far\n");
+    return RADIO_TX_ERR;
+  }
+  while(RTIMER_CLOCK_LT(RTIMER_NOW(), start));
+#if RADIO_ASYNC_TX
+  tx_done_callback = NULL;
+#endif /*RADIO_ASYNC_TX*/
+  retval = Radio_transmit(payload_len);
+#if RADIO_ASYNC_TX
+  tx_done_callback = callback;
+#endif /*RADIO_ASYNC_TX*/
+  return retval;
 }
 /*---------------------------------------------------------------------------*/
+#if RADIO_ASYNC_TX
 /**
-* @brief  Radio_channel_clear
-* 	checks the channel
+* @brief  radio_set_tx_done_callback
+* 	arms a one-shot callback for the next Radio_transmit(): the transmission
+* 	is then asynchronous and the callback is called, from the radio process,
+* 	with the RADIO_TX_* result once the frame has been sent.
+* @param  radio_tx_done_callback_t callback (NULL to disarm)
+* @retval None
+*/
+void
+radio_set_tx_done_callback(radio_tx_done_callback_t callback)
+{
+  tx_done_callback = callback;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_tx_in_progress
+* 	checks whether an asynchronous transmission is not yet reported
 * @param  none
-* @retval int result
+* @retval int 1 until the callback of the transmission has been called
 */
-static int
-Radio_channel_clear(void)
+int
+radio_tx_in_progress(void)
 {
-  float rssi_value;
-  /* Local variable used to memorize the S2LP state */
-  uint8_t radio_state = radio_on;
-
-  LOG_DBG("CHANNEL CLEAR IN\n");
-
-  if(radio_on == OFF){
-    /* Wakes up the Radio */
-    Radio_on();
+  return (tx_async_pending || tx_async_notify);
+}
+/*---------------------------------------------------------------------------*/
+static void
+radio_tx_async_timeout_handler(void *ptr)
+{
+  UNUSED(ptr);
+  tx_async_timeout = 1;
+  process_poll(&subGHz_radio_process);
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_tx_async_complete
+* 	ends a pending asynchronous transmission, waiting for it if needed.
+* 	The callback is deferred to the radio process, so that it never runs
+* 	nested in another radio call.
+* @param  none
+* @retval None
+*/
+static void
+radio_tx_async_complete(void)
+{
+  if(!tx_async_pending) {
+    return;
   }
-  rssi_value = S2LP_RADIO_QI_GetRssidBmRun();
-  int ret = (rssi_value<RSSI_TX_THRESHOLD)?1:0;
-
-  /* Puts the S2LP in its previous state */
-  if(radio_state==OFF){
-    Radio_off();
+  if(!tx_async_timeout) {
+    BUSYWAIT_UNTIL(xTxDoneFlag, 10* RADIO_WAIT_TIMEOUT);
+  }
+  ctimer_stop(&tx_async_timer);
+  tx_async_pending = 0;
+  tx_async_status = radio_tx_end(tx_async_retval, tx_async_radio_state);
+  tx_async_notify = 1;
+  if(PROCESS_CURRENT() != &subGHz_radio_process) {
+    process_poll(&subGHz_radio_process);
   }
-
-  return ret;
 }
+#endif /*RADIO_ASYNC_TX*/
 /*---------------------------------------------------------------------------*/
+#if RADIO_ISR_ACK
 /**
-* @brief  Radio_receiving_packet
-* 	checks for receiving packet
-* @param  none
-* @retval int result
+* @brief  radio_ack_request_seqno
+* 	tells whether a frame to send asks for an ACK the driver has to match
+* @param  const uint8_t *frame, unsigned short len
+* @retval int16_t sequence number of the frame, -1 if no ACK is expected
 */
-static int
-Radio_receiving_packet(void)
+static int16_t
+radio_ack_request_seqno(const uint8_t *frame, unsigned short len)
 {
-  S2LPIrqs x_irq_status;
+  frame802154_t info;
 
-  if (polling_mode) {
-       S2LP_GPIO_IrqGetStatus(&x_irq_status);
-       receiving_packet = (x_irq_status.IRQ_VALID_SYNC) ;
+  if(!radio_send_auto_ack || polling_mode ||
+     frame802154_parse((uint8_t *)frame, len, &info) == 0) {
+    return -1;
   }
-
-  return receiving_packet;
+  if((info.fcf.frame_type != FRAME802154_DATAFRAME && info.fcf.frame_type != FRAME802154_CMDFRAME) ||
+     !info.fcf.ack_required) {
+    return -1;
+  }
+  return info.seq;
 }
 /*---------------------------------------------------------------------------*/
 /**
-* @brief  Radio_pending_packet
-* 	checks for pending packet
-* @param  none
-* @retval int result
+* @brief  radio_frame_wants_ack
+* 	tells whether a received frame must be acknowledged by this node
+* @param  const uint8_t *frame, unsigned short len
+* @retval uint8_t 1 if an ACK has to be sent
 */
-static int
-Radio_pending_packet(void)
+static uint8_t
+radio_frame_wants_ack(const uint8_t *frame, unsigned short len)
 {
-  S2LPIrqs x_irq_status;
-  //LOG_DBG("RADIO PENDING PACKET\n");
-  if (polling_mode) {
-       S2LP_GPIO_IrqGetStatus(&x_irq_status);
-       pending_packet = (x_irq_status.IRQ_RX_DATA_READY) ;
-  }
+  frame802154_t info;
 
-  return pending_packet;
+  if(!radio_send_auto_ack || polling_mode || RADIO_HW_ACK_FRAME(len) ||
+     frame802154_parse((uint8_t *)frame, len, &info) == 0) {
+    return 0;
+  }
+  if((info.fcf.frame_type != FRAME802154_DATAFRAME && info.fcf.frame_type != FRAME802154_CMDFRAME) ||
+     !info.fcf.ack_required) {
+    return 0;
+  }
+  if(info.fcf.dest_addr_mode == FRAME802154_NOADDR ||
+     (info.dest_pid != frame802154_get_pan_id() && info.dest_pid != FRAME802154_BROADCASTPANDID)) {
+    return 0;
+  }
+  return linkaddr_cmp((linkaddr_t *)info.dest_addr, &linkaddr_node_addr);
 }
 /*---------------------------------------------------------------------------*/
 /**
-* @brief  Radio_off
-* 	turns off the Sub-GHz radio
-* @param  none
-* @retval int result(0 == success)
+* @brief  radio_ack_send
+* 	sends the ACK of the frame just received (ISR side)
+* @param  uint8_t seqno
+* @retval none
 */
-static int
-Radio_off(void)
+static void
+radio_ack_send(uint8_t seqno)
 {
-  LOG_DBG("Radio: ->off\n");
+  uint8_t ack[ACK_LEN];
 
-  if(radio_on == ON)
-  {
-    /* Disables the mcu to get IRQ from the RADIO */
-    RADIO_IRQ_DISABLE();  //Mind that it will be enabled only in the ON
+  ack[0] = FRAME802154_ACKFRAME;
+  ack[1] = 0;
+  ack[2] = seqno;
 
-#if RADIO_SNIFF_MODE
-    S2LP_TIM_LdcrMode(S_DISABLE);
-    S2LP_TIM_FastRxTermTimer(S_DISABLE);
-    S2LP_CMD_StrobeReady();
+  /* The persistent RX keeps the radio in RX: TX is allowed from READY only */
+  S2LP_CMD_StrobeSabort();
+  BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_READY, RADIO_WAIT_TIMEOUT);
+#if RADIO_ADDRESS_FILTERING
+  S2LP_PCKT_HNDL_SetRxSourceReferenceAddress(BROADCAST_ADDRESS);
+#endif /*RADIO_ADDRESS_FILTERING*/
+#if RADIO_HW_ACK
+  radio_hw_ack_request(0);
+#endif /*RADIO_HW_ACK*/
+  SET_PAYLOAD_LENGTH(ACK_LEN);
+  S2LP_WriteFIFO(ACK_LEN, ack);
+
+  ack_sending = 1;
+  transmitting_packet = 1;
+  S2LP_ConfigRangeExt(PA_TX);
+  S2LP_CMD_StrobeTx();
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_ack_sent
+* 	puts the radio back in RX once the ACK is on air (ISR side)
+* @param  none
+* @retval none
+*/
+static void
+radio_ack_sent(void)
+{
+  ack_sending = 0;
+  if(RADIO_SNIFFING()) {
+    /* The wake-up timer is still running */
+    S2LP_CMD_StrobeSleep();
+  } else {
     S2LP_ConfigRangeExt(PA_RX);
     S2LP_CMD_StrobeRx();
-#endif /*RADIO_SNIFF_MODE*/
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_ack_timeout
+* 	rtimer callback ending the ACK wait
+* @param  struct rtimer *t, void *ptr
+* @retval none
+*/
+static void
+radio_ack_timeout(struct rtimer *t, void *ptr)
+{
+  if(ack_state != ACK_WAITING) {
+    return;
+  }
+  if((receiving_packet || interrupt_callback_wants_poll) && !ack_wait_extended) {
+    /* A frame is on air, or one is waiting for the radio process to serve
+     * the IRQ the ISR deferred: it may be the ACK */
+    ack_wait_extended = 1;
+    rtimer_set(&ack_timer, RTIMER_NOW() + US_TO_RTIMERTICKS(RADIO_ACK_AIR_TIME_US), 0,
+               radio_ack_timeout, NULL);
+    return;
+  }
+  ack_state = ACK_TIMEOUT;
+  process_poll(&subGHz_radio_process);
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_ack_wait_start
+* 	starts waiting for the ACK of the frame just sent
+* @param  uint8_t radio_state: radio state before the transmission
+* @retval none
+*/
+static void
+radio_ack_wait_start(uint8_t radio_state)
+{
+  ack_radio_off = (radio_state == OFF);
+  ack_wait_extended = 0;
+  ack_state = ACK_WAITING;
+  rtimer_set(&ack_timer, RTIMER_NOW() + RADIO_ACK_WAIT_TIME, 0, radio_ack_timeout, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_ack_result
+* 	ends the ACK wait
+* @param  none
+* @retval int RADIO_TX_OK if the ACK has been received, RADIO_TX_NOACK otherwise
+*/
+static int
+radio_ack_result(void)
+{
+  int ret = (ack_state == ACK_RECEIVED) ? RADIO_TX_OK : RADIO_TX_NOACK;
+
+  ack_state = ACK_IDLE;
+  if(ack_radio_off) {
+    ack_radio_off = 0;
+    Radio_off();
+  }
+#if RADIO_SNIFF_MODE
+  else if(RADIO_SNIFFING()) {
+    /* The radio listened for the ACK: back to the wake ups */
+    radio_set_ready_state();
+    RADIO_IRQ_DISABLE();
+    radio_sniff_ldc(1);
+    S2LP_CMD_StrobeRx();
+    RADIO_IRQ_ENABLE();
+  }
+#endif /*RADIO_SNIFF_MODE*/
+  return ret;
+}
+#endif /*RADIO_ISR_ACK*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_HW_ACK
+/**
+* @brief  radio_hw_ack_request
+* 	sets the NO_ACK field of the next frames (written only when it changes)
+* 	and, if they ask for an ACK, bounds its wait with the RX timer
+* @param  uint8_t enable
+* @retval None
+*/
+static void
+radio_hw_ack_request(uint8_t enable)
+{
+  if(enable != hw_ack_request) {
+    S2LP_PCKT_STACK_AckRequest(enable ? S_ENABLE : S_DISABLE);
+    hw_ack_request = enable;
+  }
+  if(enable) {
+    radio_hw_ack_rx_timer(1);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_hw_ack_rx_timer
+* 	programs the RX timer for the ACK wait, or gives it back to the RX
+* 	(infinite, or the wake-up timeout when sniffing)
+* @param  uint8_t ack_wait
+* @retval None
+*/
+static void
+radio_hw_ack_rx_timer(uint8_t ack_wait)
+{
+  if(ack_wait) {
+    S2LP_TIM_SetRxTimerUs(RADIO_HW_ACK_WAIT_US);
+  }
+#if RADIO_SNIFF_MODE
+  else if(RADIO_SNIFFING()) {
+    S2LP_TIM_SetRxTimerUs(sniff_rx_timeout_us);
+  }
+#endif /*RADIO_SNIFF_MODE*/
+  else {
+    SET_INFINITE_RX_TIMEOUT();
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_hw_ack_auto
+* 	the packet handler acknowledges the received frames only while both
+* 	the auto ACK and the address filtering are on
+* @param  none
+* @retval None
+*/
+static void
+radio_hw_ack_auto(void)
+{
+  S2LP_PCKT_STACK_AutoAck((radio_send_auto_ack && auto_pkt_filter) ? S_ENABLE : S_DISABLE);
+}
+#endif /*RADIO_HW_ACK*/
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_get_tx_attempts
+* 	number of times the last frame has been put on air: with RADIO_HW_ACK
+* 	the packet handler retransmits it while its ACK is missing
+* @param  none
+* @retval int attempts, 1 without RADIO_HW_ACK
+*/
+int
+radio_get_tx_attempts(void)
+{
+#if RADIO_HW_ACK
+  return tx_attempts;
+#else /*!RADIO_HW_ACK*/
+  return 1;
+#endif /*RADIO_HW_ACK*/
+}
+/*---------------------------------------------------------------------------*/
+#if RADIO_FIFO_STREAMING
+/**
+* @brief  radio_tx_stream_refill
+* 	writes the next chunk of a long frame in the TX FIFO (ISR side)
+* @param  none
+* @retval none
+*/
+static void
+radio_tx_stream_refill(void)
+{
+  uint16_t chunk = tx_stream_len - tx_stream_pos;
+
+  if(chunk > RADIO_FIFO_CHUNK) {
+    chunk = RADIO_FIFO_CHUNK;
+  }
+  /* Blocking: a DMA transfer would leave the bus busy for the IRQ config
+   * below, and its completion IRQ cannot preempt this ISR */
+  S2LP_WriteFIFO((uint8_t)chunk, &tx_stream_buf[tx_stream_pos]);
+  tx_stream_pos += chunk;
+  if(tx_stream_pos == tx_stream_len) {
+    S2LP_GPIO_IrqConfig(TX_FIFO_ALMOST_EMPTY, S_DISABLE);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_tx_stream_stop
+* 	forgets the frame being streamed, turning off its IRQ if still on
+* @param  none
+* @retval none
+*/
+static void
+radio_tx_stream_stop(void)
+{
+  if(tx_stream_pos < tx_stream_len) {
+    S2LP_GPIO_IrqConfig(TX_FIFO_ALMOST_EMPTY, S_DISABLE);
+  }
+  tx_stream_len = 0;
+  tx_stream_pos = 0;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_rx_stream_drain
+* 	moves a chunk of the incoming frame to the head slot of the ring, which
+* 	is queued by radio_rx_ring_push at IRQ_RX_DATA_READY (ISR side)
+* @param  none
+* @retval none
+*/
+static void
+radio_rx_stream_drain(void)
+{
+  radio_rx_slot_t *slot = &rx_ring[rx_ring_head & RX_RING_MASK];
+
+  if(rx_stream_drop || IS_RXBUF_FULL() ||
+     rx_stream_len + RADIO_FIFO_CHUNK > sizeof(slot->data)) {
+    rx_stream_drop = 1;
+    S2LP_CMD_StrobeFlushRxFifo();
+    return;
+  }
+  /* Blocking as well: radio_rx_ring_push may read the rest of the frame in
+   * the same pass of the IRQ table */
+  S2LP_ReadFIFO(RADIO_FIFO_CHUNK, &slot->data[rx_stream_len]);
+  rx_stream_len += RADIO_FIFO_CHUNK;
+}
+#endif /*RADIO_FIFO_STREAMING*/
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_rx_ring_push
+* 	moves the frame in the RX FIFO to the head of the ring (ISR side)
+* @param  none
+* @retval radio_rx_slot_t* the slot queued, NULL if the frame is not queued
+*/
+static radio_rx_slot_t *
+radio_rx_ring_push(void)
+{
+  radio_rx_slot_t *slot;
+  uint8_t count = RX_RING_COUNT();
+  uint16_t offset = 0;
+  int len;
+
+#if RADIO_FIFO_STREAMING
+  /* The head of a long frame is already in the slot */
+  offset = rx_stream_len;
+  rx_stream_len = 0;
+  if(rx_stream_drop) {
+    rx_stream_drop = 0;
+    count = RADIO_RX_QUEUE_LEN;
+  }
+#endif /*RADIO_FIFO_STREAMING*/
+
+  if(count >= RADIO_RX_QUEUE_LEN) {
+    /* The caller flushes the RX FIFO */
+    rx_ring_stats.overflows++;
+#if RADIO_STATS
+    stats.drops[RADIO_DROP_RING_FULL]++;
+#endif /*RADIO_STATS*/
+    return NULL;
+  }
+
+  slot = &rx_ring[rx_ring_head & RX_RING_MASK];
+  len = Radio_read_from_fifo(&slot->data[offset], sizeof(slot->data) - offset, offset);
+  if(len < 0 || offset + len == 0) {
+    return NULL;
+  }
+  slot->len = offset + len;
+#if RADIO_ISR_ACK
+  if(ack_state == ACK_WAITING && slot->len == ACK_LEN &&
+     (slot->data[0] & 7) == FRAME802154_ACKFRAME && slot->data[2] == (uint8_t)ack_seqno) {
+    /* The ACK of the frame just sent: it is not passed to the MAC */
+    slot->len = 0;
+    ack_state = ACK_RECEIVED;
+    process_poll(&subGHz_radio_process);
+    return NULL;
+  }
+#endif /*RADIO_ISR_ACK*/
+  slot->rssi = last_packet_rssi;
+  slot->lqi = last_packet_lqi;
+  slot->timestamp = last_packet_timestamp;
+
+  rx_ring_stats.received++;
+  if(count + 1 > rx_ring_stats.max_used) {
+    rx_ring_stats.max_used = count + 1;
+  }
+  /* The slot must be complete before the consumer can see it */
+  __DMB();
+  rx_ring_head++;
+  return slot;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_rx_ring_peek
+* 	finds the oldest frame not read yet (process side)
+* @param  none
+* @retval uint8_t index of the frame, rx_ring_head if there is none
+*/
+static uint8_t
+radio_rx_ring_peek(void)
+{
+  uint8_t index = rx_ring_tail;
+
+  /* The mark is stale once the tail has moved past it */
+  if(rx_ring_ack_wait && (uint8_t)(rx_ring_ack_mark - rx_ring_tail) <= RX_RING_COUNT()) {
+    index = rx_ring_ack_mark;
+  }
+  while(index != rx_ring_head && rx_ring[index & RX_RING_MASK].len == 0) {
+    index++;
+  }
+  return index;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_rx_ring_release
+* 	frees the slot of a frame that has been read (process side)
+* @param  uint8_t index as returned by radio_rx_ring_peek
+* @retval none
+*/
+static void
+radio_rx_ring_release(uint8_t index)
+{
+  rx_ring[index & RX_RING_MASK].len = 0;
+  /* Slots read out of order are skipped once they reach the tail */
+  while(rx_ring_tail != rx_ring_head && rx_ring[rx_ring_tail & RX_RING_MASK].len == 0) {
+    rx_ring_tail++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_get_rx_queue_stats
+* 	returns the counters of the RX frame ring
+* @param  radio_rx_queue_stats_t *stats
+* @retval none
+*/
+void
+radio_get_rx_queue_stats(radio_rx_queue_stats_t *stats)
+{
+  *stats = rx_ring_stats;
+  stats->queued = RX_RING_COUNT();
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  Radio_read
+* 	reads a packet received with the subGHz radio
+* @param  void *buf, unsigned short bufsize
+* @retval int bufsize
+*/
+static int Radio_read(void *buf, unsigned short bufsize)
+{
+    int retval = 0;
+
+    if (polling_mode) {
+       if (radio_poll_irqs() & RX_DATA_READY) {
+         poll_irqs &= ~(VALID_SYNC | RX_DATA_READY);
+         retval = Radio_read_from_fifo (buf, bufsize, 0);
+         if (retval > 0) {
+           packetbuf_set_attr(PACKETBUF_ATTR_RSSI, (packetbuf_attr_t) last_packet_rssi);
+           packetbuf_set_attr(PACKETBUF_ATTR_LINK_QUALITY, last_packet_lqi);
+         } else {
+           retval = 0;
+         }
+       }
+    } else {
+      uint8_t index = radio_rx_ring_peek();
+      if (index != rx_ring_head) {
+        radio_rx_slot_t *slot = &rx_ring[index & RX_RING_MASK];
+        if (slot->len <= bufsize) {
+          memcpy(buf, slot->data, slot->len);
+          retval = slot->len;
+          last_packet_rssi = slot->rssi;
+          last_packet_lqi = slot->lqi;
+          last_packet_timestamp = slot->timestamp;
+        } else {
+          LOG_DBG("Buf too small (%d bytes to hold %u bytes)\n", bufsize, slot->len);
+#if RADIO_STATS
+          stats.drops[RADIO_DROP_BUF_TOO_SMALL]++;
+#endif /*RADIO_STATS*/
+        }
+        radio_rx_ring_release(index);
+      }
+      pending_packet = (radio_rx_ring_peek() != rx_ring_head);
+    }
+    /* RX command - to ensure the device will be ready for the next reception.
+     * TSCH reads the frame once the radio is off: it stays so. */
+    if(RADIO_SNIFFING()) {
+      S2LP_CMD_StrobeSleep();
+    } else if(radio_on == ON) {
+      S2LP_ConfigRangeExt(PA_RX);
+      S2LP_CMD_StrobeRx();
+    }
+    LOG_DBG("READ OUT: %d\n", retval);
+    return retval;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  Radio_channel_clear
+* 	checks the channel
+* @param  none
+* @retval int result
+*/
+static int
+Radio_channel_clear(void)
+{
+  float rssi_value;
+  /* Local variable used to memorize the S2LP state */
+  uint8_t radio_state = radio_on;
+
+  LOG_DBG("CHANNEL CLEAR IN\n");
+
+  if(radio_on == OFF){
+    /* Wakes up the Radio */
+    Radio_on();
+  }
+  rssi_value = S2LP_RADIO_QI_GetRssidBmRun();
+  int ret = (rssi_value<radio_cca_threshold(conf_channel))?1:0;
+
+  /* Puts the S2LP in its previous state */
+  if(radio_state==OFF){
+    Radio_off();
+  }
+
+  return ret;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  Radio_receiving_packet
+* 	checks for receiving packet
+* @param  none
+* @retval int result
+*/
+static int
+Radio_receiving_packet(void)
+{
+  if (polling_mode) {
+       /* From the sync word to the end of the frame, or to its discard */
+       receiving_packet = ((radio_poll_irqs() & (VALID_SYNC | RX_DATA_READY)) == VALID_SYNC);
+  }
+
+  return receiving_packet;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  Radio_pending_packet
+* 	checks for pending packet
+* @param  none
+* @retval int result
+*/
+static int
+Radio_pending_packet(void)
+{
+  //LOG_DBG("RADIO PENDING PACKET\n");
+  if (polling_mode) {
+       pending_packet = ((radio_poll_irqs() & RX_DATA_READY) != 0);
+  } else {
+       pending_packet = (radio_rx_ring_peek() != rx_ring_head);
+  }
+
+  return pending_packet;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  Radio_off
+* 	turns off the Sub-GHz radio
+* @param  none
+* @retval int result(0 == success)
+*/
+static int
+Radio_off(void)
+{
+  LOG_DBG("Radio: ->off\n");
+
+#if RADIO_ASYNC_TX
+  radio_tx_async_complete();
+#endif /*RADIO_ASYNC_TX*/
+
+  if(radio_on == ON)
+  {
+    /* Disables the mcu to get IRQ from the RADIO */
+    RADIO_IRQ_DISABLE();  //Mind that it will be enabled only in the ON
+
+#if RADIO_SNIFF_MODE
+    if(RADIO_SNIFFING()) {
+      radio_sniff_account();
+      radio_sniff_ldc(0);
+      S2LP_CMD_StrobeReady();
+      S2LP_ConfigRangeExt(PA_RX);
+      S2LP_CMD_StrobeRx();
+    }
+#endif /*RADIO_SNIFF_MODE*/
+
+    /* first stop rx/tx */
+    S2LP_CMD_StrobeSabort();
+
+    /* Clear any pending irqs. In poll mode a frame received is kept, for
+     * TSCH reads it after turning the radio off (STANDBY keeps the FIFO). */
+    if(polling_mode) {
+      radio_poll_irqs();
+      poll_irqs &= RX_DATA_READY;
+    } else {
+      S2LP_GPIO_IrqClearStatus();
+    }
+
+    if(RADIO_SNIFFING()) {
+      S2LP_CMD_StrobeReady();
+    }
+    BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_READY, RADIO_WAIT_TIMEOUT);
+
+    if(radio_refresh_status() != MC_STATE_READY)
+    {
+      LOG_ERR("Radio: failed off->ready\n");
+      return 1;
+    }
+    /* Puts the Radio in STANDBY */
+    S2LP_CMD_StrobeStandby();
+    BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_STANDBY,RADIO_WAIT_TIMEOUT);
+
+    if(radio_refresh_status() != MC_STATE_STANDBY)
+    {
+      LOG_ERR("Radio: failed off->stdby\n");
+      return 1;
+    }
+
+    radio_on = OFF;
+    radio_energest_listen();
+  }
+
+  LOG_DBG("Radio: off.\n");
+  //radio_print_status();
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  Radio_on
+* 	turns on the Sub-GHz radio
+* @param  none
+* @retval int result(0 == success)
+*/
+static int Radio_on(void)
+{
+  LOG_DBG("Radio: on\n");
+
+  if(radio_on == OFF) {
+    radio_set_ready_state();
+    S2LP_FIFO_MuxRxFifoIrqEnable(S_ENABLE);
+#if RADIO_SNIFF_MODE
+    /* After radio_set_ready_state(), which turns the LDC mode off */
+    if(RADIO_SNIFFING()) {
+      radio_sniff_ldc(1);
+    }
+    sniff_since = RTIMER_NOW();
+#endif /*RADIO_SNIFF_MODE*/
+    S2LP_ConfigRangeExt(PA_RX);
+    S2LP_CMD_StrobeRx();
+    radio_on = ON;
+    radio_energest_listen();
+    RADIO_IRQ_ENABLE(); //--> Coming from OFF, IRQ ARE DISABLED.
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  main Radio Contiki-NG PROCESS
+*/
+PROCESS_THREAD(subGHz_radio_process, ev, data)
+{
+  PROCESS_BEGIN();
+  LOG_DBG("Radio: process started\n");
+
+  while(1) {
+    int len;
+    uint8_t deferred_irq = 0;
+
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+    LOG_DBG("Radio: polled\n");
+
+    /* First of all: nIRQ is level triggered, no new edge comes for an IRQ
+     * the ISR deferred because the SPI was taken. It may be the TX_DATA_SENT
+     * or the ACK the early exits below are waiting for. */
+    if(interrupt_callback_wants_poll) {
+      LOG_DBG("interrupt_callback_wants_poll\n");
+      Radio_interrupt_callback();
+      deferred_irq = 1;
+    }
+
+#if RADIO_ASYNC_TX
+    if(tx_async_pending) {
+      if(!xTxDoneFlag && !tx_async_timeout) {
+        /* The frame is still on air: nothing can be received meanwhile */
+        continue;
+      }
+      radio_tx_async_complete();
+    }
+#if RADIO_ISR_ACK
+    if(tx_async_notify && ack_state != ACK_IDLE) {
+      if(ack_state == ACK_WAITING) {
+        /* Polled again by the ISR or by the rtimer */
+        continue;
+      }
+      tx_async_status = radio_ack_result();
+    }
+#endif /*RADIO_ISR_ACK*/
+    if(tx_async_notify) {
+      radio_tx_done_callback_t callback = tx_async_callback;
+#if RADIO_ADAPTIVE_CCA
+      radio_cca_account(tx_async_status);
+#endif /*RADIO_ADAPTIVE_CCA*/
+      tx_async_callback = NULL;
+      tx_async_notify = 0;
+      if(callback != NULL) {
+        callback(tx_async_status);
+      }
+      /* Any frame received meanwhile polls the process again */
+      continue;
+    }
+#endif /*RADIO_ASYNC_TX*/
+
+    /* Any ACK wait is over: deliver the frames in order of arrival */
+    rx_ring_ack_wait = 0;
+    packetbuf_clear();
+    len = Radio_read(packetbuf_dataptr(), PACKETBUF_SIZE);
+
+    if(len > 0) {
+      packetbuf_set_datalen(len);
+      packetbuf_set_attr(PACKETBUF_ATTR_RSSI, (packetbuf_attr_t) last_packet_rssi);
+      packetbuf_set_attr(PACKETBUF_ATTR_LINK_QUALITY, last_packet_lqi);
+
+      LOG_DBG("Calling MAC.Input(%d)\n", len);
+      NETSTACK_MAC.input();
+    }
+
+    if(!IS_RXBUF_EMPTY()) {
+      LOG_DBG("After MAC.input, RX BUF is not empty.\r\n");
+      process_poll(&subGHz_radio_process);
+    }
+
+    if(deferred_irq) {
+      if(radio_refresh_status() == MC_STATE_READY)
+      {
+        S2LP_FIFO_MuxRxFifoIrqEnable(S_ENABLE);
+        if(RADIO_SNIFFING()) {
+          S2LP_CMD_StrobeSleep();
+        } else {
+          S2LP_ConfigRangeExt(PA_RX);
+          S2LP_CMD_StrobeRx();
+          BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_RX, 1 * RTIMER_SECOND/1000);
+        }
+      }
+    }
+  }
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_get_rssi(void)
+{
+	/*Using default GetRssidBm() API */
+  return (int) S2LP_RADIO_QI_GetRssidBm();
+}
+/*---------------------------------------------------------------------------*/
+static int
+radio_get_channel(void)
+{
+#if RADIO_HOPPING
+  /* CHNUM is not used: the channel is in the SYNT words */
+  return conf_channel;
+#else /*!RADIO_HOPPING*/
+	uint8_t register_channel;
+  /*Next statement is mainly for debugging purpose, it can be commented out. */
+  register_channel = S2LP_RADIO_GetChannel();
+  if (register_channel != conf_channel) {
+    LOG_WARN("Warning retrieved channel %d != saved channel %d\n", register_channel, conf_channel );
+	conf_channel = register_channel;
+  }
+
+  return register_channel;
+#endif /*RADIO_HOPPING*/
+}
+/*---------------------------------------------------------------------------*/
+static void
+radio_set_channel(int c)
+{
+  uint8_t relock;
+	/*Channel value has been validated in the calling function. */
+  LOG_DBG("SET CHANNEL %d.\r\n", c);
+
+#if RADIO_ASYNC_TX
+  radio_tx_async_complete();
+#endif /*RADIO_ASYNC_TX*/
+
+  conf_channel = c;
+  /* The synthesizer takes a new channel only when it locks: in RX, it is
+   * stopped and restarted around the write */
+  RADIO_IRQ_DISABLE();
+  relock = (radio_refresh_status() == MC_STATE_RX);
+  if(relock) {
+    S2LP_CMD_StrobeSabort();
+    BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_READY, RADIO_WAIT_TIMEOUT);
+    /* A frame being received on the old channel is lost */
+    S2LP_CMD_StrobeCommand(CMD_FLUSHRXFIFO);
+    receiving_packet = 0;
+#if RADIO_FIFO_STREAMING
+    rx_stream_len = 0;
+    rx_stream_drop = 0;
+#endif /*RADIO_FIFO_STREAMING*/
+  }
+#if RADIO_HOPPING
+  radio_hop_write(conf_channel);
+#else /*!RADIO_HOPPING*/
+  S2LP_RADIO_SetChannel(conf_channel);
+  S2LP_RADIO_SetChannelSpace(CHANNEL_SPACE);
+#endif /*RADIO_HOPPING*/
+  if(relock) {
+    S2LP_CMD_StrobeRx();
+    /* Listening on the new channel when this returns */
+    BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_RX, RADIO_WAIT_TIMEOUT);
+  }
+  RADIO_IRQ_ENABLE();
+}
+/*---------------------------------------------------------------------------*/
+#if RADIO_HOPPING
+/**
+* @brief  radio_hop_lock
+* 	locks the synthesizer with a LOCKRX/LOCKTX command and reads the VCO
+* 	calibration words it found, then goes back to READY
+* @param  uint8_t command, uint8_t *cal (VCO_CALIBR_OUT1..OUT0)
+* @retval None
+*/
+static void
+radio_hop_lock(uint8_t command, uint8_t *cal)
+{
+  S2LP_CMD_StrobeCommand(command);
+  BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_LOCKON, RADIO_WAIT_TIMEOUT);
+  S2LP_ReadRegister(VCO_CALIBR_OUT1_ADDR, 2, cal);
+  S2LP_CMD_StrobeReady();
+  BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_READY, RADIO_WAIT_TIMEOUT);
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_hop_calibrate
+* 	fills the channel table: the radio is locked in RX and in TX on every
+* 	channel, then the VCO is switched to the table calibration words.
+* 	Called from Radio_init, with the radio in READY.
+* @param  none
+* @retval None
+*/
+static void
+radio_hop_calibrate(void)
+{
+  uint8_t rx_cal[2], tx_cal[2];
+  int i;
+
+  S2LP_RADIO_SetChannel(0);
+  for(i = 0; i < HOP_CHANNELS; i++) {
+    S2LP_RADIO_ComputeSynthWords((uint32_t)(BASE_FREQUENCY + (CHANNEL_NUMBER_MIN + i) * CHANNEL_SPACE),
+                                 &hop_words[i].synth);
+    S2LP_RADIO_SetSynthWords(&hop_words[i].synth);
+    radio_hop_lock(CMD_LOCKRX, rx_cal);
+    radio_hop_lock(CMD_LOCKTX, tx_cal);
+    hop_words[i].vco_cal[0] = ((tx_cal[0] & VCO_CAL_AMP_OUT_REGMASK) << 4) |
+                              (rx_cal[0] & VCO_CAL_AMP_OUT_REGMASK);
+    hop_words[i].vco_cal[1] = tx_cal[1] & VCO_CAL_FREQ_OUT_REGMASK;
+    hop_words[i].vco_cal[2] = rx_cal[1] & VCO_CAL_FREQ_OUT_REGMASK;
+  }
+  hop_pfd_split = hop_words[HOP_CHANNELS - 1].synth.cPfdSplit;
+
+  /* From now on the VCO takes the words of VCO_CALIBR_IN2..IN0 */
+  S2LP_RADIO_CalibrationVco(S_ENABLE, S_ENABLE);
+  radio_hop_write(conf_channel);
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_hop_write
+* 	writes the synthesizer and VCO calibration words of a channel, they
+* 	are used from the next lock of the synthesizer
+* @param  int channel
+* @retval None
+*/
+static void
+radio_hop_write(int channel)
+{
+  const radio_hop_words_t *words = &hop_words[channel - CHANNEL_NUMBER_MIN];
+  uint8_t buf[4];
+
+  if(words->synth.cPfdSplit != hop_pfd_split) {
+    /* Rare: the reference divider changes inside the band */
+    S2LP_RADIO_SetSynthWords(&words->synth);
+    hop_pfd_split = words->synth.cPfdSplit;
+  } else {
+    memcpy(buf, words->synth.cSynt, 4);
+    S2LP_WriteRegister(SYNT3_ADDR, 4, buf);
+  }
+  memcpy(buf, words->vco_cal, 3);
+  S2LP_WriteRegister(VCO_CALIBR_IN2_ADDR, 3, buf);
+}
+#endif /*RADIO_HOPPING*/
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_hop_set_sequence
+* 	sets the hopping sequence walked by radio_hop_next(). The array is not
+* 	copied and must stay valid.
+* @param  const uint8_t *sequence, uint16_t len (0 to clear)
+* @retval int 0 on success, -1 if a channel is out of range or RADIO_HOPPING is off
+*/
+int
+radio_hop_set_sequence(const uint8_t *sequence, uint16_t len)
+{
+#if RADIO_HOPPING
+  uint16_t i;
+
+  for(i = 0; i < len; i++) {
+    if((sequence[i] < CHANNEL_NUMBER_MIN) || (sequence[i] > CHANNEL_NUMBER_MAX)) {
+      return -1;
+    }
+  }
+  hop_sequence = sequence;
+  hop_sequence_len = len;
+  hop_index = 0;
+  return 0;
+#else /*!RADIO_HOPPING*/
+  UNUSED(sequence);
+  UNUSED(len);
+  return -1;
+#endif /*RADIO_HOPPING*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_hop_next
+* 	switches to the next channel of the hopping sequence
+* @param  none
+* @retval int the new channel, -1 if there is no sequence
+*/
+int
+radio_hop_next(void)
+{
+#if RADIO_HOPPING
+  int channel;
+
+  if(hop_sequence_len == 0) {
+    return -1;
+  }
+  channel = hop_sequence[hop_index];
+  if(++hop_index == hop_sequence_len) {
+    hop_index = 0;
+  }
+  radio_set_channel(channel);
+  return channel;
+#else /*!RADIO_HOPPING*/
+  return -1;
+#endif /*RADIO_HOPPING*/
+}
+/*---------------------------------------------------------------------------*/
+#if RADIO_SNIFF_MODE
+/**
+* @brief  radio_sniff_ldc
+* 	turns the LDC mode and the fast RX termination on or off together, with
+* 	one access to PROTOCOL1. The LDC mode starts with the next RX command.
+* @param  uint8_t enable
+* @retval None
+*/
+static void
+radio_sniff_ldc(uint8_t enable)
+{
+  uint8_t tmp;
+
+  S2LP_ReadRegister(PROTOCOL1_ADDR, 1, &tmp);
+  if(enable) {
+    tmp |= (LDC_MODE_REGMASK | FAST_CS_TERM_EN_REGMASK);
+  } else {
+    tmp &= ~(LDC_MODE_REGMASK | FAST_CS_TERM_EN_REGMASK);
+  }
+  S2LP_WriteRegister(PROTOCOL1_ADDR, 1, &tmp);
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_sniff_configure
+* 	programs the RX path for sniff_period_ms: in LDC mode each wake up is
+* 	ended by the carrier sense (RSSI_TX_THRESHOLD) or by the RX timer, which
+* 	must cover the wake-up preamble and the frame. The IRQ of an aborted
+* 	sync are not used, the radio goes back to sleep by itself.
+* 	The radio must not be in RX.
+* @param  none
+* @retval None
+*/
+static void
+radio_sniff_configure(void)
+{
+  uint32_t rx_timeout_ms;
+
+  if(RADIO_SNIFFING()) {
+    S2LP_GPIO_IrqConfig(VALID_SYNC, S_DISABLE);
+    S2LP_GPIO_IrqConfig(RX_DATA_DISC, S_DISABLE);
+    S2LP_RADIO_QI_SetRssiThreshdBm(RSSI_TX_THRESHOLD);
+    S2LP_TIM_SetWakeUpTimerUs(1000UL * sniff_period_ms);
+    rx_timeout_ms = 2UL * sniff_period_ms;
+    if(rx_timeout_ms < RX_TIMEOUT_MS) {
+      rx_timeout_ms = RX_TIMEOUT_MS;
+    }
+    sniff_rx_timeout_us = 1000UL * rx_timeout_ms;
+    S2LP_TIM_SetRxTimerUs(sniff_rx_timeout_us);
+    S2LP_PCKT_HNDL_SetRxPersistentMode(S_DISABLE);
+  } else {
+    radio_sniff_ldc(0);
+    S2LP_GPIO_IrqConfig(VALID_SYNC, S_ENABLE);
+    S2LP_GPIO_IrqConfig(RX_DATA_DISC, S_ENABLE);
+    S2LP_RADIO_QI_SetRssiThreshdBm(RSSI_RX_THRESHOLD);
+    SET_INFINITE_RX_TIMEOUT();
+    S2LP_PCKT_HNDL_SetRxPersistentMode(S_ENABLE);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_sniff_account
+* 	credits the time spent sniffing since the last call, and the RX on
+* 	time of its wake ups, estimated with RADIO_SNIFF_WAKEUP_US, to the
+* 	energest LISTEN counter: the radio wakes up by itself, the MCU does
+* 	not see the wake ups without carrier.
+* @param  none
+* @retval None
+*/
+static void
+radio_sniff_account(void)
+{
+  rtimer_clock_t now = RTIMER_NOW();
+  uint64_t elapsed;
+  uint64_t listen;
+
+  if(RADIO_SNIFFING() && radio_on == ON) {
+    elapsed = (rtimer_clock_t)(now - sniff_since);
+    listen = (elapsed * RADIO_SNIFF_WAKEUP_US) / (1000UL * sniff_period_ms);
+    sniff_ticks += elapsed;
+    sniff_listen_ticks += listen;
+    energest_type_set(ENERGEST_TYPE_LISTEN,
+                      energest_type_time(ENERGEST_TYPE_LISTEN) + listen);
+  }
+  sniff_since = now;
+}
+#endif /*RADIO_SNIFF_MODE*/
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_energest_listen
+* 	the LISTEN energest counter runs while the radio is on in continuous
+* 	RX, sniffing is accounted by radio_sniff_account()
+* @param  none
+* @retval None
+*/
+static void
+radio_energest_listen(void)
+{
+  if(radio_on == ON && !RADIO_SNIFFING()) {
+    ENERGEST_ON(ENERGEST_TYPE_LISTEN);
+  } else {
+    ENERGEST_OFF(ENERGEST_TYPE_LISTEN);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_set_sniff_period
+* 	switches the receiver between continuous RX (0) and sniffing, i.e.
+* 	waking up every period_ms to sense the carrier. The peers must send
+* 	with a wake-up preamble of the same period (radio_set_tx_wakeup).
+* @param  uint16_t period_ms (0..RADIO_SNIFF_PERIOD_MAX_MS)
+* @retval int 0 on success, -1 if the period is too long, in poll mode, while
+* 	scanning or if RADIO_SNIFF_MODE is off
+*/
+int
+radio_set_sniff_period(uint16_t period_ms)
+{
+#if RADIO_SNIFF_MODE
+  uint8_t on;
+
+  if(period_ms > RADIO_SNIFF_PERIOD_MAX_MS || (period_ms && (polling_mode || RADIO_SCANNING()))) {
+    return -1;
+  }
+#if RADIO_ASYNC_TX
+  radio_tx_async_complete();
+#endif /*RADIO_ASYNC_TX*/
+  radio_sniff_account();
+  on = (radio_on == ON);
+  if(on) {
+    radio_set_ready_state();
+    RADIO_IRQ_DISABLE();
+  }
+  sniff_period_ms = period_ms;
+  radio_sniff_configure();
+  if(on) {
+    if(RADIO_SNIFFING()) {
+      radio_sniff_ldc(1);
+    }
+    S2LP_CMD_StrobeRx();
+    RADIO_IRQ_ENABLE();
+  }
+  radio_energest_listen();
+  return 0;
+#else /*!RADIO_SNIFF_MODE*/
+  UNUSED(period_ms);
+  return -1;
+#endif /*RADIO_SNIFF_MODE*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_set_tx_wakeup
+* 	sets the preamble of the next frames long enough to wake up a receiver
+* 	sniffing every period_ms
+* @param  uint16_t period_ms (0: normal preamble)
+* @retval int 0 on success, -1 if the period is too long or RADIO_SNIFF_MODE is off
+*/
+int
+radio_set_tx_wakeup(uint16_t period_ms)
+{
+#if RADIO_SNIFF_MODE
+  if(period_ms > RADIO_SNIFF_PERIOD_MAX_MS) {
+    return -1;
+  }
+#if RADIO_ASYNC_TX
+  radio_tx_async_complete();
+#endif /*RADIO_ASYNC_TX*/
+  tx_wakeup_ms = period_ms;
+  return 0;
+#else /*!RADIO_SNIFF_MODE*/
+  UNUSED(period_ms);
+  return -1;
+#endif /*RADIO_SNIFF_MODE*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_get_sniff_stats
+* 	copies the low duty cycle counters, all zero without RADIO_SNIFF_MODE
+* @param  radio_sniff_stats_t *stats
+* @retval None
+*/
+void
+radio_get_sniff_stats(radio_sniff_stats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+#if RADIO_SNIFF_MODE
+  radio_sniff_account();
+  *stats = sniff_stats;
+  stats->period_ms = sniff_period_ms;
+  stats->tx_wakeup_ms = tx_wakeup_ms;
+  stats->sniff_ms = (uint32_t)((sniff_ticks * 1000) / RTIMER_SECOND);
+  stats->listen_ms = (uint32_t)((sniff_listen_ticks * 1000) / RTIMER_SECOND);
+  stats->preamble_ms = (uint32_t)((tx_wakeup_ticks * 1000) / RTIMER_SECOND);
+#endif /*RADIO_SNIFF_MODE*/
+}
+/*---------------------------------------------------------------------------*/
+#if RADIO_ENERGY_SCAN
+/**
+* @brief  radio_scan_timer
+* 	rtimer callback pacing the scan: it asks the scan process for a sample
+* 	every RADIO_SCAN_SAMPLE_US and stops at the end of the dwell, which is a
+* 	time whatever the samples taken.
+* @param  struct rtimer *t, void *ptr
+* @retval none
+*/
+static void
+radio_scan_timer(struct rtimer *t, void *ptr)
+{
+  rtimer_clock_t next;
+
+  if(!scan_active) {
+    return;
+  }
+  process_poll(&radio_scan_process);
+  if(++scan_taken >= RADIO_SCAN_DWELL_SAMPLES) {
+    /* The process tunes the next channel and starts the rtimer again */
+    return;
+  }
+  next = t->time + US_TO_RTIMERTICKS(RADIO_SCAN_SAMPLE_US);
+  if(RTIMER_CLOCK_LT(next, RTIMER_NOW())) {
+    /* Late: the missed periods are not made up for */
+    next = RTIMER_NOW() + US_TO_RTIMERTICKS(RADIO_SCAN_SAMPLE_US);
+  }
+  rtimer_set(t, next, 0, radio_scan_timer, ptr);
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_sample
+* 	takes one running RSSI sample into the ring, in the scan process, for
+* 	the periods counted by radio_scan_timer since the last one. The periods
+* 	the process was too late for, and the sample when the SPI or the radio
+* 	is taken (ACK on air, radio off), are counted as skipped.
+* @param  uint16_t taken: periods of the dwell so far
+* @retval none
+*/
+static void
+radio_scan_sample(uint16_t taken)
+{
+  int32_t rssi;
+
+  if(taken == scan_served) {
+    return;
+  }
+  scan_skipped += taken - scan_served - 1;
+  scan_served = taken;
+  if(radio_spi_busy() || interrupt_callback_in_progress ||
+     transmitting_packet || radio_on == OFF) {
+    scan_skipped++;
+    return;
+  }
+  rssi = S2LP_RADIO_QI_GetRssidBmRun();
+  if(scan_settle) {
+    /* The RSSI filter still holds some of the previous channel */
+    scan_settle = 0;
+  } else if((uint8_t)(scan_head - scan_tail) >= SCAN_RING_LEN) {
+    scan_overflows++;
+  } else {
+    if(rssi < -128) {
+      rssi = -128;
+    } else if(rssi > 127) {
+      rssi = 127;
+    }
+    scan_ring[scan_head & (SCAN_RING_LEN - 1)] = (int8_t)rssi;
+    scan_head++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_tune
+* 	moves the scan to a channel and starts its dwell. The ring must have
+* 	been drained: its samples are those of scan_channel.
+* @param  uint8_t channel
+* @retval none
+*/
+static void
+radio_scan_tune(uint8_t channel)
+{
+  scan_channel = channel;
+  radio_set_channel(channel);
+  scan_taken = 0;
+  scan_served = 0;
+  scan_settle = 1;
+  rtimer_set(&scan_timer, RTIMER_NOW() + US_TO_RTIMERTICKS(RADIO_SCAN_SAMPLE_US), 0,
+             radio_scan_timer, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_drain
+* 	folds the samples of the ring into the statistics of scan_channel
+* @param  none
+* @retval none
+*/
+static void
+radio_scan_drain(void)
+{
+  radio_scan_channel_t *c = &scan_table[scan_channel - CHANNEL_NUMBER_MIN];
+  int8_t dbm;
+  int bin;
+  uint8_t i;
 
-    /* first stop rx/tx */
-    S2LP_CMD_StrobeSabort();
+  while(scan_tail != scan_head) {
+    dbm = scan_ring[scan_tail & (SCAN_RING_LEN - 1)];
+    scan_tail++;
 
-    /* Clear any pending irqs */
-    S2LP_GPIO_IrqClearStatus();
+    bin = (dbm - SCAN_HIST_MIN_DBM) / SCAN_HIST_BIN_DB;
+    if(bin >= SCAN_HIST_BINS) {
+      bin = SCAN_HIST_BINS - 1;
+    }
+    if(c->hist[bin] == 0xFFFF) {
+      /* Long scan: halving keeps the shape, thus the percentiles */
+      for(i = 0; i < SCAN_HIST_BINS; i++) {
+        c->hist[i] >>= 1;
+      }
+    }
+    c->hist[bin]++;
+    if(c->count == 0 || dbm < c->min) {
+      c->min = dbm;
+    }
+    if(c->count == 0 || dbm > c->max) {
+      c->max = dbm;
+    }
+    c->sum += dbm;
+    c->count++;
+    if(dbm >= RSSI_TX_THRESHOLD) {
+      c->busy++;
+    }
+#if RADIO_ADAPTIVE_CCA
+    radio_cca_feed(scan_channel, dbm);
+#endif /*RADIO_ADAPTIVE_CCA*/
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_end
+* 	stops sampling, then tunes back the channel and the state the radio had
+* 	before the scan
+* @param  none
+* @retval none
+*/
+static void
+radio_scan_end(void)
+{
+  /* A sample already scheduled finds the scan over */
+  scan_active = 0;
+  radio_set_channel(scan_home_channel);
+  if(scan_home_off) {
+    Radio_off();
+  }
+  LOG_DBG("Scan over, %u sweeps\n", scan_sweeps);
+}
+/*---------------------------------------------------------------------------*/
+static int8_t
+radio_scan_percentile(const radio_scan_channel_t *c, uint8_t percent)
+{
+  uint32_t total = 0;
+  uint32_t below = 0;
+  int bin;
+  int dbm;
 
-#if RADIO_SNIFF_MODE
-    S2LP_CMD_StrobeReady();
-#endif /*RADIO_SNIFF_MODE*/
-    BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_READY, RADIO_WAIT_TIMEOUT);
+  for(bin = 0; bin < SCAN_HIST_BINS; bin++) {
+    total += c->hist[bin];
+  }
+  for(bin = 0; bin < SCAN_HIST_BINS - 1; bin++) {
+    below += c->hist[bin];
+    if(below * 100 >= total * percent) {
+      break;
+    }
+  }
+  /* Lower edge of the bin, within the levels seen */
+  dbm = SCAN_HIST_MIN_DBM + bin * SCAN_HIST_BIN_DB;
+  if(dbm < c->min) {
+    dbm = c->min;
+  } else if(dbm > c->max) {
+    dbm = c->max;
+  }
+  return (int8_t)dbm;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t *
+radio_scan_put_le(uint8_t *p, uint32_t value, uint8_t len)
+{
+  while(len--) {
+    *p++ = (uint8_t)value;
+    value >>= 8;
+  }
+  return p;
+}
+#endif /*RADIO_ENERGY_SCAN*/
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_start
+* 	starts the energy scan of the channel table: every channel is sampled
+* 	RADIO_SCAN_DWELL_SAMPLES times, one sample every RADIO_SCAN_SAMPLE_US.
+* 	The statistics of the previous scan are cleared. No frame can be sent
+* 	until the scan is over; the channel is restored at the end.
+* @param  uint16_t sweeps: of the whole table, 0 until radio_scan_stop()
+* @retval int 0 on success, -1 if already scanning, sniffing, in poll mode,
+* 	sending or if RADIO_ENERGY_SCAN is off
+*/
+int
+radio_scan_start(uint16_t sweeps)
+{
+#if RADIO_ENERGY_SCAN
+  if(RADIO_SCANNING() || RADIO_SNIFFING() || polling_mode) {
+    return -1;
+  }
+#if RADIO_ASYNC_TX
+  if(radio_tx_in_progress()) {
+    return -1;
+  }
+#endif /*RADIO_ASYNC_TX*/
+  memset(scan_table, 0, sizeof(scan_table));
+  scan_head = 0;
+  scan_tail = 0;
+  scan_skipped = 0;
+  scan_overflows = 0;
+  scan_sweeps = 0;
+  scan_sweeps_max = sweeps;
+  scan_home_channel = conf_channel;
+  scan_home_off = (radio_on == OFF);
+  if(scan_home_off) {
+    Radio_on();
+  }
+  scan_active = 1;
+  radio_scan_tune(CHANNEL_NUMBER_MIN);
+  return 0;
+#else /*!RADIO_ENERGY_SCAN*/
+  UNUSED(sweeps);
+  return -1;
+#endif /*RADIO_ENERGY_SCAN*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_stop
+* 	ends the scan in progress, keeping its statistics
+* @param  none
+* @retval None
+*/
+void
+radio_scan_stop(void)
+{
+#if RADIO_ENERGY_SCAN
+  if(RADIO_SCANNING()) {
+    radio_scan_drain();
+    radio_scan_end();
+  }
+#endif /*RADIO_ENERGY_SCAN*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_get_status
+* 	copies the progress of the scan, all zero without RADIO_ENERGY_SCAN
+* @param  radio_scan_status_t *status
+* @retval None
+*/
+void
+radio_scan_get_status(radio_scan_status_t *status)
+{
+  memset(status, 0, sizeof(*status));
+#if RADIO_ENERGY_SCAN
+  status->active = scan_active;
+  status->channel = scan_channel;
+  status->sweeps = scan_sweeps;
+  status->skipped = scan_skipped;
+  status->overflows = scan_overflows;
+#endif /*RADIO_ENERGY_SCAN*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_get_stats
+* 	computes the statistics of a channel from the samples taken so far by
+* 	the last scan. The percentiles have the 2 dB steps of the histogram.
+* @param  uint8_t channel (CHANNEL_NUMBER_MIN..MAX)
+* @param  radio_scan_stats_t *stats: all zero if the channel has no sample
+* @retval int 0 on success, -1 if the channel is out of the table or if
+* 	RADIO_ENERGY_SCAN is off
+*/
+int
+radio_scan_get_stats(uint8_t channel, radio_scan_stats_t *stats)
+{
+  memset(stats, 0, sizeof(*stats));
+#if RADIO_ENERGY_SCAN
+  const radio_scan_channel_t *c;
 
-    if(radio_refresh_status() != MC_STATE_READY)
-    {
-      LOG_ERR("Radio: failed off->ready\n");
-      return 1;
+  if(channel < CHANNEL_NUMBER_MIN || channel > CHANNEL_NUMBER_MAX) {
+    return -1;
+  }
+  c = &scan_table[channel - CHANNEL_NUMBER_MIN];
+  stats->samples = c->count;
+  if(c->count != 0) {
+    stats->min_dbm = c->min;
+    stats->max_dbm = c->max;
+    stats->avg_dbm = (int8_t)(c->sum / (int64_t)c->count);
+    stats->p50_dbm = radio_scan_percentile(c, 50);
+    stats->p90_dbm = radio_scan_percentile(c, 90);
+    stats->busy_pct = (uint8_t)(((uint64_t)c->busy * 100) / c->count);
+  }
+  return 0;
+#else /*!RADIO_ENERGY_SCAN*/
+  UNUSED(channel);
+  return -1;
+#endif /*RADIO_ENERGY_SCAN*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_best_channel
+* 	picks the quietest channel of the last scan: the least busy one, then
+* 	the one with the lowest p90, then the lowest average
+* @param  none
+* @retval int the channel, -1 if no channel has been sampled
+*/
+int
+radio_scan_best_channel(void)
+{
+  int best = -1;
+#if RADIO_ENERGY_SCAN
+  radio_scan_stats_t stats;
+  radio_scan_stats_t best_stats;
+  uint8_t channel;
+
+  for(channel = CHANNEL_NUMBER_MIN; channel <= CHANNEL_NUMBER_MAX; channel++) {
+    radio_scan_get_stats(channel, &stats);
+    if(stats.samples == 0) {
+      continue;
     }
-    /* Puts the Radio in STANDBY */
-    S2LP_CMD_StrobeStandby();
-    BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_STANDBY,RADIO_WAIT_TIMEOUT);
+    if(best < 0 || stats.busy_pct < best_stats.busy_pct ||
+       (stats.busy_pct == best_stats.busy_pct &&
+        (stats.p90_dbm < best_stats.p90_dbm ||
+         (stats.p90_dbm == best_stats.p90_dbm && stats.avg_dbm < best_stats.avg_dbm)))) {
+      best = channel;
+      best_stats = stats;
+    }
+  }
+#endif /*RADIO_ENERGY_SCAN*/
+  return best;
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_scan_export
+* 	writes the statistics of the last scan as a compact record, integers
+* 	little endian. Header: 'R' 'S', version, channels (uint8),
+* 	RADIO_SCAN_SAMPLE_US, RADIO_SCAN_DWELL_SAMPLES, sweeps (uint16),
+* 	skipped, overflows (uint32). Then per channel: channel, min, avg, max,
+* 	p50, p90 (int8, dBm), busy % (uint8), samples (uint32).
+* @param  uint8_t *buf
+* @param  uint16_t size
+* @retval uint16_t length of the record, 0 if it does not fit in size or if
+* 	RADIO_ENERGY_SCAN is off
+*/
+uint16_t
+radio_scan_export(uint8_t *buf, uint16_t size)
+{
+#if RADIO_ENERGY_SCAN
+  radio_scan_stats_t stats;
+  uint8_t *p = buf;
+  uint8_t channel;
 
-    if(radio_refresh_status() != MC_STATE_STANDBY)
-    {
-      LOG_ERR("Radio: failed off->stdby\n");
-      return 1;
+  if(size < SCAN_EXPORT_HEADER_LEN + SCAN_CHANNELS * SCAN_EXPORT_CHANNEL_LEN) {
+    return 0;
+  }
+  *p++ = 'R';
+  *p++ = 'S';
+  *p++ = SCAN_EXPORT_VERSION;
+  *p++ = SCAN_CHANNELS;
+  p = radio_scan_put_le(p, RADIO_SCAN_SAMPLE_US, 2);
+  p = radio_scan_put_le(p, RADIO_SCAN_DWELL_SAMPLES, 2);
+  p = radio_scan_put_le(p, scan_sweeps, 2);
+  p = radio_scan_put_le(p, scan_skipped, 4);
+  p = radio_scan_put_le(p, scan_overflows, 4);
+  for(channel = CHANNEL_NUMBER_MIN; channel <= CHANNEL_NUMBER_MAX; channel++) {
+    radio_scan_get_stats(channel, &stats);
+    *p++ = channel;
+    *p++ = (uint8_t)stats.min_dbm;
+    *p++ = (uint8_t)stats.avg_dbm;
+    *p++ = (uint8_t)stats.max_dbm;
+    *p++ = (uint8_t)stats.p50_dbm;
+    *p++ = (uint8_t)stats.p90_dbm;
+    *p++ = stats.busy_pct;
+    p = radio_scan_put_le(p, stats.samples, 4);
+  }
+  return (uint16_t)(p - buf);
+#else /*!RADIO_ENERGY_SCAN*/
+  UNUSED(buf);
+  UNUSED(size);
+  return 0;
+#endif /*RADIO_ENERGY_SCAN*/
+}
+/*---------------------------------------------------------------------------*/
+#if RADIO_ENERGY_SCAN && BUILD_WITH_SHELL
+static
+PT_THREAD(cmd_rssi_scan(struct pt *pt, shell_output_func output, char *args))
+{
+  uint8_t record[SCAN_EXPORT_HEADER_LEN + SCAN_CHANNELS * SCAN_EXPORT_CHANNEL_LEN];
+  char hex[2 * 16 + 1];
+  radio_scan_status_t status;
+  radio_scan_stats_t stats;
+  char *next_args;
+  uint16_t len;
+  uint16_t i;
+  uint8_t channel;
+
+  PT_BEGIN(pt);
+
+  SHELL_ARGS_INIT(args, next_args);
+  SHELL_ARGS_NEXT(args, next_args);
+
+  if(args == NULL || !strcmp(args, "show")) {
+    radio_scan_get_status(&status);
+    SHELL_OUTPUT(output, "Scan %s, %u sweeps, %lu samples skipped, %lu lost\n",
+                 status.active ? "running" : "stopped", status.sweeps,
+                 (unsigned long)status.skipped, (unsigned long)status.overflows);
+    SHELL_OUTPUT(output, "ch  samples  min  avg  max  p50  p90 busy\n");
+    for(channel = CHANNEL_NUMBER_MIN; channel <= CHANNEL_NUMBER_MAX; channel++) {
+      radio_scan_get_stats(channel, &stats);
+      SHELL_OUTPUT(output, "%2u %8lu %4d %4d %4d %4d %4d %3u%%\n", channel,
+                   (unsigned long)stats.samples, stats.min_dbm, stats.avg_dbm,
+                   stats.max_dbm, stats.p50_dbm, stats.p90_dbm, stats.busy_pct);
+    }
+    SHELL_OUTPUT(output, "Quietest channel: %d\n", radio_scan_best_channel());
+  } else if(!strcmp(args, "start")) {
+    SHELL_ARGS_NEXT(args, next_args);
+    if(radio_scan_start(args == NULL ? 0 : (uint16_t)atoi(args)) < 0) {
+      SHELL_OUTPUT(output, "Scan not started: scanning, sniffing, polling or sending\n");
+    }
+  } else if(!strcmp(args, "stop")) {
+    radio_scan_stop();
+  } else if(!strcmp(args, "bin")) {
+    /* Magic string for the host parser, then the record in hex */
+    len = radio_scan_export(record, sizeof(record));
+    output("RSCAN ");
+    for(i = 0; i < len; i++) {
+      snprintf(&hex[2 * (i % 16)], 3, "%02x", record[i]);
+      if(i % 16 == 15 || i == len - 1) {
+        output(hex);
+      }
+    }
+    output("\n");
+  } else {
+    SHELL_OUTPUT(output, "Usage: rssi-scan [start [sweeps]|stop|show|bin]\n");
+  }
+
+  PT_END(pt);
+}
+#endif /*RADIO_ENERGY_SCAN && BUILD_WITH_SHELL*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_ENERGY_SCAN
+/**
+* @brief  energy scan PROCESS: drains the ring and steps through the channels
+*/
+PROCESS_THREAD(radio_scan_process, ev, data)
+{
+  uint8_t next;
+  uint16_t taken;
+
+  PROCESS_BEGIN();
+
+  while(1) {
+    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
+    if(!RADIO_SCANNING()) {
+      continue;
+    }
+    /* Read once: the rtimer may count another period meanwhile */
+    taken = scan_taken;
+    radio_scan_sample(taken);
+    radio_scan_drain();
+    if(taken < RADIO_SCAN_DWELL_SAMPLES) {
+      continue;
+    }
+    next = scan_channel + 1;
+    if(next > CHANNEL_NUMBER_MAX) {
+      next = CHANNEL_NUMBER_MIN;
+      scan_sweeps++;
+      if(scan_sweeps_max != 0 && scan_sweeps >= scan_sweeps_max) {
+        radio_scan_end();
+        continue;
+      }
     }
+    radio_scan_tune(next);
+  }
+  PROCESS_END();
+}
+#endif /*RADIO_ENERGY_SCAN*/
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_cca_threshold
+* 	gives the CCA threshold of a channel: the one set through
+* 	RADIO_PARAM_CCA_THRESHOLD, or the adapted one once its noise floor is known
+* @param  int channel
+* @retval int threshold in dBm
+*/
+static int
+radio_cca_threshold(int channel)
+{
+#if RADIO_ADAPTIVE_CCA
+  radio_cca_channel_t *c = &cca_table[channel - CHANNEL_NUMBER_MIN];
+  int threshold;
 
-    radio_on = OFF;
-    CLEAR_RXBUF();
+  if(!cca_adaptive || c->floor_q4 == 0) {
+    return csma_tx_threshold;
+  }
+  threshold = (c->floor_q4 - 8) / 16 + RADIO_CCA_MARGIN_DB + c->offset_db;
+  if(threshold < CCA_THRESHOLD_MIN_DBM) {
+    threshold = CCA_THRESHOLD_MIN_DBM;
+  } else if(threshold > CCA_THRESHOLD_MAX_DBM) {
+    threshold = CCA_THRESHOLD_MAX_DBM;
+  }
+  return threshold;
+#else /*!RADIO_ADAPTIVE_CCA*/
+  UNUSED(channel);
+  return csma_tx_threshold;
+#endif /*RADIO_ADAPTIVE_CCA*/
+}
+/*---------------------------------------------------------------------------*/
+#if RADIO_ADAPTIVE_CCA
+/**
+* @brief  radio_cca_sample
+* 	ctimer callback: reads the running RSSI when the radio idles in RX on
+* 	its channel
+* @param  void *ptr
+* @retval none
+*/
+static void
+radio_cca_sample(void *ptr)
+{
+  ctimer_set(&cca_timer, RADIO_CCA_SAMPLE_MS * CLOCK_SECOND / 1000, radio_cca_sample, ptr);
+
+  /* A frame on air, ours or not, is not noise */
+  if(!cca_adaptive || radio_on == OFF || polling_mode || RADIO_SNIFFING() ||
+     RADIO_SCANNING() || receiving_packet || transmitting_packet ||
+     interrupt_callback_in_progress || radio_spi_busy()) {
+    return;
+  }
+#if RADIO_ASYNC_TX
+  if(tx_async_pending) {
+    return;
+  }
+#endif /*RADIO_ASYNC_TX*/
+#if RADIO_ISR_ACK
+  if(ack_state != ACK_IDLE || ack_sending) {
+    return;
   }
+#endif /*RADIO_ISR_ACK*/
+  radio_cca_feed(conf_channel, S2LP_RADIO_QI_GetRssidBmRun());
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_cca_feed
+* 	adds a running RSSI sample to the noise floor of a channel
+* @param  uint8_t channel
+* @param  int32_t rssi in dBm
+* @retval none
+*/
+static void
+radio_cca_feed(uint8_t channel, int32_t rssi)
+{
+  radio_cca_channel_t *c = &cca_table[channel - CHANNEL_NUMBER_MIN];
 
-  LOG_DBG("Radio: off.\n");
-  //radio_print_status();
+  if(rssi < -128) {
+    rssi = -128;
+  } else if(rssi > 127) {
+    rssi = 127;
+  }
+  c->samples++;
+  if(c->window_len == 0 || rssi < c->window_min) {
+    c->window_min = (int8_t)rssi;
+  }
+  if(++c->window_len < RADIO_CCA_WINDOW) {
+    return;
+  }
+  /* The minimum of the window skips the frames and the bursts of the others */
+  c->window_len = 0;
+  if(c->floor_q4 == 0) {
+    c->floor_q4 = c->window_min * 16;
+  } else {
+    c->floor_q4 += (c->window_min * 16 - c->floor_q4) / 4;
+  }
+  if(c->floor_q4 == 0) {
+    c->floor_q4 = -1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_cca_account
+* 	counts the outcome of a frame sent with CSMA and, every
+* 	RADIO_CCA_ADAPT_TX frames, adapts the threshold and the backoff of the
+* 	channel: a busy channel whose frames get acknowledged is over-sensitive,
+* 	frames lost while the CCA was clear are sent over other nodes
+* @param  int status RADIO_TX_xxx of the transmission
+* @retval none
+*/
+static void
+radio_cca_account(int status)
+{
+  radio_cca_channel_t *c = &cca_table[conf_channel - CHANNEL_NUMBER_MIN];
+  uint8_t busy_pct;
+  uint8_t noack_pct;
+  int8_t offset;
+  uint8_t boost;
+
+  if(!csma_enabled || !cca_adaptive) {
+    return;
+  }
+  c->tx_frames++;
+  c->period_tx++;
+  if(status == RADIO_TX_COLLISION) {
+    c->cca_busy++;
+    c->period_busy++;
+  } else if(status == RADIO_TX_NOACK) {
+    c->noack++;
+    c->period_noack++;
+  }
+  if(c->period_tx < RADIO_CCA_ADAPT_TX) {
+    return;
+  }
+
+  busy_pct = (uint8_t)((c->period_busy * 100) / c->period_tx);
+  noack_pct = (c->period_tx == c->period_busy) ? 0 :
+    (uint8_t)((c->period_noack * 100) / (c->period_tx - c->period_busy));
+  offset = c->offset_db;
+  boost = c->boost;
+  if(busy_pct >= CCA_BUSY_HIGH_PCT) {
+    if(noack_pct < CCA_NOACK_HIGH_PCT) {
+      offset += CCA_OFFSET_STEP_DB;
+    } else {
+      /* Real contention: wait longer instead */
+      boost++;
+    }
+  } else if(noack_pct >= CCA_NOACK_HIGH_PCT) {
+    offset -= CCA_OFFSET_STEP_DB;
+    boost++;
+  } else {
+    /* Healthy channel: back to the nominal values */
+    if(boost > 0) {
+      boost--;
+    }
+    if(offset > 0) {
+      offset -= CCA_OFFSET_STEP_DB;
+    } else if(offset < 0) {
+      offset += CCA_OFFSET_STEP_DB;
+    }
+  }
+  if(offset > CCA_OFFSET_MAX_DB) {
+    offset = CCA_OFFSET_MAX_DB;
+  } else if(offset < CCA_OFFSET_MIN_DB) {
+    offset = CCA_OFFSET_MIN_DB;
+  }
+  if(boost > CCA_BOOST_MAX) {
+    boost = CCA_BOOST_MAX;
+  }
+  if(offset != c->offset_db || boost != c->boost) {
+    c->offset_db = offset;
+    c->boost = boost;
+    c->adaptations++;
+    LOG_DBG("CCA channel %d: busy %u%%, no ACK %u%%, threshold %d dBm, boost %u\n",
+            conf_channel, busy_pct, noack_pct, radio_cca_threshold(conf_channel), boost);
+  }
+  c->period_tx = 0;
+  c->period_busy = 0;
+  c->period_noack = 0;
+}
+#endif /*RADIO_ADAPTIVE_CCA*/
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_cca_get_stats
+* 	gives the noise floor, the CCA threshold and the TX outcomes of a channel
+* @param  uint8_t channel
+* @param  radio_cca_stats_t *stats
+* @retval int 0, -1 if the channel is out of range or RADIO_ADAPTIVE_CCA is off
+*/
+int
+radio_cca_get_stats(uint8_t channel, radio_cca_stats_t *stats)
+{
+#if RADIO_ADAPTIVE_CCA
+  radio_cca_channel_t *c;
+
+  if(channel < CHANNEL_NUMBER_MIN || channel > CHANNEL_NUMBER_MAX) {
+    return -1;
+  }
+  c = &cca_table[channel - CHANNEL_NUMBER_MIN];
+  stats->noise_floor_dbm = (c->floor_q4 == 0) ? 0 : (int8_t)((c->floor_q4 - 8) / 16);
+  stats->threshold_dbm = (int8_t)radio_cca_threshold(channel);
+  stats->backoff_boost = c->boost;
+  stats->noise_samples = c->samples;
+  stats->tx_frames = c->tx_frames;
+  stats->cca_busy = c->cca_busy;
+  stats->noack = c->noack;
+  stats->adaptations = c->adaptations;
+  return 0;
+#else /*!RADIO_ADAPTIVE_CCA*/
+  UNUSED(channel);
+  UNUSED(stats);
+  return -1;
+#endif /*RADIO_ADAPTIVE_CCA*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_cca_set_adaptive
+* 	turns the adaptation on (the default) or off: when off, the threshold is
+* 	RADIO_PARAM_CCA_THRESHOLD and the MAC backoff is not changed
+* @param  uint8_t enable
+* @retval none
+*/
+void
+radio_cca_set_adaptive(uint8_t enable)
+{
+#if RADIO_ADAPTIVE_CCA
+  cca_adaptive = (enable != 0);
+#else /*!RADIO_ADAPTIVE_CCA*/
+  UNUSED(enable);
+#endif /*RADIO_ADAPTIVE_CCA*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_cca_backoff_boost
+* 	gives what the MAC adds to its backoff exponents on the current channel
+* @param  none
+* @retval uint8_t 0..3
+*/
+uint8_t
+radio_cca_backoff_boost(void)
+{
+#if RADIO_ADAPTIVE_CCA
+  if(cca_adaptive) {
+    return cca_table[conf_channel - CHANNEL_NUMBER_MIN].boost;
+  }
+#endif /*RADIO_ADAPTIVE_CCA*/
   return 0;
 }
 /*---------------------------------------------------------------------------*/
+#if RADIO_STATS
+/**
+* @brief  radio_stats_record
+* 	adds a duration to one of the histograms
+* @param  uint8_t hist: RADIO_STATS_xxx
+* @param  uint32_t elapsed: in RADIO_STATS_NOW() units
+* @retval none
+*/
+static void
+radio_stats_record(uint8_t hist, uint32_t elapsed)
+{
+  radio_stats_hist_t *h = &stats.hist[hist];
+  uint32_t us = RADIO_STATS_US(elapsed);
+  uint8_t bin = 0;
+
+  while(bin < RADIO_STATS_HIST_BINS - 1 && (us >> (bin + 1)) != 0) {
+    bin++;
+  }
+  h->bins[bin]++;
+  h->count++;
+  h->total_us += us;
+  if(us > h->max_us) {
+    h->max_us = us;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_stats_wait
+* 	accounts for a BUSYWAIT_UNTIL
+* @param  uint32_t start: RADIO_STATS_NOW() before the wait
+* @param  uint8_t timeout: the condition was still false at the end
+* @retval none
+*/
+static void
+radio_stats_wait(uint32_t start, uint8_t timeout)
+{
+  radio_stats_record(RADIO_STATS_WAIT, RADIO_STATS_NOW() - start);
+  if(timeout) {
+    stats.wait_timeouts++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_stats_tx_done
+* 	ends the air time of the frame being sent, at IRQ_TX_DATA_SENT
+* @param  none
+* @retval none
+*/
+static void
+radio_stats_tx_done(void)
+{
+  if(stats_tx_on) {
+    stats_tx_on = 0;
+    stats.tx_us += RADIO_STATS_US(RADIO_STATS_NOW() - stats_tx_start);
+    stats.tx_frames++;
+  }
+}
+/*---------------------------------------------------------------------------*/
 /**
-* @brief  Radio_on
-* 	turns on the Sub-GHz radio
-* @param  none
-* @retval int result(0 == success)
+* @brief  radio_stats_bus
+* 	S2-LP bus monitor: counts the SPI transactions and bytes
+* @param  uint8_t header
+* @param  uint16_t len: bytes after the 2 header bytes
+* @retval none
 */
-static int Radio_on(void)
+static void
+radio_stats_bus(uint8_t header, uint16_t len)
 {
-  LOG_DBG("Radio: on\n");
-
-  if(radio_on == OFF) {
-#if RADIO_SNIFF_MODE
-    S2LP_TIM_LdcrMode(S_ENABLE);
-    S2LP_TIM_FastRxTermTimer(S_ENABLE);
-#endif /*RADIO_SNIFF_MODE*/
-    radio_set_ready_state();
-    S2LP_FIFO_MuxRxFifoIrqEnable(S_ENABLE);
-    S2LP_ConfigRangeExt(PA_RX);
-    S2LP_CMD_StrobeRx();
-    radio_on = ON;
-    RADIO_IRQ_ENABLE(); //--> Coming from OFF, IRQ ARE DISABLED.
-  }
-  return 0;
+  UNUSED(header);
+  stats.spi_transactions++;
+  stats.spi_bytes += 2 + len;
 }
+#endif /*RADIO_STATS*/
 /*---------------------------------------------------------------------------*/
 /**
-* @brief  main Radio Contiki-NG PROCESS
+* @brief  radio_get_stats
+* 	gives the counters and histograms of the driver since the init or the
+* 	last radio_reset_stats()
+* @param  radio_stats_t *copy: filled with them
+* @retval int 0, -1 if RADIO_STATS is off
 */
-PROCESS_THREAD(subGHz_radio_process, ev, data)
+int
+radio_get_stats(radio_stats_t *copy)
 {
-  PROCESS_BEGIN();
-  LOG_DBG("Radio: process started\n");
-
-  while(1) {
-    int len;
-
-    PROCESS_YIELD_UNTIL(ev == PROCESS_EVENT_POLL);
-    LOG_DBG("Radio: polled\n");
-
-    packetbuf_clear();
-    len = Radio_read(packetbuf_dataptr(), PACKETBUF_SIZE);
-
-    if(len > 0) {
-      packetbuf_set_datalen(len);
-
-      LOG_DBG("Calling MAC.Input(%d)\n", len);
-      NETSTACK_MAC.input();
-    }
-
-    if(!IS_RXBUF_EMPTY()) {
-      LOG_DBG("After MAC.input, RX BUF is not empty.\r\n");
-      process_poll(&subGHz_radio_process);
-    }
-
-    if(interrupt_callback_wants_poll) {
-      LOG_DBG("interrupt_callback_wants_poll\n");
-      /*This part of code seems not to happen, so it is not tested.*/
-      Radio_interrupt_callback();
-      if(radio_refresh_status() == MC_STATE_READY)
-      {
-        S2LP_FIFO_MuxRxFifoIrqEnable(S_ENABLE);
-#if RADIO_SNIFF_MODE
-        /*As per previous comment, this is not tested. */
-    	S2LP_CMD_StrobeSleep();
-#else /*!RADIO_SNIFF_MODE*/
-        S2LP_ConfigRangeExt(PA_RX);
-    	S2LP_CMD_StrobeRx();
-    	BUSYWAIT_UNTIL(radio_refresh_status() == MC_STATE_RX, 1 * RTIMER_SECOND/1000);
-#endif /*RADIO_SNIFF_MODE*/
-      }
-    }
-  }
-  PROCESS_END();
+#if RADIO_STATS
+  RADIO_IRQ_DISABLE();
+  *copy = stats;
+  RADIO_IRQ_ENABLE();
+  return 0;
+#else /*!RADIO_STATS*/
+  UNUSED(copy);
+  return -1;
+#endif /*RADIO_STATS*/
 }
 /*---------------------------------------------------------------------------*/
-static int
-radio_get_rssi(void)
+/**
+* @brief  radio_reset_stats
+* 	clears the counters and histograms of the driver
+* @param  none
+* @retval none
+*/
+void
+radio_reset_stats(void)
 {
-	/*Using default GetRssidBm() API */
-  return (int) S2LP_RADIO_QI_GetRssidBm();
+#if RADIO_STATS
+  RADIO_IRQ_DISABLE();
+  memset(&stats, 0, sizeof(stats));
+  RADIO_IRQ_ENABLE();
+#endif /*RADIO_STATS*/
 }
 /*---------------------------------------------------------------------------*/
-static int
-radio_get_channel(void)
+#if RADIO_STATS && BUILD_WITH_SHELL
+static
+PT_THREAD(cmd_radio_stats(struct pt *pt, shell_output_func output, char *args))
 {
-	uint8_t register_channel;
-  /*Next statement is mainly for debugging purpose, it can be commented out. */
-  register_channel = S2LP_RADIO_GetChannel();
-  if (register_channel != conf_channel) {
-    LOG_WARN("Warning retrieved channel %d != saved channel %d\n", register_channel, conf_channel );
-	conf_channel = register_channel;
+  static const char *const names[RADIO_STATS_HISTS] = { "isr", "latency", "transmit", "wait" };
+  static radio_stats_t snapshot;
+  radio_stats_hist_t *h;
+  char *next_args;
+  uint8_t i;
+  uint8_t bin;
+
+  PT_BEGIN(pt);
+
+  SHELL_ARGS_INIT(args, next_args);
+  SHELL_ARGS_NEXT(args, next_args);
+
+  if(args != NULL && !strcmp(args, "reset")) {
+    radio_reset_stats();
+  } else if(args == NULL) {
+    radio_get_stats(&snapshot);
+    SHELL_OUTPUT(output, "TX %lu frames %lu ms, RX %lu frames %lu ms\n",
+                 (unsigned long)snapshot.tx_frames, (unsigned long)(snapshot.tx_us / 1000),
+                 (unsigned long)snapshot.rx_frames, (unsigned long)(snapshot.rx_us / 1000));
+    SHELL_OUTPUT(output, "IRQ %lu (%lu deferred), SPI %lu transactions %lu bytes, %lu wait timeouts\n",
+                 (unsigned long)snapshot.irqs, (unsigned long)snapshot.irqs_deferred,
+                 (unsigned long)snapshot.spi_transactions, (unsigned long)snapshot.spi_bytes,
+                 (unsigned long)snapshot.wait_timeouts);
+    SHELL_OUTPUT(output, "Drops: ring full %lu, buffer too small %lu, discarded %lu\n",
+                 (unsigned long)snapshot.drops[RADIO_DROP_RING_FULL],
+                 (unsigned long)snapshot.drops[RADIO_DROP_BUF_TOO_SMALL],
+                 (unsigned long)snapshot.drops[RADIO_DROP_DISCARDED]);
+    SHELL_OUTPUT(output, "us          count    avg    max  <2 <4 <8 .. >=2048\n");
+    for(i = 0; i < RADIO_STATS_HISTS; i++) {
+      h = &snapshot.hist[i];
+      SHELL_OUTPUT(output, "%-8s %8lu %6lu %6lu ", names[i], (unsigned long)h->count,
+                   (unsigned long)(h->count ? h->total_us / h->count : 0),
+                   (unsigned long)h->max_us);
+      for(bin = 0; bin < RADIO_STATS_HIST_BINS; bin++) {
+        SHELL_OUTPUT(output, " %lu", (unsigned long)h->bins[bin]);
+      }
+      SHELL_OUTPUT(output, "\n");
+    }
+  } else {
+    SHELL_OUTPUT(output, "Usage: radio-stats [reset]\n");
   }
 
-  return register_channel;
+  PT_END(pt);
 }
+#endif /*RADIO_STATS && BUILD_WITH_SHELL*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_SHELL
+static const struct shell_command_t radio_shell_commands[] = {
+#if RADIO_ENERGY_SCAN
+  { "rssi-scan", cmd_rssi_scan, "'> rssi-scan [start [sweeps]|stop|show|bin]': channel energy scan of the radio" },
+#endif /*RADIO_ENERGY_SCAN*/
+#if RADIO_STATS
+  { "radio-stats", cmd_radio_stats, "'> radio-stats [reset]': time, SPI traffic and drops of the radio driver" },
+#endif /*RADIO_STATS*/
+  { NULL, NULL, NULL },
+};
+static struct shell_command_set_t radio_shell_command_set = {
+  .next = NULL,
+  .commands = radio_shell_commands,
+};
 /*---------------------------------------------------------------------------*/
 static void
-radio_set_channel(int c)
+radio_shell_register(void *ptr)
 {
-	/*Channel value has been validated in the calling function. */
-  LOG_DBG("SET CHANNEL %d.\r\n", c);
-
-  conf_channel = c;
-  S2LP_RADIO_SetChannel(conf_channel);
-  S2LP_RADIO_SetChannelSpace(CHANNEL_SPACE);
+  UNUSED(ptr);
+  shell_command_set_register(&radio_shell_command_set);
 }
+#endif /*RADIO_SHELL*/
 /*---------------------------------------------------------------------------*/
 static void
 radio_set_txpower(int8_t power)
@@ -967,6 +3556,9 @@ radio_set_auto_pkt_filter(uint8_t enable)
   LOG_DBG("Set Auto Packet Filtering %d\n", enable);
   auto_pkt_filter = enable;
   S2LP_PCKT_HNDL_SetAutoPcktFilter(enable?S_ENABLE:S_DISABLE);
+#if RADIO_HW_ACK
+  radio_hw_ack_auto();
+#endif /*RADIO_HW_ACK*/
 }
 /*---------------------------------------------------------------------------*/
 static void
@@ -976,25 +3568,73 @@ radio_set_auto_ack(uint8_t enable)
      not send in any case since the implementation for Packet Basic is done
 	 in software */
   radio_send_auto_ack = enable;
+#if RADIO_HW_ACK
+  radio_hw_ack_auto();
+#endif /*RADIO_HW_ACK*/
 }
 /*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_set_polling_mode
+* 	in poll mode (TSCH) the IRQ line is not used at all: every mask is
+* 	cleared, the status is read by radio_poll_irqs(). The masks are set back
+* 	when leaving it. Poll mode and sniff mode exclude each other.
+* @param  uint8_t enable
+* @retval None
+*/
 static void
 radio_set_polling_mode(uint8_t enable)
 {
-  /* Polling Mode  must be fully validated. */
   LOG_DBG("POLLING MODE is %s.\r\n", enable?"ENABLED":"DISABLED");
-  polling_mode = enable;
-  if(polling_mode) {
-    /* Disable interrupts */
-    S2LP_GPIO_IrqConfig(RX_DATA_READY,S_DISABLE);
-    S2LP_GPIO_IrqConfig(TX_DATA_SENT,S_DISABLE);
-    S2LP_GPIO_IrqConfig(VALID_SYNC,S_DISABLE);
+  if(enable == polling_mode) {
+    return;
+  }
+#if RADIO_ASYNC_TX
+  radio_tx_async_complete();
+#endif /*RADIO_ASYNC_TX*/
+  RADIO_IRQ_DISABLE();
+  if(enable) {
+    S2LP_GPIO_IrqGetMask(&poll_saved_mask);
+    S2LP_GPIO_IrqDeInit(NULL);
   } else {
-    /* Initialize and enable interrupts */
-    S2LP_GPIO_IrqConfig(RX_DATA_READY,S_ENABLE);
-    S2LP_GPIO_IrqConfig(TX_DATA_SENT,S_ENABLE);
-    S2LP_GPIO_IrqConfig(VALID_SYNC,S_ENABLE);
+    S2LP_GPIO_IrqInit(&poll_saved_mask);
+  }
+  S2LP_GPIO_IrqClearStatus();
+  poll_irqs = 0;
+  sync_timestamp_valid = 0;
+  receiving_packet = 0;
+  pending_packet = 0;
+  polling_mode = enable;
+  RADIO_IRQ_ENABLE();
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_poll_irqs
+* 	reads the IRQ status in poll mode and adds it to the events not consumed
+* 	yet, timestamping the sync word and the end of the frame: the poll is
+* 	their edge. A sync word seen with the end of its frame is too late.
+* @param  none
+* @retval uint32_t the events pending, as the IrqList values
+*/
+static uint32_t
+radio_poll_irqs(void)
+{
+  uint32_t irqs = radio_irq_status();
+
+  if(irqs & RX_DATA_DISC) {
+    /* The frame synchronized on has been dropped */
+    poll_irqs &= ~VALID_SYNC;
+    irqs &= ~VALID_SYNC;
+    sync_timestamp_valid = 0;
+  }
+  if((irqs & (VALID_SYNC | RX_DATA_READY)) == VALID_SYNC) {
+    sync_timestamp = RTIMER_NOW();
+    sync_timestamp_valid = 1;
+  }
+  if(irqs & RX_DATA_READY) {
+    irq_timestamp = RTIMER_NOW();
   }
+  poll_irqs |= irqs;
+  return poll_irqs;
 }
 /*---------------------------------------------------------------------------*/
 /* Enable or disable CSMA Feature (check also RADIO_HW_CSMA macro) */
@@ -1008,7 +3648,6 @@ radio_set_csma(uint8_t enable)
 static rtimer_clock_t
 radio_get_packet_timestamp(void)
 {
-//@TODO: This is to be validated.
   LOG_DBG("radio_get_packet_timestamp: %u\r\n", last_packet_timestamp);
 
   return last_packet_timestamp;
@@ -1062,7 +3701,7 @@ Radio_get_value(radio_param_t parameter, radio_value_t *ret_value)
       *ret_value = last_packet_rssi;
 	  get_value_result = RADIO_RESULT_OK;
   } else if (parameter == RADIO_PARAM_CCA_THRESHOLD) {
-      *ret_value = csma_tx_threshold;
+      *ret_value = radio_cca_threshold(conf_channel);
 	  get_value_result = RADIO_RESULT_OK;
   } else if (parameter == RADIO_CONST_CHANNEL_MIN) {
       *ret_value = CHANNEL_NUMBER_MIN;
@@ -1080,6 +3719,21 @@ Radio_get_value(radio_param_t parameter, radio_value_t *ret_value)
 	  /*TODO: check if this value is correct.*/
       *ret_value = MAX_PACKET_LEN;
 	  get_value_result = RADIO_RESULT_OK;
+  } else if (parameter == RADIO_CONST_PHY_OVERHEAD) {
+      *ret_value = RADIO_PHY_OVERHEAD_BYTES;
+	  get_value_result = RADIO_RESULT_OK;
+  } else if (parameter == RADIO_CONST_BYTE_AIR_TIME) {
+      *ret_value = RADIO_BYTE_AIR_TIME_US;
+	  get_value_result = RADIO_RESULT_OK;
+  } else if (parameter == RADIO_CONST_DELAY_BEFORE_TX) {
+      *ret_value = RADIO_DELAY_BEFORE_TX_US;
+	  get_value_result = RADIO_RESULT_OK;
+  } else if (parameter == RADIO_CONST_DELAY_BEFORE_RX) {
+      *ret_value = RADIO_DELAY_BEFORE_RX_US;
+	  get_value_result = RADIO_RESULT_OK;
+  } else if (parameter == RADIO_CONST_DELAY_BEFORE_DETECT) {
+      *ret_value = RADIO_DELAY_BEFORE_DETECT_US;
+	  get_value_result = RADIO_RESULT_OK;
   }
 
   return get_value_result;
@@ -1108,6 +3762,12 @@ Radio_set_value(radio_param_t parameter, radio_value_t input_value)
 	  }
   } else if (parameter == RADIO_PARAM_CHANNEL){
       if((input_value >= CHANNEL_NUMBER_MIN) && (input_value <= CHANNEL_NUMBER_MAX)) {
+#if RADIO_ENERGY_SCAN
+        if(RADIO_SCANNING()) {
+          /* Tuned at the end of the scan */
+          scan_home_channel = input_value;
+        } else
+#endif /*RADIO_ENERGY_SCAN*/
         radio_set_channel(input_value);
 		set_value_result = RADIO_RESULT_OK;
       } else {
@@ -1115,7 +3775,8 @@ Radio_set_value(radio_param_t parameter, radio_value_t input_value)
 	  }
   } else if (parameter == RADIO_PARAM_RX_MODE) {
 	  radio_value_t valid = RADIO_RX_MODE_ADDRESS_FILTER | RADIO_RX_MODE_AUTOACK | RADIO_RX_MODE_POLL_MODE ;
-	  if (input_value & (~valid)) {
+	  if ((input_value & (~valid)) ||
+	      ((input_value & RADIO_RX_MODE_POLL_MODE) && (RADIO_SNIFFING() || RADIO_SCANNING()))) {
 		  set_value_result = RADIO_RESULT_INVALID_VALUE;
 	  } else {
           radio_set_auto_pkt_filter((input_value & RADIO_RX_MODE_ADDRESS_FILTER) != 0);
@@ -1139,8 +3800,11 @@ Radio_set_value(radio_param_t parameter, radio_value_t input_value)
         set_value_result = RADIO_RESULT_INVALID_VALUE;
 	  }
   } else if (parameter == RADIO_PARAM_CCA_THRESHOLD) {
-	  //TODO: this value is not currently taken into account, only RSSI_TX_THRESHOLD macro is used
+      /* Applied to the next transmissions, in place of the adapted one */
       csma_tx_threshold = input_value;
+#if RADIO_ADAPTIVE_CCA
+      cca_adaptive = 0;
+#endif /*RADIO_ADAPTIVE_CCA*/
 	  set_value_result = RADIO_RESULT_OK;
   }
 
@@ -1162,6 +3826,24 @@ Radio_get_object(radio_param_t parameter, void *destination, size_t size)
     } else {
       get_object_retval = RADIO_RESULT_INVALID_VALUE;
 	}
+#if RADIO_TSCH_TIMESLOT_US <= 0xFFFF
+  } else if(parameter == RADIO_CONST_TSCH_TIMING) {
+    if((size == sizeof(const uint16_t *)) && (destination != NULL)) {
+      *(const uint16_t **)destination = radio_tsch_timing_us;
+      get_object_retval = RADIO_RESULT_OK;
+    } else {
+      get_object_retval = RADIO_RESULT_INVALID_VALUE;
+    }
+#endif /*RADIO_TSCH_TIMESLOT_US*/
+#if RADIO_STATS
+  } else if(parameter == RADIO_PARAM_DRIVER_STATS) {
+    if((size == sizeof(radio_stats_t)) && (destination != NULL)) {
+      radio_get_stats((radio_stats_t *)destination);
+      get_object_retval = RADIO_RESULT_OK;
+    } else {
+      get_object_retval = RADIO_RESULT_INVALID_VALUE;
+    }
+#endif /*RADIO_STATS*/
   }
   return get_object_retval;
 }
@@ -1178,25 +3860,41 @@ Radio_set_object(radio_param_t parameter, const void *source, size_t size)
 }
 /*---------------------------------------------------------------------------*/
 /* @brief Radio_read_from_fifo can be called from Radio_interrupt_callback or
- *        from Radio_read depending on the operating mode.
+ *        from Radio_read depending on the operating mode. It only updates the
+ *        last_packet_* values: the packetbuf is not ours in interrupt context.
+ *        drained is what has been read of the frame already (FIFO streaming).
+ *        It returns the bytes read, -1 if they do not fit in buf.
  */
-static int Radio_read_from_fifo (uint8_t* buf, unsigned short bufsize)
+static int Radio_read_from_fifo (uint8_t* buf, unsigned short bufsize, uint16_t drained)
 {
-  uint8_t rx_bytes, retval = 0;
+  SRxPacketInfo rx_info;
+  int rx_bytes;
+  int retval = -1;
 
-  rx_bytes = S2LP_FIFO_ReadNumberBytesRxFifo();
+  /* RSSI, LQI and length in one burst: the length gives what is left in
+   * the FIFO, without reading RX_FIFO_STATUS */
+  S2LP_RADIO_QI_GetRxPacketInfo(&rx_info);
+  rx_bytes = (int)rx_info.nPacketLength - RX_PCKT_LEN_EXTRA - drained;
 
-  if (rx_bytes <= bufsize) {
-    S2LP_ReadFIFO(rx_bytes, (uint8_t*)buf);
+  if (rx_bytes >= 0 && rx_bytes <= bufsize && rx_bytes <= S2LP_RX_FIFO_SIZE) {
+    S2LP_ReadFIFO((uint8_t)rx_bytes, (uint8_t*)buf);
     retval = rx_bytes;
-    last_packet_timestamp = RTIMER_NOW() ; //@TODO: validate
-    last_packet_rssi = (radio_value_t) S2LP_RADIO_QI_GetRssidBm();
-    last_packet_lqi  = (packetbuf_attr_t) S2LP_RADIO_QI_GetLqi();
-    packetbuf_set_attr(PACKETBUF_ATTR_RSSI, (packetbuf_attr_t) last_packet_rssi);
-    packetbuf_set_attr(PACKETBUF_ATTR_LINK_QUALITY, last_packet_lqi);
+    if(sync_timestamp_valid && !RADIO_SNIFFING()) {
+      last_packet_timestamp = sync_timestamp;
+    } else {
+      last_packet_timestamp = irq_timestamp -
+                              RADIO_SYNC_TO_RX_END(rx_info.nPacketLength) -
+                              US_TO_RTIMERTICKS(RADIO_IRQ_LATENCY_US);
+    }
+    last_packet_rssi = (radio_value_t) rx_info.lRssidBm;
+    last_packet_lqi  = (packetbuf_attr_t) rx_info.cLqi;
   } else {
     LOG_DBG("Buf too small (%d bytes to hold %d bytes)\n", bufsize, rx_bytes);
+#if RADIO_STATS
+    stats.drops[RADIO_DROP_BUF_TOO_SMALL]++;
+#endif /*RADIO_STATS*/
   }
+  sync_timestamp_valid = 0;
   if (polling_mode) {
     S2LP_CMD_StrobeFlushRxFifo();
   }
@@ -1205,93 +3903,283 @@ static int Radio_read_from_fifo (uint8_t* buf, unsigned short bufsize)
 }
 /*---------------------------------------------------------------------------*/
 /**
-* @brief  Radio_interrupt_callback
-* 	callback when an interrupt is received
+* @brief  radio_irq_status
+* 	reads and clears the IRQ status registers
 * @param  none
-* @retval none
+* @retval uint32_t the IRQs raised, as the IrqList values
 */
-void
-Radio_interrupt_callback(void)
+static uint32_t
+radio_irq_status(void)
 {
+  uint8_t tmp[4];
+
+  g_xStatus = S2LP_ReadRegister(IRQ_STATUS3_ADDR, 4, tmp);
+  return ((uint32_t)tmp[0] << 24) | ((uint32_t)tmp[1] << 16) | ((uint32_t)tmp[2] << 8) | tmp[3];
+}
+/*---------------------------------------------------------------------------*/
 #define INTPRINTF(...) // printf
-  S2LPIrqs x_irq_status;
-  if (radio_spi_busy() || interrupt_callback_in_progress)
-  {
-    process_poll(&subGHz_radio_process);
-    interrupt_callback_wants_poll = 1;
-    return;
+/* The IRQ handlers below are run by Radio_interrupt_callback in the order of
+ * radio_irq_table, for the IRQs raised. They return 1 when the rest of the
+ * table has to be skipped; irqs can be updated for the next ones. */
+#if RADIO_FIFO_STREAMING
+static uint8_t
+radio_irq_tx_fifo_almost_empty(uint32_t *irqs)
+{
+  if(transmitting_packet && tx_stream_pos < tx_stream_len) {
+    radio_tx_stream_refill();
   }
-
-  interrupt_callback_wants_poll = 0;
-  interrupt_callback_in_progress = 1;
-
-  /* get interrupt source from radio */
-  S2LP_GPIO_IrqGetStatus(&x_irq_status);
-
-  /* The IRQ_TX_DATA_SENT notifies the packet transmission.
-  * Then puts the Radio in RX/Sleep according to the selected mode */
-  if(x_irq_status.IRQ_TX_DATA_SENT && transmitting_packet)
-  {
-    INTPRINTF("IRQ_TX_DATA_SENT\n");
-    transmitting_packet = 0;
-    xTxDoneFlag = SET;
-    interrupt_callback_in_progress = 0;
-    return;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+radio_irq_rx_fifo_almost_full(uint32_t *irqs)
+{
+  if(!transmitting_packet) {
+    radio_rx_stream_drain();
+  }
+  return 0;
+}
+#endif /*RADIO_FIFO_STREAMING*/
+/*---------------------------------------------------------------------------*/
+#if RADIO_HW_ACK
+static uint8_t
+radio_irq_max_re_tx_reach(uint32_t *irqs)
+{
+  /* The frame has been sent RADIO_HW_ACK_RETX + 1 times without ACK */
+  if(transmitting_packet) {
+    hw_ack_missed = 1;
+    *irqs |= TX_DATA_SENT;
+  }
+  return 0;
+}
+#endif /*RADIO_HW_ACK*/
+/*---------------------------------------------------------------------------*/
+/* The IRQ_TX_DATA_SENT notifies the packet transmission.
+ * Then puts the Radio in RX/Sleep according to the selected mode */
+static uint8_t
+radio_irq_tx_data_sent(uint32_t *irqs)
+{
+  if(!transmitting_packet) {
+#if RADIO_HW_ACK
+    /* The packet handler has acknowledged a frame: back to the wake ups */
+    if(RADIO_SNIFFING()) {
+      S2LP_CMD_StrobeSleep();
+    }
+#endif /*RADIO_HW_ACK*/
+    return 0;
   }
 
-#if !RADIO_SNIFF_MODE
-  /* The IRQ_VALID_SYNC is used to notify a new packet is coming */
-  if(x_irq_status.IRQ_VALID_SYNC  && !transmitting_packet )
-  {
-    interrupt_callback_in_progress = 0;
+  INTPRINTF("IRQ_TX_DATA_SENT\n");
+  transmitting_packet = 0;
+#if RADIO_ISR_ACK
+  if(ack_sending) {
+    radio_ack_sent();
+    return 1;
+  }
+#endif /*RADIO_ISR_ACK*/
+  xTxDoneFlag = SET;
+#if RADIO_STATS
+  radio_stats_tx_done();
+#endif /*RADIO_STATS*/
+#if RADIO_ASYNC_TX
+  if(tx_async_pending) {
+    process_poll(&subGHz_radio_process);
+  }
+#endif /*RADIO_ASYNC_TX*/
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+/* The IRQ_VALID_SYNC is used to notify a new packet is coming */
+static uint8_t
+radio_irq_valid_sync(uint32_t *irqs)
+{
+  /* In sniff mode IRQ_VALID_SYNC is masked: the edge would not be its own */
+  if(!transmitting_packet && !RADIO_SNIFFING()) {
     INTPRINTF("IRQ_VALID_SYNC\n");
+    sync_timestamp = irq_timestamp - US_TO_RTIMERTICKS(RADIO_IRQ_LATENCY_US);
+    sync_timestamp_valid = 1;
     receiving_packet = 1;
     S2LP_ConfigRangeExt(PA_RX);
+#if RADIO_STATS
+    stats_rx_start = stats_irq_edge;
+    stats_rx_on = 1;
+#endif /*RADIO_STATS*/
     S2LP_CMD_StrobeRx();
   }
-#endif /*RADIO_SNIFF_MODE*/
-
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
 #if RADIO_HW_CSMA
-  if(x_irq_status.IRQ_MAX_BO_CCA_REACH)
-  {
-    interrupt_callback_in_progress = 0;
-    /* Send a Tx command: i.e. keep on trying */
+static uint8_t
+radio_irq_max_bo_cca_reach(uint32_t *irqs)
+{
+  /* Send a Tx command: i.e. keep on trying */
   S2LP_ConfigRangeExt(PA_TX);
-    S2LP_CMD_StrobeTx();
-    return;
-  }
+  S2LP_CMD_StrobeTx();
+  return 1;
+}
 #endif /*RADIO_HW_CSMA*/
+/*---------------------------------------------------------------------------*/
+/* The IRQ_RX_DATA_READY notifies a new packet arrived */
+static uint8_t
+radio_irq_rx_data_ready(uint32_t *irqs)
+{
+  radio_rx_slot_t *slot;
 
-  /* The IRQ_RX_DATA_READY notifies a new packet arrived */
-  if(x_irq_status.IRQ_RX_DATA_READY && !(transmitting_packet))
-  {
-    receiving_packet = 0;
+  if(transmitting_packet) {
+    return 0;
+  }
+  receiving_packet = 0;
 
-    (void) Radio_read_from_fifo(radio_rxbuf, sizeof(radio_rxbuf));
-    rx_num_bytes = S2LP_PCKT_BASIC_GetReceivedPktLength();
+  slot = radio_rx_ring_push();
+#if RADIO_STATS
+  if(stats_rx_on) {
+    stats_rx_on = 0;
+    stats.rx_us += RADIO_STATS_US(stats_irq_edge - stats_rx_start);
+  }
+  if(slot != NULL) {
+    stats.rx_frames++;
+  }
+#endif /*RADIO_STATS*/
+#if RADIO_SNIFF_MODE
+  if(RADIO_SNIFFING() && slot != NULL) {
+    sniff_stats.rx_frames++;
+  }
+#endif /*RADIO_SNIFF_MODE*/
 
+  S2LP_CMD_StrobeFlushRxFifo();
+#if RADIO_ISR_ACK
+  /* A frame that could not be queued is not acknowledged */
+  if(slot != NULL && radio_frame_wants_ack(slot->data, slot->len)) {
+    radio_ack_send(slot->data[2]);
+  }
+#endif /*RADIO_ISR_ACK*/
+  pending_packet = 1;
+  process_poll(&subGHz_radio_process);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+radio_irq_rx_data_disc(uint32_t *irqs)
+{
+  if(transmitting_packet || RADIO_SNIFFING()) {
+    return 0;
+  }
+  INTPRINTF("IRQ_RX_DATA_DISC\r\n");
+  sync_timestamp_valid = 0;
+#if RADIO_STATS
+  stats_rx_on = 0;
+  stats.drops[RADIO_DROP_DISCARDED]++;
+#endif /*RADIO_STATS*/
+#if RADIO_FIFO_STREAMING
+  /* What has been drained of the discarded frame is dropped */
+  rx_stream_len = 0;
+  rx_stream_drop = 0;
+#endif /*RADIO_FIFO_STREAMING*/
+  /* RX command - to ensure the device will be ready for the next reception */
+  if(*irqs & RX_TIMEOUT)
+  {
     S2LP_CMD_StrobeFlushRxFifo();
-    pending_packet = 1;
-    interrupt_callback_in_progress = 0;
+    S2LP_ConfigRangeExt(PA_RX);
+    S2LP_CMD_StrobeRx();
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static const struct {
+  uint32_t mask;
+  uint8_t (*handler)(uint32_t *irqs);
+} radio_irq_table[] = {
+#if RADIO_FIFO_STREAMING
+  { TX_FIFO_ALMOST_EMPTY, radio_irq_tx_fifo_almost_empty },
+  { RX_FIFO_ALMOST_FULL,  radio_irq_rx_fifo_almost_full },
+#endif /*RADIO_FIFO_STREAMING*/
+#if RADIO_HW_ACK
+  { MAX_RE_TX_REACH,      radio_irq_max_re_tx_reach },
+#endif /*RADIO_HW_ACK*/
+  { TX_DATA_SENT,         radio_irq_tx_data_sent },
+  { VALID_SYNC,           radio_irq_valid_sync },
+#if RADIO_HW_CSMA
+  { MAX_BO_CCA_REACH,     radio_irq_max_bo_cca_reach },
+#endif /*RADIO_HW_CSMA*/
+  { RX_DATA_READY,        radio_irq_rx_data_ready },
+  { RX_DATA_DISC,         radio_irq_rx_data_disc },
+};
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  radio_interrupt_serve
+* 	reads and dispatches the IRQs of the radio, or defers them to the
+* 	radio process if the SPI is taken
+* @param  none
+* @retval none
+*/
+static void
+radio_interrupt_serve(void)
+{
+  uint32_t irqs;
+  uint8_t i;
+#if RADIO_STATS
+  uint32_t stats_t0 = RADIO_STATS_NOW();
+#endif /*RADIO_STATS*/
+
+  if(polling_mode) {
+    /* An edge latched before the masks were cleared: the status is polled */
+    return;
+  }
+  if(!interrupt_callback_wants_poll) {
+    /* Not a deferred call: the IRQ line has just gone down */
+    irq_timestamp = RTIMER_NOW();
+#if RADIO_STATS
+    stats_irq_edge = stats_t0;
+#endif /*RADIO_STATS*/
+  }
+  if (radio_spi_busy() || interrupt_callback_in_progress)
+  {
     process_poll(&subGHz_radio_process);
+    interrupt_callback_wants_poll = 1;
+#if RADIO_STATS
+    stats.irqs_deferred++;
+#endif /*RADIO_STATS*/
     return;
   }
+#if RADIO_STATS
+  /* From the edge to the call that serves it, deferrals included */
+  stats.irqs++;
+  radio_stats_record(RADIO_STATS_IRQ_LATENCY, stats_t0 - stats_irq_edge);
+#endif /*RADIO_STATS*/
 
-#if !RADIO_SNIFF_MODE
-  if(x_irq_status.IRQ_RX_DATA_DISC && !transmitting_packet)
-  {
-    INTPRINTF("IRQ_RX_DATA_DISC\r\n");
-    /* RX command - to ensure the device will be ready for the next reception */
-    if(x_irq_status.IRQ_RX_TIMEOUT)
-    {
-      S2LP_CMD_StrobeFlushRxFifo();
-      S2LP_ConfigRangeExt(PA_RX);
-      S2LP_CMD_StrobeRx();
+  interrupt_callback_wants_poll = 0;
+  interrupt_callback_in_progress = 1;
+
+  /* get interrupt source from radio */
+  irqs = radio_irq_status();
+
+  for(i = 0; i < sizeof(radio_irq_table) / sizeof(radio_irq_table[0]); i++) {
+    if((irqs & radio_irq_table[i].mask) && radio_irq_table[i].handler(&irqs)) {
+      break;
     }
   }
-#endif /*!RADIO_SNIFF_MODE*/
 
   interrupt_callback_in_progress = 0;
+#if RADIO_STATS
+  radio_stats_record(RADIO_STATS_ISR, RADIO_STATS_NOW() - stats_t0);
+#endif /*RADIO_STATS*/
+}
+/*---------------------------------------------------------------------------*/
+/**
+* @brief  Radio_interrupt_callback
+* 	callback when an interrupt is received
+* @param  none
+* @retval none
+*/
+void
+Radio_interrupt_callback(void)
+{
+  /* It may interrupt the code of another S2-LP */
+  S2LP_Object_t *caller = S2LP_SelectObject(&radio_s2lp);
+
+  radio_interrupt_serve();
+  S2LP_SelectObject(caller);
 }
 /*---------------------------------------------------------------------------*/
 /** @} */
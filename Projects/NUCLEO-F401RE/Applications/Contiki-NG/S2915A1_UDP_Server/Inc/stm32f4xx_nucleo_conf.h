@@ -34,8 +34,9 @@
 /* COM Feature define */
 #define USE_BSP_COM_FEATURE                 1U
 
-/* COM define */
-#define USE_COM_LOG                         1U
+/* COM define: with the DMA, printf goes through the console TX ring */
+#define USE_BSP_COM1_DMA                    1U
+#define USE_COM_LOG                         0U
 
 /* IRQ priorities */
 #define BSP_BUTTON_USER_IT_PRIORITY         15U
@@ -46,6 +47,9 @@
 /* SPI1 Baud rate in bps  */
 #define BUS_SPI1_BAUDRATE                   16000000U /* baud rate of SPIn = 16 Mbps */
 
+/* Radio FIFO transfers run on the SPI1 DMA channels */
+#define USE_BSP_SPI1_DMA                    1U
+
 /* UART1 Baud rate in bps  */
 #define BUS_UART1_BAUDRATE                  9600U /* baud rate of UARTn = 9600 baud */
 
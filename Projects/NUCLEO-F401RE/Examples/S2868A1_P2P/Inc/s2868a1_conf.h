@@ -35,7 +35,7 @@ extern "C" {
 #include "RTE_Components.h"
 
 /* Global configuration ---------------------------------------------------*/
-extern volatile int irq_disable_cnt;
+extern volatile int S2868A1_irq_disable_cnt;
 
 /* Defines ---------------------------------------------------------------*/
 
@@ -43,14 +43,14 @@ extern volatile int irq_disable_cnt;
 #define S2868A1_RADIO_GPIO_0_IT_PRIO                         1
 #define S2868A1_ENTER_CRITICAL()                            \
    do{                                                                \
-     irq_disable_cnt++;                                               \
+     S2868A1_irq_disable_cnt++;                                       \
      HAL_NVIC_DisableIRQ( S2868A1_RADIO_GPIO_0_IRQn);        \
    }while(0)
 #define S2868A1_EXIT_CRITICAL()                             \
    do{                                                                \
-     if (irq_disable_cnt > 0)                                         \
-       irq_disable_cnt--;                                             \
-     if (irq_disable_cnt==0)                                          \
+     if (S2868A1_irq_disable_cnt > 0)                                 \
+       S2868A1_irq_disable_cnt--;                                     \
+     if (S2868A1_irq_disable_cnt==0)                                  \
        HAL_NVIC_EnableIRQ( S2868A1_RADIO_GPIO_0_IRQn);       \
    }while(0)
 #endif
@@ -58,14 +58,14 @@ extern volatile int irq_disable_cnt;
 #define S2868A1_RADIO_GPIO_1_IT_PRIO                         1
 #define S2868A1_ENTER_CRITICAL()                            \
    do{                                                                \
-     irq_disable_cnt++;                                               \
+     S2868A1_irq_disable_cnt++;                                       \
      HAL_NVIC_DisableIRQ( S2868A1_RADIO_GPIO_1_IRQn);        \
    }while(0)
 #define S2868A1_EXIT_CRITICAL()                             \
    do{                                                                \
-     if (irq_disable_cnt > 0)                                         \
-       irq_disable_cnt--;                                             \
-     if (irq_disable_cnt==0)                                          \
+     if (S2868A1_irq_disable_cnt > 0)                                 \
+       S2868A1_irq_disable_cnt--;                                     \
+     if (S2868A1_irq_disable_cnt==0)                                  \
        HAL_NVIC_EnableIRQ( S2868A1_RADIO_GPIO_1_IRQn);       \
    }while(0)
 #endif
@@ -73,14 +73,14 @@ extern volatile int irq_disable_cnt;
 #define S2868A1_RADIO_GPIO_2_IT_PRIO                         1
 #define S2868A1_ENTER_CRITICAL()                            \
    do{                                                                \
-     irq_disable_cnt++;                                               \
+     S2868A1_irq_disable_cnt++;                                       \
      HAL_NVIC_DisableIRQ( S2868A1_RADIO_GPIO_2_IRQn);        \
    }while(0)
 #define S2868A1_EXIT_CRITICAL()                             \
    do{                                                                \
-     if (irq_disable_cnt > 0)                                         \
-       irq_disable_cnt--;                                             \
-     if (irq_disable_cnt==0)                                          \
+     if (S2868A1_irq_disable_cnt > 0)                                 \
+       S2868A1_irq_disable_cnt--;                                     \
+     if (S2868A1_irq_disable_cnt==0)                                  \
        HAL_NVIC_EnableIRQ( S2868A1_RADIO_GPIO_2_IRQn);       \
    }while(0)
 #endif
@@ -88,14 +88,14 @@ extern volatile int irq_disable_cnt;
 #define S2868A1_RADIO_GPIO_3_IT_PRIO                         1
 #define S2868A1_ENTER_CRITICAL()                            \
    do{                                                                \
-     irq_disable_cnt++;                                               \
+     S2868A1_irq_disable_cnt++;                                       \
      HAL_NVIC_DisableIRQ( S2868A1_RADIO_GPIO_3_IRQn);        \
    }while(0)
 #define S2868A1_EXIT_CRITICAL()                             \
    do{                                                                \
-     if (irq_disable_cnt > 0)                                         \
-       irq_disable_cnt--;                                             \
-     if (irq_disable_cnt==0)                                          \
+     if (S2868A1_irq_disable_cnt > 0)                                 \
+       S2868A1_irq_disable_cnt--;                                     \
+     if (S2868A1_irq_disable_cnt==0)                                  \
        HAL_NVIC_EnableIRQ( S2868A1_RADIO_GPIO_3_IRQn);       \
    }while(0)
 #endif
@@ -24,6 +24,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 
+#include <string.h>
 #include "main.h"
 
 #include "app_x-cube-subg2.h"
@@ -31,6 +32,11 @@
 #include "s2868a2.h"
 #include "s2lp.h"
 #include "p2p_demo_settings.h"
+#ifdef USE_P2P_LINKTEST
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#endif
 
 /** @defgroup S2LP_Nucleo
   * @{
@@ -152,6 +158,81 @@ typedef struct
 }CSMA_Attr_typedef;
 #endif
 
+#ifdef USE_WMBUS_GATEWAY
+/**
+* @brief  Meter heard by the Wireless M-Bus gateway.
+*/
+typedef struct
+{
+  uint16_t Manufacturer;  /*!< M field */
+  uint32_t Id;            /*!< identification number of the A field */
+  uint8_t AccessNumber;   /*!< access number of the last telegram */
+  int8_t Rssi;            /*!< RSSI of the last telegram, dBm */
+  uint16_t Telegrams;     /*!< telegrams received */
+  uint32_t LastTick;      /*!< HAL tick of the last telegram */
+}WMBusMeter_t;
+#endif
+
+#ifdef USE_P2P_BULK
+/**
+* @brief  Bulk transfer State Enum.
+*/
+typedef enum {
+  BULK_STATE_LISTEN=0,        /* receiver, or sender between two transfers */
+  BULK_STATE_SEND_DATA,
+  BULK_STATE_WAIT_DATA_SENT,
+  BULK_STATE_WAIT_ACK,
+  BULK_STATE_WAIT_ACK_SENT
+} BulkState_t;
+
+/**
+* @brief  Throughput and frame error rate of the bulk transfer, one per
+*         BULK_REPORT_MS period. Bytes are the payload delivered in order on
+*         the receiver, acknowledged on the sender.
+*/
+typedef struct
+{
+  uint32_t BytesPerSecond;      /*!< goodput of the last period */
+  uint32_t Bytes;               /*!< payload bytes of the transfer so far */
+  uint32_t FramesSent;          /*!< data frames put on air, retransmissions included */
+  uint32_t FramesRetransmitted; /*!< data frames sent again: lost, or their ACK lost */
+  uint32_t FramesReceived;      /*!< data frames received, duplicates included */
+  uint32_t FramesDuplicate;     /*!< data frames received twice */
+  uint32_t AckTimeouts;         /*!< bursts that got no ACK */
+  uint16_t PerPermille;         /*!< retransmitted / sent of the last period, sender side */
+  uint32_t TransferMs;          /*!< duration of the last completed transfer */
+}P2PBulkReport_t;
+#endif
+
+#ifdef USE_P2P_LINKTEST
+/**
+* @brief  Radio settings of a link test, sent to the responder before the test
+*/
+typedef struct
+{
+  uint32_t lDatarate;
+  ModulationSelect xModulation;
+  uint32_t lFreqDev;
+  uint32_t lBandwidth;
+  SFunctionalState xFec;
+  SFunctionalState xWhitening;
+}LinkTestPhy_t;
+
+/**
+* @brief  Link test State Enum, of the node controlled from the PC. In
+*         LT_STATE_IDLE the node answers the tests of the other one.
+*/
+typedef enum {
+  LT_STATE_IDLE=0,
+  LT_STATE_CONFIG,            /* test PHY sent on the base PHY */
+  LT_STATE_SWITCH,            /* leaving the responder the time to change PHY */
+  LT_STATE_STREAM,            /* data frames back to back */
+  LT_STATE_PING,              /* one frame each way */
+  LT_STATE_REPORT,            /* what the responder received */
+  LT_STATE_DONE               /* the responder is sent back to the base PHY */
+} LinkTestState_t;
+#endif
+
 /* Exported functions ------------------------------------------------------- */
 
 void Enter_LP_mode(void);
@@ -168,6 +249,20 @@ void AppliReceiveBuff(uint8_t *RxFrameBuff, uint8_t cRxlen);
 void STackProtocolInit(void);
 void BasicProtocolInit(void);
 static void P2PInterruptHandler(void);
+#ifdef USE_WMBUS_GATEWAY
+static void WMBusGatewayInit(void);
+static void WMBusGatewayProcess(void);
+#endif
+#ifdef USE_P2P_BULK
+static void P2PBulkInit(void);
+static void P2PBulkProcess(void);
+void P2PBulk_DataToSend(uint32_t lOffset, uint8_t *pData, uint8_t cLen);
+void P2PBulk_DataReceived(uint8_t *pData, uint8_t cLen);
+#endif
+#ifdef USE_P2P_LINKTEST
+static void LinkTestInit(void);
+static void LinkTestProcess(void);
+#endif
 void Set_KeyStatus(FlagStatus val);
 void S2LPInterfaceInit(void);
 void S2LP_ManagementSetBand(uint8_t value);
@@ -359,6 +454,47 @@ RadioCsmaInit xCsmaInit={
 /* Private define ------------------------------------------------------------*/
 #define TIME_UP                                         0x01
 
+#ifdef USE_P2P_BULK
+#define BULK_CMD_DATA                                   0x33
+#define BULK_CMD_ACK                                    0x34
+#define BULK_FLAG_ACK_REQ                               0x01
+#define BULK_HEADER_LEN                                 5     /* cmd, session, seq, flags, len */
+#define BULK_ACK_LEN                                    7     /* cmd, session, next expected seq, 32 bits of selective ACKs */
+#if (BULK_WINDOW & (BULK_WINDOW - 1)) || (BULK_WINDOW > 32)
+#error BULK_WINDOW must be a power of two, at most 32
+#endif
+#if BULK_DATA_LEN + BULK_HEADER_LEN > S2LP_TX_FIFO_SIZE
+#error BULK_DATA_LEN does not fit the FIFO
+#endif
+#ifdef USE_STack_LLP
+#error The bulk transfer acknowledges the frames itself, USE_STack_LLP must be disabled
+#endif
+#endif
+
+#ifdef USE_P2P_LINKTEST
+#define LT_CMD_CONFIG                                   0x40  /* run, datarate, modulation, fdev, bandwidth, FEC and whitening */
+#define LT_CMD_CONFIG_ACK                               0x41  /* run */
+#define LT_CMD_DATA                                     0x42  /* run, 16 bit sequence number, padding */
+#define LT_CMD_PING                                     0x43  /* run, sequence number, padding */
+#define LT_CMD_ECHO                                     0x44  /* run, sequence number, RSSI and LQI of the ping, padding */
+#define LT_CMD_REPORT_REQ                               0x45  /* run */
+#define LT_CMD_REPORT                                   0x46  /* run, frames, RSSI and LQI distribution, pings */
+#define LT_CMD_DONE                                     0x47  /* run */
+#define LT_CONFIG_LEN                                   16
+#define LT_REPORT_LEN                                   14
+#define LT_MIN_LEN                                      5
+#define LT_MAX_LEN                                      S2LP_TX_FIFO_SIZE
+#define LT_FRAME_OVERHEAD                               16    /* preamble, sync, length, address, CRC: bytes on air besides the payload */
+#define LT_TURNAROUND_MS                                20    /* answer of the other node, frame read and written */
+#define LT_SWITCH_MS                                    10    /* PHY change of the responder */
+#define LT_RSSI_MIN                                     (-140)
+#define LT_RSSI_BINS                                    130   /* 1 dB each, from LT_RSSI_MIN */
+#define LT_LINE_LEN                                     64
+#if defined(USE_P2P_BULK) || defined(USE_WMBUS_GATEWAY)
+#error USE_P2P_LINKTEST runs alone
+#endif
+#endif
+
 /* Private variables ---------------------------------------------------------*/
 RadioDriver_t *pRadioDriver;
 MCULowPowerMode_t *pMCU_LPM_Comm;
@@ -382,6 +518,110 @@ uint16_t dataSendCounter = 0x00;
 
 SM_State_t SM_State = SM_STATE_START_RX;/* The actual state running */
 
+#ifdef USE_WMBUS_GATEWAY
+WMBusMeter_t aWMBusMeters[WMBUS_GATEWAY_METERS];
+uint8_t cWMBusMeters = 0;
+uint16_t nWMBusTelegramsPerMinute = 0;  /* telegrams of the last full minute */
+static uint16_t s_nWMBusMinuteCount = 0;
+static uint32_t s_lWMBusMinuteTick = 0;
+#endif
+
+#ifdef USE_P2P_BULK
+P2PBulkReport_t xBulkReport;
+static BulkState_t s_xBulkState = BULK_STATE_LISTEN;
+static volatile FlagStatus s_xBulkKeyPressed = RESET;
+static uint8_t aBulkTxFrame[S2LP_TX_FIFO_SIZE];
+static uint8_t aBulkRxFrame[S2LP_RX_FIFO_SIZE];
+/* Sender: frames numbered from 0, their sequence number is the low byte */
+static uint8_t s_cBulkSession = 0;
+static uint32_t s_lBulkFrames = 0;
+static uint32_t s_lBulkBase = 0;      /* first frame not acknowledged */
+static uint32_t s_lBulkNext = 0;      /* next frame of the burst */
+static uint32_t s_lBulkHighest = 0;   /* frames sent at least once */
+static uint32_t s_lBulkAcked = 0;     /* bit i: frame s_lBulkBase + i acknowledged */
+static uint32_t s_lBulkBurstEnd = 0;  /* after an ACK timeout, only one frame asks for the ACK again */
+static uint32_t s_lBulkAckTick = 0;
+/* Receiver: frames after a missing one wait in the window */
+static uint8_t s_cBulkRxSession = 0;
+static uint8_t s_cBulkExpected = 0;
+static uint32_t s_lBulkRxMap = 0;     /* bit i: frame s_cBulkExpected + i held */
+static uint8_t aBulkRxData[BULK_WINDOW][BULK_DATA_LEN];
+static uint8_t aBulkRxLen[BULK_WINDOW];
+/* Report */
+static uint32_t s_lBulkStartTick = 0;
+static uint32_t s_lBulkReportTick = 0;
+static uint32_t s_lBulkPeriodBytes = 0;
+static uint32_t s_lBulkPeriodSent = 0;
+static uint32_t s_lBulkPeriodRetx = 0;
+#endif
+
+#ifdef USE_P2P_LINKTEST
+UART_HandleTypeDef hLinkTestUart;
+static const LinkTestPhy_t xLtBasePhy = {
+  DATARATE,
+  MODULATION_SELECT,
+  FREQ_DEVIATION,
+  BANDWIDTH,
+  EN_FEC,
+  EN_WHITENING
+};
+static const struct
+{
+  const char *pcName;
+  ModulationSelect xModulation;
+} aLtModulations[] = {
+  {"2FSK", MOD_2FSK},
+  {"4FSK", MOD_4FSK},
+  {"2GFSK05", MOD_2GFSK_BT05},
+  {"2GFSK1", MOD_2GFSK_BT1},
+  {"4GFSK05", MOD_4GFSK_BT05},
+  {"4GFSK1", MOD_4GFSK_BT1},
+  {"OOK", MOD_ASK_OOK}
+};
+static uint8_t aLtTxFrame[S2LP_TX_FIFO_SIZE];
+static uint8_t aLtRxFrame[S2LP_RX_FIFO_SIZE];
+static SRxPacketInfo xLtRxInfo;
+static uint8_t s_cLtTxBusy = 0;
+static char aLtLine[LT_LINE_LEN];
+static uint8_t s_cLtLineLen = 0;
+/* Controller */
+static LinkTestState_t s_xLtState = LT_STATE_IDLE;
+static LinkTestPhy_t xLtPhy;          /* set by the "phy" command */
+static uint8_t s_cLtRun = 0;
+static uint8_t s_cLtLen = 0;
+static uint16_t s_nLtCount = 0;
+static uint16_t s_nLtPings = 0;
+static uint16_t s_nLtSent = 0;
+static uint16_t s_nLtPingsSent = 0;
+static uint8_t s_cLtTries = 0;
+static LinkTestPhy_t xLtLastPhy;
+static uint32_t s_lLtConfigStart = 0;
+static uint32_t s_lLtConfigMs = 0;
+static uint32_t s_lLtDeadline = 0;
+static uint32_t s_lLtStartUs = 0;
+static uint32_t s_lLtStreamUs = 0;
+static uint32_t s_lLtPingUs = 0;
+static uint16_t s_nLtEchoes = 0;
+static uint32_t s_lLtRttMin = 0;
+static uint32_t s_lLtRttMax = 0;
+static uint32_t s_lLtRttSum = 0;
+static int32_t s_lLtEchoRssiSum = 0;
+static uint8_t aLtReport[LT_REPORT_LEN];
+/* Responder */
+static uint8_t s_cLtRxRun = 0;
+static uint8_t s_cLtRxOnTest = 0;
+static uint8_t s_cLtRxSwitch = 0;
+static LinkTestPhy_t xLtRxPhy;
+static uint32_t s_lLtRxActivity = 0;
+static uint32_t s_lLtRxIdleMs = 0;
+static uint16_t s_nLtRxData = 0;
+static uint16_t s_nLtRxPings = 0;
+static uint16_t aLtRssiHist[LT_RSSI_BINS];
+static uint8_t s_cLtLqiMin = 0;
+static uint8_t s_cLtLqiMax = 0;
+static uint32_t s_lLtLqiSum = 0;
+#endif
+
 void MX_X_CUBE_SUBG2_Init(void)
 {
   /* USER CODE BEGIN SV */
@@ -462,6 +702,15 @@ void MX_SUBG2_P2P_Init(void)
 
   S2LP_RADIO_QI_SetRssiThreshdBm(RSSI_THRESHOLD);
 
+#ifdef USE_WMBUS_GATEWAY
+  WMBusGatewayInit();
+#endif
+#ifdef USE_P2P_BULK
+  P2PBulkInit();
+#endif
+#ifdef USE_P2P_LINKTEST
+  LinkTestInit();
+#endif
 }
 
 /**
@@ -476,6 +725,19 @@ void MX_SUBG2_P2P_Process(uint8_t *pTxBuff, uint8_t cTxlen, uint8_t* pRxBuff, ui
   uint8_t  dest_addr;
   /*float rRSSIValue = 0;*/
 
+#ifdef USE_WMBUS_GATEWAY
+  WMBusGatewayProcess();
+  return;
+#endif
+#ifdef USE_P2P_BULK
+  P2PBulkProcess();
+  return;
+#endif
+#ifdef USE_P2P_LINKTEST
+  LinkTestProcess();
+  return;
+#endif
+
   switch(SM_State)
   {
   case SM_STATE_START_RX:
@@ -619,207 +881,1531 @@ void MX_SUBG2_P2P_Process(uint8_t *pTxBuff, uint8_t cTxlen, uint8_t* pRxBuff, ui
 }
 }
 
+#ifdef USE_WMBUS_GATEWAY
 /**
-* @brief  This function handles the point-to-point packet transmission
-* @param  AppliFrame_t *xTxFrame = Pointer to AppliFrame_t structure
-*         uint8_t cTxlen = Length of aTransmitBuffer
+* @brief  Configure the S2-LP for the Wireless M-Bus mode of the gateway and listen
+* @param  None
 * @retval None
 */
-void AppliSendBuff(AppliFrame_t *xTxFrame, uint8_t cTxlen)
+static void WMBusGatewayInit(void)
 {
-  uint8_t xIndex = 0;
-  uint8_t trxLength = 0;
-  pRadioDriver = &radio_cb;
+  /* The mode has its own frequency and data rate: only the offset of the board is kept */
+  S2LP_WMBUS_LL_Init(WMBUS_GATEWAY_MODE, S2LP_ManagementGetOffset());
+  S2LP_WMBUS_LL_StartRx();
+  s_lWMBusMinuteTick = HAL_GetTick();
+}
 
-#ifdef USE_STack_PROTOCOL
+/**
+* @brief  Record a telegram in the meter table
+* @param  pxFrame = telegram checked by the link layer
+* @param  lTick = HAL tick of its reception
+* @retval None
+*/
+static void WMBusGatewayUpdateMeter(const WMbusFrame* pxFrame, uint32_t lTick)
+{
+  WMBusMeter_t* pxMeter = NULL;
+  const uint8_t* pcData;
+  uint8_t cDataLen, i;
 
-  PktStackAddressesInit xAddressInit=
+  for(i = 0; i < cWMBusMeters; i++)
   {
-    .xFilterOnMyAddress = S_ENABLE,
-    .cMyAddress = MY_ADDRESS,
-    .xFilterOnMulticastAddress = S_DISABLE,
-    .cMulticastAddress = MULTICAST_ADDRESS,
-    .xFilterOnBroadcastAddress = S_ENABLE,
-    .cBroadcastAddress = BROADCAST_ADDRESS
-  };
-  S2LP_PCKT_STACK_AddressesInit(&xAddressInit);
-
-#ifdef USE_STack_LLP
+    if(aWMBusMeters[i].Id == pxFrame->lId && aWMBusMeters[i].Manufacturer == pxFrame->nManufacturer)
+    {
+      pxMeter = &aWMBusMeters[i];
+      break;
+    }
+  }
 
-  /* LLP structure fitting */
-  PktStackLlpInit xStackLLPInit=
+  if(pxMeter == NULL)
   {
-    .xAutoAck = S_DISABLE,
-    .xPiggybacking = S_DISABLE,
-    .xNMaxRetx = PKT_N_RETX_2
-  };
-
-#else
+    if(cWMBusMeters < WMBUS_GATEWAY_METERS)
+    {
+      pxMeter = &aWMBusMeters[cWMBusMeters++];
+    }
+    else
+    {
+      /* Table full: forget the meter heard the longest time ago */
+      pxMeter = &aWMBusMeters[0];
+      for(i = 1; i < WMBUS_GATEWAY_METERS; i++)
+      {
+        if(lTick - aWMBusMeters[i].LastTick > lTick - pxMeter->LastTick)
+        {
+          pxMeter = &aWMBusMeters[i];
+        }
+      }
+    }
+    pxMeter->Manufacturer = pxFrame->nManufacturer;
+    pxMeter->Id = pxFrame->lId;
+    pxMeter->Telegrams = 0;
+  }
 
-  /* LLP structure fitting */
-  PktStackLlpInit xStackLLPInit=
+  /* The access number opens the short (0x7A) and ends the long (0x72) transport header */
+  cDataLen = S2LP_WMBUS_GetDataBlock(pxFrame, 0, &pcData);
+  if(pxFrame->cCI == 0x7A && cDataLen >= 1)
   {
-    .xAutoAck = S_DISABLE,
-    .xPiggybacking = S_DISABLE,
-    .xNMaxRetx = PKT_DISABLE_RETX
-  };
-#endif
-
-  Radio_PktStackLlpInit(&xStackLLPInit);
-
-#endif
-
-#ifdef USE_BASIC_PROTOCOL
-  S2LP_PCKT_BASIC_AddressesInit(&xAddressInit);
-#endif
-
-  TxFrameBuff[0] = xTxFrame->Cmd;
-  TxFrameBuff[1] = xTxFrame->CmdLen;
-  TxFrameBuff[2] = xTxFrame->Cmdtag;
-  TxFrameBuff[3] = xTxFrame->CmdType;
-  TxFrameBuff[4] = xTxFrame->DataLen;
-
-  for(; xIndex < xTxFrame->DataLen; xIndex++)
+    pxMeter->AccessNumber = pcData[0];
+  }
+  else if(pxFrame->cCI == 0x72 && cDataLen >= 9)
   {
-    TxFrameBuff[xIndex+5] =  xTxFrame->DataBuff[xIndex];
+    pxMeter->AccessNumber = pcData[8];
   }
-
-  trxLength = (xIndex+5);
-
-  S2LP_GPIO_IrqDeInit(NULL);
-
-  pRadioDriver->EnableTxIrq();
-  /* payload length config */
-  pRadioDriver->SetPayloadLen(trxLength);
-  /* rx timeout config */
-  pRadioDriver->SetRxTimeout(RECEIVE_TIMEOUT);
-  /* IRQ registers blanking */
-
-  S2LP_GPIO_IrqClearStatus();
-  /* destination address */
-  pRadioDriver->SetDestinationAddress(DESTINATION_ADDRESS);
-
-  /* send the TX command */
-  pRadioDriver->StartTx(TxFrameBuff, trxLength);
+  pxMeter->Rssi = pxFrame->cRssidBm;
+  pxMeter->Telegrams++;
+  pxMeter->LastTick = lTick;
 }
 
 /**
-* @brief  This function handles the point-to-point packet reception
-* @param  uint8_t *RxFrameBuff = Pointer to ReceiveBuffer
-*         uint8_t cRxlen = length of ReceiveBuffer
+* @brief  Empty the receive ring of the link layer and count the telegrams per minute
+* @param  None
 * @retval None
 */
-void AppliReceiveBuff(uint8_t *RxFrameBuff, uint8_t cRxlen)
+static void WMBusGatewayProcess(void)
 {
-  /*float rRSSIValue = 0;*/
-  exitTime = SET;
-  exitCounter = TIME_TO_EXIT_RX;
-
-#ifdef USE_STack_PROTOCOL
-
-#ifdef USE_STack_LLP
-  /* LLP structure fitting */
-  PktStackLlpInit xStackLLPInit=
-  {
-    .xAutoAck = S_ENABLE,
-    .xPiggybacking = S_ENABLE,
-    .xNMaxRetx = PKT_DISABLE_RETX
-  };
-#else
-  /* LLP structure fitting */
-  PktStackLlpInit xStackLLPInit=
-  {
-    .xAutoAck = S_DISABLE,
-    .xPiggybacking = S_DISABLE,
-    .xNMaxRetx = PKT_DISABLE_RETX
-  };
-#endif
+  WMbusFrame xFrame;
+  uint32_t lTick = HAL_GetTick();
 
-  Radio_PktStackLlpInit(&xStackLLPInit);
-
-  PktStackAddressesInit xAddressInit=
-  {
-    .xFilterOnMyAddress = S_ENABLE,
-    .cMyAddress = MY_ADDRESS,
-    .xFilterOnMulticastAddress = S_DISABLE,
-    .cMulticastAddress = MULTICAST_ADDRESS,
-    .xFilterOnBroadcastAddress = S_ENABLE,
-    .cBroadcastAddress = BROADCAST_ADDRESS
-  };
-
-  S2LP_PCKT_STACK_AddressesInit(&xAddressInit);
-
-  if(EN_FILT_SOURCE_ADDRESS)
+  /* The frames stay in the ring, parsed in place, until released */
+  while(S2LP_WMBUS_LL_Receive(&xFrame))
   {
-    Radio_PktStackFilterOnSourceAddress(S_ENABLE);
-    Radio_PktStackSetRxSourceMask(SOURCE_ADDR_MASK);
-    Radio_PktStackSetSourceReferenceAddress (SOURCE_ADDR_REF);
-
+    WMBusGatewayUpdateMeter(&xFrame, lTick);
+    S2LP_WMBUS_LL_Release();
+    s_nWMBusMinuteCount++;
+    BSP_LED_Toggle(LED2);
   }
-  else
+
+  if(lTick - s_lWMBusMinuteTick >= 60000)
   {
-    RadioPktStackFilterOnSourceAddress(S_DISABLE);
+    nWMBusTelegramsPerMinute = s_nWMBusMinuteCount;
+    s_nWMBusMinuteCount = 0;
+    s_lWMBusMinuteTick += 60000;
   }
+}
 #endif
 
-  //RadioPktBasicAddressesInit(&xAddressInit);
-  S2LP_PCKT_BASIC_AddressesInit(&xAddressInit);
-
+#ifdef USE_P2P_BULK
+/**
+* @brief  Bulk transfer: configure the radio once for both directions and listen
+* @param  None
+* @retval None
+*/
+static void P2PBulkInit(void)
+{
   pRadioDriver = &radio_cb;
-  /* S2LP IRQs disable */
-  S2LP_GPIO_IrqDeInit(NULL);
-  /* S2LP IRQs enable */
-
-  pRadioDriver->EnableRxIrq();
-  /* payload length config */
-  pRadioDriver->SetPayloadLen(PAYLOAD_LEN);
-  /* rx timeout config */
 
-  S2LP_TIM_SetRxTimerMs(700.0);
+#ifdef USE_STack_PROTOCOL
+  S2LP_PCKT_STACK_AddressesInit(&xAddressInit);
+#else
+  S2LP_PCKT_BASIC_AddressesInit(&xAddressInit);
+#endif
+  pRadioDriver->SetDestinationAddress(DESTINATION_ADDRESS);
   SET_INFINITE_RX_TIMEOUT();
 
-  pRadioDriver->SetDestinationAddress(DESTINATION_ADDRESS);
-  /* IRQ registers blanking */
+  /* The direction changes at every burst: all the IRQs stay enabled */
+  S2LP_GPIO_IrqDeInit(NULL);
+  pRadioDriver->EnableTxIrq();
+  pRadioDriver->EnableRxIrq();
+#ifdef CSMA_ENABLE
+  S2LP_GPIO_IrqConfig(MAX_BO_CCA_REACH, S_ENABLE);
+#endif
   S2LP_GPIO_IrqClearStatus();
 
-  /* RX command */
+  s_lBulkReportTick = HAL_GetTick();
   pRadioDriver->StartRx();
-  /* destination address */
 }
 
 /**
-* @brief  This function initializes the STack Packet handler of S2LP
-* @param  None
+* @brief  Source of the bytes sent by the bulk transfer, a counting pattern by default
+* @param  lOffset = position of the first byte in the transfer
+* @param  pData = filled with the bytes
+* @param  cLen = number of bytes
 * @retval None
 */
-void STackProtocolInit(void)
+__weak void P2PBulk_DataToSend(uint32_t lOffset, uint8_t *pData, uint8_t cLen)
 {
-
-  PktStackInit xStackInit=
+  for(uint8_t i = 0; i < cLen; i++)
   {
-    .xPreambleLength = PREAMBLE_LENGTH,
-    .xSyncLength = SYNC_LENGTH,
-    .lSyncWords = SYNC_WORD,
-
-    .xFixVarLength = S_ENABLE,
-    .cExtendedPktLenField = S_DISABLE,
-
-    .xCrcMode = CRC_MODE,
-    .xFec = EN_FEC,
-    .xDataWhitening = EN_WHITENING
-  };
-  /* Radio Packet config */
-  S2LP_PCKT_STACK_Init(&xStackInit);
+    pData[i] = (uint8_t)(lOffset + i);
+  }
 }
 
-/*xDataWhitening;  *
-* @brief  This function initializes the BASIC Packet handler of S2LP
-* @param  None
+/**
+* @brief  Sink of the bytes received by the bulk transfer, in order and once each
+* @param  pData = received bytes
+* @param  cLen = number of bytes
 * @retval None
 */
-void BasicProtocolInit(void)
+__weak void P2PBulk_DataReceived(uint8_t *pData, uint8_t cLen)
 {
-  /* RAdio Packet config */
+  (void)pData;
+  (void)cLen;
+}
+
+/**
+* @brief  Start sending BULK_TRANSFER_BYTES to the other node
+* @param  None
+* @retval None
+*/
+static void P2PBulkStart(void)
+{
+  s_cBulkSession++;
+  s_lBulkFrames = (BULK_TRANSFER_BYTES + BULK_DATA_LEN - 1) / BULK_DATA_LEN;
+  s_lBulkBase = 0;
+  s_lBulkNext = 0;
+  s_lBulkHighest = 0;
+  s_lBulkAcked = 0;
+  s_lBulkBurstEnd = s_lBulkFrames;
+  s_lBulkStartTick = HAL_GetTick();
+  memset(&xBulkReport, 0, sizeof(xBulkReport));
+  s_lBulkPeriodBytes = 0;
+  s_lBulkPeriodSent = 0;
+  s_lBulkPeriodRetx = 0;
+  s_lBulkReportTick = s_lBulkStartTick;
+  s_xBulkState = BULK_STATE_SEND_DATA;
+}
+
+/**
+* @brief  Next frame of the burst: the first one of the window not acknowledged yet
+* @param  lFrom = first frame to look at
+* @retval Frame number, s_lBulkFrames if the burst is over
+*/
+static uint32_t P2PBulkNextUnacked(uint32_t lFrom)
+{
+  uint32_t lEnd = s_lBulkBase + BULK_WINDOW;
+
+  if(lEnd > s_lBulkBurstEnd)
+  {
+    lEnd = s_lBulkBurstEnd;
+  }
+  for(; lFrom < lEnd; lFrom++)
+  {
+    if(!(s_lBulkAcked & (1UL << (lFrom - s_lBulkBase))))
+    {
+      return lFrom;
+    }
+  }
+  return s_lBulkFrames;
+}
+
+/**
+* @brief  Send a data frame of the window; the last one of the burst asks for the ACK
+* @param  lFrame = frame number in the transfer
+* @retval None
+*/
+static void P2PBulkSendData(uint32_t lFrame)
+{
+  uint32_t lOffset = lFrame * BULK_DATA_LEN;
+  uint8_t cLen = BULK_DATA_LEN;
+  uint8_t cFlags = 0;
+
+  if(lOffset + cLen > BULK_TRANSFER_BYTES)
+  {
+    cLen = (uint8_t)(BULK_TRANSFER_BYTES - lOffset);
+  }
+  if(P2PBulkNextUnacked(lFrame + 1) == s_lBulkFrames)
+  {
+    cFlags |= BULK_FLAG_ACK_REQ;
+  }
+  aBulkTxFrame[0] = BULK_CMD_DATA;
+  aBulkTxFrame[1] = s_cBulkSession;
+  aBulkTxFrame[2] = (uint8_t)lFrame;
+  aBulkTxFrame[3] = cFlags;
+  aBulkTxFrame[4] = cLen;
+  P2PBulk_DataToSend(lOffset, &aBulkTxFrame[BULK_HEADER_LEN], cLen);
+
+  if(lFrame < s_lBulkHighest)
+  {
+    xBulkReport.FramesRetransmitted++;
+    s_lBulkPeriodRetx++;
+  }
+  else
+  {
+    s_lBulkHighest = lFrame + 1;
+  }
+  xBulkReport.FramesSent++;
+  s_lBulkPeriodSent++;
+
+  pRadioDriver->SetPayloadLen(BULK_HEADER_LEN + cLen);
+  pRadioDriver->StartTx(aBulkTxFrame, BULK_HEADER_LEN + cLen);
+}
+
+/**
+* @brief  Sender: slide the window on an ACK
+* @param  pcAck = ACK frame
+* @param  cLen = its length
+* @retval None
+*/
+static void P2PBulkAckReceived(uint8_t *pcAck, uint8_t cLen)
+{
+  uint8_t cAdvance;
+  uint32_t lSelective;
+
+  if(cLen < BULK_ACK_LEN || pcAck[0] != BULK_CMD_ACK || pcAck[1] != s_cBulkSession)
+  {
+    return;
+  }
+  /* Cumulative part: every frame before pcAck[2] has been received */
+  cAdvance = (uint8_t)(pcAck[2] - (uint8_t)s_lBulkBase);
+  if(cAdvance > BULK_WINDOW || s_lBulkBase + cAdvance > s_lBulkFrames)
+  {
+    /* Stale ACK */
+    return;
+  }
+  if(cAdvance != 0)
+  {
+    uint32_t lBytes = cAdvance * BULK_DATA_LEN;
+
+    if((s_lBulkBase + cAdvance) * BULK_DATA_LEN > BULK_TRANSFER_BYTES)
+    {
+      lBytes -= (s_lBulkBase + cAdvance) * BULK_DATA_LEN - BULK_TRANSFER_BYTES;
+    }
+    xBulkReport.Bytes += lBytes;
+    s_lBulkPeriodBytes += lBytes;
+    s_lBulkBase += cAdvance;
+    s_lBulkAcked = (cAdvance < 32) ? (s_lBulkAcked >> cAdvance) : 0;
+  }
+  /* Selective part: bit i is the frame pcAck[2] + 1 + i */
+  lSelective = pcAck[3] | ((uint32_t)pcAck[4] << 8) | ((uint32_t)pcAck[5] << 16) | ((uint32_t)pcAck[6] << 24);
+  s_lBulkAcked |= lSelective << 1;
+  if(BULK_WINDOW < 32)
+  {
+    s_lBulkAcked &= (1UL << BULK_WINDOW) - 1;
+  }
+}
+
+/**
+* @brief  Receiver: take a data frame into the window, deliver what is in order
+* @param  pcFrame = data frame
+* @param  cLen = its length
+* @retval 1 if the sender asks for an ACK
+*/
+static uint8_t P2PBulkDataReceived(uint8_t *pcFrame, uint8_t cLen)
+{
+  uint8_t cOffset, cSlot;
+
+  if(cLen < BULK_HEADER_LEN || pcFrame[4] > cLen - BULK_HEADER_LEN || pcFrame[4] > BULK_DATA_LEN)
+  {
+    return 0;
+  }
+  if(pcFrame[1] != s_cBulkRxSession)
+  {
+    /* A new transfer */
+    s_cBulkRxSession = pcFrame[1];
+    s_cBulkExpected = 0;
+    s_lBulkRxMap = 0;
+    s_lBulkStartTick = HAL_GetTick();
+    memset(&xBulkReport, 0, sizeof(xBulkReport));
+    s_lBulkPeriodBytes = 0;
+    s_lBulkReportTick = s_lBulkStartTick;
+  }
+  xBulkReport.FramesReceived++;
+
+  cOffset = (uint8_t)(pcFrame[2] - s_cBulkExpected);
+  if(cOffset >= BULK_WINDOW || (s_lBulkRxMap & (1UL << cOffset)))
+  {
+    /* Already delivered (its ACK was lost) or already waiting in the window */
+    xBulkReport.FramesDuplicate++;
+  }
+  else
+  {
+    cSlot = pcFrame[2] & (BULK_WINDOW - 1);
+    memcpy(aBulkRxData[cSlot], &pcFrame[BULK_HEADER_LEN], pcFrame[4]);
+    aBulkRxLen[cSlot] = pcFrame[4];
+    s_lBulkRxMap |= 1UL << cOffset;
+    while(s_lBulkRxMap & 1)
+    {
+      cSlot = s_cBulkExpected & (BULK_WINDOW - 1);
+      P2PBulk_DataReceived(aBulkRxData[cSlot], aBulkRxLen[cSlot]);
+      xBulkReport.Bytes += aBulkRxLen[cSlot];
+      s_lBulkPeriodBytes += aBulkRxLen[cSlot];
+      s_cBulkExpected++;
+      s_lBulkRxMap >>= 1;
+    }
+  }
+  return (pcFrame[3] & BULK_FLAG_ACK_REQ) != 0;
+}
+
+/**
+* @brief  Receiver: acknowledge what the window holds
+* @param  None
+* @retval None
+*/
+static void P2PBulkSendAck(void)
+{
+  uint32_t lSelective = s_lBulkRxMap >> 1;
+
+  aBulkTxFrame[0] = BULK_CMD_ACK;
+  aBulkTxFrame[1] = s_cBulkRxSession;
+  aBulkTxFrame[2] = s_cBulkExpected;
+  aBulkTxFrame[3] = (uint8_t)lSelective;
+  aBulkTxFrame[4] = (uint8_t)(lSelective >> 8);
+  aBulkTxFrame[5] = (uint8_t)(lSelective >> 16);
+  aBulkTxFrame[6] = (uint8_t)(lSelective >> 24);
+
+  pRadioDriver->SetPayloadLen(BULK_ACK_LEN);
+  pRadioDriver->StartTx(aBulkTxFrame, BULK_ACK_LEN);
+}
+
+/**
+* @brief  Update the throughput and PER of the period
+* @param  lTick = HAL tick
+* @retval None
+*/
+static void P2PBulkReport(uint32_t lTick)
+{
+  uint32_t lElapsed = lTick - s_lBulkReportTick;
+
+  if(lElapsed < BULK_REPORT_MS)
+  {
+    return;
+  }
+  xBulkReport.BytesPerSecond = (uint32_t)(((uint64_t)s_lBulkPeriodBytes * 1000) / lElapsed);
+  xBulkReport.PerPermille = s_lBulkPeriodSent ? (uint16_t)((s_lBulkPeriodRetx * 1000) / s_lBulkPeriodSent) : 0;
+  s_lBulkPeriodBytes = 0;
+  s_lBulkPeriodSent = 0;
+  s_lBulkPeriodRetx = 0;
+  s_lBulkReportTick = lTick;
+  if(xBulkReport.BytesPerSecond != 0)
+  {
+    BSP_LED_Toggle(LED2);
+  }
+}
+
+/**
+* @brief  Bulk transfer state machine: bursts of up to BULK_WINDOW frames, each
+*         burst answered by a cumulative and selective ACK
+* @param  None
+* @retval None
+*/
+static void P2PBulkProcess(void)
+{
+  uint8_t cRxLen = 0;
+  uint32_t lTick = HAL_GetTick();
+
+  if(s_xBulkKeyPressed)
+  {
+    s_xBulkKeyPressed = RESET;
+    if(s_xBulkState == BULK_STATE_LISTEN)
+    {
+      P2PBulkStart();
+    }
+  }
+
+  switch(s_xBulkState)
+  {
+  case BULK_STATE_LISTEN:
+    if(xRxDoneFlag)
+    {
+      xRxDoneFlag = RESET;
+      pRadioDriver->GetRxPacket(aBulkRxFrame, &cRxLen);
+      if(cRxLen != 0 && aBulkRxFrame[0] == BULK_CMD_DATA && P2PBulkDataReceived(aBulkRxFrame, cRxLen))
+      {
+        P2PBulkSendAck();
+        s_xBulkState = BULK_STATE_WAIT_ACK_SENT;
+      }
+      else
+      {
+        pRadioDriver->StartRx();
+      }
+    }
+    break;
+
+  case BULK_STATE_WAIT_ACK_SENT:
+    if(xTxDoneFlag)
+    {
+      xTxDoneFlag = RESET;
+      pRadioDriver->StartRx();
+      s_xBulkState = BULK_STATE_LISTEN;
+    }
+    break;
+
+  case BULK_STATE_SEND_DATA:
+    s_lBulkNext = P2PBulkNextUnacked(s_lBulkNext);
+    if(s_lBulkNext == s_lBulkFrames)
+    {
+      /* Burst over: the ACK says what to send next */
+      xRxDoneFlag = RESET;
+      pRadioDriver->StartRx();
+      s_lBulkAckTick = lTick;
+      s_xBulkState = BULK_STATE_WAIT_ACK;
+    }
+    else
+    {
+      P2PBulkSendData(s_lBulkNext++);
+      s_xBulkState = BULK_STATE_WAIT_DATA_SENT;
+    }
+    break;
+
+  case BULK_STATE_WAIT_DATA_SENT:
+    if(xTxDoneFlag)
+    {
+      xTxDoneFlag = RESET;
+      s_xBulkState = BULK_STATE_SEND_DATA;
+    }
+    break;
+
+  case BULK_STATE_WAIT_ACK:
+    if(xRxDoneFlag)
+    {
+      xRxDoneFlag = RESET;
+      pRadioDriver->GetRxPacket(aBulkRxFrame, &cRxLen);
+      P2PBulkAckReceived(aBulkRxFrame, cRxLen);
+      s_lBulkBurstEnd = s_lBulkFrames;
+    }
+    else if(lTick - s_lBulkAckTick >= BULK_ACK_TIMEOUT_MS)
+    {
+      /* The ACK or the frame asking for it is lost: the rest of the burst
+         may have been received, ask again with the first missing frame only */
+      xBulkReport.AckTimeouts++;
+      s_lBulkBurstEnd = s_lBulkFrames;
+      s_lBulkBurstEnd = P2PBulkNextUnacked(s_lBulkBase) + 1;
+    }
+    else
+    {
+      break;
+    }
+    if(s_lBulkBase == s_lBulkFrames)
+    {
+      xBulkReport.TransferMs = lTick - s_lBulkStartTick;
+      pRadioDriver->StartRx();
+      s_xBulkState = BULK_STATE_LISTEN;
+    }
+    else
+    {
+      /* Next burst: what is still missing of the window, then the new frames */
+      s_lBulkNext = s_lBulkBase;
+      s_xBulkState = BULK_STATE_SEND_DATA;
+    }
+    break;
+  }
+
+  P2PBulkReport(lTick);
+}
+#endif
+
+#ifdef USE_P2P_LINKTEST
+/**
+* @brief  MSP of the link test UART: USART2, on the ST-LINK virtual COM port
+* @param  huart = UART handle
+* @retval None
+*/
+void HAL_UART_MspInit(UART_HandleTypeDef *huart)
+{
+  GPIO_InitTypeDef GPIO_InitStruct = {0};
+
+  if(huart->Instance == USART2)
+  {
+    __HAL_RCC_USART2_CLK_ENABLE();
+    __HAL_RCC_GPIOA_CLK_ENABLE();
+
+    /* PA2 USART2_TX, PA3 USART2_RX */
+    GPIO_InitStruct.Pin = GPIO_PIN_2 | GPIO_PIN_3;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_NOPULL;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_VERY_HIGH;
+    GPIO_InitStruct.Alternate = GPIO_AF7_USART2;
+    HAL_GPIO_Init(GPIOA, &GPIO_InitStruct);
+  }
+}
+
+/**
+* @brief  Print a line on the link test UART
+* @param  pcFormat = printf format
+* @retval None
+*/
+static void LinkTestPrint(const char *pcFormat, ...)
+{
+  char aBuffer[200];
+  va_list xArgs;
+  int nLen;
+
+  va_start(xArgs, pcFormat);
+  nLen = vsnprintf(aBuffer, sizeof(aBuffer) - 2, pcFormat, xArgs);
+  va_end(xArgs);
+  if(nLen < 0)
+  {
+    return;
+  }
+  if(nLen > (int)sizeof(aBuffer) - 3)
+  {
+    nLen = sizeof(aBuffer) - 3;
+  }
+  aBuffer[nLen++] = '\r';
+  aBuffer[nLen++] = '\n';
+  HAL_UART_Transmit(&hLinkTestUart, (uint8_t *)aBuffer, nLen, 100);
+}
+
+/**
+* @brief  Microseconds from SysTick, to time the frames on every core
+* @param  None
+* @retval Free running microseconds
+*/
+static uint32_t LinkTestMicros(void)
+{
+  uint32_t lTick, lVal;
+
+  do
+  {
+    lTick = HAL_GetTick();
+    lVal = SysTick->VAL;
+  } while(lTick != HAL_GetTick());
+
+  return lTick * 1000 + ((SysTick->LOAD - lVal) * 1000) / (SysTick->LOAD + 1);
+}
+
+/**
+* @brief  Time on air of a frame, rounded up
+* @param  pxPhy = PHY of the frame
+* @param  cLen = payload length
+* @retval Milliseconds
+*/
+static uint32_t LinkTestAirMs(const LinkTestPhy_t *pxPhy, uint8_t cLen)
+{
+  uint32_t lBits = ((uint32_t)cLen + LT_FRAME_OVERHEAD) * 8;
+
+  if(pxPhy->xFec == S_ENABLE)
+  {
+    lBits *= 2;
+  }
+  return (lBits * 1000 + pxPhy->lDatarate - 1) / pxPhy->lDatarate;
+}
+
+/**
+* @brief  Program a PHY: modulation, datarate, deviation, filter, FEC and whitening
+* @param  pxPhy = PHY
+* @retval None
+*/
+static void LinkTestSetPhy(const LinkTestPhy_t *pxPhy)
+{
+  SRadioInit xPhyInit = xRadioInit;
+
+  /* The status of the last transaction may predate the last RX command */
+  S2LP_RefreshStatus();
+  if(g_xStatus.MC_STATE == MC_STATE_RX)
+  {
+    S2LP_CMD_StrobeSabort();
+  }
+  xPhyInit.xModulationSelect = pxPhy->xModulation;
+  xPhyInit.lDatarate = pxPhy->lDatarate;
+  xPhyInit.lFreqDev = pxPhy->lFreqDev;
+  xPhyInit.lBandwidth = pxPhy->lBandwidth;
+  S2LP_RADIO_Init(&xPhyInit);
+  S2LP_PCKT_HNDL_Fec(pxPhy->xFec);
+  S2LP_PCKT_HNDL_Whitening(pxPhy->xWhitening);
+}
+
+/**
+* @brief  Back to RX, unless the radio is still in it (persistent RX). Called
+*         once per event: the status returned by the RX command is the one
+*         before it.
+* @param  None
+* @retval None
+*/
+static void LinkTestListen(void)
+{
+  if(!s_cLtTxBusy && g_xStatus.MC_STATE != MC_STATE_RX)
+  {
+    S2LP_CMD_StrobeRx();
+  }
+}
+
+/**
+* @brief  Send the first cLen bytes of aLtTxFrame
+* @param  cLen = frame length
+* @retval None
+*/
+static void LinkTestSend(uint8_t cLen)
+{
+  s_cLtTxBusy = 1;
+  pRadioDriver->SetPayloadLen(cLen);
+  pRadioDriver->StartTx(aLtTxFrame, cLen);
+}
+
+/**
+* @brief  Write a 32 bit field, little endian
+* @param  pcDest = first byte
+* @param  lValue = value
+* @retval None
+*/
+static void LinkTestPut32(uint8_t *pcDest, uint32_t lValue)
+{
+  pcDest[0] = (uint8_t)lValue;
+  pcDest[1] = (uint8_t)(lValue >> 8);
+  pcDest[2] = (uint8_t)(lValue >> 16);
+  pcDest[3] = (uint8_t)(lValue >> 24);
+}
+
+/**
+* @brief  Read a 32 bit field, little endian
+* @param  pcSrc = first byte
+* @retval Value
+*/
+static uint32_t LinkTestGet32(const uint8_t *pcSrc)
+{
+  return pcSrc[0] | ((uint32_t)pcSrc[1] << 8) | ((uint32_t)pcSrc[2] << 16) | ((uint32_t)pcSrc[3] << 24);
+}
+
+/**
+* @brief  Name of a modulation in the commands and results
+* @param  xModulation = modulation
+* @retval Name, "?" if not one of aLtModulations
+*/
+static const char *LinkTestModName(ModulationSelect xModulation)
+{
+  for(uint8_t i = 0; i < sizeof(aLtModulations) / sizeof(aLtModulations[0]); i++)
+  {
+    if(aLtModulations[i].xModulation == xModulation)
+    {
+      return aLtModulations[i].pcName;
+    }
+  }
+  return "?";
+}
+
+/**
+* @brief  Link tester: UART, base PHY and RX
+* @param  None
+* @retval None
+*/
+static void LinkTestInit(void)
+{
+  pRadioDriver = &radio_cb;
+  xLtPhy = xLtBasePhy;
+  xLtLastPhy = xLtBasePhy;
+
+  hLinkTestUart.Instance = USART2;
+  hLinkTestUart.Init.BaudRate = LINKTEST_UART_BAUDRATE;
+  hLinkTestUart.Init.WordLength = UART_WORDLENGTH_8B;
+  hLinkTestUart.Init.StopBits = UART_STOPBITS_1;
+  hLinkTestUart.Init.Parity = UART_PARITY_NONE;
+  hLinkTestUart.Init.Mode = UART_MODE_TX_RX;
+  hLinkTestUart.Init.HwFlowCtl = UART_HWCONTROL_NONE;
+  hLinkTestUart.Init.OverSampling = UART_OVERSAMPLING_16;
+  HAL_UART_Init(&hLinkTestUart);
+
+#ifdef USE_STack_PROTOCOL
+  S2LP_PCKT_STACK_AddressesInit(&xAddressInit);
+#else
+  S2LP_PCKT_BASIC_AddressesInit(&xAddressInit);
+#endif
+  pRadioDriver->SetDestinationAddress(DESTINATION_ADDRESS);
+  SET_INFINITE_RX_TIMEOUT();
+
+  S2LP_GPIO_IrqDeInit(NULL);
+  pRadioDriver->EnableTxIrq();
+  pRadioDriver->EnableRxIrq();
+#ifdef CSMA_ENABLE
+  S2LP_GPIO_IrqConfig(MAX_BO_CCA_REACH, S_ENABLE);
+#endif
+  S2LP_GPIO_IrqClearStatus();
+
+  pRadioDriver->StartRx();
+  LinkTestPrint("LINKTEST %s %lu", LinkTestModName(xLtBasePhy.xModulation), (unsigned long)xLtBasePhy.lDatarate);
+}
+
+/**
+* @brief  Responder: what was received, sent back to the controller
+* @param  None
+* @retval None
+*/
+static void LinkTestBuildReport(void)
+{
+  uint8_t cPercent[3] = {10, 50, 90};
+  uint8_t cNext = 0;
+  uint32_t lSeen = 0;
+  int8_t cMin = 0, cMax = 0;
+
+  memset(aLtTxFrame, 0, LT_REPORT_LEN);
+  aLtTxFrame[0] = LT_CMD_REPORT;
+  aLtTxFrame[1] = s_cLtRxRun;
+  aLtTxFrame[2] = (uint8_t)s_nLtRxData;
+  aLtTxFrame[3] = (uint8_t)(s_nLtRxData >> 8);
+  if(s_nLtRxData != 0)
+  {
+    /* Min, 10th, 50th, 90th percentile and max of the RSSI */
+    for(uint16_t i = 0; i < LT_RSSI_BINS; i++)
+    {
+      if(aLtRssiHist[i] == 0)
+      {
+        continue;
+      }
+      if(lSeen == 0)
+      {
+        cMin = (int8_t)(LT_RSSI_MIN + i);
+      }
+      lSeen += aLtRssiHist[i];
+      while(cNext < 3 && lSeen * 100 >= (uint32_t)s_nLtRxData * cPercent[cNext])
+      {
+        aLtTxFrame[5 + cNext] = (uint8_t)(int8_t)(LT_RSSI_MIN + i);
+        cNext++;
+      }
+      cMax = (int8_t)(LT_RSSI_MIN + i);
+    }
+    aLtTxFrame[4] = (uint8_t)cMin;
+    aLtTxFrame[8] = (uint8_t)cMax;
+    aLtTxFrame[9] = s_cLtLqiMin;
+    aLtTxFrame[10] = (uint8_t)((s_lLtLqiSum * 10 + s_nLtRxData / 2) / s_nLtRxData);
+    aLtTxFrame[11] = s_cLtLqiMax;
+  }
+  aLtTxFrame[12] = (uint8_t)s_nLtRxPings;
+  aLtTxFrame[13] = (uint8_t)(s_nLtRxPings >> 8);
+}
+
+/**
+* @brief  Responder: answer a frame of the controller
+* @param  pcFrame = received frame
+* @param  cLen = its length
+* @param  lTick = HAL tick
+* @retval None
+*/
+static void LinkTestRespond(uint8_t *pcFrame, uint8_t cLen, uint32_t lTick)
+{
+  int32_t lBin;
+
+  if(cLen < 2)
+  {
+    return;
+  }
+  if(pcFrame[0] == LT_CMD_CONFIG && cLen >= LT_CONFIG_LEN)
+  {
+    if(s_cLtRxOnTest && pcFrame[1] == s_cLtRxRun)
+    {
+      /* The CONFIG_ACK was lost, the controller looks for us on the test PHY */
+      s_lLtRxActivity = lTick;
+      aLtTxFrame[0] = LT_CMD_CONFIG_ACK;
+      aLtTxFrame[1] = s_cLtRxRun;
+      LinkTestSend(2);
+      return;
+    }
+    /* A new test, heard on the base PHY */
+    s_cLtRxRun = pcFrame[1];
+    xLtRxPhy.lDatarate = LinkTestGet32(&pcFrame[2]);
+    xLtRxPhy.xModulation = (ModulationSelect)pcFrame[6];
+    xLtRxPhy.lFreqDev = LinkTestGet32(&pcFrame[7]);
+    xLtRxPhy.lBandwidth = LinkTestGet32(&pcFrame[11]);
+    xLtRxPhy.xFec = (pcFrame[15] & 0x01) ? S_ENABLE : S_DISABLE;
+    xLtRxPhy.xWhitening = (pcFrame[15] & 0x02) ? S_ENABLE : S_DISABLE;
+    if(xLtRxPhy.lDatarate == 0)
+    {
+      return;
+    }
+    /* Longer than the controller waits for an answer */
+    s_lLtRxIdleMs = LINKTEST_IDLE_MS + 2 * LinkTestAirMs(&xLtRxPhy, LT_MAX_LEN);
+    s_nLtRxData = 0;
+    s_nLtRxPings = 0;
+    memset(aLtRssiHist, 0, sizeof(aLtRssiHist));
+    s_cLtLqiMin = 0xFF;
+    s_cLtLqiMax = 0;
+    s_lLtLqiSum = 0;
+
+    aLtTxFrame[0] = LT_CMD_CONFIG_ACK;
+    aLtTxFrame[1] = s_cLtRxRun;
+    LinkTestSend(2);
+    s_cLtRxSwitch = 1;
+    return;
+  }
+  if(!s_cLtRxOnTest || pcFrame[1] != s_cLtRxRun)
+  {
+    return;
+  }
+  s_lLtRxActivity = lTick;
+
+  switch(pcFrame[0])
+  {
+  case LT_CMD_DATA:
+    s_nLtRxData++;
+    lBin = xLtRxInfo.lRssidBm - LT_RSSI_MIN;
+    if(lBin < 0)
+    {
+      lBin = 0;
+    }
+    else if(lBin >= LT_RSSI_BINS)
+    {
+      lBin = LT_RSSI_BINS - 1;
+    }
+    aLtRssiHist[lBin]++;
+    if(xLtRxInfo.cLqi < s_cLtLqiMin)
+    {
+      s_cLtLqiMin = xLtRxInfo.cLqi;
+    }
+    if(xLtRxInfo.cLqi > s_cLtLqiMax)
+    {
+      s_cLtLqiMax = xLtRxInfo.cLqi;
+    }
+    s_lLtLqiSum += xLtRxInfo.cLqi;
+    break;
+
+  case LT_CMD_PING:
+    if(cLen >= LT_MIN_LEN)
+    {
+      s_nLtRxPings++;
+      memcpy(aLtTxFrame, pcFrame, cLen);
+      aLtTxFrame[0] = LT_CMD_ECHO;
+      aLtTxFrame[3] = (uint8_t)(int8_t)xLtRxInfo.lRssidBm;
+      aLtTxFrame[4] = xLtRxInfo.cLqi;
+      LinkTestSend(cLen);
+    }
+    break;
+
+  case LT_CMD_REPORT_REQ:
+    LinkTestBuildReport();
+    LinkTestSend(LT_REPORT_LEN);
+    break;
+
+  case LT_CMD_DONE:
+    LinkTestSetPhy(&xLtBasePhy);
+    s_cLtRxOnTest = 0;
+    break;
+  }
+}
+
+/**
+* @brief  Controller: print the result of the test as a CSV row
+* @param  None
+* @retval None
+*/
+static void LinkTestPrintResult(void)
+{
+  uint16_t nReceived = aLtReport[2] | ((uint16_t)aLtReport[3] << 8);
+  uint32_t lGoodput = 0;
+  char aRssi[48] = ",,,,,,,";
+  char aRtt[48] = ",,,";
+
+  if(s_lLtStreamUs != 0)
+  {
+    lGoodput = (uint32_t)(((uint64_t)nReceived * s_cLtLen * 8 * 1000000) / s_lLtStreamUs);
+  }
+  if(nReceived != 0)
+  {
+    snprintf(aRssi, sizeof(aRssi), "%d,%d,%d,%d,%d,%u,%u.%u,%u",
+             (int8_t)aLtReport[4], (int8_t)aLtReport[5], (int8_t)aLtReport[6], (int8_t)aLtReport[7], (int8_t)aLtReport[8],
+             aLtReport[9], aLtReport[10] / 10, aLtReport[10] % 10, aLtReport[11]);
+  }
+  if(s_nLtEchoes != 0)
+  {
+    snprintf(aRtt, sizeof(aRtt), "%lu,%lu,%lu,%ld",
+             (unsigned long)s_lLtRttMin, (unsigned long)(s_lLtRttSum / s_nLtEchoes), (unsigned long)s_lLtRttMax,
+             (long)(s_lLtEchoRssiSum / s_nLtEchoes));
+  }
+  LinkTestPrint("RESULT,%lu,%s,%lu,%lu,%u,%u,%u,%u,%u,%u,%lu,%s,%u,%u,%s",
+                (unsigned long)xLtPhy.lDatarate, LinkTestModName(xLtPhy.xModulation),
+                (unsigned long)xLtPhy.lFreqDev, (unsigned long)xLtPhy.lBandwidth,
+                xLtPhy.xFec == S_ENABLE, xLtPhy.xWhitening == S_ENABLE,
+                s_cLtLen, s_nLtCount, nReceived,
+                s_nLtCount ? (unsigned)(((uint32_t)(s_nLtCount - nReceived) * 1000) / s_nLtCount) : 0,
+                (unsigned long)lGoodput, aRssi, s_nLtPingsSent, s_nLtEchoes, aRtt);
+}
+
+/**
+* @brief  Controller: send the test PHY, on the base PHY and, in case the
+*         responder already switched, every other time on the test PHY
+* @param  lTick = HAL tick
+* @retval None
+*/
+static void LinkTestSendConfig(uint32_t lTick)
+{
+  const LinkTestPhy_t *pxPhy = (s_cLtTries++ & 1) ? &xLtPhy : &xLtBasePhy;
+
+  LinkTestSetPhy(pxPhy);
+  aLtTxFrame[0] = LT_CMD_CONFIG;
+  aLtTxFrame[1] = s_cLtRun;
+  LinkTestPut32(&aLtTxFrame[2], xLtPhy.lDatarate);
+  aLtTxFrame[6] = (uint8_t)xLtPhy.xModulation;
+  LinkTestPut32(&aLtTxFrame[7], xLtPhy.lFreqDev);
+  LinkTestPut32(&aLtTxFrame[11], xLtPhy.lBandwidth);
+  aLtTxFrame[15] = (xLtPhy.xFec == S_ENABLE ? 0x01 : 0) | (xLtPhy.xWhitening == S_ENABLE ? 0x02 : 0);
+  LinkTestSend(LT_CONFIG_LEN);
+  s_lLtDeadline = lTick + LinkTestAirMs(pxPhy, LT_CONFIG_LEN) + LinkTestAirMs(pxPhy, 2) + LT_TURNAROUND_MS;
+}
+
+/**
+* @brief  Controller: next ping, or the report once they are all sent
+* @param  lTick = HAL tick
+* @retval None
+*/
+static void LinkTestNextPing(uint32_t lTick)
+{
+  if(s_nLtPingsSent < s_nLtPings)
+  {
+    memset(aLtTxFrame, 0, s_cLtLen);
+    aLtTxFrame[0] = LT_CMD_PING;
+    aLtTxFrame[1] = s_cLtRun;
+    aLtTxFrame[2] = (uint8_t)s_nLtPingsSent;
+    s_nLtPingsSent++;
+    s_lLtPingUs = LinkTestMicros();
+    LinkTestSend(s_cLtLen);
+    s_lLtDeadline = lTick + 2 * LinkTestAirMs(&xLtPhy, s_cLtLen) + LT_TURNAROUND_MS;
+    s_xLtState = LT_STATE_PING;
+  }
+  else
+  {
+    aLtTxFrame[0] = LT_CMD_REPORT_REQ;
+    aLtTxFrame[1] = s_cLtRun;
+    LinkTestSend(2);
+    s_lLtDeadline = lTick + LinkTestAirMs(&xLtPhy, 2) + LinkTestAirMs(&xLtPhy, LT_REPORT_LEN) + LT_TURNAROUND_MS;
+    s_xLtState = LT_STATE_REPORT;
+  }
+}
+
+/**
+* @brief  Controller: end of the test, back to the base PHY
+* @param  pcError = NULL, or why the test failed
+* @retval None
+*/
+static void LinkTestEnd(const char *pcError)
+{
+  LinkTestSetPhy(&xLtBasePhy);
+  if(pcError != NULL)
+  {
+    LinkTestPrint("ERR %s", pcError);
+  }
+  else
+  {
+    LinkTestPrintResult();
+  }
+  s_xLtState = LT_STATE_IDLE;
+}
+
+/**
+* @brief  Controller: a frame of the responder
+* @param  pcFrame = received frame
+* @param  cLen = its length
+* @param  lTick = HAL tick
+* @retval None
+*/
+static void LinkTestControllerRx(uint8_t *pcFrame, uint8_t cLen, uint32_t lTick)
+{
+  uint32_t lRtt;
+
+  if(cLen < 2 || pcFrame[1] != s_cLtRun)
+  {
+    return;
+  }
+  if(s_xLtState == LT_STATE_CONFIG && pcFrame[0] == LT_CMD_CONFIG_ACK)
+  {
+    s_cLtTries = 0;
+    s_lLtDeadline = lTick + LT_SWITCH_MS;
+    s_xLtState = LT_STATE_SWITCH;
+  }
+  else if(s_xLtState == LT_STATE_PING && pcFrame[0] == LT_CMD_ECHO && cLen >= LT_MIN_LEN &&
+          pcFrame[2] == (uint8_t)(s_nLtPingsSent - 1))
+  {
+    lRtt = LinkTestMicros() - s_lLtPingUs;
+    if(s_nLtEchoes == 0 || lRtt < s_lLtRttMin)
+    {
+      s_lLtRttMin = lRtt;
+    }
+    if(lRtt > s_lLtRttMax)
+    {
+      s_lLtRttMax = lRtt;
+    }
+    s_lLtRttSum += lRtt;
+    s_lLtEchoRssiSum += xLtRxInfo.lRssidBm;
+    s_nLtEchoes++;
+    LinkTestNextPing(lTick);
+  }
+  else if(s_xLtState == LT_STATE_REPORT && pcFrame[0] == LT_CMD_REPORT && cLen >= LT_REPORT_LEN)
+  {
+    memcpy(aLtReport, pcFrame, LT_REPORT_LEN);
+    aLtTxFrame[0] = LT_CMD_DONE;
+    aLtTxFrame[1] = s_cLtRun;
+    LinkTestSend(2);
+    s_xLtState = LT_STATE_DONE;
+  }
+}
+
+/**
+* @brief  Controller: a frame is on air
+* @param  lTick = HAL tick
+* @retval None
+*/
+static void LinkTestControllerTxDone(uint32_t lTick)
+{
+  switch(s_xLtState)
+  {
+  case LT_STATE_STREAM:
+    s_nLtSent++;
+    if(s_nLtSent < s_nLtCount)
+    {
+      aLtTxFrame[2] = (uint8_t)s_nLtSent;
+      aLtTxFrame[3] = (uint8_t)(s_nLtSent >> 8);
+      LinkTestSend(s_cLtLen);
+    }
+    else
+    {
+      s_lLtStreamUs = LinkTestMicros() - s_lLtStartUs;
+      LinkTestNextPing(lTick);
+    }
+    break;
+
+  case LT_STATE_DONE:
+    LinkTestEnd(NULL);
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+* @brief  Controller: the answer that did not come
+* @param  lTick = HAL tick
+* @retval 1 if the deadline has passed
+*/
+static uint8_t LinkTestControllerTimeout(uint32_t lTick)
+{
+  if(s_cLtTxBusy || (int32_t)(lTick - s_lLtDeadline) < 0)
+  {
+    return 0;
+  }
+  switch(s_xLtState)
+  {
+  case LT_STATE_CONFIG:
+    if(lTick - s_lLtConfigStart >= s_lLtConfigMs)
+    {
+      LinkTestEnd("no responder");
+    }
+    else
+    {
+      LinkTestSendConfig(lTick);
+    }
+    break;
+
+  case LT_STATE_SWITCH:
+    LinkTestSetPhy(&xLtPhy);
+    memset(aLtTxFrame, 0, s_cLtLen);
+    aLtTxFrame[0] = LT_CMD_DATA;
+    aLtTxFrame[1] = s_cLtRun;
+    s_lLtStartUs = LinkTestMicros();
+    LinkTestSend(s_cLtLen);
+    s_xLtState = LT_STATE_STREAM;
+    break;
+
+  case LT_STATE_PING:
+    LinkTestNextPing(lTick);
+    break;
+
+  case LT_STATE_REPORT:
+    if(++s_cLtTries >= LINKTEST_RETRIES)
+    {
+      LinkTestEnd("no report");
+    }
+    else
+    {
+      s_nLtPingsSent = s_nLtPings;
+      LinkTestNextPing(lTick);
+    }
+    break;
+
+  default:
+    break;
+  }
+  return 1;
+}
+
+/**
+* @brief  Start a test with the PHY set by the "phy" command
+* @param  cLen = frame length
+* @param  nCount = data frames
+* @param  nPings = pings after them
+* @retval None
+*/
+static void LinkTestStart(uint8_t cLen, uint16_t nCount, uint16_t nPings)
+{
+  uint32_t lTick = HAL_GetTick();
+
+  if(s_cLtRxOnTest)
+  {
+    LinkTestSetPhy(&xLtBasePhy);
+    s_cLtRxOnTest = 0;
+  }
+  s_cLtRun++;
+  s_cLtLen = cLen;
+  s_nLtCount = nCount;
+  s_nLtPings = nPings;
+  s_nLtSent = 0;
+  s_nLtPingsSent = 0;
+  s_nLtEchoes = 0;
+  s_lLtRttMin = 0;
+  s_lLtRttMax = 0;
+  s_lLtRttSum = 0;
+  s_lLtEchoRssiSum = 0;
+  s_lLtStreamUs = 0;
+  s_cLtTries = 0;
+  /* A responder still on the PHY of the last test comes back after its idle time */
+  s_lLtConfigMs = LINKTEST_CONFIG_MS + 2 * LinkTestAirMs(&xLtLastPhy, LT_MAX_LEN);
+  xLtLastPhy = xLtPhy;
+  s_lLtConfigStart = lTick;
+  s_xLtState = LT_STATE_CONFIG;
+  LinkTestSendConfig(lTick);
+}
+
+/**
+* @brief  Execute a command line of the PC:
+*         phy <datarate> <modulation> <fdev> <bandwidth> <fec> <whitening>
+*         run <length> <frames> <pings>
+* @param  pcLine = command line
+* @retval None
+*/
+static void LinkTestCommand(char *pcLine)
+{
+  char *pcArg[7];
+  uint8_t cArgs = 0;
+  uint32_t lValue[6];
+
+  for(char *pcToken = strtok(pcLine, " \t"); pcToken != NULL && cArgs < 7; pcToken = strtok(NULL, " \t"))
+  {
+    pcArg[cArgs++] = pcToken;
+  }
+  if(cArgs == 0)
+  {
+    return;
+  }
+  if(s_xLtState != LT_STATE_IDLE)
+  {
+    LinkTestPrint("ERR busy");
+  }
+  else if(strcmp(pcArg[0], "phy") == 0 && cArgs == 7)
+  {
+    uint8_t i;
+
+    for(i = 0; i < sizeof(aLtModulations) / sizeof(aLtModulations[0]); i++)
+    {
+      if(strcmp(pcArg[2], aLtModulations[i].pcName) == 0)
+      {
+        break;
+      }
+    }
+    lValue[0] = strtoul(pcArg[1], NULL, 10);
+    lValue[1] = strtoul(pcArg[3], NULL, 10);
+    lValue[2] = strtoul(pcArg[4], NULL, 10);
+    if(i == sizeof(aLtModulations) / sizeof(aLtModulations[0]) || lValue[0] == 0 || lValue[2] == 0)
+    {
+      LinkTestPrint("ERR phy");
+      return;
+    }
+    xLtPhy.lDatarate = lValue[0];
+    xLtPhy.xModulation = aLtModulations[i].xModulation;
+    xLtPhy.lFreqDev = lValue[1];
+    xLtPhy.lBandwidth = lValue[2];
+    xLtPhy.xFec = strtoul(pcArg[5], NULL, 10) ? S_ENABLE : S_DISABLE;
+    xLtPhy.xWhitening = strtoul(pcArg[6], NULL, 10) ? S_ENABLE : S_DISABLE;
+    LinkTestPrint("OK");
+  }
+  else if(strcmp(pcArg[0], "run") == 0 && cArgs == 4)
+  {
+    lValue[0] = strtoul(pcArg[1], NULL, 10);
+    lValue[1] = strtoul(pcArg[2], NULL, 10);
+    lValue[2] = strtoul(pcArg[3], NULL, 10);
+    if(lValue[0] < LT_MIN_LEN || lValue[0] > LT_MAX_LEN || lValue[1] == 0 || lValue[1] > 0xFFFF || lValue[2] > 0xFFFF)
+    {
+      LinkTestPrint("ERR run");
+      return;
+    }
+    LinkTestStart((uint8_t)lValue[0], (uint16_t)lValue[1], (uint16_t)lValue[2]);
+  }
+  else
+  {
+    LinkTestPrint("ERR command");
+  }
+}
+
+/**
+* @brief  Collect the command lines of the PC, polled
+* @param  None
+* @retval None
+*/
+static void LinkTestUartPoll(void)
+{
+  uint8_t cChar;
+
+  if(__HAL_UART_GET_FLAG(&hLinkTestUart, UART_FLAG_ORE))
+  {
+    __HAL_UART_CLEAR_OREFLAG(&hLinkTestUart);
+  }
+  while(HAL_UART_Receive(&hLinkTestUart, &cChar, 1, 0) == HAL_OK)
+  {
+    if(cChar == '\r' || cChar == '\n')
+    {
+      aLtLine[s_cLtLineLen] = '\0';
+      s_cLtLineLen = 0;
+      LinkTestCommand(aLtLine);
+    }
+    else if(s_cLtLineLen < LT_LINE_LEN - 1)
+    {
+      aLtLine[s_cLtLineLen++] = (char)cChar;
+    }
+  }
+}
+
+/**
+* @brief  Link tester state machine: controller of the tests asked by the PC,
+*         responder of the tests of the other node otherwise
+* @param  None
+* @retval None
+*/
+static void LinkTestProcess(void)
+{
+  uint32_t lTick = HAL_GetTick();
+  uint8_t cRxLen = 0;
+  uint8_t cListen = 0;
+
+  LinkTestUartPoll();
+
+  if(xTxDoneFlag)
+  {
+    xTxDoneFlag = RESET;
+    s_cLtTxBusy = 0;
+    if(s_cLtRxSwitch)
+    {
+      /* CONFIG_ACK sent: the test starts */
+      s_cLtRxSwitch = 0;
+      LinkTestSetPhy(&xLtRxPhy);
+      s_cLtRxOnTest = 1;
+      s_lLtRxActivity = lTick;
+    }
+    else
+    {
+      LinkTestControllerTxDone(lTick);
+    }
+    cListen = 1;
+  }
+
+  if(xRxDoneFlag)
+  {
+    xRxDoneFlag = RESET;
+    S2LP_RADIO_QI_GetRxPacketInfo(&xLtRxInfo);
+    pRadioDriver->GetRxPacket(aLtRxFrame, &cRxLen);
+    if(s_xLtState == LT_STATE_IDLE)
+    {
+      LinkTestRespond(aLtRxFrame, cRxLen, lTick);
+    }
+    else
+    {
+      LinkTestControllerRx(aLtRxFrame, cRxLen, lTick);
+    }
+    cListen = 1;
+  }
+
+  if(s_xLtState != LT_STATE_IDLE)
+  {
+    cListen |= LinkTestControllerTimeout(lTick);
+  }
+  else if(s_cLtRxOnTest && !s_cLtTxBusy && lTick - s_lLtRxActivity >= s_lLtRxIdleMs)
+  {
+    /* The controller is gone */
+    LinkTestSetPhy(&xLtBasePhy);
+    s_cLtRxOnTest = 0;
+    cListen = 1;
+  }
+
+  if(cListen)
+  {
+    LinkTestListen();
+  }
+}
+#endif
+
+/**
+* @brief  This function handles the point-to-point packet transmission
+* @param  AppliFrame_t *xTxFrame = Pointer to AppliFrame_t structure
+*         uint8_t cTxlen = Length of aTransmitBuffer
+* @retval None
+*/
+void AppliSendBuff(AppliFrame_t *xTxFrame, uint8_t cTxlen)
+{
+  uint8_t xIndex = 0;
+  uint8_t trxLength = 0;
+  pRadioDriver = &radio_cb;
+
+#ifdef USE_STack_PROTOCOL
+
+  PktStackAddressesInit xAddressInit=
+  {
+    .xFilterOnMyAddress = S_ENABLE,
+    .cMyAddress = MY_ADDRESS,
+    .xFilterOnMulticastAddress = S_DISABLE,
+    .cMulticastAddress = MULTICAST_ADDRESS,
+    .xFilterOnBroadcastAddress = S_ENABLE,
+    .cBroadcastAddress = BROADCAST_ADDRESS
+  };
+  S2LP_PCKT_STACK_AddressesInit(&xAddressInit);
+
+#ifdef USE_STack_LLP
+
+  /* LLP structure fitting */
+  PktStackLlpInit xStackLLPInit=
+  {
+    .xAutoAck = S_DISABLE,
+    .xPiggybacking = S_DISABLE,
+    .xNMaxRetx = PKT_N_RETX_2
+  };
+
+#else
+
+  /* LLP structure fitting */
+  PktStackLlpInit xStackLLPInit=
+  {
+    .xAutoAck = S_DISABLE,
+    .xPiggybacking = S_DISABLE,
+    .xNMaxRetx = PKT_DISABLE_RETX
+  };
+#endif
+
+  Radio_PktStackLlpInit(&xStackLLPInit);
+
+#endif
+
+#ifdef USE_BASIC_PROTOCOL
+  S2LP_PCKT_BASIC_AddressesInit(&xAddressInit);
+#endif
+
+  TxFrameBuff[0] = xTxFrame->Cmd;
+  TxFrameBuff[1] = xTxFrame->CmdLen;
+  TxFrameBuff[2] = xTxFrame->Cmdtag;
+  TxFrameBuff[3] = xTxFrame->CmdType;
+  TxFrameBuff[4] = xTxFrame->DataLen;
+
+  for(; xIndex < xTxFrame->DataLen; xIndex++)
+  {
+    TxFrameBuff[xIndex+5] =  xTxFrame->DataBuff[xIndex];
+  }
+
+  trxLength = (xIndex+5);
+
+  S2LP_GPIO_IrqDeInit(NULL);
+
+  pRadioDriver->EnableTxIrq();
+  /* payload length config */
+  pRadioDriver->SetPayloadLen(trxLength);
+  /* rx timeout config */
+  pRadioDriver->SetRxTimeout(RECEIVE_TIMEOUT);
+  /* IRQ registers blanking */
+
+  S2LP_GPIO_IrqClearStatus();
+  /* destination address */
+  pRadioDriver->SetDestinationAddress(DESTINATION_ADDRESS);
+
+  /* send the TX command */
+  pRadioDriver->StartTx(TxFrameBuff, trxLength);
+}
+
+/**
+* @brief  This function handles the point-to-point packet reception
+* @param  uint8_t *RxFrameBuff = Pointer to ReceiveBuffer
+*         uint8_t cRxlen = length of ReceiveBuffer
+* @retval None
+*/
+void AppliReceiveBuff(uint8_t *RxFrameBuff, uint8_t cRxlen)
+{
+  /*float rRSSIValue = 0;*/
+  exitTime = SET;
+  exitCounter = TIME_TO_EXIT_RX;
+
+#ifdef USE_STack_PROTOCOL
+
+#ifdef USE_STack_LLP
+  /* LLP structure fitting */
+  PktStackLlpInit xStackLLPInit=
+  {
+    .xAutoAck = S_ENABLE,
+    .xPiggybacking = S_ENABLE,
+    .xNMaxRetx = PKT_DISABLE_RETX
+  };
+#else
+  /* LLP structure fitting */
+  PktStackLlpInit xStackLLPInit=
+  {
+    .xAutoAck = S_DISABLE,
+    .xPiggybacking = S_DISABLE,
+    .xNMaxRetx = PKT_DISABLE_RETX
+  };
+#endif
+
+  Radio_PktStackLlpInit(&xStackLLPInit);
+
+  PktStackAddressesInit xAddressInit=
+  {
+    .xFilterOnMyAddress = S_ENABLE,
+    .cMyAddress = MY_ADDRESS,
+    .xFilterOnMulticastAddress = S_DISABLE,
+    .cMulticastAddress = MULTICAST_ADDRESS,
+    .xFilterOnBroadcastAddress = S_ENABLE,
+    .cBroadcastAddress = BROADCAST_ADDRESS
+  };
+
+  S2LP_PCKT_STACK_AddressesInit(&xAddressInit);
+
+  if(EN_FILT_SOURCE_ADDRESS)
+  {
+    Radio_PktStackFilterOnSourceAddress(S_ENABLE);
+    Radio_PktStackSetRxSourceMask(SOURCE_ADDR_MASK);
+    Radio_PktStackSetSourceReferenceAddress (SOURCE_ADDR_REF);
+
+  }
+  else
+  {
+    RadioPktStackFilterOnSourceAddress(S_DISABLE);
+  }
+#endif
+
+  //RadioPktBasicAddressesInit(&xAddressInit);
+  S2LP_PCKT_BASIC_AddressesInit(&xAddressInit);
+
+  pRadioDriver = &radio_cb;
+  /* S2LP IRQs disable */
+  S2LP_GPIO_IrqDeInit(NULL);
+  /* S2LP IRQs enable */
+
+  pRadioDriver->EnableRxIrq();
+  /* payload length config */
+  pRadioDriver->SetPayloadLen(PAYLOAD_LEN);
+  /* rx timeout config */
+
+  S2LP_TIM_SetRxTimerMs(700.0);
+  SET_INFINITE_RX_TIMEOUT();
+
+  pRadioDriver->SetDestinationAddress(DESTINATION_ADDRESS);
+  /* IRQ registers blanking */
+  S2LP_GPIO_IrqClearStatus();
+
+  /* RX command */
+  pRadioDriver->StartRx();
+  /* destination address */
+}
+
+/**
+* @brief  This function initializes the STack Packet handler of S2LP
+* @param  None
+* @retval None
+*/
+void STackProtocolInit(void)
+{
+
+  PktStackInit xStackInit=
+  {
+    .xPreambleLength = PREAMBLE_LENGTH,
+    .xSyncLength = SYNC_LENGTH,
+    .lSyncWords = SYNC_WORD,
+
+    .xFixVarLength = S_ENABLE,
+    .cExtendedPktLenField = S_DISABLE,
+
+    .xCrcMode = CRC_MODE,
+    .xFec = EN_FEC,
+    .xDataWhitening = EN_WHITENING
+  };
+  /* Radio Packet config */
+  S2LP_PCKT_STACK_Init(&xStackInit);
+}
+
+/*xDataWhitening;  *
+* @brief  This function initializes the BASIC Packet handler of S2LP
+* @param  None
+* @retval None
+*/
+void BasicProtocolInit(void)
+{
+  /* RAdio Packet config */
  S2LP_PCKT_BASIC_Init(&xBasicInit);
 }
 
@@ -988,6 +2574,13 @@ void RadioSleep(void)
 */
 void Set_KeyStatus(FlagStatus val)
 {
+#ifdef USE_P2P_BULK
+  if(val==SET)
+  {
+    s_xBulkKeyPressed = SET;
+  }
+  return;
+#endif
   if(val==SET)
   {
     SM_State = SM_STATE_SEND_DATA;
@@ -1007,6 +2600,11 @@ static void P2PInterruptHandler(void)
 {
   S2LP_GPIO_IrqGetStatus(&xIrqStatus);
 
+#ifdef USE_WMBUS_GATEWAY
+  S2LP_WMBUS_LL_IrqHandler(&xIrqStatus);
+  return;
+#endif
+
   /* Check the S2LP TX_DATA_SENT IRQ flag */
   if(
      (xIrqStatus.IRQ_TX_DATA_SENT)
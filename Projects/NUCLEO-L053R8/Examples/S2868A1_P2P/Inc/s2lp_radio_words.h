@@ -0,0 +1,37 @@
+/* Generated by s2lp_words_gen (Utilities/PC_Software/S2LPSimulator, "make words")
+ * from the radio settings of p2p_demo_settings.h: do not edit.
+ * Register words of S2LP_RADIO_Init and synthesizer words of channels
+ * BASE_FREQUENCY + n * CHANNEL_SPACE, valid for RADIO_WORDS_XTAL_FREQUENCY only.
+ */
+#ifndef S2LP_RADIO_WORDS_H
+#define S2LP_RADIO_WORDS_H
+
+#define RADIO_WORDS_XTAL_FREQUENCY    50000000U
+#define RADIO_WORDS_FREQUENCY_BASE    868000000U
+#define RADIO_WORDS_CHANNELS          16
+
+/* SRadioInitWords initializer */
+#define RADIO_INIT_WORDS  { 0x2F, 0xC2, { 0x92, 0xA7, 0x07, 0x03, 0xA3, 0x13 }, 0, 2, \
+    { 0, { 0x62, 0x2B, 0x85, 0x1F } } }
+
+/* SRadioSynthWords[RADIO_WORDS_CHANNELS] initializer */
+#define RADIO_CHANNEL_WORDS  { \
+    { 0, { 0x62, 0x2B, 0x85, 0x1F } }, \
+    { 0, { 0x62, 0x2B, 0x95, 0x81 } }, \
+    { 0, { 0x62, 0x2B, 0xA5, 0xE3 } }, \
+    { 0, { 0x62, 0x2B, 0xB6, 0x46 } }, \
+    { 0, { 0x62, 0x2B, 0xC6, 0xA8 } }, \
+    { 0, { 0x62, 0x2B, 0xD7, 0x0A } }, \
+    { 0, { 0x62, 0x2B, 0xE7, 0x6D } }, \
+    { 0, { 0x62, 0x2B, 0xF7, 0xCF } }, \
+    { 0, { 0x62, 0x2C, 0x08, 0x31 } }, \
+    { 0, { 0x62, 0x2C, 0x18, 0x93 } }, \
+    { 0, { 0x62, 0x2C, 0x28, 0xF6 } }, \
+    { 0, { 0x62, 0x2C, 0x39, 0x58 } }, \
+    { 0, { 0x62, 0x2C, 0x49, 0xBA } }, \
+    { 0, { 0x62, 0x2C, 0x5A, 0x1D } }, \
+    { 0, { 0x62, 0x2C, 0x6A, 0x7F } }, \
+    { 0, { 0x62, 0x2C, 0x7A, 0xE1 } } \
+  }
+
+#endif /* S2LP_RADIO_WORDS_H */
@@ -96,6 +96,37 @@ extern "C" {
 extern RadioCsmaInit xCsmaInit;
  #endif
 
+//#define USE_WMBUS_GATEWAY  /* Uncomment to listen to Wireless M-Bus meters instead of running the P2P demo */
+
+#ifdef USE_WMBUS_GATEWAY
+#include "s2lp_wmbus_ll.h"
+/* Wireless M-Bus gateway parameters */
+#define WMBUS_GATEWAY_MODE                                  WMBUS_MODE_T1
+#define WMBUS_GATEWAY_METERS                                32    /* meters tracked, the least recently heard is replaced */
+#endif
+
+//#define USE_P2P_BULK  /* Uncomment to run the bulk transfer link benchmark instead of the P2P demo */
+
+#ifdef USE_P2P_BULK
+/* Bulk transfer parameters: both nodes must use the same ones */
+#define BULK_DATA_LEN                                       100   /* payload bytes per frame, at most S2LP_TX_FIFO_SIZE - 5 */
+#define BULK_WINDOW                                         16    /* frames sent before an ACK, power of two, at most 32 */
+#define BULK_TRANSFER_BYTES                                 65536 /* bytes sent at each push of the button */
+#define BULK_ACK_TIMEOUT_MS                                 50    /* the unacknowledged frames are sent again after it */
+#define BULK_REPORT_MS                                      1000  /* throughput and PER period */
+#endif
+
+//#define USE_P2P_LINKTEST  /* Uncomment to run the link tester driven from the PC (Utilities/PC_Software/LinkTest) */
+
+#ifdef USE_P2P_LINKTEST
+/* Link tester parameters: the radio settings above are the base PHY, on which
+   the nodes agree the PHY of each test */
+#define LINKTEST_UART_BAUDRATE                              115200 /* ST-LINK virtual COM port */
+#define LINKTEST_CONFIG_MS                                  3000  /* the controller sends the test PHY that long */
+#define LINKTEST_IDLE_MS                                    1000  /* the responder goes back to the base PHY after this silence */
+#define LINKTEST_RETRIES                                    5     /* requests of the responder report */
+#endif
+
 /* Defines ---------------------------------------------------------------*/
 
 #define XTAL_OFFSET_PPM             0
@@ -108,6 +139,10 @@ extern RadioCsmaInit xCsmaInit;
 #define DATARATE                    38400
 #define FREQ_DEVIATION              20e3
 #define BANDWIDTH                   100E3
+/* Use the register words of s2lp_radio_words.h, precomputed from the values
+ * above ("make words" in Utilities/PC_Software/S2LPSimulator), instead of
+ * computing them with 64-bit divisions at init */
+#define USE_RADIO_INIT_WORDS
 #define POWER_INDEX                 7
 #define RECEIVE_TIMEOUT             2000.0 /*change the value for required timeout period*/
 
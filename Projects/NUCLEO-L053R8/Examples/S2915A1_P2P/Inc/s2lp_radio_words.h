@@ -0,0 +1,37 @@
+/* Generated by s2lp_words_gen (Utilities/PC_Software/S2LPSimulator, "make words")
+ * from the radio settings of p2p_demo_settings.h: do not edit.
+ * Register words of S2LP_RADIO_Init and synthesizer words of channels
+ * BASE_FREQUENCY + n * CHANNEL_SPACE, valid for RADIO_WORDS_XTAL_FREQUENCY only.
+ */
+#ifndef S2LP_RADIO_WORDS_H
+#define S2LP_RADIO_WORDS_H
+
+#define RADIO_WORDS_XTAL_FREQUENCY    50000000U
+#define RADIO_WORDS_FREQUENCY_BASE    915000000U
+#define RADIO_WORDS_CHANNELS          16
+
+/* SRadioInitWords initializer */
+#define RADIO_INIT_WORDS  { 0x2F, 0xC2, { 0x92, 0xA7, 0x07, 0x03, 0xA3, 0x13 }, 0, 2, \
+    { 0, { 0x42, 0x49, 0x99, 0x9A } } }
+
+/* SRadioSynthWords[RADIO_WORDS_CHANNELS] initializer */
+#define RADIO_CHANNEL_WORDS  { \
+    { 0, { 0x42, 0x49, 0x99, 0x9A } }, \
+    { 0, { 0x42, 0x49, 0xA9, 0xFC } }, \
+    { 0, { 0x42, 0x49, 0xBA, 0x5E } }, \
+    { 0, { 0x42, 0x49, 0xCA, 0xC1 } }, \
+    { 0, { 0x42, 0x49, 0xDB, 0x23 } }, \
+    { 0, { 0x42, 0x49, 0xEB, 0x85 } }, \
+    { 0, { 0x42, 0x49, 0xFB, 0xE7 } }, \
+    { 0, { 0x42, 0x4A, 0x0C, 0x4A } }, \
+    { 0, { 0x42, 0x4A, 0x1C, 0xAC } }, \
+    { 0, { 0x42, 0x4A, 0x2D, 0x0E } }, \
+    { 0, { 0x42, 0x4A, 0x3D, 0x71 } }, \
+    { 0, { 0x42, 0x4A, 0x4D, 0xD3 } }, \
+    { 0, { 0x42, 0x4A, 0x5E, 0x35 } }, \
+    { 0, { 0x42, 0x4A, 0x6E, 0x98 } }, \
+    { 0, { 0x42, 0x4A, 0x7E, 0xFA } }, \
+    { 0, { 0x42, 0x4A, 0x8F, 0x5C } } \
+  }
+
+#endif /* S2LP_RADIO_WORDS_H */
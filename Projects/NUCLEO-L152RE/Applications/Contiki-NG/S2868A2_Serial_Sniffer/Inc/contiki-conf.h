@@ -60,16 +60,13 @@
     do {c=(cond);} while((!c) && RTIMER_CLOCK_LT(RTIMER_NOW(), (t0) + (max_time))); \
   }
 
-/*TSCH macros*/
-//@TODO: next macros needs to be validated
-#define S2LP_PREAMBLE_TIME (2 * PREAMBLE_LENGTH * 1000000 / DATARATE) //Preamble is in chip sequence (2 bits)
-#define S2LP_SYNCH_TIME (SYNC_LENGTH * 1000000 / DATARATE)
-#define RADIO_DELAY_BEFORE_TX  ((unsigned)US_TO_RTIMERTICKS(90 + S2LP_PREAMBLE_TIME +S2LP_SYNCH_TIME ))
-#define RADIO_DELAY_BEFORE_RX ((unsigned)US_TO_RTIMERTICKS(90))
-//#define TSCH_CONF_DEFAULT_TIMESLOT_LENGTH ...
-#define RADIO_BYTE_AIR_TIME    (1000000 / ( DATARATE / 8))
-#define RADIO_PHY_OVERHEAD         2//Should be 2: 1 Byte for LEN and 1 Byte for CRC...
-#define RADIO_DELAY_BEFORE_DETECT ((unsigned)US_TO_RTIMERTICKS(20))//dummy value
+/*TSCH macros: the S2-LP timing at DATARATE, see radio-driver.h*/
+#define RADIO_DELAY_BEFORE_TX  ((unsigned)US_TO_RTIMERTICKS(RADIO_DELAY_BEFORE_TX_US))
+#define RADIO_DELAY_BEFORE_RX ((unsigned)US_TO_RTIMERTICKS(RADIO_DELAY_BEFORE_RX_US))
+#define TSCH_CONF_DEFAULT_TIMESLOT_TIMING radio_tsch_timing_us
+#define RADIO_BYTE_AIR_TIME    RADIO_BYTE_AIR_TIME_US
+#define RADIO_PHY_OVERHEAD     RADIO_PHY_OVERHEAD_BYTES
+#define RADIO_DELAY_BEFORE_DETECT ((unsigned)US_TO_RTIMERTICKS(RADIO_DELAY_BEFORE_DETECT_US))
 #define RADIO_TO_RTIMER(X) ((uint32_t)((uint64_t)(X) * RTIMER_ARCH_SECOND / S2LPTimerGetRcoFrequency()))
 //#define TSCH_CONF_DEFAULT_HOPPING_SEQUENCE TSCH_HOPPING_SEQUENCE_1_1
 /* 6TiSCH minimal schedule length.
@@ -125,6 +122,12 @@
 #include "project-conf.h"
 #endif /* PROJECT_CONF_H */
 /*---------------------------------------------------------------------------*/
+#if RADIO_ISR_ACK
+/* ACKs are sent and matched by the radio driver, in its ISR */
+#undef CSMA_CONF_SEND_SOFT_ACK
+#define CSMA_CONF_SEND_SOFT_ACK 0
+#endif /*RADIO_ISR_ACK*/
+/*---------------------------------------------------------------------------*/
 #endif /* CONTIKI_CONF_H */
 /*---------------------------------------------------------------------------*/
 /** @} */
@@ -120,6 +120,21 @@ void S2LP_Interface_IoIrqDisable(void)
 {
   (void) S2868A2_RADIO_IoIrqDisable(GpioIrq);
 }
+#if (S2868A2_USE_SPI_DMA == 1)
+/*----------------------------------------------------------------------------*/
+/**
+* @brief  SPI transfer complete, closes a radio FIFO transfer started on DMA.
+* @param  hspi: SPI handle
+* @retval None
+*/
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+  if(hspi->Instance == BUS_SPI1_INSTANCE)
+  {
+    S2868A2_SPI_DMA_TxRxCplt();
+  }
+}
+#endif /*S2868A2_USE_SPI_DMA*/
 /*----------------------------------------------------------------------------*/
 void S2LPManagementRcoCalibration(void)
 {
@@ -47,6 +47,9 @@ extern const struct sensors_sensor button_sensor;
 
 extern volatile unsigned long seconds;
 extern volatile clock_time_t ticks;
+#if MCU_LOW_POWER
+extern RTC_HandleTypeDef hrtc;
+#endif /*MCU_LOW_POWER*/
 
 /* Private function prototypes -----------------------------------------------*/
 /* Functions Definition ------------------------------------------------------*/
@@ -165,6 +168,10 @@ void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
 void UART_IRQHandler(void)
 {
   /* USER CODE BEGIN USART2_IRQn 0 */
+#if (USE_BSP_COM1_DMA == 1U)
+  /* Idle line, end of the DMA transmission and errors: see console.c */
+  HAL_UART_IRQHandler(&UartHandle);
+#else
   UART_HandleTypeDef *huart = &UartHandle;
 
   if(__HAL_UART_GET_FLAG(huart, UART_FLAG_PE)){
@@ -186,6 +193,7 @@ void UART_IRQHandler(void)
   if(__HAL_UART_GET_FLAG(huart, UART_FLAG_RXNE)){
    input_handler(huart->Instance->DR);
   }
+#endif /*USE_BSP_COM1_DMA*/
 
 }
 /*----------------------------------------------------------------------------*/
@@ -217,11 +225,26 @@ void Contiki_SysTick_Handler(void)
     energest_flush();
   }
 
-  if(etimer_pending()) {
+  /* Poll the etimer process at the expiration only, so that the idle loop
+   * is not woken up at every tick */
+  if(etimer_pending()
+     && ((int32_t)(ticks - etimer_next_expiration_time()) >= 0)) {
     etimer_request_poll();
   }
 }
 /*----------------------------------------------------------------------------*/
+#if MCU_LOW_POWER
+/**
+* @brief  RTC wake-up timer interrupt: end of the STOP mode of clock_arch_idle()
+* @param  None
+* @retval None
+*/
+void RTC_WKUP_IRQHandler(void)
+{
+  HAL_RTCEx_WakeUpTimerIRQHandler(&hrtc);
+}
+#endif /*MCU_LOW_POWER*/
+/*----------------------------------------------------------------------------*/
 #ifdef __cplusplus
 }
 #endif
@@ -37,6 +37,124 @@ extern const struct radio_driver subGHz_radio_driver;
 /*---------------------------------------------------------------------------*/
 void Radio_interrupt_callback(void);
 /*---------------------------------------------------------------------------*/
+/* Asynchronous transmission (RADIO_ASYNC_TX), see radio-driver.c */
+typedef void (*radio_tx_done_callback_t)(int status);
+void radio_set_tx_done_callback(radio_tx_done_callback_t callback);
+int radio_tx_in_progress(void);
+/*---------------------------------------------------------------------------*/
+/* RX frame ring (RADIO_RX_QUEUE_LEN slots), see radio-driver.c */
+typedef struct {
+  uint32_t received;   /* frames stored in the ring */
+  uint32_t overflows;  /* frames dropped because the ring was full */
+  uint8_t max_used;    /* highest number of frames queued at once */
+  uint8_t queued;      /* frames waiting to be read */
+} radio_rx_queue_stats_t;
+void radio_get_rx_queue_stats(radio_rx_queue_stats_t *stats);
+/*---------------------------------------------------------------------------*/
+/* Times the last frame went on air, retransmissions of RADIO_HW_ACK included */
+int radio_get_tx_attempts(void);
+/*---------------------------------------------------------------------------*/
+/* Frequency hopping over CHANNEL_NUMBER_MIN..MAX (RADIO_HOPPING) */
+int radio_hop_set_sequence(const uint8_t *sequence, uint16_t len);
+int radio_hop_next(void);
+/*---------------------------------------------------------------------------*/
+/* Low duty cycle RX and wake-up preamble TX (RADIO_SNIFF_MODE) */
+typedef struct {
+  uint16_t period_ms;     /* sniff period, 0: continuous RX */
+  uint16_t tx_wakeup_ms;  /* wake-up preamble of the sent frames, 0: none */
+  uint32_t rx_frames;     /* frames received while sniffing */
+  uint32_t tx_frames;     /* frames sent with a wake-up preamble */
+  uint32_t sniff_ms;      /* time spent sniffing with the radio on */
+  uint32_t listen_ms;     /* estimated RX on time of the wake ups */
+  uint32_t preamble_ms;   /* air time of the wake-up preambles */
+} radio_sniff_stats_t;
+int radio_set_sniff_period(uint16_t period_ms);
+int radio_set_tx_wakeup(uint16_t period_ms);
+void radio_get_sniff_stats(radio_sniff_stats_t *stats);
+/*---------------------------------------------------------------------------*/
+/* TSCH timeslot timing of this PHY, see RADIO_CONST_TSCH_TIMING */
+extern const uint16_t radio_tsch_timing_us[];
+/*---------------------------------------------------------------------------*/
+/* Channel energy scan over CHANNEL_NUMBER_MIN..MAX (RADIO_ENERGY_SCAN) */
+typedef struct {
+  uint32_t samples;    /* running RSSI samples taken on the channel */
+  int8_t min_dbm;
+  int8_t avg_dbm;
+  int8_t max_dbm;
+  int8_t p50_dbm;      /* half of the samples are at or below, 2 dB steps */
+  int8_t p90_dbm;      /* 90% of the samples are at or below, 2 dB steps */
+  uint8_t busy_pct;    /* samples at or above RSSI_TX_THRESHOLD, in % */
+} radio_scan_stats_t;
+typedef struct {
+  uint8_t active;      /* a scan is running */
+  uint8_t channel;     /* channel being sampled */
+  uint16_t sweeps;     /* sweeps of the channel table completed */
+  uint32_t skipped;    /* samples not taken: SPI or radio busy */
+  uint32_t overflows;  /* samples lost because the ring was full */
+} radio_scan_status_t;
+int radio_scan_start(uint16_t sweeps);
+void radio_scan_stop(void);
+void radio_scan_get_status(radio_scan_status_t *status);
+int radio_scan_get_stats(uint8_t channel, radio_scan_stats_t *stats);
+int radio_scan_best_channel(void);
+uint16_t radio_scan_export(uint8_t *buf, uint16_t size);
+/*---------------------------------------------------------------------------*/
+/* CCA threshold and backoff adapted to the noise floor (RADIO_ADAPTIVE_CCA) */
+typedef struct {
+  int8_t noise_floor_dbm;  /* estimated noise floor, 0 until measured */
+  int8_t threshold_dbm;    /* CCA threshold applied on the channel */
+  uint8_t backoff_boost;   /* added to the backoff exponents of the MAC */
+  uint32_t noise_samples;  /* running RSSI samples taken while idle in RX */
+  uint32_t tx_frames;      /* frames sent with CSMA on the channel */
+  uint32_t cca_busy;       /* of which dropped after MAX_NB busy CCAs */
+  uint32_t noack;          /* of which sent but not acknowledged */
+  uint32_t adaptations;    /* changes of the threshold or of the boost */
+} radio_cca_stats_t;
+int radio_cca_get_stats(uint8_t channel, radio_cca_stats_t *stats);
+void radio_cca_set_adaptive(uint8_t enable);
+uint8_t radio_cca_backoff_boost(void);
+/*---------------------------------------------------------------------------*/
+/* Driver instrumentation (RADIO_STATS), times in us. Histogram bin i counts
+ * the events of 2^i to 2^(i+1) - 1 us, bin 0 those under 2 us and the last
+ * bin anything longer. */
+#define RADIO_STATS_HIST_BINS       12
+enum {
+  RADIO_STATS_ISR,          /* run time of Radio_interrupt_callback */
+  RADIO_STATS_IRQ_LATENCY,  /* IRQ line edge to its handling, deferrals included */
+  RADIO_STATS_TRANSMIT,     /* time spent in Radio_transmit */
+  RADIO_STATS_WAIT,         /* busy waits on the radio state or on a flag */
+  RADIO_STATS_HISTS
+};
+enum {
+  RADIO_DROP_RING_FULL,     /* no free slot in the RX ring */
+  RADIO_DROP_BUF_TOO_SMALL, /* longer than the buffer given to read() */
+  RADIO_DROP_DISCARDED,     /* IRQ_RX_DATA_DISC: CRC or address mismatch */
+  RADIO_DROP_REASONS
+};
+typedef struct {
+  uint32_t count;
+  uint32_t max_us;
+  uint64_t total_us;
+  uint32_t bins[RADIO_STATS_HIST_BINS];
+} radio_stats_hist_t;
+typedef struct {
+  uint64_t tx_us;           /* TX command to IRQ_TX_DATA_SENT, CSMA included */
+  uint64_t rx_us;           /* IRQ_VALID_SYNC to IRQ_RX_DATA_READY */
+  uint32_t tx_frames;
+  uint32_t rx_frames;
+  uint32_t irqs;            /* calls of Radio_interrupt_callback */
+  uint32_t irqs_deferred;   /* of which left to the radio process: SPI busy */
+  uint32_t wait_timeouts;   /* busy waits that ran out of time */
+  uint32_t spi_transactions;
+  uint64_t spi_bytes;       /* header bytes included */
+  uint32_t drops[RADIO_DROP_REASONS];
+  radio_stats_hist_t hist[RADIO_STATS_HISTS];
+} radio_stats_t;
+/* get_object() parameter: a radio_stats_t */
+#define RADIO_PARAM_DRIVER_STATS    (RADIO_CONST_MAX_PAYLOAD_LEN + 0x40)
+int radio_get_stats(radio_stats_t *stats);
+void radio_reset_stats(void);
+/*---------------------------------------------------------------------------*/
 #if (defined S2868A1) || (defined S2868A2)
   #define USE_RADIO_868MHz
 #elif defined(S2915A1)
@@ -105,15 +223,27 @@ void Radio_interrupt_callback(void);
 #define SYNC_LENGTH                 SYNC_BYTE(4)
 #define SYNC_WORD                   0x88888888
 #define VARIABLE_LENGTH             S_ENABLE
+#if RADIO_FIFO_STREAMING
+/* 2 bytes length field, and a CRC fit for frames of up to 2047 bytes */
+#define EXTENDED_LENGTH_FIELD       S_ENABLE
+#define LENGTH_FIELD_BYTES          2
+#define CRC_MODE                    PKT_CRC_MODE_16BITS_2
+#define CRC_BYTES                   2
+#else /*!RADIO_FIFO_STREAMING*/
 #define EXTENDED_LENGTH_FIELD       S_DISABLE
+#define LENGTH_FIELD_BYTES          1
 #define CRC_MODE                    PKT_CRC_MODE_8BITS
+#define CRC_BYTES                   1
+#endif /*RADIO_FIFO_STREAMING*/
 #define EN_FEC                      S_DISABLE
 #define EN_WHITENING                S_ENABLE
 
 #if RADIO_ADDRESS_FILTERING
 #define EN_ADDRESS                  S_ENABLE
+#define ADDRESS_BYTES               1
 #else /*!RADIO_ADDRESS_FILTERING*/
 #define EN_ADDRESS                  S_DISABLE
+#define ADDRESS_BYTES               0
 #endif /*RADIO_ADDRESS_FILTERING*/
 
 /*  Addresses configuration parameters  */
@@ -129,17 +259,91 @@ void Radio_interrupt_callback(void);
 #if RADIO_SNIFF_MODE
 #define MIN_PERIOD_WAKEUP_MS ((8000*((PREAMBLE_LENGTH/4)-2))/DATARATE)
 #define RX_TIMEOUT_MS        30
+/* Preamble (bit pairs) lasting a sniff period, plus 4 bytes for the carrier
+ * sense; the PREAMBLE_LENGTH field is 10 bits wide */
+#define RADIO_WAKEUP_PREAMBLE(ms)  (4*((((ms)*DATARATE)+7999)/8000+4))
+#define RADIO_SNIFF_PERIOD_MAX_MS  ((8000*((1023/4)-4))/DATARATE)
 #endif /*RADIO_SNIFF_MODE*/
 
+#if RADIO_ENERGY_SCAN
+/* Running RSSI sample period of the energy scan, and samples per channel */
+#ifndef RADIO_SCAN_SAMPLE_US
+#define RADIO_SCAN_SAMPLE_US        1000
+#endif /*RADIO_SCAN_SAMPLE_US*/
+#ifndef RADIO_SCAN_DWELL_SAMPLES
+#define RADIO_SCAN_DWELL_SAMPLES    100
+#endif /*RADIO_SCAN_DWELL_SAMPLES*/
+#endif /*RADIO_ENERGY_SCAN*/
+
+#if RADIO_ADAPTIVE_CCA
+/* Noise floor sample period, and samples whose minimum updates the floor */
+#ifndef RADIO_CCA_SAMPLE_MS
+#define RADIO_CCA_SAMPLE_MS         1000
+#endif /*RADIO_CCA_SAMPLE_MS*/
+#ifndef RADIO_CCA_WINDOW
+#define RADIO_CCA_WINDOW            8
+#endif /*RADIO_CCA_WINDOW*/
+/* CCA threshold above the noise floor, and transmissions between two checks
+ * of the busy and no ACK rates */
+#ifndef RADIO_CCA_MARGIN_DB
+#define RADIO_CCA_MARGIN_DB         12
+#endif /*RADIO_CCA_MARGIN_DB*/
+#ifndef RADIO_CCA_ADAPT_TX
+#define RADIO_CCA_ADAPT_TX          16
+#endif /*RADIO_CCA_ADAPT_TX*/
+#endif /*RADIO_ADAPTIVE_CCA*/
+
+#if RADIO_HW_ACK
+/* Retransmissions of a frame left without ACK by the packet handler (0..15) */
+#ifndef RADIO_HW_ACK_RETX
+#define RADIO_HW_ACK_RETX           3
+#endif /*RADIO_HW_ACK_RETX*/
+#define LLP_CONTROL_BYTES           1
+#else /*!RADIO_HW_ACK*/
+#define LLP_CONTROL_BYTES           0
+#endif /*RADIO_HW_ACK*/
+
+/*  Timing of the radio at DATARATE (RADIO_CONST_*), in us. The transitions
+ *  are the S2-LP ones: XO start up from STANDBY, and synthesizer lock with
+ *  the VCO calibration, unless RADIO_HOPPING has stored its words. The SPI
+ *  ones are those of the driver calls, at the 8 MHz of the NUCLEO boards. */
+#define RADIO_XO_SETUP_US           40
+#if RADIO_HOPPING
+#define RADIO_SYNTH_SETUP_US        40
+#else /*!RADIO_HOPPING*/
+#define RADIO_SYNTH_SETUP_US        60
+#endif /*RADIO_HOPPING*/
+#define RADIO_TX_CALL_US            25    /* transmit() up to the TX command */
+#define RADIO_RX_CALL_US            75    /* on() up to the RX command */
+#define RADIO_POLL_CALL_US          20    /* one read of the IRQ status */
+
+#define RADIO_BYTE_AIR_TIME_US      ((8000000 + DATARATE / 2) / DATARATE)
+#define RADIO_SHR_BYTES             ((PREAMBLE_LENGTH / 4) + (SYNC_LENGTH / 8))
+/* Bytes the radio adds to the MAC frame, beside the SHR */
+#define RADIO_PHY_OVERHEAD_BYTES    (LENGTH_FIELD_BYTES + ADDRESS_BYTES + \
+                                     LLP_CONTROL_BYTES + CRC_BYTES)
+/* From transmit() to the end of the sync word on air */
+#define RADIO_DELAY_BEFORE_TX_US    (RADIO_TX_CALL_US + RADIO_SYNTH_SETUP_US + \
+                                     (8000000UL * RADIO_SHR_BYTES) / DATARATE)
+/* From on() to the radio listening */
+#define RADIO_DELAY_BEFORE_RX_US    (RADIO_RX_CALL_US + RADIO_XO_SETUP_US + RADIO_SYNTH_SETUP_US)
+/* From the end of the sync word to receiving_packet() returning 1 (poll mode) */
+#define RADIO_DELAY_BEFORE_DETECT_US RADIO_POLL_CALL_US
+
 /**
  * The MAX_PACKET_LEN is the max allowed len for the packet.
- * If it is more than S2LP_RX_FIFO_SIZE it will be handled with FIFO thresholds.
+ * If it is more than S2LP_RX_FIFO_SIZE it will be handled with FIFO thresholds
+ * (RADIO_FIFO_STREAMING), up to the 2047 bytes of an IEEE 802.15.4g PSDU.
  * The RADIO supports with its packet handler a length of 65,535 bytes,
  * and in direct mode (without packet handler) there is no limit of data.
  * At system level, the max len is set in PACKETBUF_SIZE, so we se it
  * with PACKETBUF_CONF_SIZE = MAX_PACKET_LEN in contiki-conf.h
  */
+#if RADIO_FIFO_STREAMING
+#define MAX_PACKET_LEN              2047
+#else /*!RADIO_FIFO_STREAMING*/
 #define MAX_PACKET_LEN              S2LP_RX_FIFO_SIZE
+#endif /*RADIO_FIFO_STREAMING*/
 
 /*---------------------------------------------------------------------------*/
 #endif /* RADIO_DRIVER_H__ */
@@ -35,7 +35,8 @@ extern "C" {
 #include "RTE_Components.h"
 
 /* Global configuration ---------------------------------------------------*/
-extern volatile int irq_disable_cnt;
+#define S2915A1_USE_SPI_DMA                              USE_BSP_SPI1_DMA
+extern volatile int S2915A1_irq_disable_cnt;
 
 /* Defines ---------------------------------------------------------------*/
 
@@ -43,14 +44,14 @@ extern volatile int irq_disable_cnt;
 #define S2915A1_RADIO_GPIO_0_IT_PRIO                         1
 #define S2915A1_ENTER_CRITICAL()                            \
    do{                                                                \
-     irq_disable_cnt++;                                               \
+     S2915A1_irq_disable_cnt++;                                       \
      HAL_NVIC_DisableIRQ( S2915A1_RADIO_GPIO_0_IRQn);        \
    }while(0)
 #define S2915A1_EXIT_CRITICAL()                             \
    do{                                                                \
-     if (irq_disable_cnt > 0)                                         \
-       irq_disable_cnt--;                                             \
-     if (irq_disable_cnt==0)                                          \
+     if (S2915A1_irq_disable_cnt > 0)                                 \
+       S2915A1_irq_disable_cnt--;                                     \
+     if (S2915A1_irq_disable_cnt==0)                                  \
        HAL_NVIC_EnableIRQ( S2915A1_RADIO_GPIO_0_IRQn);       \
    }while(0)
 #endif
@@ -58,14 +59,14 @@ extern volatile int irq_disable_cnt;
 #define S2915A1_RADIO_GPIO_1_IT_PRIO                         1
 #define S2915A1_ENTER_CRITICAL()                            \
    do{                                                                \
-     irq_disable_cnt++;                                               \
+     S2915A1_irq_disable_cnt++;                                       \
      HAL_NVIC_DisableIRQ( S2915A1_RADIO_GPIO_1_IRQn);        \
    }while(0)
 #define S2915A1_EXIT_CRITICAL()                             \
    do{                                                                \
-     if (irq_disable_cnt > 0)                                         \
-       irq_disable_cnt--;                                             \
-     if (irq_disable_cnt==0)                                          \
+     if (S2915A1_irq_disable_cnt > 0)                                 \
+       S2915A1_irq_disable_cnt--;                                     \
+     if (S2915A1_irq_disable_cnt==0)                                  \
        HAL_NVIC_EnableIRQ( S2915A1_RADIO_GPIO_1_IRQn);       \
    }while(0)
 #endif
@@ -73,14 +74,14 @@ extern volatile int irq_disable_cnt;
 #define S2915A1_RADIO_GPIO_2_IT_PRIO                         1
 #define S2915A1_ENTER_CRITICAL()                            \
    do{                                                                \
-     irq_disable_cnt++;                                               \
+     S2915A1_irq_disable_cnt++;                                       \
      HAL_NVIC_DisableIRQ( S2915A1_RADIO_GPIO_2_IRQn);        \
    }while(0)
 #define S2915A1_EXIT_CRITICAL()                             \
    do{                                                                \
-     if (irq_disable_cnt > 0)                                         \
-       irq_disable_cnt--;                                             \
-     if (irq_disable_cnt==0)                                          \
+     if (S2915A1_irq_disable_cnt > 0)                                 \
+       S2915A1_irq_disable_cnt--;                                     \
+     if (S2915A1_irq_disable_cnt==0)                                  \
        HAL_NVIC_EnableIRQ( S2915A1_RADIO_GPIO_2_IRQn);       \
    }while(0)
 #endif
@@ -88,14 +89,14 @@ extern volatile int irq_disable_cnt;
 #define S2915A1_RADIO_GPIO_3_IT_PRIO                         1
 #define S2915A1_ENTER_CRITICAL()                            \
    do{                                                                \
-     irq_disable_cnt++;                                               \
+     S2915A1_irq_disable_cnt++;                                       \
      HAL_NVIC_DisableIRQ( S2915A1_RADIO_GPIO_3_IRQn);        \
    }while(0)
 #define S2915A1_EXIT_CRITICAL()                             \
    do{                                                                \
-     if (irq_disable_cnt > 0)                                         \
-       irq_disable_cnt--;                                             \
-     if (irq_disable_cnt==0)                                          \
+     if (S2915A1_irq_disable_cnt > 0)                                 \
+       S2915A1_irq_disable_cnt--;                                     \
+     if (S2915A1_irq_disable_cnt==0)                                  \
        HAL_NVIC_EnableIRQ( S2915A1_RADIO_GPIO_3_IRQn);       \
    }while(0)
 #endif
@@ -103,6 +104,7 @@ extern volatile int irq_disable_cnt;
 #define S2915A1_SPI_Init                                    BSP_SPI1_Init
 #define S2915A1_SPI_DeInit                                  BSP_SPI1_DeInit
 #define S2915A1_SPI_SendRecv                                BSP_SPI1_SendRecv
+#define S2915A1_SPI_SendRecv_DMA                            BSP_SPI1_SendRecv_DMA
 #define EEPROM_SPI_SendRecv                                           BSP_SPI1_SendRecv
 #define S2915A1_Delay                                       HAL_Delay
 #define hspi                                                          hspi1
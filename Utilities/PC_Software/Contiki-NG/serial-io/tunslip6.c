@@ -71,6 +71,8 @@ int slipfd = 0;
 uint16_t basedelay=0,delaymsec=0;
 uint32_t startsec,startmsec,delaystartsec,delaystartmsec;
 int timestamp = 0, flowcontrol=0, showprogress=0, flowcontrol_xonxoff=0;
+/* Baudrate asked to the border router with "?B", 0 when none pending */
+int baud_request = 0;
 
 int ssystem(const char *fmt, ...)
      __attribute__((__format__ (__printf__, 1, 2)));
@@ -172,176 +174,207 @@ is_sensible_string(const unsigned char *s, int len)
   return 1;
 }
 
+void stty_speed(int fd, speed_t speed);
+
 /*
- * Read from serial, when we have a packet write it to tun. No output
- * buffering, input buffered by stdio.
+ * Handle a frame received from the serial line: configuration messages,
+ * debug output or packet for tun.
  */
 void
-serial_to_tun(FILE *inslip, int outfd)
+slip_packet(int outfd, unsigned char *inbuf, int len)
 {
-  static union {
-    unsigned char inbuf[2000];
-  } uip;
-  static int inbufptr = 0;
-  int ret,i;
-  unsigned char c;
-
-#ifdef linux
-  ret = fread(&c, 1, 1, inslip);
-  if(ret == -1 || ret == 0) err(1, "serial_to_tun: read");
-  goto after_fread;
-#endif
+  int i;
 
- read_more:
-  if(inbufptr >= sizeof(uip.inbuf)) {
-     if(timestamp) stamptime();
-     fprintf(stderr, "*** dropping large %d byte packet\n",inbufptr);
-	 inbufptr = 0;
-  }
-  ret = fread(&c, 1, 1, inslip);
-#ifdef linux
- after_fread:
-#endif
-  if(ret == -1) {
-    err(1, "serial_to_tun: read");
-  }
-  if(ret == 0) {
-    clearerr(inslip);
-    return;
-  }
-  PROGRESS(".");
-  switch(c) {
-  case SLIP_END:
-    if(inbufptr > 0) {
-      if(uip.inbuf[0] == '!') {
-	if(uip.inbuf[1] == 'M') {
-	  /* Read gateway MAC address and autoconfigure tap0 interface */
-	  char macs[24];
-	  int i, pos;
-	  for(i = 0, pos = 0; i < 16; i++) {
-	    macs[pos++] = uip.inbuf[2 + i];
-	    if((i & 1) == 1 && i < 14) {
-	      macs[pos++] = ':';
-	    }
-	  }
-          if(timestamp) stamptime();
-	  macs[pos] = '\0';
-//	  printf("*** Gateway's MAC address: %s\n", macs);
-	  fprintf(stderr,"*** Gateway's MAC address: %s\n", macs);
-          if (timestamp) stamptime();
-	  ssystem("ifconfig %s down", tundev);
-          if (timestamp) stamptime();
-	  ssystem("ifconfig %s hw ether %s", tundev, &macs[6]);
-          if (timestamp) stamptime();
-	  ssystem("ifconfig %s up", tundev);
-	}
-      } else if(uip.inbuf[0] == '?') {
-	if(uip.inbuf[1] == 'P') {
-          /* Prefix info requested */
-          struct in6_addr addr;
-	  int i;
-	  char *s = strchr(ipaddr, '/');
-	  if(s != NULL) {
-	    *s = '\0';
-	  }
-          inet_pton(AF_INET6, ipaddr, &addr);
-          if(timestamp) stamptime();
-          fprintf(stderr,"*** Address:%s => %02x%02x:%02x%02x:%02x%02x:%02x%02x\n",
-		 ipaddr,
-		 addr.s6_addr[0], addr.s6_addr[1],
-		 addr.s6_addr[2], addr.s6_addr[3],
-		 addr.s6_addr[4], addr.s6_addr[5],
-		 addr.s6_addr[6], addr.s6_addr[7]);
-	  slip_send(slipfd, '!');
-	  slip_send(slipfd, 'P');
-	  for(i = 0; i < 8; i++) {
-	    /* need to call the slip_send_char for stuffing */
-	    slip_send_char(slipfd, addr.s6_addr[i]);
-	  }
-	  slip_send(slipfd, SLIP_END);
-        }
-#define DEBUG_LINE_MARKER '\r'
-      } else if(uip.inbuf[0] == DEBUG_LINE_MARKER) {
-	fwrite(uip.inbuf + 1, inbufptr - 1, 1, stdout);
-      } else if(is_sensible_string(uip.inbuf, inbufptr)) {
-        if(verbose==1) {   /* strings already echoed below for verbose>1 */
-          if (timestamp) stamptime();
-          fwrite(uip.inbuf, inbufptr, 1, stdout);
+  if(inbuf[0] == '!') {
+    if(inbuf[1] == 'M') {
+      /* Read gateway MAC address and autoconfigure tap0 interface */
+      char macs[24];
+      int i, pos;
+      for(i = 0, pos = 0; i < 16; i++) {
+        macs[pos++] = inbuf[2 + i];
+        if((i & 1) == 1 && i < 14) {
+          macs[pos++] = ':';
         }
+      }
+      if(timestamp) stamptime();
+      macs[pos] = '\0';
+      fprintf(stderr,"*** Gateway's MAC address: %s\n", macs);
+      if (timestamp) stamptime();
+      ssystem("ifconfig %s down", tundev);
+      if (timestamp) stamptime();
+      ssystem("ifconfig %s hw ether %s", tundev, &macs[6]);
+      if (timestamp) stamptime();
+      ssystem("ifconfig %s up", tundev);
+    } else if(inbuf[1] == 'B' && baud_request) {
+      /* The border router switches once this answer is sent */
+      char rate[12];
+      int baudrate;
+      speed_t speed;
+      if(len - 2 >= sizeof(rate)) {
+        return;
+      }
+      memcpy(rate, inbuf + 2, len - 2);
+      rate[len - 2] = '\0';
+      baudrate = atoi(rate);
+      speed = select_baudrate(baudrate);
+      if(timestamp) stamptime();
+      if(speed == 0) {
+        fprintf(stderr, "*** Border router answered unknown baudrate %d\n", baudrate);
       } else {
-        if(verbose>2) {
-          if (timestamp) stamptime();
-          printf("Packet from SLIP of length %d - write TUN\n", inbufptr);
-          if (verbose>4) {
+        if(speed != b_rate) {
+          b_rate = speed;
+          stty_speed(slipfd, b_rate);
+        }
+        fprintf(stderr, "*** Baudrate: %d%s\n", baudrate,
+                baudrate != baud_request ? " (request refused)" : "");
+      }
+      baud_request = 0;
+    } else if(inbuf[1] == 'X') {
+      if(timestamp) stamptime();
+      fprintf(stderr, "*** XON/XOFF flow control enabled on the border router\n");
+    }
+  } else if(inbuf[0] == '?') {
+    if(inbuf[1] == 'P') {
+      /* Prefix info requested */
+      struct in6_addr addr;
+      int i;
+      char *s = strchr(ipaddr, '/');
+      if(s != NULL) {
+        *s = '\0';
+      }
+      inet_pton(AF_INET6, ipaddr, &addr);
+      if(timestamp) stamptime();
+      fprintf(stderr,"*** Address:%s => %02x%02x:%02x%02x:%02x%02x:%02x%02x\n",
+              ipaddr,
+              addr.s6_addr[0], addr.s6_addr[1],
+              addr.s6_addr[2], addr.s6_addr[3],
+              addr.s6_addr[4], addr.s6_addr[5],
+              addr.s6_addr[6], addr.s6_addr[7]);
+      slip_send(slipfd, '!');
+      slip_send(slipfd, 'P');
+      for(i = 0; i < 8; i++) {
+        /* need to call the slip_send_char for stuffing */
+        slip_send_char(slipfd, addr.s6_addr[i]);
+      }
+      slip_send(slipfd, SLIP_END);
+    }
+#define DEBUG_LINE_MARKER '\r'
+  } else if(inbuf[0] == DEBUG_LINE_MARKER) {
+    fwrite(inbuf + 1, len - 1, 1, stdout);
+  } else if(is_sensible_string(inbuf, len)) {
+    if(verbose==1) {   /* strings already echoed below for verbose>1 */
+      if (timestamp) stamptime();
+      fwrite(inbuf, len, 1, stdout);
+    }
+  } else {
+    if(verbose>2) {
+      if (timestamp) stamptime();
+      printf("Packet from SLIP of length %d - write TUN\n", len);
+      if (verbose>4) {
 #if WIRESHARK_IMPORT_FORMAT
-            printf("0000");
-	        for(i = 0; i < inbufptr; i++) printf(" %02x",uip.inbuf[i]);
+        printf("0000");
+        for(i = 0; i < len; i++) printf(" %02x", inbuf[i]);
 #else
-            printf("         ");
-            for(i = 0; i < inbufptr; i++) {
-              printf("%02x", uip.inbuf[i]);
-              if((i & 3) == 3) printf(" ");
-              if((i & 15) == 15) printf("\n         ");
-            }
-#endif
-            printf("\n");
-          }
+        printf("         ");
+        for(i = 0; i < len; i++) {
+          printf("%02x", inbuf[i]);
+          if((i & 3) == 3) printf(" ");
+          if((i & 15) == 15) printf("\n         ");
         }
-	if(write(outfd, uip.inbuf, inbufptr) != inbufptr) {
-	  err(1, "serial_to_tun: write");
-	}
+#endif
+        printf("\n");
       }
-      inbufptr = 0;
     }
-    break;
+    if(write(outfd, inbuf, len) != len) {
+      err(1, "serial_to_tun: write");
+    }
+  }
+}
 
-  case SLIP_ESC:
-    if(fread(&c, 1, 1, inslip) != 1) {
-      clearerr(inslip);
-      /* Put ESC back and give up! */
-      ungetc(SLIP_ESC, inslip);
+/*
+ * Read from serial, when we have a packet write it to tun. The serial
+ * line is read by blocks: at high baudrates a read per byte does not
+ * keep up.
+ */
+void
+serial_to_tun(int infd, int outfd)
+{
+  static unsigned char inbuf[2000];
+  static int inbufptr = 0;
+  static int esc = 0;
+  unsigned char rbuf[4096];
+  int ret, n;
+  unsigned char c;
+
+  ret = read(infd, rbuf, sizeof(rbuf));
+  if(ret == -1) {
+    if(errno == EAGAIN || errno == EINTR) {
       return;
     }
+    err(1, "serial_to_tun: read");
+  }
+  if(ret == 0) {
+#ifdef linux
+    /* select() said readable: the device is gone */
+    err(1, "serial_to_tun: read");
+#endif
+    return;
+  }
 
-    switch(c) {
-    case SLIP_ESC_END:
-      c = SLIP_END;
-      break;
-    case SLIP_ESC_ESC:
-      c = SLIP_ESC;
-      break;
-    case SLIP_ESC_XON:
-      c = XON;
-      break;
-    case SLIP_ESC_XOFF:
-      c = XOFF;
-      break;
+  for(n = 0; n < ret; n++) {
+    c = rbuf[n];
+    PROGRESS(".");
+    if(inbufptr >= sizeof(inbuf)) {
+      if(timestamp) stamptime();
+      fprintf(stderr, "*** dropping large %d byte packet\n", inbufptr);
+      inbufptr = 0;
+    }
+    if(esc) {
+      esc = 0;
+      switch(c) {
+      case SLIP_ESC_END:
+        c = SLIP_END;
+        break;
+      case SLIP_ESC_ESC:
+        c = SLIP_ESC;
+        break;
+      case SLIP_ESC_XON:
+        c = XON;
+        break;
+      case SLIP_ESC_XOFF:
+        c = XOFF;
+        break;
+      }
+    } else if(c == SLIP_ESC) {
+      esc = 1;
+      continue;
+    } else if(c == SLIP_END) {
+      if(inbufptr > 0) {
+        slip_packet(outfd, inbuf, inbufptr);
+        inbufptr = 0;
+      }
+      continue;
     }
-    /* FALLTHROUGH */
-  default:
-    uip.inbuf[inbufptr++] = c;
+
+    inbuf[inbufptr++] = c;
 
     /* Echo lines as they are received for verbose=2,3,5+ */
     /* Echo all printable characters for verbose==4 */
     if((verbose==2) || (verbose==3) || (verbose>4)) {
       if(c=='\n') {
-        if(is_sensible_string(uip.inbuf, inbufptr)) {
+        if(is_sensible_string(inbuf, inbufptr)) {
           if (timestamp) stamptime();
-          fwrite(uip.inbuf, inbufptr, 1, stdout);
+          fwrite(inbuf, inbufptr, 1, stdout);
           inbufptr=0;
         }
       }
     } else if(verbose==4) {
       if(c == 0 || c == '\r' || c == '\n' || c == '\t' || (c >= ' ' && c <= '~')) {
-	fwrite(&c, 1, 1, stdout);
+        fwrite(&c, 1, 1, stdout);
         if(c=='\n') if(timestamp) stamptime();
       }
     }
-
-    break;
   }
-
-  goto read_more;
 }
 
 unsigned char slip_buf[2000];
@@ -523,11 +556,13 @@ stty_telos(int fd)
     tty.c_cflag |= CRTSCTS;
   else
     tty.c_cflag &= ~CRTSCTS;
-  tty.c_iflag &= ~IXON;
+  /* With -X, XON/XOFF of the border router suspend our output and its
+     data bytes of the same value come escaped */
+  tty.c_iflag &= ~IXANY;
   if(flowcontrol_xonxoff) {
-    tty.c_iflag |= IXOFF | IXANY;
+    tty.c_iflag |= IXON | IXOFF;
   } else {
-    tty.c_iflag &= ~IXOFF & ~IXANY;
+    tty.c_iflag &= ~IXON & ~IXOFF;
   }
   tty.c_cflag &= ~HUPCL;
   tty.c_cflag &= ~CLOCAL;
@@ -554,6 +589,20 @@ stty_telos(int fd)
   if(tcflush(fd, TCIOFLUSH) == -1) err(1, "tcflush");
 }
 
+/*
+ * Change the baudrate once the output is sent.
+ */
+void
+stty_speed(int fd, speed_t speed)
+{
+  struct termios tty;
+
+  if(tcgetattr(fd, &tty) == -1) err(1, "tcgetattr");
+  cfsetispeed(&tty, speed);
+  cfsetospeed(&tty, speed);
+  if(tcsetattr(fd, TCSADRAIN, &tty) == -1) err(1, "tcsetattr");
+}
+
 int
 devopen(const char *dev, int flags)
 {
@@ -759,7 +808,8 @@ main(int argc, char **argv)
   int tunfd, maxfd;
   int ret;
   fd_set rset, wset;
-  FILE *inslip;
+  struct timeval tv, *timeout;
+  int baud_negotiate = 0;
   const char *siodev = NULL;
   const char *host = NULL;
   const char *port = NULL;
@@ -772,7 +822,7 @@ main(int argc, char **argv)
   prog = argv[0];
   setvbuf(stdout, NULL, _IOLBF, 0); /* Line buffered output. */
 
-  while((c = getopt(argc, argv, "B:HILPhXM:s:t:v::d::a:p:T")) != -1) {
+  while((c = getopt(argc, argv, "B:HILN:PhXM:s:t:v::d::a:p:T")) != -1) {
     switch(c) {
     case 'B':
       baudrate = atoi(optarg);
@@ -782,6 +832,13 @@ main(int argc, char **argv)
       flowcontrol=1;
       break;
 
+    case 'N':
+      baud_negotiate = atoi(optarg);
+      if(select_baudrate(baud_negotiate) == 0) {
+        err(1, "unknown baudrate %d", baud_negotiate);
+      }
+      break;
+
     case 'X':
       flowcontrol_xonxoff=1;
       break;
@@ -851,12 +908,14 @@ fprintf(stderr,"usage:  %s [options] ipaddress\n", prog);
 fprintf(stderr,"example: tunslip6 -L -v2 -s ttyUSB1 fd00::1/64\n");
 fprintf(stderr,"Options are:\n");
 #ifndef __APPLE__
-fprintf(stderr," -B baudrate    9600,19200,38400,57600,115200 (default),230400,460800,921600\n");
+fprintf(stderr," -B baudrate    9600,19200,38400,57600,115200 (default),230400,460800,921600,\n");
+fprintf(stderr,"                1000000,2000000\n");
 #else
 fprintf(stderr," -B baudrate    9600,19200,38400,57600,115200 (default),230400\n");
 #endif
 fprintf(stderr, " -P             Show progress\n");
 fprintf(stderr, " -H             Hardware CTS/RTS flow control (default disabled)\n");
+fprintf(stderr, " -N baudrate    Ask the border router to switch to baudrate, once started at -B\n");
 fprintf(stderr, " -I             Inquire IP address\n");
 fprintf(stderr, " -X             Software XON/XOFF flow control (default disabled)\n");
 fprintf(stderr, " -L             Log output format (adds time stamps)\n");
@@ -897,7 +956,7 @@ exit(1);
   argv += (optind - 1);
 
   if(argc != 2 && argc != 3) {
-    err(1, "usage: %s [-B baudrate] [-P] [-H] [-I] [-X] [-L] [-s siodev] [-M] [-T] [-t tundev] "
+    err(1, "usage: %s [-B baudrate] [-N baudrate] [-P] [-H] [-I] [-X] [-L] [-s siodev] [-M] [-T] [-t tundev] "
 #ifdef __APPLE__
            "[-v level] [-d basedelay] "
 #else
@@ -998,8 +1057,24 @@ exit(1);
     stty_telos(slipfd);
   }
   slip_send(slipfd, SLIP_END);
-  inslip = fdopen(slipfd, "r");
-  if(inslip == NULL) err(1, "main: fdopen");
+  if(flowcontrol_xonxoff) {
+    /* The border router escapes XON/XOFF and uses them from now on */
+    slip_send(slipfd, '?');
+    slip_send(slipfd, 'X');
+    slip_send(slipfd, SLIP_END);
+  }
+  if(baud_negotiate && host == NULL) {
+    char rate[12];
+    int i, len;
+    len = snprintf(rate, sizeof(rate), "%d", baud_negotiate);
+    slip_send(slipfd, '?');
+    slip_send(slipfd, 'B');
+    for(i = 0; i < len; i++) {
+      slip_send(slipfd, rate[i]);
+    }
+    slip_send(slipfd, SLIP_END);
+    baud_request = baud_negotiate;
+  }
 
   tunfd = tun_alloc(tundev, tap);
   if(tunfd == -1) err(1, "main: open /dev/tun");
@@ -1036,18 +1111,29 @@ exit(1);
     FD_SET(slipfd, &rset);	/* Read from slip ASAP! */
     if(slipfd > maxfd) maxfd = slipfd;
 
-    /* We only have one packet at a time queued for slip output. */
-    if(slip_empty()) {
+    /* We only have one packet at a time queued for slip output, none
+       while the baudrate changes. */
+    if(slip_empty() && !baud_request) {
       FD_SET(tunfd, &rset);
       if(tunfd > maxfd) maxfd = tunfd;
     }
 
-    ret = select(maxfd + 1, &rset, &wset, NULL, NULL);
+    timeout = NULL;
+    if(baud_request) {
+      tv.tv_sec = 1;
+      tv.tv_usec = 0;
+      timeout = &tv;
+    }
+    ret = select(maxfd + 1, &rset, &wset, NULL, timeout);
     if(ret == -1 && errno != EINTR) {
       err(1, "select");
+    } else if(ret == 0 && baud_request) {
+      if(timestamp) stamptime();
+      fprintf(stderr, "*** No answer to the baudrate request, staying at the -B one\n");
+      baud_request = 0;
     } else if(ret > 0) {
       if(FD_ISSET(slipfd, &rset)) {
-        serial_to_tun(inslip, tunfd);
+        serial_to_tun(slipfd, tunfd);
       }
 
       if(FD_ISSET(slipfd, &wset)) {
@@ -1066,7 +1152,7 @@ exit(1);
        if(dmsec>delaymsec) delaymsec=0;
       }
       if(delaymsec==0) {
-        if(slip_empty() && FD_ISSET(tunfd, &rset)) {
+        if(slip_empty() && !baud_request && FD_ISSET(tunfd, &rset)) {
           tun_to_serial(tunfd, slipfd);
           slip_flushbuf(slipfd);
           if(ipa_enable) sigalarm_reset();
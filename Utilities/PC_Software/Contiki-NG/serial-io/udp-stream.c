@@ -0,0 +1,262 @@
+/**
+  ******************************************************************************
+  * @file    udp-stream.c
+  * @author  SRA Application Team
+  * @brief   Throughput and loss test of the Border Router: sends a stream of
+  *          numbered UDP datagrams through the tun interface of tunslip6 to
+  *          a node echoing them (UDP_Server application) and reports the
+  *          echoes received, the loss, the throughput and the round trip time
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <errno.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define US_SERVER_PORT          "5678"  /* UDP_Server application */
+#define US_CLIENT_PORT          8765    /* where it sends the echoes */
+#define US_HEADER_LEN           12      /* sequence number and send time */
+#define US_MAX_LEN              1232    /* IPv6 minimum MTU less the headers */
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+  unsigned long lSent;
+  unsigned long lEchoed;
+  unsigned long lDuplicates;
+  unsigned long lReordered;
+  uint64_t      llRttSum;
+  uint64_t      llRttMin;
+  uint64_t      llRttMax;
+} StreamStats;
+
+/* Private variables ---------------------------------------------------------*/
+static uint8_t *pcSeen;
+static unsigned long lHighest;
+
+/* Private functions ---------------------------------------------------------*/
+static uint64_t now_us(void)
+{
+  struct timeval tv;
+
+  gettimeofday(&tv, NULL);
+  return (uint64_t) tv.tv_sec * 1000000u + (uint64_t) tv.tv_usec;
+}
+
+static void usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [options] address\n", prog);
+  fprintf(stderr, "example: %s -l 200 -r 20 -t 30 fd00::212:4b00:615:a5d3\n", prog);
+  fprintf(stderr, "Options are:\n");
+  fprintf(stderr, " -p port        UDP port of the echoing node (default %s)\n", US_SERVER_PORT);
+  fprintf(stderr, " -L port        Local UDP port, where the echoes come (default %d)\n", US_CLIENT_PORT);
+  fprintf(stderr, " -l length      Payload length, %d to %d bytes (default 64)\n", US_HEADER_LEN, US_MAX_LEN);
+  fprintf(stderr, " -r rate        Datagrams per second (default 10)\n");
+  fprintf(stderr, " -t seconds     Duration of the stream (default 10)\n");
+  fprintf(stderr, " -w ms          Wait for the last echoes (default 2000)\n");
+  fprintf(stderr, " -q             Only the summary, no report every second\n");
+  exit(1);
+}
+
+static void receive_echo(int nSock, unsigned nLength, StreamStats *pStats,
+                         unsigned long *plBytes)
+{
+  uint8_t acBuffer[US_MAX_LEN + 1];
+  unsigned long lSeq;
+  uint64_t llSent, llRtt;
+  ssize_t n;
+
+  while((n = recv(nSock, acBuffer, sizeof(acBuffer), MSG_DONTWAIT)) > 0) {
+    if(n != (ssize_t) nLength) {
+      continue;
+    }
+    memcpy(&lSeq, acBuffer, 4);
+    lSeq &= 0xFFFFFFFFu;
+    memcpy(&llSent, acBuffer + 4, 8);
+    if(lSeq >= pStats->lSent) {
+      continue;
+    }
+    if(pcSeen[lSeq]) {
+      pStats->lDuplicates++;
+      continue;
+    }
+    pcSeen[lSeq] = 1;
+    if(lSeq < lHighest) {
+      pStats->lReordered++;
+    } else {
+      lHighest = lSeq;
+    }
+    llRtt = now_us() - llSent;
+    pStats->lEchoed++;
+    pStats->llRttSum += llRtt;
+    if(llRtt < pStats->llRttMin) {
+      pStats->llRttMin = llRtt;
+    }
+    if(llRtt > pStats->llRttMax) {
+      pStats->llRttMax = llRtt;
+    }
+    *plBytes += (unsigned long) n;
+  }
+}
+
+/* Main ----------------------------------------------------------------------*/
+int main(int argc, char **argv)
+{
+  const char *pcPort = US_SERVER_PORT;
+  unsigned nLocalPort = US_CLIENT_PORT;
+  unsigned nLength = 64, nRate = 10, nSeconds = 10, nWaitMs = 2000;
+  int bQuiet = 0;
+  struct addrinfo xHints, *pxServer;
+  struct sockaddr_in6 xLocal;
+  StreamStats xStats;
+  uint8_t acPayload[US_MAX_LEN];
+  unsigned long lTotal, lTxBytes = 0, lRxBytes = 0, lLastTx = 0, lLastRx = 0;
+  unsigned long lLastSent = 0, lLastEchoed = 0;
+  uint64_t llStart, llNext, llReport, llEnd, llNow;
+  int nSock, c, rv;
+  unsigned i;
+
+  while((c = getopt(argc, argv, "p:L:l:r:t:w:q")) != -1) {
+    switch(c) {
+    case 'p': pcPort = optarg; break;
+    case 'L': nLocalPort = (unsigned) atoi(optarg); break;
+    case 'l': nLength = (unsigned) atoi(optarg); break;
+    case 'r': nRate = (unsigned) atoi(optarg); break;
+    case 't': nSeconds = (unsigned) atoi(optarg); break;
+    case 'w': nWaitMs = (unsigned) atoi(optarg); break;
+    case 'q': bQuiet = 1; break;
+    default: usage(argv[0]);
+    }
+  }
+  if(optind != argc - 1 || nLength < US_HEADER_LEN || nLength > US_MAX_LEN ||
+     nRate == 0 || nSeconds == 0) {
+    usage(argv[0]);
+  }
+
+  memset(&xHints, 0, sizeof(xHints));
+  xHints.ai_family = AF_INET6;
+  xHints.ai_socktype = SOCK_DGRAM;
+  if((rv = getaddrinfo(argv[optind], pcPort, &xHints, &pxServer)) != 0) {
+    fprintf(stderr, "%s: %s\n", argv[optind], gai_strerror(rv));
+    return 1;
+  }
+  nSock = socket(AF_INET6, SOCK_DGRAM, 0);
+  if(nSock < 0) {
+    perror("socket");
+    return 1;
+  }
+  memset(&xLocal, 0, sizeof(xLocal));
+  xLocal.sin6_family = AF_INET6;
+  xLocal.sin6_addr = in6addr_any;
+  xLocal.sin6_port = htons((uint16_t) nLocalPort);
+  if(bind(nSock, (struct sockaddr *) &xLocal, sizeof(xLocal)) < 0) {
+    perror("bind");
+    return 1;
+  }
+  if(connect(nSock, pxServer->ai_addr, pxServer->ai_addrlen) < 0) {
+    perror("connect");
+    return 1;
+  }
+  freeaddrinfo(pxServer);
+
+  lTotal = (unsigned long) nRate * nSeconds;
+  pcSeen = calloc(lTotal, 1);
+  if(pcSeen == NULL) {
+    perror("calloc");
+    return 1;
+  }
+  for(i = US_HEADER_LEN; i < nLength; i++) {
+    acPayload[i] = (uint8_t) i;
+  }
+  memset(&xStats, 0, sizeof(xStats));
+  xStats.llRttMin = UINT64_MAX;
+
+  if(!bQuiet) {
+    printf("time_s,sent,echoed,tx_kbps,rx_kbps\n");
+  }
+  llStart = now_us();
+  llNext = llStart;
+  llReport = llStart + 1000000u;
+  llEnd = llStart + (uint64_t) nSeconds * 1000000u;
+
+  for(;;) {
+    llNow = now_us();
+    if(xStats.lSent < lTotal && llNow >= llNext) {
+      uint32_t lSeq = (uint32_t) xStats.lSent;
+      memcpy(acPayload, &lSeq, 4);
+      memcpy(acPayload + 4, &llNow, 8);
+      if(send(nSock, acPayload, nLength, 0) == (ssize_t) nLength) {
+        lTxBytes += nLength;
+      } else if(errno != ENOBUFS && errno != EAGAIN && errno != ECONNREFUSED) {
+        perror("send");
+        return 1;
+      }
+      xStats.lSent++;
+      llNext = llStart + (uint64_t) xStats.lSent * 1000000u / nRate;
+      continue;
+    }
+    if(!bQuiet && llNow >= llReport) {
+      printf("%llu,%lu,%lu,%.1f,%.1f\n",
+             (unsigned long long) ((llReport - llStart) / 1000000u),
+             xStats.lSent - lLastSent, xStats.lEchoed - lLastEchoed,
+             (lTxBytes - lLastTx) * 8 / 1000.0, (lRxBytes - lLastRx) * 8 / 1000.0);
+      fflush(stdout);
+      lLastSent = xStats.lSent;
+      lLastEchoed = xStats.lEchoed;
+      lLastTx = lTxBytes;
+      lLastRx = lRxBytes;
+      llReport += 1000000u;
+    }
+    if(llNow >= llEnd + (uint64_t) nWaitMs * 1000u ||
+       (xStats.lSent == lTotal && xStats.lEchoed == lTotal)) {
+      break;
+    }
+    {
+      struct pollfd xPoll = { nSock, POLLIN, 0 };
+      uint64_t llWake = xStats.lSent < lTotal ? llNext : llEnd + (uint64_t) nWaitMs * 1000u;
+      int nTimeout;
+      if(!bQuiet && llReport < llWake) {
+        llWake = llReport;
+      }
+      nTimeout = llWake > llNow ? (int) ((llWake - llNow + 999u) / 1000u) : 0;
+      if(poll(&xPoll, 1, nTimeout) > 0) {
+        receive_echo(nSock, nLength, &xStats, &lRxBytes);
+      }
+    }
+  }
+
+  printf("sent %lu, echoed %lu, lost %lu (%.2f%%), duplicates %lu, reordered %lu\n",
+         xStats.lSent, xStats.lEchoed, xStats.lSent - xStats.lEchoed,
+         100.0 * (double) (xStats.lSent - xStats.lEchoed) / (double) xStats.lSent,
+         xStats.lDuplicates, xStats.lReordered);
+  printf("offered %.1f kbit/s, echoed %.1f kbit/s (payload)\n",
+         lTxBytes * 8 / 1000.0 / nSeconds, lRxBytes * 8 / 1000.0 / nSeconds);
+  if(xStats.lEchoed) {
+    printf("rtt min/avg/max %.1f/%.1f/%.1f ms\n",
+           xStats.llRttMin / 1000.0, (double) xStats.llRttSum / xStats.lEchoed / 1000.0,
+           xStats.llRttMax / 1000.0);
+  }
+  close(nSock);
+  free(pcSeen);
+  return xStats.lEchoed == xStats.lSent ? 0 : 2;
+}
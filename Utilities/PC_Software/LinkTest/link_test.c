@@ -0,0 +1,390 @@
+/**
+  ******************************************************************************
+  * @file    link_test.c
+  * @author  SRA Application Team
+  * @brief   PC controller of the P2P link tester (USE_P2P_LINKTEST): steps a
+  *          node through a sweep of PHY settings and frame lengths over its
+  *          virtual COM port and writes the results as CSV
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <termios.h>
+#include <unistd.h>
+
+/* Private define ------------------------------------------------------------*/
+#define LT_MAX_LIST             16
+#define LT_LINE_LEN             256
+#define LT_FRAME_OVERHEAD       16    /* as the firmware: bytes on air besides the payload */
+#define LT_REPLY_MS             2000
+#define LT_CSV_HEADER           "datarate,modulation,fdev,bandwidth,fec,whitening,length,sent,received," \
+                                "per_permille,goodput_bps,rssi_min,rssi_p10,rssi_p50,rssi_p90,rssi_max," \
+                                "lqi_min,lqi_avg,lqi_max,pings,echoes,rtt_min_us,rtt_avg_us,rtt_max_us," \
+                                "echo_rssi_avg,error"
+#define LT_EMPTY_RESULT         ",,,,,,,,,,,,,,,,,"   /* received to echo_rssi_avg */
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+  unsigned long lDatarate;
+  char          acModulation[12];
+  unsigned long lFreqDev;
+  unsigned long lBandwidth;
+  unsigned      nFec;
+  unsigned      nWhitening;
+  unsigned      nLength;
+  unsigned      nFrames;
+  unsigned      nPings;
+} LinkTest;
+
+/* Private variables ---------------------------------------------------------*/
+static int nFd = -1;
+static char acRxBuffer[LT_LINE_LEN];
+static size_t nRxFill;
+static int bVerbose;
+
+/* Private functions ---------------------------------------------------------*/
+static uint64_t NowMs(void)
+{
+  struct timeval xNow;
+
+  gettimeofday(&xNow, NULL);
+  return (uint64_t)xNow.tv_sec * 1000 + xNow.tv_usec / 1000;
+}
+
+static speed_t BaudConstant(unsigned long lBaud)
+{
+  switch(lBaud) {
+  case 9600:    return B9600;
+  case 19200:   return B19200;
+  case 38400:   return B38400;
+  case 57600:   return B57600;
+  case 115200:  return B115200;
+  case 230400:  return B230400;
+#ifdef B460800
+  case 460800:  return B460800;
+#endif
+#ifdef B921600
+  case 921600:  return B921600;
+#endif
+  default:      return 0;
+  }
+}
+
+static int SerialOpen(const char* pcDevice, unsigned long lBaud)
+{
+  struct termios xTio;
+  speed_t xSpeed = BaudConstant(lBaud);
+
+  if(xSpeed == 0) {
+    fprintf(stderr, "unsupported baud rate %lu\n", lBaud);
+    return -1;
+  }
+  nFd = open(pcDevice, O_RDWR | O_NOCTTY);
+  if(nFd < 0) {
+    fprintf(stderr, "%s: %s\n", pcDevice, strerror(errno));
+    return -1;
+  }
+  if(tcgetattr(nFd, &xTio) < 0) {
+    fprintf(stderr, "%s: %s\n", pcDevice, strerror(errno));
+    return -1;
+  }
+  cfmakeraw(&xTio);
+  xTio.c_cflag |= CLOCAL | CREAD;
+  xTio.c_cc[VMIN] = 0;
+  xTio.c_cc[VTIME] = 1;
+  cfsetispeed(&xTio, xSpeed);
+  cfsetospeed(&xTio, xSpeed);
+  if(tcsetattr(nFd, TCSANOW, &xTio) < 0) {
+    fprintf(stderr, "%s: %s\n", pcDevice, strerror(errno));
+    return -1;
+  }
+  return 0;
+}
+
+static int SerialWriteLine(const char* pcLine)
+{
+  size_t nLen = strlen(pcLine);
+
+  if(bVerbose) {
+    fprintf(stderr, "> %s", pcLine);
+  }
+  while(nLen > 0) {
+    ssize_t n = write(nFd, pcLine, nLen);
+    if(n < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    pcLine += n;
+    nLen -= n;
+  }
+  return 0;
+}
+
+/* Next line of the node, without its end of line. Returns 0 on timeout. */
+static int SerialReadLine(char* pcLine, size_t nSize, uint32_t lTimeoutMs)
+{
+  uint64_t lEnd = NowMs() + lTimeoutMs;
+
+  for(;;) {
+    char* pcEol = memchr(acRxBuffer, '\n', nRxFill);
+
+    if(pcEol != NULL) {
+      size_t nLen = pcEol - acRxBuffer;
+      size_t nCopy = nLen < nSize - 1 ? nLen : nSize - 1;
+
+      memcpy(pcLine, acRxBuffer, nCopy);
+      while(nCopy > 0 && pcLine[nCopy - 1] == '\r') {
+        nCopy--;
+      }
+      pcLine[nCopy] = '\0';
+      nRxFill -= nLen + 1;
+      memmove(acRxBuffer, pcEol + 1, nRxFill);
+      if(bVerbose) {
+        fprintf(stderr, "< %s\n", pcLine);
+      }
+      return 1;
+    }
+    if(nRxFill == sizeof(acRxBuffer)) {
+      /* No end of line in a full buffer: drop it */
+      nRxFill = 0;
+    }
+    if(NowMs() >= lEnd) {
+      return 0;
+    }
+    ssize_t n = read(nFd, acRxBuffer + nRxFill, sizeof(acRxBuffer) - nRxFill);
+    if(n < 0 && errno != EINTR && errno != EAGAIN) {
+      fprintf(stderr, "serial port: %s\n", strerror(errno));
+      exit(2);
+    }
+    if(n > 0) {
+      nRxFill += n;
+    }
+  }
+}
+
+/* Waits for a line starting with one of the prefixes; the other lines are skipped. */
+static int WaitReply(const char* pcPrefix, char* pcLine, size_t nSize, uint32_t lTimeoutMs)
+{
+  uint64_t lEnd = NowMs() + lTimeoutMs;
+  uint64_t lNow;
+
+  while((lNow = NowMs()) < lEnd) {
+    if(!SerialReadLine(pcLine, nSize, (uint32_t)(lEnd - lNow))) {
+      break;
+    }
+    if(strncmp(pcLine, pcPrefix, strlen(pcPrefix)) == 0 || strncmp(pcLine, "ERR", 3) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Longest time the firmware can take for a test: a generous bound of the
+ * frames on air, the CONFIG attempts and the report requests. */
+static uint32_t TestTimeoutMs(const LinkTest* pxTest)
+{
+  uint64_t lBits = ((uint64_t)pxTest->nLength + LT_FRAME_OVERHEAD) * 8 * (pxTest->nFec ? 2 : 1);
+  uint64_t lFrameMs = (lBits * 1000 + pxTest->lDatarate - 1) / pxTest->lDatarate;
+
+  return (uint32_t)(lFrameMs * (pxTest->nFrames + 4 * pxTest->nPings + 20) * 2 + 15000);
+}
+
+static void PrintConfig(const LinkTest* pxTest)
+{
+  printf("%lu,%s,%lu,%lu,%u,%u,%u,%u", pxTest->lDatarate, pxTest->acModulation, pxTest->lFreqDev,
+         pxTest->lBandwidth, pxTest->nFec, pxTest->nWhitening, pxTest->nLength, pxTest->nFrames);
+}
+
+static int RunTest(const LinkTest* pxTest)
+{
+  char acLine[LT_LINE_LEN];
+
+  snprintf(acLine, sizeof(acLine), "phy %lu %s %lu %lu %u %u\n", pxTest->lDatarate, pxTest->acModulation,
+           pxTest->lFreqDev, pxTest->lBandwidth, pxTest->nFec, pxTest->nWhitening);
+  SerialWriteLine(acLine);
+  if(!WaitReply("OK", acLine, sizeof(acLine), LT_REPLY_MS)) {
+    strcpy(acLine, "ERR no answer to phy");
+  }
+  if(strncmp(acLine, "OK", 2) == 0) {
+    snprintf(acLine, sizeof(acLine), "run %u %u %u\n", pxTest->nLength, pxTest->nFrames, pxTest->nPings);
+    SerialWriteLine(acLine);
+    if(!WaitReply("RESULT,", acLine, sizeof(acLine), TestTimeoutMs(pxTest))) {
+      strcpy(acLine, "ERR no answer to run");
+    }
+  }
+  if(strncmp(acLine, "RESULT,", 7) == 0) {
+    printf("%s,\n", acLine + 7);
+  }
+  else {
+    PrintConfig(pxTest);
+    printf(LT_EMPTY_RESULT ",%s\n", acLine + (strncmp(acLine, "ERR ", 4) == 0 ? 4 : 0));
+  }
+  fflush(stdout);
+  return strncmp(acLine, "RESULT,", 7) == 0;
+}
+
+static int ParseList(const char* pcArg, unsigned long* plValues)
+{
+  int n = 0;
+  char* pcEnd;
+
+  while(*pcArg && n < LT_MAX_LIST) {
+    plValues[n++] = strtoul(pcArg, &pcEnd, 10);
+    if(pcEnd == pcArg || (*pcEnd != ',' && *pcEnd != '\0')) {
+      return -1;
+    }
+    pcArg = *pcEnd ? pcEnd + 1 : pcEnd;
+  }
+  return n;
+}
+
+static int ParseNames(char* pcArg, char (*pacNames)[12])
+{
+  int n = 0;
+
+  for(char* pcName = strtok(pcArg, ","); pcName && n < LT_MAX_LIST; pcName = strtok(NULL, ",")) {
+    strncpy(pacNames[n], pcName, 11);
+    pacNames[n++][11] = '\0';
+  }
+  return n;
+}
+
+static void Usage(const char* pcName)
+{
+  fprintf(stderr,
+          "usage: %s -s <serial device> [-B baudrate] [-v]\n"
+          "         [-d datarates] [-m modulations] [-i modulation index %%] [-F fec]\n"
+          "         [-W whitening] [-l lengths] [-n frames] [-p pings]\n"
+          "       %s -s <serial device> [-B baudrate] [-v] -f <sweep file>\n"
+          "Lists are comma separated. Without a sweep file every combination of\n"
+          "datarate, modulation, FEC and length is tested, with\n"
+          "  fdev = index * datarate / 200 and bandwidth = datarate + 2 * fdev.\n"
+          "A sweep file has one test per line:\n"
+          "  datarate modulation fdev bandwidth fec whitening length frames pings\n"
+          "Modulations: 2FSK 4FSK 2GFSK05 2GFSK1 4GFSK05 4GFSK1 OOK.\n"
+          "The results are written to stdout as CSV.\n", pcName, pcName);
+  exit(1);
+}
+
+int main(int argc, char** argv)
+{
+  const char* pcDevice = NULL;
+  const char* pcSweep = NULL;
+  unsigned long lBaud = 115200;
+  unsigned long alDatarates[LT_MAX_LIST] = {38400};
+  char aacModulations[LT_MAX_LIST][12] = {"2FSK"};
+  unsigned long alFec[LT_MAX_LIST] = {0};
+  unsigned long alLengths[LT_MAX_LIST] = {20, 60, 120};
+  int nDatarates = 1, nModulations = 1, nFec = 1, nLengths = 3;
+  unsigned long lIndex = 100, lWhitening = 1, lFrames = 100, lPings = 10;
+  unsigned nTests = 0, nPassed = 0;
+  char acLine[LT_LINE_LEN];
+  int c;
+
+  while((c = getopt(argc, argv, "s:B:d:m:i:F:W:l:n:p:f:v")) != -1) {
+    switch(c) {
+    case 's': pcDevice = optarg; break;
+    case 'B': lBaud = strtoul(optarg, NULL, 10); break;
+    case 'd': nDatarates = ParseList(optarg, alDatarates); break;
+    case 'm': nModulations = ParseNames(optarg, aacModulations); break;
+    case 'i': lIndex = strtoul(optarg, NULL, 10); break;
+    case 'F': nFec = ParseList(optarg, alFec); break;
+    case 'W': lWhitening = strtoul(optarg, NULL, 10); break;
+    case 'l': nLengths = ParseList(optarg, alLengths); break;
+    case 'n': lFrames = strtoul(optarg, NULL, 10); break;
+    case 'p': lPings = strtoul(optarg, NULL, 10); break;
+    case 'f': pcSweep = optarg; break;
+    case 'v': bVerbose = 1; break;
+    default: Usage(argv[0]);
+    }
+  }
+  if(pcDevice == NULL || nDatarates <= 0 || nModulations <= 0 || nFec <= 0 || nLengths <= 0) {
+    Usage(argv[0]);
+  }
+  if(SerialOpen(pcDevice, lBaud) < 0) {
+    return 2;
+  }
+  /* End any partial line and drop what the node printed before */
+  SerialWriteLine("\n");
+  usleep(100000);
+  tcflush(nFd, TCIFLUSH);
+
+  printf("%s\n", LT_CSV_HEADER);
+  if(pcSweep != NULL) {
+    FILE* pxFile = fopen(pcSweep, "r");
+    unsigned nLine = 0;
+
+    if(pxFile == NULL) {
+      fprintf(stderr, "%s: %s\n", pcSweep, strerror(errno));
+      return 2;
+    }
+    while(fgets(acLine, sizeof(acLine), pxFile) != NULL) {
+      LinkTest xTest;
+
+      nLine++;
+      if(acLine[strspn(acLine, " \t\r\n")] == '\0' || acLine[strspn(acLine, " \t")] == '#') {
+        continue;
+      }
+      if(sscanf(acLine, "%lu %11s %lu %lu %u %u %u %u %u", &xTest.lDatarate, xTest.acModulation,
+                &xTest.lFreqDev, &xTest.lBandwidth, &xTest.nFec, &xTest.nWhitening, &xTest.nLength,
+                &xTest.nFrames, &xTest.nPings) != 9 || xTest.lDatarate == 0) {
+        fprintf(stderr, "%s:%u: syntax error\n", pcSweep, nLine);
+        continue;
+      }
+      nTests++;
+      nPassed += RunTest(&xTest);
+    }
+    fclose(pxFile);
+  }
+  else {
+    for(int d = 0; d < nDatarates; d++) {
+      for(int m = 0; m < nModulations; m++) {
+        for(int f = 0; f < nFec; f++) {
+          for(int l = 0; l < nLengths; l++) {
+            LinkTest xTest;
+
+            if(alDatarates[d] == 0) {
+              continue;
+            }
+            xTest.lDatarate = alDatarates[d];
+            memcpy(xTest.acModulation, aacModulations[m], sizeof(xTest.acModulation));
+            xTest.lFreqDev = alDatarates[d] * lIndex / 200;
+            xTest.lBandwidth = alDatarates[d] + 2 * xTest.lFreqDev;
+            xTest.nFec = alFec[f] != 0;
+            xTest.nWhitening = lWhitening != 0;
+            xTest.nLength = alLengths[l];
+            xTest.nFrames = lFrames;
+            xTest.nPings = lPings;
+            nTests++;
+            nPassed += RunTest(&xTest);
+          }
+        }
+      }
+    }
+  }
+  fprintf(stderr, "%u of %u tests completed\n", nPassed, nTests);
+  close(nFd);
+  return nPassed == nTests ? 0 : 1;
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,466 @@
+/**
+  ******************************************************************************
+  * @file    bsp_multi.c
+  * @author  SRA Application Team
+  * @brief   Links the S2868A1 and S2915A1 BSPs in one program, each board on
+  *          its own SPI bus, NSS and EXTI line (host/bsp/), and checks that
+  *          every S2LP_Object_t reaches its own radio, that each BSP masks
+  *          only its own IRQ line and that S2LP_SelectObject cannot be
+  *          interrupted by the IRQ of either radio
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "stm32f4xx_hal.h"
+#include "stm32f4xx_nucleo_bus.h"
+#include "stm32f4xx_nucleo_errno.h"
+#include "s2lp.h"
+
+/* Private define ------------------------------------------------------------*/
+#define BOARDS                  2
+#define EXTI_IRQN_BASE          6           /* EXTI0_IRQn */
+
+/* Private types -------------------------------------------------------------*/
+/* One radio: its wiring (host/bsp/<board>_conf.h) and a register file */
+typedef struct {
+  const char*   pcName;
+  GPIO_TypeDef* pxNssPort;
+  uint16_t      nNssPin;
+  IRQn_Type     xIrqn;
+  volatile int* pnIrqDisableCnt;
+  uint8_t       cStatus;                    /* MC_STATE byte it answers */
+  uint8_t       vectcRegs[256];
+  uint8_t       bHeader;                    /* Next byte clocked is the header */
+  uint8_t       cHeader, cAddress;
+  uint32_t      nTransfers;
+  uint32_t      nIrqs;
+  S2LP_Object_t xObject;
+} BoardRadio;
+
+/* Exported functions of the BSPs: their headers cannot share a file --------*/
+typedef void (GpioIrqHandler)(void);
+int32_t S2868A1_RADIO_Init(void);
+int32_t S2868A1_RADIO_IoIrqEnable(GpioIrqHandler **irqHanlder);
+int32_t S2915A1_RADIO_Init(void);
+int32_t S2915A1_RADIO_IoIrqEnable(GpioIrqHandler **irqHanlder);
+extern volatile int S2868A1_irq_disable_cnt;
+extern volatile int S2915A1_irq_disable_cnt;
+
+/* Private variables ---------------------------------------------------------*/
+GPIO_TypeDef xGpioA, xGpioB, xGpioC;
+
+static BoardRadio aBoard[BOARDS] = {
+  { "S2868A1", GPIOA, GPIO_PIN_1, EXTI0_IRQn, &S2868A1_irq_disable_cnt, 0x30 },
+  { "S2915A1", GPIOB, GPIO_PIN_6, EXTI1_IRQn, &S2915A1_irq_disable_cnt, 0x40 },
+};
+static uint8_t bBoardsReady;
+static uint32_t lNvicEnabled, lNvicPending;
+static uint32_t lPrimask, lIpsr;
+static void (*apfnExtiCallback[32])(void);
+static int nFailures;
+
+/* IRQ to raise from inside the next SPI transfer or critical section, -1 none */
+static int nRaiseInTransfer = -1;
+static int nRaiseInCritical = -1;
+static uint32_t lSelectPrimask;
+static uint8_t cSelectDepth;
+static S2LP_Object_t *pxSelecting;
+
+/* Private functions ---------------------------------------------------------*/
+static void Check(int bOk, const char *pcWhat)
+{
+  if(!bOk)
+  {
+    printf("FAIL %s\n", pcWhat);
+    nFailures++;
+  }
+}
+
+/**
+  * @brief  Runs the pending EXTI handlers the NVIC would take: enabled, not
+  *         masked by PRIMASK, and the CPU in thread mode (both lines have the
+  *         same priority and do not preempt each other).
+  */
+static void HostRunIrqs(void)
+{
+  uint32_t lIrqn;
+
+  for(lIrqn = 0; lIrqn < 32; lIrqn++)
+  {
+    uint32_t lBit = 1UL << lIrqn;
+
+    if((lNvicPending & lNvicEnabled & lBit) && !lPrimask && !lIpsr)
+    {
+      lNvicPending &= ~lBit;
+      lIpsr = lIrqn + 16;
+      apfnExtiCallback[lIrqn - EXTI_IRQN_BASE]();
+      lIpsr = 0;
+    }
+  }
+}
+
+static void HostRaiseIrq(IRQn_Type xIrqn)
+{
+  lNvicPending |= 1UL << xIrqn;
+  HostRunIrqs();
+}
+
+static uint8_t NssLow(const BoardRadio *pxBoard)
+{
+  return !(pxBoard->pxNssPort->ODR & pxBoard->nNssPin);
+}
+
+/**
+  * @brief  One transfer on the bus of board nBoard: its NSS is low, its IRQ
+  *         is masked and the other one's is not.
+  */
+static int32_t HostSpiSendRecv(int nBoard, uint8_t *pTxData, uint8_t *pRxData, uint16_t Length)
+{
+  BoardRadio *pxBoard = &aBoard[nBoard];
+  const BoardRadio *pxOther = &aBoard[1 - nBoard];
+  uint16_t i;
+
+  if(!bBoardsReady)
+  {
+    return BSP_ERROR_NONE;
+  }
+  pxBoard->nTransfers++;
+  Check(NssLow(pxBoard), "transfer without the NSS of its board");
+  Check(!(lNvicEnabled & (1UL << pxBoard->xIrqn)), "IRQ of the board not masked during its transfer");
+  Check(*pxOther->pnIrqDisableCnt != 0 || (lNvicEnabled & (1UL << pxOther->xIrqn)),
+        "IRQ of the other board masked by this transfer");
+  for(i = 0; i < Length; i++)
+  {
+    uint8_t cTx = pTxData[i];
+
+    if(pxBoard->bHeader == 2)
+    {
+      pxBoard->cHeader = cTx;
+      pRxData[i] = pxBoard->cStatus;
+      pxBoard->bHeader = 1;
+    }
+    else if(pxBoard->bHeader == 1)
+    {
+      pxBoard->cAddress = cTx;
+      pRxData[i] = 0x07;
+      pxBoard->bHeader = 0;
+    }
+    else if(pxBoard->cHeader == READ_HEADER)
+    {
+      pRxData[i] = pxBoard->vectcRegs[pxBoard->cAddress++];
+    }
+    else
+    {
+      pxBoard->vectcRegs[pxBoard->cAddress++] = cTx;
+      pRxData[i] = 0;
+    }
+  }
+  if(nRaiseInTransfer >= 0)
+  {
+    int nIrq = nRaiseInTransfer;
+
+    nRaiseInTransfer = -1;
+    HostRaiseIrq(aBoard[nIrq].xIrqn);
+  }
+  return BSP_ERROR_NONE;
+}
+
+/**
+  * @brief  The IRQ handler of a radio, as radio-driver.c does it: select its
+  *         object, read a register, give the previous object back.
+  */
+static void HostRadioIrq(int nBoard)
+{
+  BoardRadio *pxBoard = &aBoard[nBoard];
+  S2LP_Object_t *pxPrevious;
+  uint8_t cValue = 0;
+
+  pxBoard->nIrqs++;
+  Check(!NssLow(pxBoard), "radio IRQ in the middle of a transfer of its board");
+  pxPrevious = S2LP_SelectObject(&pxBoard->xObject);
+  if(pxSelecting != NULL)
+  {
+    Check(pxPrevious == pxSelecting, "radio IRQ in the middle of S2LP_SelectObject");
+  }
+  S2LP_ReadRegister(0x10, 1, &cValue);
+  Check(cValue == pxBoard->vectcRegs[0x10], "radio IRQ read another board");
+  S2LP_SelectObject(pxPrevious);
+}
+
+static void HostRadioIrqA(void)
+{
+  HostRadioIrq(0);
+}
+
+static void HostRadioIrqB(void)
+{
+  HostRadioIrq(1);
+}
+
+/**
+  * @brief  Critical section of S2LP_SelectObject, as radio-driver.c
+  *         registers it: every interrupt masked.
+  */
+static void HostSelectLock(void)
+{
+  uint32_t lPrevious = __get_PRIMASK();
+
+  __disable_irq();
+  if(cSelectDepth++ == 0)
+  {
+    lSelectPrimask = lPrevious;
+  }
+  if(nRaiseInCritical >= 0)
+  {
+    int nIrq = nRaiseInCritical;
+
+    nRaiseInCritical = -1;
+    HostRaiseIrq(aBoard[nIrq].xIrqn);
+  }
+}
+
+static void HostSelectUnlock(void)
+{
+  if(--cSelectDepth == 0)
+  {
+    __set_PRIMASK(lSelectPrimask);
+  }
+}
+
+/**
+  * @brief  Reads register 0x10 of the object selected and checks that the
+  *         value and the status come from board nBoard.
+  */
+static void CheckRead(int nBoard, const char *pcWhat)
+{
+  uint8_t cValue = 0;
+  StatusBytes xStatus = S2LP_ReadRegister(0x10, 1, &cValue);
+  uint32_t nTransfers = aBoard[nBoard].nTransfers;
+
+  Check(cValue == aBoard[nBoard].vectcRegs[0x10], pcWhat);
+  Check(((uint8_t *)&xStatus)[1] == aBoard[nBoard].cStatus, pcWhat);
+  Check(nTransfers != 0, pcWhat);
+}
+
+/* HAL and BSP bus of the host -----------------------------------------------*/
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init)
+{
+  if(GPIO_Init->Mode == GPIO_MODE_OUTPUT_PP)
+  {
+    GPIOx->OUT |= (uint16_t)GPIO_Init->Pin;
+  }
+}
+
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin)
+{
+  GPIOx->OUT &= (uint16_t)~GPIO_Pin;
+}
+
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  return (GPIOx->ODR & GPIO_Pin) ? GPIO_PIN_SET : GPIO_PIN_RESET;
+}
+
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState)
+{
+  int i;
+
+  if(PinState == GPIO_PIN_SET)
+  {
+    GPIOx->ODR |= GPIO_Pin;
+  }
+  else
+  {
+    GPIOx->ODR &= (uint16_t)~GPIO_Pin;
+  }
+  for(i = 0; i < BOARDS; i++)
+  {
+    if(GPIOx == aBoard[i].pxNssPort && (GPIO_Pin & aBoard[i].nNssPin))
+    {
+      aBoard[i].bHeader = 2;
+    }
+  }
+}
+
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin)
+{
+  GPIOx->ODR ^= GPIO_Pin;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  UNUSED(IRQn);
+  UNUSED(PreemptPriority);
+  UNUSED(SubPriority);
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+  lNvicEnabled |= 1UL << IRQn;
+  HostRunIrqs();
+}
+
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+  lNvicEnabled &= ~(1UL << IRQn);
+}
+
+HAL_StatusTypeDef HAL_EXTI_GetHandle(EXTI_HandleTypeDef *hexti, uint32_t ExtiLine)
+{
+  hexti->Line = ExtiLine;
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_EXTI_RegisterCallback(EXTI_HandleTypeDef *hexti, EXTI_CallbackIDTypeDef CallbackID,
+                                            void (*pPendingCbfn)(void))
+{
+  UNUSED(CallbackID);
+  hexti->PendingCallback = pPendingCbfn;
+  apfnExtiCallback[hexti->Line & 0x1FU] = pPendingCbfn;
+  return HAL_OK;
+}
+
+uint32_t __get_IPSR(void)
+{
+  return lIpsr;
+}
+
+uint32_t __get_PRIMASK(void)
+{
+  return lPrimask;
+}
+
+void __set_PRIMASK(uint32_t priMask)
+{
+  lPrimask = priMask & 1U;
+  HostRunIrqs();
+}
+
+void __disable_irq(void)
+{
+  lPrimask = 1;
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+  UNUSED(Delay);
+}
+
+int32_t BSP_SPI1_Init(void)
+{
+  return BSP_ERROR_NONE;
+}
+
+int32_t BSP_SPI1_DeInit(void)
+{
+  return BSP_ERROR_NONE;
+}
+
+int32_t BSP_SPI1_SendRecv(uint8_t *pTxData, uint8_t *pRxData, uint16_t Length)
+{
+  return HostSpiSendRecv(0, pTxData, pRxData, Length);
+}
+
+int32_t BSP_SPI2_Init(void)
+{
+  return BSP_ERROR_NONE;
+}
+
+int32_t BSP_SPI2_DeInit(void)
+{
+  return BSP_ERROR_NONE;
+}
+
+int32_t BSP_SPI2_SendRecv(uint8_t *pTxData, uint8_t *pRxData, uint16_t Length)
+{
+  return HostSpiSendRecv(1, pTxData, pRxData, Length);
+}
+
+/* Main ----------------------------------------------------------------------*/
+int main(void)
+{
+  static GpioIrqHandler *apfnIrqA[] = { HostRadioIrqA };
+  static GpioIrqHandler *apfnIrqB[] = { HostRadioIrqB };
+  uint8_t aData[40];
+  int i;
+
+  for(i = 0; i < BOARDS; i++)
+  {
+    memset(aBoard[i].vectcRegs, 0xA0 + i, sizeof(aBoard[i].vectcRegs));
+    aBoard[i].bHeader = 2;
+  }
+  S2LP_RegisterCriticalSection(HostSelectLock, HostSelectUnlock);
+
+  /* Each BSP registers its bus on the object selected when it starts */
+  S2LP_SelectObject(&aBoard[0].xObject);
+  S2868A1_RADIO_Init();
+  S2868A1_RADIO_IoIrqEnable(apfnIrqA);
+  S2LP_SelectObject(&aBoard[1].xObject);
+  S2915A1_RADIO_Init();
+  S2915A1_RADIO_IoIrqEnable(apfnIrqB);
+  bBoardsReady = 1;
+
+  /* Every object reaches its own board */
+  S2LP_SelectObject(&aBoard[0].xObject);
+  CheckRead(0, "S2868A1 object read");
+  memset(aData, 0x5A, sizeof(aData));
+  S2LP_WriteRegister(0x20, sizeof(aData), aData);
+  Check(aBoard[0].vectcRegs[0x20] == 0x5A && aBoard[1].vectcRegs[0x20] == 0xA1, "S2868A1 object write");
+  S2LP_SelectObject(&aBoard[1].xObject);
+  CheckRead(1, "S2915A1 object read");
+  memset(aData, 0x5A, sizeof(aData));
+  S2LP_WriteRegister(0x60, 1, aData);
+  Check(aBoard[1].vectcRegs[0x60] == 0x5A && aBoard[0].vectcRegs[0x60] == 0xA0, "S2915A1 object write");
+
+  /* The IRQ of the other board preempts a transfer, the board's own waits */
+  S2LP_SelectObject(&aBoard[0].xObject);
+  nRaiseInTransfer = 1;
+  CheckRead(0, "S2868A1 read preempted by the S2915A1 IRQ");
+  Check(aBoard[1].nIrqs == 1, "S2915A1 IRQ not taken during a S2868A1 transfer");
+  nRaiseInTransfer = 0;
+  CheckRead(0, "S2868A1 read with its own IRQ pending");
+  Check(aBoard[0].nIrqs == 1, "S2868A1 IRQ not taken after its transfer");
+  S2LP_SelectObject(&aBoard[1].xObject);
+  nRaiseInTransfer = 0;
+  CheckRead(1, "S2915A1 read preempted by the S2868A1 IRQ");
+  Check(aBoard[0].nIrqs == 2, "S2868A1 IRQ not taken during a S2915A1 transfer");
+
+  /* Neither IRQ comes in the middle of an object swap */
+  for(i = 0; i < BOARDS; i++)
+  {
+    pxSelecting = &aBoard[i].xObject;
+    nRaiseInCritical = 1 - i;
+    S2LP_SelectObject(pxSelecting);
+    nRaiseInCritical = i;
+    S2LP_SelectObject(pxSelecting);
+    pxSelecting = NULL;
+  }
+  Check(aBoard[0].nIrqs == 4 && aBoard[1].nIrqs == 3, "IRQ lost by S2LP_SelectObject");
+  Check(lPrimask == 0 && cSelectDepth == 0, "PRIMASK not restored by S2LP_SelectObject");
+
+  Check(S2868A1_irq_disable_cnt == 0 && S2915A1_irq_disable_cnt == 0, "IRQ mask counters left set");
+  Check((lNvicEnabled & ((1UL << EXTI0_IRQn) | (1UL << EXTI1_IRQn))) == ((1UL << EXTI0_IRQn) | (1UL << EXTI1_IRQn)),
+        "IRQ lines left masked");
+
+  if(nFailures == 0)
+  {
+    printf("two-board checks passed (%u + %u transfers)\n",
+           (unsigned)aBoard[0].nTransfers, (unsigned)aBoard[1].nTransfers);
+  }
+  return nFailures ? 1 : 0;
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
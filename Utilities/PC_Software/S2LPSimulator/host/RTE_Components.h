@@ -0,0 +1,29 @@
+/**
+  ******************************************************************************
+  * @file    RTE_Components.h
+  * @author  SRA Application Team
+  * @brief   Host build: components selected for the simulated radio driver
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef  __RTE_COMPONENTS_H__
+#define  __RTE_COMPONENTS_H__
+
+#define S2868A1
+#define PROJECT_CONF_H 1
+#define MAC_CONF_WITH_CSMA 1
+#define MAC_CONF_WITH_TSCH 0
+
+#endif /* __RTE_COMPONENTS_H__ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
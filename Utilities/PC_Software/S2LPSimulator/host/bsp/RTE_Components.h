@@ -0,0 +1,24 @@
+/**
+  ******************************************************************************
+  * @file    RTE_Components.h
+  * @author  SRA Application Team
+  * @brief   Host two-radio test: no middleware component
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef __RTE_COMPONENTS_H__
+#define __RTE_COMPONENTS_H__
+
+#endif /* __RTE_COMPONENTS_H__ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
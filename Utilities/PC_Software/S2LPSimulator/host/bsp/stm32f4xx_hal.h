@@ -0,0 +1,128 @@
+/**
+  ******************************************************************************
+  * @file    stm32f4xx_hal.h
+  * @author  SRA Application Team
+  * @brief   Host two-radio test: the HAL symbols used by the expansion board
+  *          BSPs, implemented by bsp_multi.c
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define UNUSED(X) (void)X
+
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+/* GPIO ----------------------------------------------------------------------*/
+typedef struct
+{
+  uint16_t ODR;                       /*!< Output levels */
+  uint16_t OUT;                       /*!< Pins configured as outputs */
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef xGpioA, xGpioB, xGpioC;
+#define GPIOA                         (&xGpioA)
+#define GPIOB                         (&xGpioB)
+#define GPIOC                         (&xGpioC)
+
+typedef struct
+{
+  uint32_t Pin;
+  uint32_t Mode;
+  uint32_t Pull;
+  uint32_t Speed;
+} GPIO_InitTypeDef;
+
+typedef enum
+{
+  GPIO_PIN_RESET = 0,
+  GPIO_PIN_SET
+} GPIO_PinState;
+
+#define GPIO_PIN_0                    ((uint16_t)0x0001)
+#define GPIO_PIN_1                    ((uint16_t)0x0002)
+#define GPIO_PIN_4                    ((uint16_t)0x0010)
+#define GPIO_PIN_5                    ((uint16_t)0x0020)
+#define GPIO_PIN_6                    ((uint16_t)0x0040)
+#define GPIO_PIN_7                    ((uint16_t)0x0080)
+#define GPIO_PIN_8                    ((uint16_t)0x0100)
+#define GPIO_PIN_10                   ((uint16_t)0x0400)
+
+#define GPIO_MODE_INPUT               0x00000000U
+#define GPIO_MODE_OUTPUT_PP           0x00000001U
+#define GPIO_MODE_IT_RISING           0x10110000U
+#define GPIO_MODE_IT_FALLING          0x10210000U
+#define GPIO_MODE_IT_RISING_FALLING   0x10310000U
+#define GPIO_NOPULL                   0x00000000U
+#define GPIO_PULLUP                   0x00000001U
+#define GPIO_PULLDOWN                 0x00000002U
+#define GPIO_SPEED_FREQ_HIGH          0x00000002U
+
+#define __HAL_RCC_GPIOA_CLK_ENABLE()  do{}while(0)
+#define __HAL_RCC_GPIOB_CLK_ENABLE()  do{}while(0)
+#define __HAL_RCC_GPIOC_CLK_ENABLE()  do{}while(0)
+
+void HAL_GPIO_Init(GPIO_TypeDef *GPIOx, GPIO_InitTypeDef *GPIO_Init);
+void HAL_GPIO_DeInit(GPIO_TypeDef *GPIOx, uint32_t GPIO_Pin);
+GPIO_PinState HAL_GPIO_ReadPin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+void HAL_GPIO_WritePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin, GPIO_PinState PinState);
+void HAL_GPIO_TogglePin(GPIO_TypeDef *GPIOx, uint16_t GPIO_Pin);
+
+/* NVIC and EXTI -------------------------------------------------------------*/
+typedef enum
+{
+  EXTI0_IRQn = 6,
+  EXTI1_IRQn = 7
+} IRQn_Type;
+
+typedef enum
+{
+  HAL_EXTI_COMMON_CB_ID = 0x00U
+} EXTI_CallbackIDTypeDef;
+
+typedef struct
+{
+  uint32_t Line;
+  void (*PendingCallback)(void);
+} EXTI_HandleTypeDef;
+
+#define EXTI_LINE_0                   0x06000000U
+#define EXTI_LINE_1                   0x06000001U
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+void HAL_NVIC_DisableIRQ(IRQn_Type IRQn);
+HAL_StatusTypeDef HAL_EXTI_GetHandle(EXTI_HandleTypeDef *hexti, uint32_t ExtiLine);
+HAL_StatusTypeDef HAL_EXTI_RegisterCallback(EXTI_HandleTypeDef *hexti, EXTI_CallbackIDTypeDef CallbackID,
+                                            void (*pPendingCbfn)(void));
+
+/* Core ----------------------------------------------------------------------*/
+uint32_t __get_IPSR(void);
+uint32_t __get_PRIMASK(void);
+void __set_PRIMASK(uint32_t priMask);
+void __disable_irq(void);
+void HAL_Delay(uint32_t Delay);
+
+#endif /* __STM32F4xx_HAL_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,26 @@
+/**
+  ******************************************************************************
+  * @file    stm32f4xx_hal_exti.h
+  * @author  SRA Application Team
+  * @brief   Host two-radio test: EXTI symbols, in stm32f4xx_hal.h
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef STM32F4xx_HAL_EXTI_H
+#define STM32F4xx_HAL_EXTI_H
+
+#include "stm32f4xx_hal.h"
+
+#endif /* STM32F4xx_HAL_EXTI_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
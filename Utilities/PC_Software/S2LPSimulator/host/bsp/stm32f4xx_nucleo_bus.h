@@ -0,0 +1,36 @@
+/**
+  ******************************************************************************
+  * @file    stm32f4xx_nucleo_bus.h
+  * @author  SRA Application Team
+  * @brief   Host two-radio test: one SPI bus per expansion board
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef STM32F4XX_NUCLEO_BUS_H
+#define STM32F4XX_NUCLEO_BUS_H
+
+#include "stm32f4xx_hal.h"
+
+#define USE_BSP_SPI1_DMA    0U
+#define USE_BSP_SPI2_DMA    0U
+
+int32_t BSP_SPI1_Init(void);
+int32_t BSP_SPI1_DeInit(void);
+int32_t BSP_SPI1_SendRecv(uint8_t *pTxData, uint8_t *pRxData, uint16_t Length);
+int32_t BSP_SPI2_Init(void);
+int32_t BSP_SPI2_DeInit(void);
+int32_t BSP_SPI2_SendRecv(uint8_t *pTxData, uint8_t *pRxData, uint16_t Length);
+
+#endif /* STM32F4XX_NUCLEO_BUS_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,27 @@
+/**
+  ******************************************************************************
+  * @file    stm32f4xx_nucleo_errno.h
+  * @author  SRA Application Team
+  * @brief   Host two-radio test: BSP error codes
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef STM32F4XX_NUCLEO_ERRNO_H
+#define STM32F4XX_NUCLEO_ERRNO_H
+
+#define BSP_ERROR_NONE                    0
+#define BSP_ERROR_PERIPH_FAILURE         -4
+
+#endif /* STM32F4XX_NUCLEO_ERRNO_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,39 @@
+/**
+  ******************************************************************************
+  * @file    contiki-conf.h
+  * @author  SRA Application Team
+  * @brief   Host build: Contiki-NG configuration for the radio driver benchmark
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef CONTIKI_CONF_H__
+#define CONTIKI_CONF_H__
+
+#include <stdint.h>
+#include "main.h"
+#include "RTE_Components.h"
+
+#define LINKADDR_CONF_SIZE              8
+#define PROCESS_CONF_NUMEVENTS          8
+#define CC_CONF_INLINE                  inline
+
+typedef unsigned long clock_time_t;
+
+/* The target project configuration, as used by the firmware build */
+#include "project-conf.h"
+
+#define PACKETBUF_CONF_SIZE MAX_PACKET_LEN
+
+#endif /* CONTIKI_CONF_H__ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,28 @@
+/**
+  ******************************************************************************
+  * @file    contiki.h
+  * @author  SRA Application Team
+  * @brief   Host build: Contiki-NG core subset needed by the radio driver
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef CONTIKI_H_
+#define CONTIKI_H_
+
+#include "contiki-conf.h"
+#include "sys/process.h"
+#include "dev/radio.h"
+
+#endif /* CONTIKI_H_ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
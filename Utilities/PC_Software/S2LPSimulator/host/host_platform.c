@@ -0,0 +1,342 @@
+/**
+  ******************************************************************************
+  * @file    host_platform.c
+  * @author  SRA Application Team
+  * @brief   Host build: minimal Contiki-NG services used by the radio driver
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "contiki.h"
+#include "sys/rtimer.h"
+#include "sys/ctimer.h"
+#include "net/linkaddr.h"
+#include "net/packetbuf.h"
+#include "net/netstack.h"
+#include "s2lp_interface.h"
+#include "host_platform.h"
+
+/* Private define ------------------------------------------------------------*/
+#define HOST_MAX_PROCESSES  4
+
+/* Private variables ---------------------------------------------------------*/
+uint8_t hspi;
+
+linkaddr_t linkaddr_node_addr = { { 0x00, 0x12, 0x4B, 0x00, 0x00, 0x00, 0x00, 0x01 } };
+const linkaddr_t linkaddr_null = { { 0 } };
+
+struct process *process_current;
+static struct process *aProcesses[HOST_MAX_PROCESSES];
+static uint8_t nProcesses;
+
+static uint8_t aPacketbuf[PACKETBUF_SIZE];
+static uint16_t nPacketbufLen;
+static packetbuf_attr_t aAttrs[PACKETBUF_ATTR_MAX];
+static linkaddr_t xReceiver;
+
+static struct ctimer *pxCtimers;
+static struct rtimer *pxRtimer;
+static uint8_t bInRtimer;
+
+static uint8_t aMacFrame[PACKETBUF_SIZE];
+static uint16_t nMacFrameLen;
+static uint32_t nMacFrames;
+
+/* Private functions ---------------------------------------------------------*/
+static void host_rtimer_run(void)
+{
+  struct rtimer *t = pxRtimer;
+  rtimer_clock_t now;
+
+  if(t == NULL || bInRtimer)
+  {
+    return;
+  }
+  now = (rtimer_clock_t)((S2LP_SIM_Now() * RTIMER_ARCH_SECOND) / 1000000000ULL);
+  if(RTIMER_CLOCK_LT(now, t->time))
+  {
+    return;
+  }
+  pxRtimer = NULL;
+  bInRtimer = 1;
+  S2LP_SIM_SetIsrContext(1);
+  t->func(t, t->ptr);
+  S2LP_SIM_SetIsrContext(0);
+  bInRtimer = 0;
+}
+
+static void host_mac_input(void)
+{
+  memcpy(aMacFrame, aPacketbuf, nPacketbufLen);
+  nMacFrameLen = nPacketbufLen;
+  nMacFrames++;
+}
+
+const struct mac_driver host_mac_driver = {
+  "host",
+  host_mac_input
+};
+
+static void call_process(struct process *p, process_event_t ev, process_data_t data)
+{
+  struct process *caller = process_current;
+  char ret;
+
+  process_current = p;
+  ret = p->thread(&p->pt, ev, data);
+  if(ret == PT_EXITED || ret == PT_ENDED)
+  {
+    p->state = 0;
+  }
+  process_current = caller;
+}
+
+/* Exported functions --------------------------------------------------------*/
+void process_start(struct process *p, process_data_t data)
+{
+  uint8_t i;
+
+  for(i = 0; i < nProcesses; i++)
+  {
+    if(aProcesses[i] == p)
+    {
+      return;
+    }
+  }
+  if(nProcesses == HOST_MAX_PROCESSES)
+  {
+    return;
+  }
+  aProcesses[nProcesses++] = p;
+  p->state = 1;
+  p->needspoll = 0;
+  PT_INIT(&p->pt);
+  call_process(p, PROCESS_EVENT_INIT, data);
+}
+
+void process_poll(struct process *p)
+{
+  if(p != NULL)
+  {
+    p->needspoll = 1;
+  }
+}
+
+/**
+  * @brief  Runs the expired callback timers and then the polled processes.
+  */
+int process_run(void)
+{
+  uint8_t i;
+  int nRun = 0;
+  struct ctimer *c;
+
+  host_rtimer_run();
+  for(c = pxCtimers; c != NULL; c = c->next)
+  {
+    if(!ctimer_expired(c))
+    {
+      continue;
+    }
+    void (*f)(void *) = c->f;
+    ctimer_stop(c);
+    process_current = c->p;
+    f(c->ptr);
+    process_current = NULL;
+    nRun++;
+    break;  /* The list may have been changed by the callback */
+  }
+
+  for(i = 0; i < nProcesses; i++)
+  {
+    struct process *p = aProcesses[i];
+    if(p->state && p->needspoll)
+    {
+      p->needspoll = 0;
+      call_process(p, PROCESS_EVENT_POLL, NULL);
+      nRun++;
+    }
+  }
+  return nRun;
+}
+
+int process_post(struct process *p, process_event_t ev, process_data_t data)
+{
+  if(p != NULL && p->state)
+  {
+    call_process(p, ev, data);
+  }
+  return PROCESS_ERR_OK;
+}
+
+int process_is_running(struct process *p)
+{
+  return p->state != 0;
+}
+
+rtimer_clock_t host_rtimer_now(void)
+{
+  S2LP_SIM_ChargePoll();
+  host_rtimer_run();
+  return (rtimer_clock_t)((S2LP_SIM_Now() * RTIMER_ARCH_SECOND) / 1000000000ULL);
+}
+
+int rtimer_set(struct rtimer *task, rtimer_clock_t time, rtimer_clock_t duration,
+               rtimer_callback_t func, void *ptr)
+{
+  (void)duration;
+  task->time = time;
+  task->func = func;
+  task->ptr = ptr;
+  pxRtimer = task;
+  return RTIMER_OK;
+}
+
+clock_time_t clock_time(void)
+{
+  return (clock_time_t)(S2LP_SIM_Now() / 1000000ULL);
+}
+
+void ctimer_set(struct ctimer *c, clock_time_t t, void (*f)(void *), void *ptr)
+{
+  ctimer_stop(c);
+  c->expiry = clock_time() + t;
+  c->f = f;
+  c->ptr = ptr;
+  c->p = process_current;
+  c->next = pxCtimers;
+  pxCtimers = c;
+}
+
+void ctimer_stop(struct ctimer *c)
+{
+  struct ctimer **pp;
+
+  for(pp = &pxCtimers; *pp != NULL; pp = &(*pp)->next)
+  {
+    if(*pp == c)
+    {
+      *pp = c->next;
+      break;
+    }
+  }
+  c->f = NULL;
+}
+
+int ctimer_expired(struct ctimer *c)
+{
+  return c->f == NULL || (long)(clock_time() - c->expiry) >= 0;
+}
+
+void packetbuf_clear(void)
+{
+  nPacketbufLen = 0;
+  memset(aAttrs, 0, sizeof(aAttrs));
+  memset(&xReceiver, 0, sizeof(xReceiver));
+}
+
+void *packetbuf_dataptr(void)
+{
+  return aPacketbuf;
+}
+
+uint16_t packetbuf_datalen(void)
+{
+  return nPacketbufLen;
+}
+
+void packetbuf_set_datalen(uint16_t len)
+{
+  nPacketbufLen = len;
+}
+
+int packetbuf_set_attr(uint8_t type, const packetbuf_attr_t val)
+{
+  aAttrs[type] = val;
+  return 1;
+}
+
+packetbuf_attr_t packetbuf_attr(uint8_t type)
+{
+  return aAttrs[type];
+}
+
+int packetbuf_set_addr(uint8_t type, const linkaddr_t *addr)
+{
+  (void)type;
+  xReceiver = *addr;
+  return 1;
+}
+
+const linkaddr_t *packetbuf_addr(uint8_t type)
+{
+  (void)type;
+  return &xReceiver;
+}
+
+void linkaddr_copy(linkaddr_t *dest, const linkaddr_t *from)
+{
+  memcpy(dest, from, sizeof(linkaddr_t));
+}
+
+int linkaddr_cmp(const linkaddr_t *addr1, const linkaddr_t *addr2)
+{
+  return memcmp(addr1, addr2, sizeof(linkaddr_t)) == 0;
+}
+
+int packetbuf_holds_broadcast(void)
+{
+  return memcmp(&xReceiver, &linkaddr_null, sizeof(linkaddr_t)) == 0;
+}
+
+/**
+  * @brief  Registers the simulator as the S2-LP bus, as S2868A1_RADIO_Init()
+  *         does with the SPI wrapper (and its DMA variant) on the board.
+  */
+void S2LPInterfaceInit(void)
+{
+  S2LP_IO_t xIO;
+
+  xIO.Init = S2LP_SIM_BusInit;
+  xIO.DeInit = S2LP_SIM_BusDeInit;
+  xIO.WriteBuffer = S2LP_SIM_WriteBuffer;
+  xIO.Delay = S2LP_SIM_Delay;
+  S2LP_RegisterBusIO(&xIO);
+  S2LP_RegisterBusIOAsync(S2LP_SIM_WriteBufferAsync);
+}
+
+RangeExtType S2LP_ManagementGetRangeExtender(void)
+{
+  return RANGE_EXT_NONE;
+}
+
+uint16_t host_mac_last_frame(uint8_t *pcData, uint16_t nSize)
+{
+  uint16_t nCopy = (nMacFrameLen < nSize) ? nMacFrameLen : nSize;
+  memcpy(pcData, aMacFrame, nCopy);
+  return nMacFrameLen;
+}
+
+uint32_t host_mac_frame_count(void)
+{
+  return nMacFrames;
+}
+
+packetbuf_attr_t host_mac_last_attr(uint8_t type)
+{
+  return aAttrs[type];
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
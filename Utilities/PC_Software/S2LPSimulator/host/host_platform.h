@@ -0,0 +1,35 @@
+/**
+  ******************************************************************************
+  * @file    host_platform.h
+  * @author  SRA Application Team
+  * @brief   Host build: hooks exposed to the benchmark
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+#ifndef HOST_PLATFORM_H
+#define HOST_PLATFORM_H
+
+#include <stdint.h>
+#include "net/packetbuf.h"
+
+int process_run(void);
+
+/* Last frame handed to NETSTACK_MAC.input() and its attributes */
+uint16_t host_mac_last_frame(uint8_t *pcData, uint16_t nSize);
+uint32_t host_mac_frame_count(void);
+packetbuf_attr_t host_mac_last_attr(uint8_t type);
+
+#endif /* HOST_PLATFORM_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,50 @@
+/**
+  ******************************************************************************
+  * @file    main.h
+  * @author  SRA Application Team
+  * @brief   Host build: HAL/BSP symbols used by the radio driver
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef __MAIN_H
+#define __MAIN_H
+
+#include <stdint.h>
+#include <string.h>
+#include "s2lp_sim.h"
+
+typedef enum
+{
+  RESET = 0,
+  SET = !RESET
+} FlagStatus;
+
+#define UNUSED(X) (void)X
+#define __DMB()                     __sync_synchronize()
+
+/* The SPI handle is only used to check whether a transfer is ongoing */
+extern uint8_t hspi;
+#define HAL_SPI_STATE_READY         0U
+#define HAL_SPI_GetState(h)         ((void)(h), (uint32_t)S2LP_SIM_IsBusBusy())
+
+/* Core interrupt mask, modelled by the simulator */
+#define __get_PRIMASK()             S2LP_SIM_GetPrimask()
+#define __set_PRIMASK(m)            S2LP_SIM_SetPrimask(m)
+#define __disable_irq()             S2LP_SIM_SetPrimask(1U)
+
+#define S2868A1_ENTER_CRITICAL()    S2LP_SIM_IrqLineDisable()
+#define S2868A1_EXIT_CRITICAL()     S2LP_SIM_IrqLineEnable()
+
+#endif /* __MAIN_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,24 @@
+/**
+  ******************************************************************************
+  * @file    uip.h
+  * @author  SRA Application Team
+  * @brief   Host build: uIP (unused)
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef UIP_H_
+#define UIP_H_
+
+#endif /* UIP_H_ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,38 @@
+/**
+  ******************************************************************************
+  * @file    net/linkaddr.h
+  * @author  SRA Application Team
+  * @brief   Host build: link-layer address
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef LINKADDR_H_
+#define LINKADDR_H_
+
+#include "contiki.h"
+
+#define LINKADDR_SIZE LINKADDR_CONF_SIZE
+
+typedef union {
+  unsigned char u8[LINKADDR_SIZE];
+} linkaddr_t;
+
+extern linkaddr_t linkaddr_node_addr;
+extern const linkaddr_t linkaddr_null;
+
+void linkaddr_copy(linkaddr_t *dest, const linkaddr_t *from);
+int linkaddr_cmp(const linkaddr_t *addr1, const linkaddr_t *addr2);
+
+#endif /* LINKADDR_H_ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
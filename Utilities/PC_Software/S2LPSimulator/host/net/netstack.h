@@ -0,0 +1,35 @@
+/**
+  ******************************************************************************
+  * @file    net/netstack.h
+  * @author  SRA Application Team
+  * @brief   Host build: network stack with a capturing MAC layer
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef NETSTACK_H
+#define NETSTACK_H
+
+#include "contiki.h"
+
+struct mac_driver {
+  char *name;
+  void (* input)(void);
+};
+
+extern const struct mac_driver host_mac_driver;
+
+#define NETSTACK_MAC    host_mac_driver
+
+#endif /* NETSTACK_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,52 @@
+/**
+  ******************************************************************************
+  * @file    net/packetbuf.h
+  * @author  SRA Application Team
+  * @brief   Host build: packet buffer subset used by the radio driver
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef PACKETBUF_H_
+#define PACKETBUF_H_
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+
+#define PACKETBUF_SIZE PACKETBUF_CONF_SIZE
+
+typedef uint16_t packetbuf_attr_t;
+
+enum {
+  PACKETBUF_ATTR_NONE,
+  PACKETBUF_ATTR_RSSI,
+  PACKETBUF_ATTR_LINK_QUALITY,
+  PACKETBUF_ATTR_TIMESTAMP,
+  PACKETBUF_ATTR_MAC_SEQNO,
+  PACKETBUF_ADDR_SENDER,
+  PACKETBUF_ADDR_RECEIVER,
+  PACKETBUF_ATTR_MAX
+};
+
+void packetbuf_clear(void);
+void *packetbuf_dataptr(void);
+uint16_t packetbuf_datalen(void);
+void packetbuf_set_datalen(uint16_t len);
+int packetbuf_set_attr(uint8_t type, const packetbuf_attr_t val);
+packetbuf_attr_t packetbuf_attr(uint8_t type);
+int packetbuf_set_addr(uint8_t type, const linkaddr_t *addr);
+const linkaddr_t *packetbuf_addr(uint8_t type);
+int packetbuf_holds_broadcast(void);
+
+#endif /* PACKETBUF_H_ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,29 @@
+/**
+  ******************************************************************************
+  * @file    s2lp_interface.h
+  * @author  SRA Application Team
+  * @brief   Host build: S2-LP board interface backed by the simulator
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef S2LP_INTERFACE_H
+#define S2LP_INTERFACE_H
+
+#include "s2lp.h"
+
+void S2LPInterfaceInit(void);
+RangeExtType S2LP_ManagementGetRangeExtender(void);
+
+#endif /* S2LP_INTERFACE_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,30 @@
+/**
+  ******************************************************************************
+  * @file    clock.h
+  * @author  SRA Application Team
+  * @brief   Host build: system clock driven by the simulator clock
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+#include "contiki.h"
+
+#define CLOCK_SECOND    1000
+
+clock_time_t clock_time(void);
+
+#endif /* CLOCK_H_ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,39 @@
+/**
+  ******************************************************************************
+  * @file    ctimer.h
+  * @author  SRA Application Team
+  * @brief   Host build: callback timers, run from process_run()
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef CTIMER_H_
+#define CTIMER_H_
+
+#include "contiki.h"
+#include "sys/clock.h"
+
+struct ctimer {
+  struct ctimer *next;
+  clock_time_t expiry;
+  void (*f)(void *);
+  void *ptr;
+  struct process *p;
+};
+
+void ctimer_set(struct ctimer *c, clock_time_t t, void (*f)(void *), void *ptr);
+void ctimer_stop(struct ctimer *c);
+int ctimer_expired(struct ctimer *c);
+
+#endif /* CTIMER_H_ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
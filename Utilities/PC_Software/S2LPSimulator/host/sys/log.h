@@ -0,0 +1,35 @@
+/**
+  ******************************************************************************
+  * @file    sys/log.h
+  * @author  SRA Application Team
+  * @brief   Host build: Contiki-NG log macros (output discarded)
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef LOG_H_
+#define LOG_H_
+
+#define LOG_LEVEL_NONE         0
+#define LOG_LEVEL_ERR          1
+#define LOG_LEVEL_WARN         2
+#define LOG_LEVEL_INFO         3
+#define LOG_LEVEL_DBG          4
+
+#define LOG_ERR(...)           do { } while(0)
+#define LOG_WARN(...)          do { } while(0)
+#define LOG_INFO(...)          do { } while(0)
+#define LOG_DBG(...)           do { } while(0)
+
+#endif /* LOG_H_ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
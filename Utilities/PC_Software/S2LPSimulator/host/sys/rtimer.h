@@ -0,0 +1,53 @@
+/**
+  ******************************************************************************
+  * @file    sys/rtimer.h
+  * @author  SRA Application Team
+  * @brief   Host build: rtimer driven by the simulator clock
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+#ifndef RTIMER_H_
+#define RTIMER_H_
+
+#include "contiki.h"
+
+typedef uint32_t rtimer_clock_t;
+
+#define RTIMER_SECOND               RTIMER_ARCH_SECOND
+#define RTIMER_CLOCK_LT(a, b)       ((int32_t)((a) - (b)) < 0)
+#define US_TO_RTIMERTICKS(US)       ((US) >= 0 ?                        \
+                                     (((int32_t)(US) * (RTIMER_ARCH_SECOND) + 500000) / 1000000L) :      \
+                                     ((int32_t)(US) * (RTIMER_ARCH_SECOND) - 500000) / 1000000L)
+
+/* Every read of the timer charges one busy-wait iteration to the simulator */
+#define RTIMER_NOW()                host_rtimer_now()
+#define RTIMER_OK                   0
+
+struct rtimer;
+typedef void (* rtimer_callback_t)(struct rtimer *t, void *ptr);
+
+struct rtimer {
+  rtimer_clock_t time;
+  rtimer_callback_t func;
+  void *ptr;
+};
+
+/* A single rtimer, fired from RTIMER_NOW() and process_run() as the
+ * interrupt would preempt them on the target */
+int rtimer_set(struct rtimer *task, rtimer_clock_t time, rtimer_clock_t duration,
+               rtimer_callback_t func, void *ptr);
+rtimer_clock_t host_rtimer_now(void);
+
+#endif /* RTIMER_H_ */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
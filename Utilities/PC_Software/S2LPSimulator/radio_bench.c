@@ -0,0 +1,1544 @@
+/**
+  ******************************************************************************
+  * @file    radio_bench.c
+  * @author  SRA Application Team
+  * @brief   Runs the Contiki-NG S2-LP radio driver against the simulator and
+  *          reports the SPI traffic and the time spent for each operation
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "contiki.h"
+#include "sys/rtimer.h"
+#include "radio-driver.h"
+#include "host_platform.h"
+#include "s2lp_sim.h"
+#include "net/mac/framer/frame802154.h"
+
+/* Not in radio-driver.h: TSCH schedules Radio_transmit() itself */
+int radio_transmit_at(unsigned short payload_len, uint32_t sfd_time);
+
+/* Private define ------------------------------------------------------------*/
+#define BENCH_MAX_RESULTS     40
+#define BENCH_STEP_NS         10000ULL     /* Main loop granularity while idle */
+#define BENCH_RX_TIMEOUT_NS   50000000ULL
+#define BENCH_BURST_FRAMES    4
+#define BENCH_PEER_TURNAROUND_NS  1000000ULL  /* Peer ISR: frame read to ACK on air */
+#define BENCH_LLP_TURNAROUND_NS   100000ULL   /* Peer packet handler: frame end to ACK */
+#define BENCH_SNIFF_PERIOD_MS 20
+#define BENCH_TIMESTAMP_TICKS 2            /* TSCH resyncs on the SFD: a few tens of us */
+#define BENCH_TSCH_TICKS      2            /* Error allowed on the RADIO_CONST_DELAY_* */
+#define BENCH_TSCH_LEAD_US    5000         /* From prepare() to the TX deadline */
+#define BENCH_SCAN_CHANNELS   (CHANNEL_NUMBER_MAX - CHANNEL_NUMBER_MIN + 1)
+#define BENCH_SCAN_JAM_CH     3            /* Channel of the interferer */
+#define BENCH_SCAN_JAM_DBM    (-70)
+#define BENCH_SCAN_JAM_DUTY   30           /* % of the time it is on air */
+#define BENCH_CCA_NOISE_DBM   (-95)        /* Steady noise raised on the channel */
+#define BENCH_CCA_WINDOWS     5            /* Noise floor updates waited for */
+#define BENCH_CCA_STEP_NS     1000000ULL
+#define BENCH_CCA_LEN         50
+#define BENCH_CCA_FRAMES      (2 * RADIO_CCA_ADAPT_TX - 1)
+#define BENCH_CCA_FIXED_DBM   (-85)
+#define BENCH_STATS_LEN       50
+#define BENCH_STATS_SLACK_US  2000         /* From the TX strobe to the end of the frame */
+#define BENCH_MULTI_LEN       50
+#define BENCH_MULTI_SLACK_NS  2000000ULL
+#define BENCH_MULTI_XTAL      26000000     /* Second radio: other crystal, other channel */
+#define BENCH_MULTI_CHANNEL   7
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  char cOp[16];
+  uint16_t nLen;
+  S2LP_SIM_Stats xStats;
+  uint64_t lTotalNs;
+  uint64_t lAirNs;     /*!< Part of lTotalNs the frame spends on air */
+  uint64_t lCallNs;    /*!< Part of lTotalNs spent blocked in the driver call */
+} BenchResult;
+
+/* Private variables ---------------------------------------------------------*/
+static BenchResult aResults[BENCH_MAX_RESULTS];
+static uint8_t nResults;
+static int nFailures;
+static int nTxDoneStatus;
+static uint8_t nTxDoneCalls;
+static uint8_t bPeerAcks;
+static uint8_t nPeerSkips;
+static uint8_t aOtherRegs[256];
+static uint32_t nOtherTransactions;
+
+static const linkaddr_t xPeerAddr = { { 0x00, 0x12, 0x4B, 0x00, 0x00, 0x00, 0x00, 0x02 } };
+
+static const uint16_t aLengths[] = { 10, 50, 100, 127 };
+#if RADIO_FIFO_STREAMING
+static const uint16_t aLongLengths[] = { 300, 1000, MAX_PACKET_LEN };
+#endif /*RADIO_FIFO_STREAMING*/
+
+/* Private functions ---------------------------------------------------------*/
+static void bench_fail(const char *pcOp, uint16_t nLen, const char *pcWhy)
+{
+  fprintf(stderr, "FAIL %s/%u: %s\n", pcOp, nLen, pcWhy);
+  nFailures++;
+}
+
+static void bench_record(const char *pcOp, uint16_t nLen, uint64_t lStart, uint8_t bOnAir)
+{
+  BenchResult *pxRes = &aResults[nResults++];
+
+  snprintf(pxRes->cOp, sizeof(pxRes->cOp), "%s", pcOp);
+  pxRes->nLen = nLen;
+  S2LP_SIM_GetStats(&pxRes->xStats);
+  pxRes->lTotalNs = S2LP_SIM_Now() - lStart;
+  pxRes->lAirNs = bOnAir ? S2LP_SIM_FrameAirTimeNs(nLen) : 0;
+  pxRes->lCallNs = pxRes->lTotalNs;
+  if(pxRes->xStats.nIsrBusWaits)
+  {
+    bench_fail(pcOp, nLen, "radio accessed from an ISR while the DMA owned the bus");
+  }
+}
+
+static void bench_fill(uint8_t *pcBuf, uint16_t nLen, uint8_t cSeed)
+{
+  for(uint16_t i = 0; i < nLen; i++)
+  {
+    pcBuf[i] = (uint8_t)(cSeed + 7 * i);
+  }
+}
+
+/**
+  * @brief  Builds an 802.15.4 data frame asking for an ACK.
+  */
+static uint16_t bench_frame(uint8_t *pcBuf, uint16_t nLen, const linkaddr_t *pxDst,
+                            const linkaddr_t *pxSrc, uint8_t cSeq)
+{
+  frame802154_t xFrame;
+  int nHdr;
+
+  memset(&xFrame, 0, sizeof(xFrame));
+  xFrame.fcf.frame_type = FRAME802154_DATAFRAME;
+  xFrame.fcf.ack_required = 1;
+  xFrame.fcf.panid_compression = 1;
+  xFrame.fcf.frame_version = FRAME802154_IEEE802154_2006;
+  xFrame.fcf.dest_addr_mode = FRAME802154_LONGADDRMODE;
+  xFrame.fcf.src_addr_mode = FRAME802154_LONGADDRMODE;
+  xFrame.seq = cSeq;
+  xFrame.dest_pid = frame802154_get_pan_id();
+  xFrame.src_pid = xFrame.dest_pid;
+  memcpy(xFrame.dest_addr, pxDst, LINKADDR_SIZE);
+  memcpy(xFrame.src_addr, pxSrc, LINKADDR_SIZE);
+  nHdr = frame802154_create(&xFrame, pcBuf);
+  bench_fill(&pcBuf[nHdr], nLen - nHdr, cSeq);
+  return nLen;
+}
+
+/**
+  * @brief  The peer acknowledges every frame asking for it, from its packet
+  *         handler when the LLP header asks so, else from its ISR. The first
+  *         nPeerSkips frames are missed.
+  */
+static void bench_peer(const uint8_t *pcData, uint16_t nLen)
+{
+  uint8_t aAck[3] = { FRAME802154_ACKFRAME, 0, 0 };
+
+  if(bPeerAcks && nPeerSkips)
+  {
+    nPeerSkips--;
+    return;
+  }
+#if RADIO_HW_ACK
+  if(bPeerAcks && !(S2LP_SIM_GetTxLlpControl() & S2LP_SIM_LLP_NO_ACK))
+  {
+    S2LP_SIM_InjectAckAt(S2LP_SIM_GetTxLlpControl() & S2LP_SIM_LLP_SEQ_MASK, -65,
+                         BENCH_LLP_TURNAROUND_NS);
+    return;
+  }
+#endif /*RADIO_HW_ACK*/
+  if(bPeerAcks && nLen > 3 && (pcData[0] & 0x20))
+  {
+    aAck[2] = pcData[2];
+    S2LP_SIM_InjectFrameAt(aAck, sizeof(aAck), -65, 8, BENCH_PEER_TURNAROUND_NS);
+  }
+}
+
+/**
+  * @brief  Radio_init(), from reset to RX.
+  */
+static void bench_init(void)
+{
+  uint64_t lStart;
+
+  S2LP_SIM_Init(NULL);
+  S2LP_SIM_SetIrqHandler(Radio_interrupt_callback);
+  S2LP_SIM_SetTxHook(bench_peer);
+
+  lStart = S2LP_SIM_Now();
+  if(subGHz_radio_driver.init() != 0)
+  {
+    bench_fail("init", 0, "init returned an error");
+  }
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    S2LP_SIM_Advance(1000000);
+    if(S2LP_SIM_GetState() != MC_STATE_RX)
+    {
+      bench_fail("init", 0, "radio not in RX");
+    }
+  }
+  bench_record("init", 0, lStart, 0);
+#if RADIO_ADAPTIVE_CCA
+  /* Its RSSI sampling in the background would add a transaction to the
+   * operations it happens to fall in: only "cca" runs with it */
+  radio_cca_set_adaptive(0);
+#endif /*RADIO_ADAPTIVE_CCA*/
+}
+
+/**
+  * @brief  subGHz_radio_driver.send(), until the radio is back in RX.
+  */
+static void bench_send(uint16_t nLen)
+{
+  uint8_t aTx[MAX_PACKET_LEN];
+  uint8_t aAir[S2LP_SIM_MAX_FRAME_LEN];
+  uint64_t lStart;
+  int ret;
+
+  bench_fill(aTx, nLen, (uint8_t)nLen);
+  packetbuf_clear();
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+
+  ret = subGHz_radio_driver.send(aTx, nLen);
+
+  bench_record("send", nLen, lStart, 1);
+  if(ret != RADIO_TX_OK)
+  {
+    bench_fail("send", nLen, "send did not return RADIO_TX_OK");
+  }
+  if(S2LP_SIM_GetLastTxFrame(aAir, sizeof(aAir)) != nLen || memcmp(aAir, aTx, nLen))
+  {
+    bench_fail("send", nLen, "frame on air differs from payload");
+  }
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail("send", nLen, "radio not back in RX");
+  }
+}
+
+#if RADIO_ASYNC_TX
+static void bench_tx_done(int status)
+{
+  nTxDoneStatus = status;
+  nTxDoneCalls++;
+}
+
+/**
+  * @brief  Asynchronous send: the call returns once the frame is handed to the
+  *         radio, the main loop runs until the TX done callback.
+  */
+static void bench_send_async(uint16_t nLen)
+{
+  uint8_t aTx[MAX_PACKET_LEN];
+  uint8_t aAir[S2LP_SIM_MAX_FRAME_LEN];
+  uint64_t lStart, lCall;
+  int ret;
+
+  bench_fill(aTx, nLen, (uint8_t)(0x40 + nLen));
+  packetbuf_clear();
+  S2LP_SIM_ResetStats();
+  nTxDoneCalls = 0;
+  lStart = S2LP_SIM_Now();
+
+  radio_set_tx_done_callback(bench_tx_done);
+  ret = subGHz_radio_driver.send(aTx, nLen);
+  lCall = S2LP_SIM_Now() - lStart;
+
+  while(nTxDoneCalls == 0 &&
+        (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS + S2LP_SIM_FrameAirTimeNs(nLen))
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+  }
+
+  bench_record("asend", nLen, lStart, 1);
+  aResults[nResults - 1].lCallNs = lCall;
+  if(ret != RADIO_TX_OK || !radio_tx_in_progress() == !nTxDoneCalls)
+  {
+    bench_fail("asend", nLen, "send did not start an asynchronous transmission");
+  }
+  if(nTxDoneCalls != 1 || nTxDoneStatus != RADIO_TX_OK)
+  {
+    bench_fail("asend", nLen, "TX done callback not called once with RADIO_TX_OK");
+  }
+  if(S2LP_SIM_GetLastTxFrame(aAir, sizeof(aAir)) != nLen || memcmp(aAir, aTx, nLen))
+  {
+    bench_fail("asend", nLen, "frame on air differs from payload");
+  }
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail("asend", nLen, "radio not back in RX");
+  }
+}
+#endif /*RADIO_ASYNC_TX*/
+
+/**
+  * @brief  RADIO_PARAM_LAST_PACKET_TIMESTAMP against the time the sync word of
+  *         the last frame was detected.
+  */
+static void bench_check_timestamp(const char *pcOp, uint16_t nLen)
+{
+  rtimer_clock_t xTimestamp;
+  rtimer_clock_t xSync;
+  int32_t lError;
+
+  if(subGHz_radio_driver.get_object(RADIO_PARAM_LAST_PACKET_TIMESTAMP, &xTimestamp,
+                                    sizeof(xTimestamp)) != RADIO_RESULT_OK)
+  {
+    bench_fail(pcOp, nLen, "no last packet timestamp");
+    return;
+  }
+  xSync = (rtimer_clock_t)((S2LP_SIM_GetLastSyncTime() * RTIMER_SECOND) / 1000000000ULL);
+  lError = (int32_t)(xTimestamp - xSync);
+  if(lError < -BENCH_TIMESTAMP_TICKS || lError > BENCH_TIMESTAMP_TICKS)
+  {
+    fprintf(stderr, "%s/%u: timestamp %d ticks from the sync word\n", pcOp, nLen, (int)lError);
+    bench_fail(pcOp, nLen, "wrong last packet timestamp");
+  }
+}
+
+/**
+  * @brief  A frame arrives over the air: from the first bit to the delivery to
+  *         NETSTACK_MAC.input(). The main loop runs the process every
+  *         BENCH_STEP_NS.
+  */
+static void bench_read(uint16_t nLen)
+{
+  uint8_t aRx[MAX_PACKET_LEN];
+  uint8_t aMac[MAX_PACKET_LEN];
+  uint32_t nFrames = host_mac_frame_count();
+  uint64_t lStart;
+  radio_value_t xRssi = 0;
+
+  bench_fill(aRx, nLen, (uint8_t)(0x80 + nLen));
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+
+  S2LP_SIM_InjectFrame(aRx, nLen, -60, 9);
+  while(host_mac_frame_count() == nFrames &&
+        (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS + S2LP_SIM_FrameAirTimeNs(nLen))
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+  }
+
+  bench_record("read", nLen, lStart, 1);
+  aResults[nResults - 1].lCallNs = 0;
+  if(host_mac_frame_count() == nFrames)
+  {
+    bench_fail("read", nLen, "frame not delivered");
+    return;
+  }
+  if(host_mac_last_frame(aMac, sizeof(aMac)) != nLen || memcmp(aMac, aRx, nLen))
+  {
+    bench_fail("read", nLen, "delivered frame differs");
+  }
+  if(subGHz_radio_driver.get_value(RADIO_PARAM_LAST_RSSI, &xRssi) != RADIO_RESULT_OK || xRssi != -60)
+  {
+    bench_fail("read", nLen, "wrong last packet RSSI");
+  }
+  bench_check_timestamp("read", nLen);
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail("read", nLen, "radio not back in RX");
+  }
+}
+
+#if RADIO_HOPPING
+/**
+  * @brief  Checks that the radio is back in RX, tuned on the channel.
+  */
+static void bench_check_channel(const char *pcOp, int nChannel)
+{
+  int32_t lError;
+
+  /* Time for the synthesizer to lock */
+  S2LP_SIM_Advance(1000000);
+  lError = (int32_t)(S2LP_SIM_GetTunedFrequency() -
+                     (uint32_t)(BASE_FREQUENCY + nChannel * CHANNEL_SPACE));
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail(pcOp, nChannel, "radio not back in RX");
+  }
+  /* SYNT resolution is a few tens of Hz */
+  if(lError > 100 || lError < -100)
+  {
+    bench_fail(pcOp, nChannel, "synthesizer not tuned on the channel");
+  }
+}
+#endif /*RADIO_HOPPING*/
+
+/**
+  * @brief  Channel hop and TX power change through set_value(). With
+  *         RADIO_HOPPING, the radio must also be retuned on every channel
+  *         of a hopping sequence.
+  */
+static void bench_settings(void)
+{
+  radio_value_t xChannel, xPower;
+  uint64_t lStart;
+#if RADIO_HOPPING
+  static const uint8_t aSequence[] = { 3, 11, 0, 7, CHANNEL_NUMBER_MAX, 5 };
+  int nChannel;
+#endif /*RADIO_HOPPING*/
+
+  subGHz_radio_driver.get_value(RADIO_PARAM_CHANNEL, &xChannel);
+  subGHz_radio_driver.get_value(RADIO_PARAM_TXPOWER, &xPower);
+
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+  if(subGHz_radio_driver.set_value(RADIO_PARAM_CHANNEL, xChannel == 0 ? 1 : 0) != RADIO_RESULT_OK)
+  {
+    bench_fail("hop", 0, "set_value(RADIO_PARAM_CHANNEL) failed");
+  }
+  bench_record("hop", 0, lStart, 0);
+#if RADIO_HOPPING
+  bench_check_channel("hop", xChannel == 0 ? 1 : 0);
+  radio_hop_set_sequence(aSequence, sizeof(aSequence));
+  for(uint16_t i = 0; i < sizeof(aSequence); i++)
+  {
+    nChannel = radio_hop_next();
+    if(nChannel != aSequence[i])
+    {
+      bench_fail("hop", nChannel, "radio_hop_next() out of sequence");
+    }
+    bench_check_channel("hop", nChannel);
+  }
+  radio_hop_set_sequence(NULL, 0);
+#endif /*RADIO_HOPPING*/
+
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+  if(subGHz_radio_driver.set_value(RADIO_PARAM_TXPOWER, xPower - 1) != RADIO_RESULT_OK)
+  {
+    bench_fail("txpow", 0, "set_value(RADIO_PARAM_TXPOWER) failed");
+  }
+  bench_record("txpow", 0, lStart, 0);
+
+  subGHz_radio_driver.set_value(RADIO_PARAM_CHANNEL, xChannel);
+  subGHz_radio_driver.set_value(RADIO_PARAM_TXPOWER, xPower);
+}
+
+/**
+  * @brief  Back-to-back frames arrive while the process does not run: all of
+  *         them must be delivered once it does.
+  */
+static void bench_burst(uint16_t nLen)
+{
+  uint8_t aRx[MAX_PACKET_LEN];
+  uint8_t aMac[MAX_PACKET_LEN];
+  uint32_t nFrames = host_mac_frame_count();
+  uint64_t lStart;
+
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+
+  for(uint8_t i = 0; i < BENCH_BURST_FRAMES; i++)
+  {
+    bench_fill(aRx, nLen, (uint8_t)(0xA0 + i));
+    S2LP_SIM_InjectFrame(aRx, nLen, -70, 8);
+  }
+  /* The process is held off until the last frame is in */
+  while((S2LP_SIM_Now() - lStart) < BENCH_BURST_FRAMES * (S2LP_SIM_FrameAirTimeNs(nLen) + 1000000ULL))
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+  }
+  while(host_mac_frame_count() - nFrames < BENCH_BURST_FRAMES &&
+        (S2LP_SIM_Now() - lStart) < BENCH_BURST_FRAMES * BENCH_RX_TIMEOUT_NS)
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+  }
+
+  bench_record("burst", nLen, lStart, 0);
+  aResults[nResults - 1].lCallNs = 0;
+  if(host_mac_frame_count() - nFrames != BENCH_BURST_FRAMES)
+  {
+    bench_fail("burst", nLen, "frames lost");
+    return;
+  }
+  if(host_mac_last_frame(aMac, sizeof(aMac)) != nLen || memcmp(aMac, aRx, nLen))
+  {
+    bench_fail("burst", nLen, "last frame delivered differs from the last sent");
+  }
+}
+
+#if RADIO_ISR_ACK
+/**
+  * @brief  Unicast frame asking for an ACK, until the MAC gets the outcome:
+  *         "uack" when the peer answers, "noack" when it does not, "retx"
+  *         when it answers only after nPeerSkips missed frames.
+  */
+static void bench_unicast(uint16_t nLen, uint8_t bAcked)
+{
+  const char *pcOp = !bAcked ? "noack" : nPeerSkips ? "retx" : "uack";
+  int nExpected = bAcked ? RADIO_TX_OK : RADIO_TX_NOACK;
+  int nAttempts = 1;
+  uint8_t aTx[MAX_PACKET_LEN];
+  uint64_t lStart, lCall;
+  int ret;
+
+#if RADIO_HW_ACK
+  /* Frames the FIFO holds whole are sent again by the packet handler */
+  if(nLen <= S2LP_TX_FIFO_SIZE)
+  {
+    nAttempts = bAcked ? 1 + nPeerSkips : RADIO_HW_ACK_RETX + 1;
+  }
+#endif /*RADIO_HW_ACK*/
+  bench_frame(aTx, nLen, &xPeerAddr, &linkaddr_node_addr, (uint8_t)(nLen + bAcked));
+  packetbuf_clear();
+  packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &xPeerAddr);
+  bPeerAcks = bAcked;
+  S2LP_SIM_ResetStats();
+  nTxDoneCalls = 0;
+  lStart = S2LP_SIM_Now();
+
+#if RADIO_ASYNC_TX
+  radio_set_tx_done_callback(bench_tx_done);
+#endif /*RADIO_ASYNC_TX*/
+  ret = subGHz_radio_driver.send(aTx, nLen);
+  lCall = S2LP_SIM_Now() - lStart;
+#if RADIO_ASYNC_TX
+  while(nTxDoneCalls == 0 &&
+        (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS + nAttempts * S2LP_SIM_FrameAirTimeNs(nLen))
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+  }
+  ret = nTxDoneCalls ? nTxDoneStatus : RADIO_TX_ERR;
+#endif /*RADIO_ASYNC_TX*/
+  bPeerAcks = 0;
+  nPeerSkips = 0;
+
+  bench_record(pcOp, nLen, lStart, 1);
+  aResults[nResults - 1].lCallNs = lCall;
+  if(ret != nExpected)
+  {
+    bench_fail(pcOp, nLen, bAcked ? "ACK not matched" : "missing ACK not reported");
+  }
+#if RADIO_HW_ACK
+  if(radio_get_tx_attempts() != nAttempts)
+  {
+    bench_fail(pcOp, nLen, "wrong radio_get_tx_attempts()");
+  }
+#endif /*RADIO_HW_ACK*/
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail(pcOp, nLen, "radio not back in RX");
+  }
+}
+
+/**
+  * @brief  Frame to this node asking for an ACK: the ACK must be on air
+  *         without waiting for the process. With RADIO_HW_ACK it is the
+  *         packet handler that sends it, the driver transmits nothing.
+  */
+static void bench_rx_ack(uint16_t nLen)
+{
+  uint8_t aRx[MAX_PACKET_LEN];
+  uint8_t aAir[S2LP_SIM_MAX_FRAME_LEN];
+  uint32_t nFrames = host_mac_frame_count();
+  uint64_t lStart;
+  S2LP_SIM_Stats xStats;
+
+  bench_frame(aRx, nLen, &linkaddr_node_addr, &xPeerAddr, (uint8_t)(0x90 + nLen));
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+
+#if RADIO_HW_ACK
+  S2LP_SIM_SetPeerAckRequest(1);
+  S2LP_SIM_InjectFrame(aRx, nLen, -60, 9);
+  do
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    S2LP_SIM_GetStats(&xStats);
+  } while(xStats.nAutoAcks == 0 && (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS);
+  S2LP_SIM_SetPeerAckRequest(0);
+  (void)aAir;
+
+  bench_record("rack", nLen, lStart, 1);
+  aResults[nResults - 1].lCallNs = 0;
+  if(xStats.nAutoAcks != 1 || xStats.nFramesTx != 0)
+  {
+    bench_fail("rack", nLen, "no ACK sent from the packet handler");
+  }
+#else /*!RADIO_HW_ACK*/
+  /* No process runs until the ACK is on air */
+  S2LP_SIM_InjectFrame(aRx, nLen, -60, 9);
+  do
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    S2LP_SIM_GetStats(&xStats);
+  } while(xStats.nFramesTx == 0 && (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS);
+
+  bench_record("rack", nLen, lStart, 1);
+  aResults[nResults - 1].lCallNs = 0;
+  if(xStats.nFramesTx != 1 || S2LP_SIM_GetLastTxFrame(aAir, sizeof(aAir)) != 3 ||
+     aAir[0] != FRAME802154_ACKFRAME || aAir[2] != aRx[2])
+  {
+    bench_fail("rack", nLen, "no ACK sent from the ISR");
+  }
+#endif /*RADIO_HW_ACK*/
+  while(host_mac_frame_count() == nFrames && (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS)
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+  }
+  if(host_mac_frame_count() == nFrames)
+  {
+    bench_fail("rack", nLen, "frame not delivered");
+  }
+  /* Past the end of the ACK */
+  S2LP_SIM_Advance(1000000 + S2LP_SIM_FrameAirTimeNs(0));
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail("rack", nLen, "radio not back in RX");
+  }
+}
+#endif /*RADIO_ISR_ACK*/
+
+#if RADIO_SNIFF_MODE
+/**
+  * @brief  Low duty cycle RX: the radio idles one second waking up every
+  *         BENCH_SNIFF_PERIOD_MS without MCU activity, then frames sent with
+  *         a wake-up preamble arrive at several phases of the period and
+  *         a frame is sent with one.
+  */
+static void bench_sniff(void)
+{
+  uint8_t aRx[50];
+  uint8_t aMac[50];
+  uint8_t aAir[S2LP_SIM_MAX_FRAME_LEN];
+  uint16_t nPreambleBits = 2 * RADIO_WAKEUP_PREAMBLE(BENCH_SNIFF_PERIOD_MS);
+  uint32_t nFrames;
+  uint64_t lStart, lLatency, lMaxLatency;
+  /* Air time of the wake-up preamble beyond the normal one */
+  uint64_t lWakeupNs = ((nPreambleBits - 2ULL * PREAMBLE_LENGTH) * 1000000000ULL) / DATARATE;
+  radio_sniff_stats_t xSniff;
+  S2LP_SIM_Stats xStats;
+
+  if(radio_set_sniff_period(RADIO_SNIFF_PERIOD_MAX_MS + 1) == 0)
+  {
+    bench_fail("sniff", 0, "period above RADIO_SNIFF_PERIOD_MAX_MS accepted");
+  }
+  if(radio_set_sniff_period(BENCH_SNIFF_PERIOD_MS) != 0)
+  {
+    bench_fail("sniff", BENCH_SNIFF_PERIOD_MS, "radio_set_sniff_period() failed");
+    return;
+  }
+
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+  while((S2LP_SIM_Now() - lStart) < 1000000000ULL)
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+  }
+  bench_record("sniff", BENCH_SNIFF_PERIOD_MS, lStart, 0);
+  aResults[nResults - 1].lCallNs = 0;
+  S2LP_SIM_GetStats(&xStats);
+  printf("sniff: %u ms period, %u wake ups/s, RX on %.2f%%\n", BENCH_SNIFF_PERIOD_MS,
+         xStats.nLdcWakeups, xStats.lRxOnNs / 1e7);
+  if(xStats.nTransactions != 0)
+  {
+    bench_fail("sniff", BENCH_SNIFF_PERIOD_MS, "SPI traffic while idle");
+  }
+  if(xStats.nLdcWakeups + 1 < 1000 / BENCH_SNIFF_PERIOD_MS ||
+     xStats.nLdcWakeups > 1000 / BENCH_SNIFF_PERIOD_MS + 1)
+  {
+    bench_fail("sniff", BENCH_SNIFF_PERIOD_MS, "wrong number of wake ups");
+  }
+
+  /* The first frame is recorded, the others only checked */
+  S2LP_SIM_SetPeerPreamble(nPreambleBits);
+  lMaxLatency = 0;
+  for(uint8_t i = 0; i < 3; i++)
+  {
+    S2LP_SIM_Advance(i * 7000000ULL);
+    bench_fill(aRx, sizeof(aRx), (uint8_t)(0x40 + i));
+    nFrames = host_mac_frame_count();
+    S2LP_SIM_ResetStats();
+    lStart = S2LP_SIM_Now();
+    S2LP_SIM_InjectFrame(aRx, sizeof(aRx), -60, 9);
+    while(host_mac_frame_count() == nFrames && (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS)
+    {
+      S2LP_SIM_Advance(BENCH_STEP_NS);
+      process_run();
+    }
+    lLatency = S2LP_SIM_Now() - lStart;
+    if(i == 0)
+    {
+      bench_record("sread", sizeof(aRx), lStart, 1);
+      aResults[nResults - 1].lAirNs += lWakeupNs;
+      aResults[nResults - 1].lCallNs = 0;
+    }
+    if(host_mac_frame_count() == nFrames)
+    {
+      bench_fail("sread", sizeof(aRx), "frame not delivered");
+      continue;
+    }
+    if(host_mac_last_frame(aMac, sizeof(aMac)) != sizeof(aRx) || memcmp(aMac, aRx, sizeof(aRx)))
+    {
+      bench_fail("sread", sizeof(aRx), "delivered frame differs");
+    }
+    /* VALID_SYNC is masked: the timestamp is worked back from RX_DATA_READY */
+    bench_check_timestamp("sread", sizeof(aRx));
+    if(lLatency > lMaxLatency)
+    {
+      lMaxLatency = lLatency;
+    }
+  }
+  S2LP_SIM_SetPeerPreamble(0);
+  printf("sniff: wake-up preamble %u bits, max delivery latency %.1f ms\n", nPreambleBits,
+         lMaxLatency / 1e6);
+  /* The preamble covers a period, the rest is the frame and the read out */
+  if(lMaxLatency > 1000000ULL * (BENCH_SNIFF_PERIOD_MS + 2) + S2LP_SIM_FrameAirTimeNs(sizeof(aRx)))
+  {
+    bench_fail("sread", sizeof(aRx), "delivery later than a sniff period");
+  }
+  S2LP_SIM_Advance(1000000);
+  if(S2LP_SIM_GetState() != MC_STATE_SLEEP && S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail("sread", sizeof(aRx), "radio not back to sniffing");
+  }
+
+  radio_set_tx_wakeup(BENCH_SNIFF_PERIOD_MS);
+  bench_fill(aRx, sizeof(aRx), 0x60);
+  packetbuf_clear();
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+  if(subGHz_radio_driver.send(aRx, sizeof(aRx)) != RADIO_TX_OK)
+  {
+    bench_fail("ssend", sizeof(aRx), "send did not return RADIO_TX_OK");
+  }
+  bench_record("ssend", sizeof(aRx), lStart, 1);
+  aResults[nResults - 1].lAirNs += lWakeupNs;
+  if(S2LP_SIM_GetLastTxFrame(aAir, sizeof(aAir)) != sizeof(aRx) || memcmp(aAir, aRx, sizeof(aRx)))
+  {
+    bench_fail("ssend", sizeof(aRx), "frame on air differs from payload");
+  }
+  if(S2LP_SIM_GetTxPreamble() != nPreambleBits)
+  {
+    bench_fail("ssend", sizeof(aRx), "frame not sent with the wake-up preamble");
+  }
+  if(S2LP_SIM_PeekRegister(PCKTCTRL5_ADDR) != (PREAMBLE_LENGTH & 0xFF))
+  {
+    bench_fail("ssend", sizeof(aRx), "preamble length not restored");
+  }
+  radio_set_tx_wakeup(0);
+
+  radio_get_sniff_stats(&xSniff);
+  if(xSniff.rx_frames != 3 || xSniff.tx_frames != 1 || xSniff.period_ms != BENCH_SNIFF_PERIOD_MS)
+  {
+    bench_fail("sniff", BENCH_SNIFF_PERIOD_MS, "wrong radio_get_sniff_stats() counters");
+  }
+  printf("sniff: %lu ms sniffing, %lu ms estimated listening\n",
+         (unsigned long)xSniff.sniff_ms, (unsigned long)xSniff.listen_ms);
+
+  radio_set_sniff_period(0);
+  S2LP_SIM_Advance(1000000);
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail("sniff", 0, "radio not back in continuous RX");
+  }
+}
+#endif /*RADIO_SNIFF_MODE*/
+
+static int32_t bench_ns_to_ticks(uint64_t lNs)
+{
+  return (int32_t)((lNs * RTIMER_SECOND + 500000000ULL) / 1000000000ULL);
+}
+
+/**
+  * @brief  Fails if lNs is more than BENCH_TSCH_TICKS away from lConstUs.
+  */
+static void bench_check_delay(const char *pcOp, uint16_t nLen, uint64_t lNs, uint32_t lConstUs,
+                              const char *pcWhy)
+{
+  int32_t lError = bench_ns_to_ticks(lNs) - (int32_t)US_TO_RTIMERTICKS(lConstUs);
+
+  printf("tsch: %s %.1f us, RADIO_CONST %lu us\n", pcOp, lNs / 1000.0, (unsigned long)lConstUs);
+  if(lError < -BENCH_TSCH_TICKS || lError > BENCH_TSCH_TICKS)
+  {
+    bench_fail(pcOp, nLen, pcWhy);
+  }
+}
+
+/**
+  * @brief  TSCH use of the driver, in poll mode: a frame sent at a deadline,
+  *         the radio turned on, a frame detected and read with the radio off.
+  *         The delays are checked against the RADIO_CONST_* values.
+  */
+static void bench_tsch(void)
+{
+  uint8_t aTx[50], aRx[50], aMac[50];
+  uint64_t lStart, lNs;
+  const uint16_t *pnTiming = NULL;
+  radio_value_t xMode = 0, xTxMode = 0;
+  rtimer_clock_t xSfd;
+  int32_t lError;
+  int nLen;
+
+  /* As tsch_init(): no filtering, no ACK, no CCA */
+  subGHz_radio_driver.get_value(RADIO_PARAM_RX_MODE, &xMode);
+  subGHz_radio_driver.get_value(RADIO_PARAM_TX_MODE, &xTxMode);
+  subGHz_radio_driver.set_value(RADIO_PARAM_RX_MODE, RADIO_RX_MODE_POLL_MODE);
+  subGHz_radio_driver.set_value(RADIO_PARAM_TX_MODE, 0);
+  if(S2LP_SIM_PeekRegister(IRQ_MASK3_ADDR) | S2LP_SIM_PeekRegister(IRQ_MASK2_ADDR) |
+     S2LP_SIM_PeekRegister(IRQ_MASK1_ADDR) | S2LP_SIM_PeekRegister(IRQ_MASK0_ADDR))
+  {
+    bench_fail("tsch", 0, "IRQ still routed to the GPIO in poll mode");
+  }
+  if(subGHz_radio_driver.get_object(RADIO_CONST_TSCH_TIMING, &pnTiming, sizeof(pnTiming)) != RADIO_RESULT_OK ||
+     pnTiming[10] < (127 + RADIO_PHY_OVERHEAD_BYTES) * RADIO_BYTE_AIR_TIME_US ||
+     pnTiming[11] < pnTiming[2] + pnTiming[10] + pnTiming[5] + pnTiming[9] ||
+     pnTiming[3] < RADIO_DELAY_BEFORE_RX_US || pnTiming[2] < RADIO_DELAY_BEFORE_TX_US)
+  {
+    bench_fail("tsch", 0, "wrong RADIO_CONST_TSCH_TIMING");
+  }
+  else
+  {
+    printf("tsch: timeslot %u us, TxOffset %u us, MaxTx %u us\n", pnTiming[11], pnTiming[2],
+           pnTiming[10]);
+  }
+
+  /* TX at a deadline: the sync word ends at xSfd */
+  bench_fill(aTx, sizeof(aTx), 0x30);
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+  subGHz_radio_driver.prepare(aTx, sizeof(aTx));
+  xSfd = RTIMER_NOW() + US_TO_RTIMERTICKS(BENCH_TSCH_LEAD_US);
+  if(radio_transmit_at(sizeof(aTx), xSfd) != RADIO_TX_OK)
+  {
+    bench_fail("ttx", sizeof(aTx), "radio_transmit_at() failed");
+  }
+  bench_record("ttx", sizeof(aTx), lStart, 1);
+  lError = bench_ns_to_ticks(S2LP_SIM_GetLastTxSyncTime()) - (int32_t)xSfd;
+  printf("tsch: sync word sent %d ticks from the deadline\n", (int)lError);
+  if(lError < -BENCH_TSCH_TICKS || lError > BENCH_TSCH_TICKS)
+  {
+    bench_fail("ttx", sizeof(aTx), "sync word not at the deadline");
+  }
+  if(aResults[nResults - 1].xStats.nIrqs != 0)
+  {
+    bench_fail("ttx", sizeof(aTx), "IRQ raised in poll mode");
+  }
+  subGHz_radio_driver.prepare(aTx, sizeof(aTx));
+  if(radio_transmit_at(sizeof(aTx), RTIMER_NOW()) != RADIO_TX_ERR)
+  {
+    bench_fail("ttx", sizeof(aTx), "missed deadline not reported");
+  }
+  if(pnTiming != NULL &&
+     radio_transmit_at(sizeof(aTx), RTIMER_NOW() + bench_ns_to_ticks(1000ULL * (pnTiming[11] + BENCH_TSCH_LEAD_US)))
+     != RADIO_TX_ERR)
+  {
+    bench_fail("ttx", sizeof(aTx), "deadline beyond a timeslot accepted");
+  }
+  lStart = S2LP_SIM_Now();
+  subGHz_radio_driver.transmit(sizeof(aTx));
+  bench_check_delay("ttx", sizeof(aTx), S2LP_SIM_GetLastTxSyncTime() - lStart,
+                    RADIO_DELAY_BEFORE_TX_US, "wrong RADIO_CONST_DELAY_BEFORE_TX");
+#if RADIO_FIFO_STREAMING
+  {
+    /* No threshold IRQ to stream it: refused, not sent truncated */
+    static uint8_t aLong[S2LP_TX_FIFO_SIZE + 1];
+
+    bench_fill(aLong, sizeof(aLong), 0x31);
+    if(subGHz_radio_driver.prepare(aLong, sizeof(aLong)) != RADIO_TX_ERR)
+    {
+      bench_fail("ttx", sizeof(aLong), "frame longer than the FIFO accepted in poll mode");
+    }
+  }
+#endif /*RADIO_FIFO_STREAMING*/
+
+  /* Radio on, from STANDBY to listening */
+  subGHz_radio_driver.off();
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+  subGHz_radio_driver.on();
+  while(S2LP_SIM_GetState() != MC_STATE_RX && S2LP_SIM_Now() - lStart < 1000000ULL)
+  {
+    S2LP_SIM_Advance(1000);
+  }
+  bench_record("ton", 0, lStart, 0);
+  bench_check_delay("ton", 0, S2LP_SIM_Now() - lStart, RADIO_DELAY_BEFORE_RX_US,
+                    "wrong RADIO_CONST_DELAY_BEFORE_RX");
+
+  /* RX slot: busy-wait on receiving_packet(), radio off, then read */
+  bench_fill(aRx, sizeof(aRx), 0x50);
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+  S2LP_SIM_InjectFrame(aRx, sizeof(aRx), -70, 9);
+  while(!subGHz_radio_driver.receiving_packet() && S2LP_SIM_Now() - lStart < BENCH_RX_TIMEOUT_NS);
+  lNs = S2LP_SIM_Now() - S2LP_SIM_GetLastSyncTime();
+  while(subGHz_radio_driver.receiving_packet() && S2LP_SIM_Now() - lStart < BENCH_RX_TIMEOUT_NS);
+  subGHz_radio_driver.off();
+  nLen = subGHz_radio_driver.pending_packet() ? subGHz_radio_driver.read(aMac, sizeof(aMac)) : 0;
+  bench_record("trx", sizeof(aRx), lStart, 1);
+  aResults[nResults - 1].lCallNs = 0;
+  if(nLen != sizeof(aRx) || memcmp(aMac, aRx, sizeof(aRx)))
+  {
+    bench_fail("trx", sizeof(aRx), "frame not read after the radio is off");
+  }
+  else
+  {
+    /* The poll is the edge: up to a poll late, never early */
+    if(bench_ns_to_ticks(lNs) > (int32_t)US_TO_RTIMERTICKS(RADIO_DELAY_BEFORE_DETECT_US) + BENCH_TSCH_TICKS)
+    {
+      bench_fail("trx", sizeof(aRx), "detected later than RADIO_CONST_DELAY_BEFORE_DETECT");
+    }
+    printf("tsch: frame detected %.1f us after its sync word, RADIO_CONST %u us\n", lNs / 1000.0,
+           RADIO_DELAY_BEFORE_DETECT_US);
+    bench_check_timestamp("trx", sizeof(aRx));
+  }
+  if(aResults[nResults - 1].xStats.nIrqs != 0)
+  {
+    bench_fail("trx", sizeof(aRx), "IRQ raised in poll mode");
+  }
+
+  subGHz_radio_driver.on();
+  subGHz_radio_driver.set_value(RADIO_PARAM_RX_MODE, xMode);
+  subGHz_radio_driver.set_value(RADIO_PARAM_TX_MODE, xTxMode);
+  if(S2LP_SIM_PeekRegister(IRQ_MASK0_ADDR) == 0)
+  {
+    bench_fail("tsch", 0, "IRQ masks not restored");
+  }
+#if RADIO_ASYNC_TX
+  /* An armed TX done callback does not make it asynchronous, nor is it used */
+  lStart = S2LP_SIM_Now();
+  while(S2LP_SIM_GetState() != MC_STATE_RX && S2LP_SIM_Now() - lStart < 1000000ULL)
+  {
+    S2LP_SIM_Advance(1000);
+  }
+  subGHz_radio_driver.prepare(aTx, sizeof(aTx));
+  nTxDoneCalls = 0;
+  radio_set_tx_done_callback(bench_tx_done);
+  xSfd = RTIMER_NOW() + US_TO_RTIMERTICKS(BENCH_TSCH_LEAD_US);
+  if(radio_transmit_at(sizeof(aTx), xSfd) != RADIO_TX_OK || radio_tx_in_progress() || nTxDoneCalls)
+  {
+    bench_fail("ttx", sizeof(aTx), "radio_transmit_at() not synchronous with a callback armed");
+  }
+  /* The IRQ set up in interrupt mode comes on top: late, never early */
+  lError = bench_ns_to_ticks(S2LP_SIM_GetLastTxSyncTime()) - (int32_t)xSfd;
+  printf("tsch: sync word sent %d ticks from the deadline in interrupt mode\n", (int)lError);
+  if(lError < -BENCH_TSCH_TICKS)
+  {
+    bench_fail("ttx", sizeof(aTx), "sync word before the deadline with a callback armed");
+  }
+  radio_set_tx_done_callback(NULL);
+#endif /*RADIO_ASYNC_TX*/
+}
+
+#if RADIO_ENERGY_SCAN
+/**
+  * @brief  One sweep of the energy scan, an interferer on air part of the
+  *         time on one channel: the statistics must single it out, and the
+  *         radio must be back in RX on its channel at the end.
+  */
+static void bench_scan(void)
+{
+  uint8_t aTx[20];
+  uint8_t aRecord[256];
+  radio_scan_status_t xStatus;
+  radio_scan_stats_t xScan;
+  radio_value_t xChannel = 0;
+  uint64_t lStart;
+  uint16_t nLen;
+  uint8_t i;
+
+  subGHz_radio_driver.get_value(RADIO_PARAM_CHANNEL, &xChannel);
+  S2LP_SIM_SetInterferer((uint32_t)(BASE_FREQUENCY + BENCH_SCAN_JAM_CH * CHANNEL_SPACE),
+                         BENCH_SCAN_JAM_DBM, BENCH_SCAN_JAM_DUTY);
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+  if(radio_scan_start(1) != 0)
+  {
+    bench_fail("scan", BENCH_SCAN_CHANNELS, "radio_scan_start() failed");
+    S2LP_SIM_SetInterferer(0, 0, 0);
+    return;
+  }
+  if(radio_scan_start(1) == 0)
+  {
+    bench_fail("scan", BENCH_SCAN_CHANNELS, "second scan started");
+  }
+  bench_fill(aTx, sizeof(aTx), 0x70);
+  if(subGHz_radio_driver.send(aTx, sizeof(aTx)) != RADIO_TX_ERR)
+  {
+    bench_fail("scan", BENCH_SCAN_CHANNELS, "frame sent while scanning");
+  }
+#if RADIO_SNIFF_MODE
+  if(radio_set_sniff_period(BENCH_SNIFF_PERIOD_MS) == 0)
+  {
+    bench_fail("scan", BENCH_SCAN_CHANNELS, "sniffing started while scanning");
+  }
+#endif /*RADIO_SNIFF_MODE*/
+  do
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+    radio_scan_get_status(&xStatus);
+  } while(xStatus.active && (S2LP_SIM_Now() - lStart) < 5000000000ULL);
+  bench_record("scan", BENCH_SCAN_CHANNELS, lStart, 0);
+  aResults[nResults - 1].lCallNs = 0;
+  printf("scan: %u sweep in %.1f ms, %lu samples skipped, %lu lost\n", xStatus.sweeps,
+         (S2LP_SIM_Now() - lStart) / 1e6, (unsigned long)xStatus.skipped,
+         (unsigned long)xStatus.overflows);
+  if(xStatus.active || xStatus.sweeps != 1)
+  {
+    bench_fail("scan", BENCH_SCAN_CHANNELS, "scan not over after one sweep");
+  }
+  if(xStatus.overflows != 0)
+  {
+    bench_fail("scan", BENCH_SCAN_CHANNELS, "samples lost");
+  }
+
+  for(i = CHANNEL_NUMBER_MIN; i <= CHANNEL_NUMBER_MAX; i++)
+  {
+    radio_scan_get_stats(i, &xScan);
+    if(xScan.samples < RADIO_SCAN_DWELL_SAMPLES / 2)
+    {
+      bench_fail("scan", i, "too few samples");
+    }
+    else if(i == BENCH_SCAN_JAM_CH)
+    {
+      printf("scan: channel %u min %d avg %d max %d p50 %d p90 %d busy %u%%\n", i, xScan.min_dbm,
+             xScan.avg_dbm, xScan.max_dbm, xScan.p50_dbm, xScan.p90_dbm, xScan.busy_pct);
+      if(xScan.max_dbm != BENCH_SCAN_JAM_DBM || xScan.p90_dbm != BENCH_SCAN_JAM_DBM ||
+         xScan.p50_dbm != -120 || xScan.busy_pct < BENCH_SCAN_JAM_DUTY - 5 ||
+         xScan.busy_pct > BENCH_SCAN_JAM_DUTY + 5)
+      {
+        bench_fail("scan", i, "interferer not measured");
+      }
+    }
+    else if(xScan.max_dbm != -120 || xScan.busy_pct != 0)
+    {
+      bench_fail("scan", i, "energy on a quiet channel");
+    }
+  }
+  if(radio_scan_best_channel() == BENCH_SCAN_JAM_CH || radio_scan_best_channel() < 0)
+  {
+    bench_fail("scan", BENCH_SCAN_CHANNELS, "wrong quietest channel");
+  }
+  nLen = radio_scan_export(aRecord, sizeof(aRecord));
+  if(nLen != 18 + 11 * BENCH_SCAN_CHANNELS || aRecord[0] != 'R' || aRecord[1] != 'S' ||
+     aRecord[3] != BENCH_SCAN_CHANNELS ||
+     (int8_t)aRecord[18 + 11 * BENCH_SCAN_JAM_CH + 3] != BENCH_SCAN_JAM_DBM)
+  {
+    bench_fail("scan", BENCH_SCAN_CHANNELS, "wrong radio_scan_export() record");
+  }
+#if RADIO_HOPPING
+  bench_check_channel("scan", xChannel);
+#endif /*RADIO_HOPPING*/
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail("scan", BENCH_SCAN_CHANNELS, "radio not back in RX");
+  }
+  S2LP_SIM_SetInterferer(0, 0, 0);
+}
+#endif /*RADIO_ENERGY_SCAN*/
+
+#if RADIO_ADAPTIVE_CCA
+/**
+  * @brief  Raises the noise on the channel and waits for the CCA threshold to
+  *         follow it, then sends unacknowledged frames until the backoff of the
+  *         MAC is widened.
+  */
+static void bench_cca(void)
+{
+  radio_cca_stats_t xBefore, xCca;
+  radio_value_t xChannel = 0;
+  radio_value_t xThreshold = 0;
+  uint64_t lStart;
+#if RADIO_ISR_ACK
+  uint8_t aTx[BENCH_CCA_LEN];
+  uint8_t i;
+  int ret;
+#endif /*RADIO_ISR_ACK*/
+
+  radio_cca_set_adaptive(1);
+  subGHz_radio_driver.get_value(RADIO_PARAM_CHANNEL, &xChannel);
+  radio_cca_get_stats((uint8_t)xChannel, &xBefore);
+  S2LP_SIM_SetInterferer((uint32_t)(BASE_FREQUENCY + xChannel * CHANNEL_SPACE),
+                         BENCH_CCA_NOISE_DBM, 100);
+  S2LP_SIM_ResetStats();
+  lStart = S2LP_SIM_Now();
+  while((S2LP_SIM_Now() - lStart) <
+        BENCH_CCA_WINDOWS * RADIO_CCA_WINDOW * RADIO_CCA_SAMPLE_MS * 1000000ULL)
+  {
+    S2LP_SIM_Advance(BENCH_CCA_STEP_NS);
+    process_run();
+  }
+  bench_record("cca", BENCH_CCA_WINDOWS * RADIO_CCA_WINDOW, lStart, 0);
+  aResults[nResults - 1].lCallNs = 0;
+  S2LP_SIM_SetInterferer(0, 0, 0);
+
+  radio_cca_get_stats((uint8_t)xChannel, &xCca);
+  subGHz_radio_driver.get_value(RADIO_PARAM_CCA_THRESHOLD, &xThreshold);
+  printf("cca: noise floor %d -> %d dBm, threshold %d dBm, %lu samples\n",
+         xBefore.noise_floor_dbm, xCca.noise_floor_dbm, (int)xThreshold,
+         (unsigned long)(xCca.noise_samples - xBefore.noise_samples));
+  if(xCca.noise_samples - xBefore.noise_samples < BENCH_CCA_WINDOWS * RADIO_CCA_WINDOW - 1)
+  {
+    bench_fail("cca", xChannel, "noise samples skipped");
+  }
+  if(xCca.noise_floor_dbm < BENCH_CCA_NOISE_DBM - 10 || xCca.noise_floor_dbm > BENCH_CCA_NOISE_DBM)
+  {
+    bench_fail("cca", xChannel, "noise floor not tracked");
+  }
+  if(xThreshold != xCca.threshold_dbm ||
+     xCca.threshold_dbm != xCca.noise_floor_dbm + RADIO_CCA_MARGIN_DB)
+  {
+    bench_fail("cca", xChannel, "threshold not set above the noise floor");
+  }
+
+#if RADIO_ISR_ACK
+  /* Frames lost while the channel looked clear: more sensitive CCA, longer
+   * backoffs. Whatever the count of the frames sent before, these cover a
+   * whole adaptation period. */
+  xBefore = xCca;
+  bench_frame(aTx, sizeof(aTx), &xPeerAddr, &linkaddr_node_addr, 0x80);
+  for(i = 0; i < BENCH_CCA_FRAMES; i++)
+  {
+    packetbuf_clear();
+    packetbuf_set_addr(PACKETBUF_ADDR_RECEIVER, &xPeerAddr);
+    nTxDoneCalls = 0;
+    lStart = S2LP_SIM_Now();
+#if RADIO_ASYNC_TX
+    radio_set_tx_done_callback(bench_tx_done);
+#endif /*RADIO_ASYNC_TX*/
+    ret = subGHz_radio_driver.send(aTx, sizeof(aTx));
+#if RADIO_ASYNC_TX
+    while(nTxDoneCalls == 0 && (S2LP_SIM_Now() - lStart) < 10 * BENCH_RX_TIMEOUT_NS)
+    {
+      S2LP_SIM_Advance(BENCH_STEP_NS);
+      process_run();
+    }
+    ret = nTxDoneCalls ? nTxDoneStatus : RADIO_TX_ERR;
+#endif /*RADIO_ASYNC_TX*/
+    if(ret != RADIO_TX_NOACK)
+    {
+      bench_fail("cca", xChannel, "missing ACK not reported");
+    }
+  }
+  radio_cca_get_stats((uint8_t)xChannel, &xCca);
+  printf("cca: %lu frames, %lu without ACK, threshold %d dBm, backoff boost %u\n",
+         (unsigned long)xCca.tx_frames, (unsigned long)xCca.noack, xCca.threshold_dbm,
+         xCca.backoff_boost);
+  if(xCca.noack - xBefore.noack != BENCH_CCA_FRAMES || xCca.adaptations == xBefore.adaptations ||
+     xCca.threshold_dbm >= xBefore.threshold_dbm || xCca.backoff_boost <= xBefore.backoff_boost ||
+     radio_cca_backoff_boost() != xCca.backoff_boost)
+  {
+    bench_fail("cca", xChannel, "no adaptation to the missing ACKs");
+  }
+#endif /*RADIO_ISR_ACK*/
+
+  /* A threshold set by the upper layers stops the adaptation */
+  subGHz_radio_driver.set_value(RADIO_PARAM_CCA_THRESHOLD, BENCH_CCA_FIXED_DBM);
+  subGHz_radio_driver.get_value(RADIO_PARAM_CCA_THRESHOLD, &xThreshold);
+  if(xThreshold != BENCH_CCA_FIXED_DBM || radio_cca_backoff_boost() != 0)
+  {
+    bench_fail("cca", xChannel, "set threshold not applied");
+  }
+  radio_cca_set_adaptive(1);
+  if(radio_cca_backoff_boost() != xCca.backoff_boost)
+  {
+    bench_fail("cca", xChannel, "adaptation not turned back on");
+  }
+  radio_cca_set_adaptive(0);
+  if(S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail("cca", xChannel, "radio not back in RX");
+  }
+}
+#endif /*RADIO_ADAPTIVE_CCA*/
+
+#if RADIO_STATS
+/**
+  * @brief  A frame sent and one received with the driver statistics reset:
+  *         its SPI counters must match the model, the frames and their time
+  *         on air must be accounted.
+  */
+static void bench_stats(void)
+{
+  uint8_t aTx[BENCH_STATS_LEN];
+  uint32_t nFrames = host_mac_frame_count();
+  uint64_t lAirUs = S2LP_SIM_FrameAirTimeNs(BENCH_STATS_LEN) / 1000;
+  uint64_t lStart;
+  S2LP_SIM_Stats xSim;
+  radio_stats_t xStats;
+  uint32_t nHist = 0;
+
+  bench_fill(aTx, sizeof(aTx), 0x5A);
+  radio_reset_stats();
+  S2LP_SIM_ResetStats();
+
+  packetbuf_clear();
+  nTxDoneCalls = 0;
+  lStart = S2LP_SIM_Now();
+#if RADIO_ASYNC_TX
+  radio_set_tx_done_callback(bench_tx_done);
+#endif /*RADIO_ASYNC_TX*/
+  subGHz_radio_driver.send(aTx, sizeof(aTx));
+#if RADIO_ASYNC_TX
+  while(nTxDoneCalls == 0 && (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS)
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+  }
+#endif /*RADIO_ASYNC_TX*/
+  lStart = S2LP_SIM_Now();
+  S2LP_SIM_InjectFrame(aTx, sizeof(aTx), -60, 9);
+  while(host_mac_frame_count() == nFrames &&
+        (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS + S2LP_SIM_FrameAirTimeNs(sizeof(aTx)))
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+  }
+
+  S2LP_SIM_GetStats(&xSim);
+  if(subGHz_radio_driver.get_object(RADIO_PARAM_DRIVER_STATS, &xStats, sizeof(xStats)) != RADIO_RESULT_OK)
+  {
+    bench_fail("stats", BENCH_STATS_LEN, "RADIO_PARAM_DRIVER_STATS not supported");
+    return;
+  }
+  for(uint8_t i = 0; i < RADIO_STATS_HIST_BINS; i++)
+  {
+    nHist += xStats.hist[RADIO_STATS_ISR].bins[i];
+  }
+  printf("stats: tx %lu frames %lu us, rx %lu frames %lu us (air %lu us), %lu irqs, "
+         "%lu transactions %lu bytes, isr avg %lu max %lu us\n",
+         (unsigned long)xStats.tx_frames, (unsigned long)xStats.tx_us,
+         (unsigned long)xStats.rx_frames, (unsigned long)xStats.rx_us, (unsigned long)lAirUs,
+         (unsigned long)xStats.irqs, (unsigned long)xStats.spi_transactions,
+         (unsigned long)xStats.spi_bytes,
+         (unsigned long)(xStats.hist[RADIO_STATS_ISR].count ?
+                         xStats.hist[RADIO_STATS_ISR].total_us / xStats.hist[RADIO_STATS_ISR].count : 0),
+         (unsigned long)xStats.hist[RADIO_STATS_ISR].max_us);
+  if(xStats.spi_transactions != xSim.nTransactions || xStats.spi_bytes != xSim.nBytes)
+  {
+    bench_fail("stats", BENCH_STATS_LEN, "SPI traffic differs from the model");
+  }
+  if(xStats.tx_frames != 1 || xStats.tx_us < lAirUs || xStats.tx_us > lAirUs + BENCH_STATS_SLACK_US)
+  {
+    bench_fail("stats", BENCH_STATS_LEN, "TX time not accounted");
+  }
+  if(xStats.rx_frames != 1 || xStats.rx_us == 0 || xStats.rx_us > lAirUs)
+  {
+    bench_fail("stats", BENCH_STATS_LEN, "RX time not accounted");
+  }
+  if(xStats.irqs == 0 || xStats.irqs + xStats.irqs_deferred > xSim.nIrqs ||
+     xStats.hist[RADIO_STATS_ISR].count != xStats.irqs || nHist != xStats.irqs ||
+     xStats.hist[RADIO_STATS_TRANSMIT].count != 1 || xStats.hist[RADIO_STATS_WAIT].count == 0)
+  {
+    bench_fail("stats", BENCH_STATS_LEN, "histograms not consistent");
+  }
+}
+#endif /*RADIO_STATS*/
+
+/**
+  * @brief  Bus of a second S2-LP, a plain register file: it counts the
+  *         transactions that reach it.
+  */
+static int32_t bench_other_init(void)
+{
+  return 0;
+}
+
+static int32_t bench_other_write(uint8_t *pcHeader, uint8_t *pcBuffer, uint16_t nLen)
+{
+  uint8_t cAddr = pcHeader[1];
+
+  nOtherTransactions++;
+  if(pcHeader[0] == READ_HEADER && cAddr != LINEAR_FIFO_ADDRESS)
+  {
+    memcpy(pcBuffer, &aOtherRegs[cAddr], nLen);
+  }
+  else if(pcHeader[0] == WRITE_HEADER && cAddr != LINEAR_FIFO_ADDRESS)
+  {
+    memcpy(&aOtherRegs[cAddr], pcBuffer, nLen);
+  }
+  pcHeader[0] = 0;
+  pcHeader[1] = MC_STATE_READY << 1;
+  return 0;
+}
+
+static void bench_other_delay(uint32_t lMs)
+{
+  (void)lMs;
+}
+
+/**
+  * @brief  A second S2-LP driven through its own library object while the
+  *         driver receives a frame: its IRQ handler must switch to the
+  *         object of the driver and back, and neither radio must see the
+  *         traffic of the other one.
+  */
+static void bench_multi(void)
+{
+  static S2LP_Object_t xOther;
+  S2LP_IO_t xOtherIO = { bench_other_init, NULL, bench_other_write, bench_other_delay };
+  S2LP_SIM_Stats xSim;
+  S2LP_Object_t *pxDriver;
+  uint8_t aRx[BENCH_MULTI_LEN];
+  uint32_t nFrames = host_mac_frame_count();
+  uint32_t nOther;
+  uint64_t lStart;
+  radio_value_t xChannel = 0;
+
+  subGHz_radio_driver.get_value(RADIO_PARAM_CHANNEL, &xChannel);
+  S2LP_SIM_ResetStats();
+  pxDriver = S2LP_SelectObject(&xOther);
+  S2LP_RegisterBusIO(&xOtherIO);
+  S2LP_Init();
+  S2LP_ShadowEnable(S_ENABLE);
+  S2LP_RADIO_SetXtalFrequency(BENCH_MULTI_XTAL);
+  S2LP_RADIO_SetChannel(BENCH_MULTI_CHANNEL);
+  nOther = nOtherTransactions;
+
+  /* The frame is received while the other radio is selected */
+  bench_fill(aRx, sizeof(aRx), 0x3C);
+  lStart = S2LP_SIM_Now();
+  S2LP_SIM_InjectFrame(aRx, sizeof(aRx), -60, 9);
+  while((S2LP_SIM_Now() - lStart) < S2LP_SIM_FrameAirTimeNs(sizeof(aRx)) + BENCH_MULTI_SLACK_NS)
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+  }
+  S2LP_SIM_GetStats(&xSim);
+  if(xSim.nIrqs == 0 || xSim.nTransactions == 0)
+  {
+    bench_fail("multi", BENCH_MULTI_LEN, "IRQ of the driver not served");
+  }
+  if(nOtherTransactions != nOther || S2LP_RADIO_GetChannel() != BENCH_MULTI_CHANNEL ||
+     S2LP_RADIO_GetXtalFrequency() != BENCH_MULTI_XTAL)
+  {
+    bench_fail("multi", BENCH_MULTI_LEN, "other radio disturbed by the IRQ handler");
+  }
+  if(S2LP_SelectObject(pxDriver) != &xOther)
+  {
+    bench_fail("multi", BENCH_MULTI_LEN, "object not given back by the IRQ handler");
+  }
+
+  while(host_mac_frame_count() == nFrames && (S2LP_SIM_Now() - lStart) < BENCH_RX_TIMEOUT_NS)
+  {
+    S2LP_SIM_Advance(BENCH_STEP_NS);
+    process_run();
+  }
+  if(host_mac_frame_count() == nFrames)
+  {
+    bench_fail("multi", BENCH_MULTI_LEN, "frame not delivered");
+  }
+  if(nOtherTransactions != nOther || S2LP_RADIO_GetXtalFrequency() != XTAL_FREQUENCY ||
+     S2LP_SIM_GetState() != MC_STATE_RX)
+  {
+    bench_fail("multi", BENCH_MULTI_LEN, "driver radio not given back");
+  }
+  printf("multi: %lu transactions on the other radio, channel %d kept by the driver\n",
+         (unsigned long)nOtherTransactions, (int)xChannel);
+  {
+    radio_value_t xNow = 0;
+
+    subGHz_radio_driver.get_value(RADIO_PARAM_CHANNEL, &xNow);
+    if(xNow != xChannel)
+    {
+      bench_fail("multi", BENCH_MULTI_LEN, "driver channel changed");
+    }
+  }
+}
+
+static void bench_print(void)
+{
+  printf("%-6s %5s %6s %6s %6s %10s %10s %10s %10s %10s\n", "op", "len", "trans", "bytes", "irqs", "bus_us",
+         "buscpu_us", "total_us", "ovh_us", "call_us");
+  for(uint8_t i = 0; i < nResults; i++)
+  {
+    BenchResult *pxRes = &aResults[i];
+    printf("%-6s %5u %6u %6u %6u %10.1f %10.1f %10.1f %10.1f %10.1f\n", pxRes->cOp, pxRes->nLen,
+           pxRes->xStats.nTransactions, pxRes->xStats.nBytes, pxRes->xStats.nIrqs,
+           pxRes->xStats.lBusTimeNs / 1000.0, pxRes->xStats.lBusCpuNs / 1000.0,
+           pxRes->lTotalNs / 1000.0,
+           (pxRes->lTotalNs - pxRes->lAirNs) / 1000.0, pxRes->lCallNs / 1000.0);
+  }
+}
+
+static int bench_write_baseline(const char *pcFile)
+{
+  FILE *f = fopen(pcFile, "w");
+
+  if(f == NULL)
+  {
+    perror(pcFile);
+    return 1;
+  }
+  fprintf(f, "# op len transactions bytes\n");
+  for(uint8_t i = 0; i < nResults; i++)
+  {
+    fprintf(f, "%s %u %u %u\n", aResults[i].cOp, aResults[i].nLen,
+            aResults[i].xStats.nTransactions, aResults[i].xStats.nBytes);
+  }
+  fclose(f);
+  return 0;
+}
+
+/**
+  * @brief  Fails if any operation needs more transactions or more bytes than
+  *         recorded in the baseline file.
+  */
+static int bench_check_baseline(const char *pcFile)
+{
+  char cLine[128], cOp[16];
+  unsigned nLen, nTrans, nBytes;
+  int nWorse = 0;
+  FILE *f = fopen(pcFile, "r");
+
+  if(f == NULL)
+  {
+    perror(pcFile);
+    return 1;
+  }
+  while(fgets(cLine, sizeof(cLine), f))
+  {
+    if(cLine[0] == '#' || sscanf(cLine, "%15s %u %u %u", cOp, &nLen, &nTrans, &nBytes) != 4)
+    {
+      continue;
+    }
+    for(uint8_t i = 0; i < nResults; i++)
+    {
+      BenchResult *pxRes = &aResults[i];
+      if(strcmp(pxRes->cOp, cOp) || pxRes->nLen != nLen)
+      {
+        continue;
+      }
+      if(pxRes->xStats.nTransactions > nTrans || pxRes->xStats.nBytes > nBytes)
+      {
+        fprintf(stderr, "REGRESSION %s/%u: %u transactions, %u bytes (baseline %u, %u)\n",
+                cOp, nLen, pxRes->xStats.nTransactions, pxRes->xStats.nBytes, nTrans, nBytes);
+        nWorse++;
+      }
+    }
+  }
+  fclose(f);
+  return nWorse ? 1 : 0;
+}
+
+/* Exported functions --------------------------------------------------------*/
+int main(int argc, char *argv[])
+{
+  const char *pcCheck = NULL, *pcWrite = NULL;
+  int ret = 0;
+
+  for(int i = 1; i < argc; i++)
+  {
+    if(!strcmp(argv[i], "-c") && i + 1 < argc)
+    {
+      pcCheck = argv[++i];
+    }
+    else if(!strcmp(argv[i], "-w") && i + 1 < argc)
+    {
+      pcWrite = argv[++i];
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [-c baseline] [-w baseline]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  bench_init();
+  for(uint8_t i = 0; i < sizeof(aLengths) / sizeof(aLengths[0]); i++)
+  {
+    bench_send(aLengths[i]);
+  }
+#if RADIO_ASYNC_TX
+  for(uint8_t i = 0; i < sizeof(aLengths) / sizeof(aLengths[0]); i++)
+  {
+    bench_send_async(aLengths[i]);
+  }
+#endif /*RADIO_ASYNC_TX*/
+  for(uint8_t i = 0; i < sizeof(aLengths) / sizeof(aLengths[0]); i++)
+  {
+    bench_read(aLengths[i]);
+  }
+  bench_burst(50);
+  bench_settings();
+#if RADIO_FIFO_STREAMING
+  for(uint8_t i = 0; i < sizeof(aLongLengths) / sizeof(aLongLengths[0]); i++)
+  {
+    bench_send(aLongLengths[i]);
+    bench_read(aLongLengths[i]);
+  }
+#endif /*RADIO_FIFO_STREAMING*/
+#if RADIO_ISR_ACK
+  for(uint8_t i = 0; i < sizeof(aLengths) / sizeof(aLengths[0]); i++)
+  {
+    bench_unicast(aLengths[i] < 30 ? 30 : aLengths[i], 1);
+  }
+  bench_unicast(50, 0);
+#if RADIO_HW_ACK
+  nPeerSkips = 1;
+  bench_unicast(50, 1);
+#if RADIO_FIFO_STREAMING
+  bench_unicast(aLongLengths[0], 1);
+#endif /*RADIO_FIFO_STREAMING*/
+#endif /*RADIO_HW_ACK*/
+  bench_rx_ack(50);
+#endif /*RADIO_ISR_ACK*/
+#if !RADIO_LONG_PREAMBLE
+  /* The wake-up preamble does not fit a TSCH timeslot */
+  bench_tsch();
+#endif /*!RADIO_LONG_PREAMBLE*/
+#if RADIO_SNIFF_MODE
+  bench_sniff();
+#endif /*RADIO_SNIFF_MODE*/
+#if RADIO_ENERGY_SCAN
+  bench_scan();
+#endif /*RADIO_ENERGY_SCAN*/
+#if RADIO_ADAPTIVE_CCA
+  bench_cca();
+#endif /*RADIO_ADAPTIVE_CCA*/
+#if RADIO_STATS
+  bench_stats();
+#endif /*RADIO_STATS*/
+  bench_multi();
+
+  bench_print();
+
+  if(pcWrite)
+  {
+    ret |= bench_write_baseline(pcWrite);
+  }
+  if(pcCheck)
+  {
+    ret |= bench_check_baseline(pcCheck);
+  }
+  if(nFailures)
+  {
+    fprintf(stderr, "%d check(s) failed\n", nFailures);
+    ret = 1;
+  }
+  return ret;
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
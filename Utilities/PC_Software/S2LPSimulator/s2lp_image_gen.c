@@ -0,0 +1,124 @@
+/**
+  ******************************************************************************
+  * @file    s2lp_image_gen.c
+  * @author  SRA Application Team
+  * @brief   Runs the S2-LP library initialization of a Contiki-NG project
+  *          against the simulator and prints the resulting configuration
+  *          registers as a C image for S2LP_WriteRegisterBatch()
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "contiki.h"
+#include "radio-driver.h"
+#include "s2lp_interface.h"
+#include "s2lp_sim.h"
+
+/* Private variables ---------------------------------------------------------*/
+/* Configuration structures of the radio driver */
+extern SRadioInit xRadioInit;
+#if RADIO_HW_ACK
+extern PktStackInit xStackInit;
+#else /*!RADIO_HW_ACK*/
+extern PktBasicInit xBasicInit;
+#endif /*RADIO_HW_ACK*/
+extern SGpioInit xGpioIRQ;
+#if RADIO_HW_CSMA
+extern SCsmaInit xCsmaInit;
+#endif /*RADIO_HW_CSMA*/
+
+static uint8_t aReset[S2LP_SHADOW_SIZE];
+static uint8_t aConfig[S2LP_SHADOW_SIZE];
+static S2LPRegValue aImage[S2LP_SHADOW_SIZE];
+
+/* Private functions ---------------------------------------------------------*/
+static void image_reset(void)
+{
+  S2LP_SIM_Init(NULL);
+  S2LPInterfaceInit();
+  S2LP_RADIO_SetXtalFrequency(XTAL_FREQUENCY);
+  S2LP_CMD_StrobeSres();
+  S2LP_SIM_ResetStats();
+}
+
+static void image_peek(uint8_t *pcRegs)
+{
+  for(uint16_t i = 0; i < S2LP_SHADOW_SIZE; i++)
+  {
+    pcRegs[i] = S2LP_SIM_PeekRegister((uint8_t)i);
+  }
+}
+
+int main(int argc, char *argv[])
+{
+  const char *pcName = (argc > 1) ? argv[1] : "xS2LPConfigImage";
+  S2LP_SIM_Stats xInitStats, xImageStats;
+  uint16_t nCount = 0;
+
+  image_reset();
+  image_peek(aReset);
+
+  S2LP_RADIO_Init(&xRadioInit);
+#if RADIO_HW_ACK
+  S2LP_PCKT_STACK_Init(&xStackInit);
+#else /*!RADIO_HW_ACK*/
+  S2LP_PCKT_BASIC_Init(&xBasicInit);
+#endif /*RADIO_HW_ACK*/
+#if RADIO_HW_CSMA
+  S2LP_CSMA_Init(&xCsmaInit);
+#endif /*RADIO_HW_CSMA*/
+  S2LP_GPIO_Init(&xGpioIRQ);
+  S2LP_SIM_GetStats(&xInitStats);
+  image_peek(aConfig);
+
+  for(uint16_t i = 0; i < S2LP_SHADOW_SIZE; i++)
+  {
+    if(aConfig[i] != aReset[i])
+    {
+      aImage[nCount].cAddress = (uint8_t)i;
+      aImage[nCount].cValue = aConfig[i];
+      nCount++;
+    }
+  }
+
+  /* The image must give back the same registers, from reset */
+  image_reset();
+  S2LP_WriteRegisterBatch(aImage, nCount);
+  S2LP_SIM_GetStats(&xImageStats);
+  image_peek(aReset);
+  if(memcmp(aReset, aConfig, sizeof(aConfig)))
+  {
+    fprintf(stderr, "s2lp_image_gen: the image does not reproduce the configuration\n");
+    return 1;
+  }
+
+  printf("/* Generated by s2lp_image_gen: radio, packet, CSMA and GPIO configuration\n");
+  printf(" * of the radio driver. Write it after S2LP_CMD_StrobeSres() with\n");
+  printf(" * S2LP_WriteRegisterBatch(%s, %u).\n", pcName, nCount);
+  printf(" * Library init: %u SPI transactions, %u bytes. Image: %u transactions, %u bytes.\n",
+         (unsigned)xInitStats.nTransactions, (unsigned)xInitStats.nBytes,
+         (unsigned)xImageStats.nTransactions, (unsigned)xImageStats.nBytes);
+  printf(" */\n");
+  printf("static const S2LPRegValue %s[] = {\n", pcName);
+  for(uint16_t i = 0; i < nCount; i++)
+  {
+    printf("  { 0x%02X, 0x%02X },\n", aImage[i].cAddress, aImage[i].cValue);
+  }
+  printf("};\n");
+  return 0;
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,1396 @@
+/**
+  ******************************************************************************
+  * @file    s2lp_sim.c
+  * @author  SRA Application Team
+  * @brief   Host-side register level model of the S2-LP transceiver
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <string.h>
+#include "s2lp_sim.h"
+#include "s2lp.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_FIFO_SIZE            S2LP_TX_FIFO_SIZE
+#define SIM_NS_PER_S             1000000000ULL
+
+#define IRQ_BIT(x)               ((uint32_t)(x))
+#define SIM_JAM_PERIOD_NS        10000000ULL
+#define SIM_JAM_BANDWIDTH_HZ     100000
+#define SIM_VCO_EXT_CAL          (VCO_CALAMP_EXT_SEL_REGMASK | VCO_CALFREQ_EXT_SEL_REGMASK)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint8_t  cData[S2LP_SIM_MAX_FRAME_LEN];
+  uint16_t nLen;
+  int8_t   cRssidBm;
+  uint8_t  cLqi;
+  uint64_t lCarrierStart; /*!< Time the first preamble bit is on air */
+  uint64_t lSyncTime;  /*!< Time the sync word has been received */
+  uint64_t lEndTime;   /*!< Time the last bit has been received */
+  uint8_t  bSynced;    /*!< The radio was in RX when the sync word arrived */
+  uint16_t nDelivered; /*!< Bytes already moved to the RX FIFO */
+  uint64_t lPayloadStart; /*!< Time the first payload bit has been received */
+  uint8_t  cLlp;       /*!< LLP control field, STack format only */
+} SimRxFrame;
+
+/* Private variables ---------------------------------------------------------*/
+static S2LP_SIM_Config xConfig;
+static S2LP_SIM_Stats xStats;
+
+static uint8_t  aRegs[256];
+static uint8_t  cState;            /*!< MC_STATE as reported on the bus */
+static uint8_t  cNextState;        /*!< Target of a pending transition */
+static uint64_t lTransitionEnd;    /*!< 0 when no transition is in progress */
+static uint8_t  bLockTx;           /*!< The LOCK in progress uses the TX synth configuration */
+static uint64_t lNow;
+static uint32_t lTunedHz;          /*!< Carrier the synthesizer locked on last */
+static uint64_t lLdcWake;          /*!< Next LDC wake up, 0 when the wake-up timer is off */
+static uint64_t lFastRxEnd;        /*!< End of the carrier sense window of a wake up */
+static uint64_t lRxTimerEnd;       /*!< RX timer expiry of a wake up */
+static uint16_t nPeerPreambleBits; /*!< Preamble of the injected frames, 0: as programmed here */
+static uint8_t  bPeerAckRequest;   /*!< The injected STack frames ask for an ACK */
+static uint8_t  cPeerSeq;          /*!< LLP sequence number of the next injected frame */
+static uint32_t lJamHz;            /*!< Carrier of the interferer, 0: none */
+static int8_t   cJamdBm;           /*!< Its level at the antenna */
+static uint8_t  nJamDutyPct;       /*!< Part of every SIM_JAM_PERIOD_NS it is on air */
+
+static uint8_t  aTxFifo[SIM_FIFO_SIZE];
+static uint16_t nTxFifo;
+static uint64_t lTxEnd;            /*!< 0 when no TX is in progress */
+static uint64_t lTxPayloadStart;   /*!< Time the first payload bit goes on air */
+static uint16_t nTxLen;            /*!< Payload bytes of the frame on air */
+static uint8_t  aLastTx[S2LP_SIM_MAX_FRAME_LEN];
+static uint16_t nLastTx;
+static uint16_t nLastTxPreambleBits;
+static uint8_t  cTxSeq;            /*!< LLP sequence number of the frame being sent */
+static uint8_t  cTxLlp;            /*!< LLP control field of the frame on air or of the last one sent */
+static uint8_t  nReTx;             /*!< Retransmissions of the frame being sent */
+static uint8_t  bAckWait;          /*!< The LLP waits in RX for the ACK of the frame sent */
+static uint64_t lAckTxEnd;         /*!< End of the ACK sent by the LLP, 0 if none */
+
+static uint8_t  aRxFifo[SIM_FIFO_SIZE];
+static uint16_t nRxFifo;
+static SimRxFrame aRxQueue[S2LP_SIM_RX_QUEUE_LEN];
+static uint8_t  cRxHead, cRxCount;
+static uint64_t lLastSyncTime;     /*!< End of the sync word of the last frame detected */
+static uint64_t lLastTxSyncTime;   /*!< End of the sync word of the last frame sent */
+
+static uint32_t lIrqStatus;
+static uint8_t  bLineActive;
+static uint8_t  bExtiPending;
+static uint8_t  bLineMasked;
+static uint8_t  bInIsr;
+static uint8_t  bInOtherIsr;       /*!< Another ISR (rtimer) is running, see S2LP_SIM_SetIsrContext */
+static uint8_t  bPrimask;          /*!< All the interrupts are masked, see S2LP_SIM_SetPrimask */
+static uint8_t  bInTransaction;
+static uint8_t  bDmaBusy;          /*!< An asynchronous transfer owns the bus */
+static uint8_t  bDmaDone;          /*!< Its completion interrupt is pending */
+static uint64_t lDmaEnd;
+static void   (*pfnDmaCallback)(void);
+static S2LP_SIM_IrqHandler pfnIrqHandler;
+static S2LP_SIM_TxHook pfnTxHook;
+
+/* Private function prototypes -----------------------------------------------*/
+static void SimReset(void);
+static void SimRunEvents(uint64_t lUntil);
+static void SimRaiseIrq(uint32_t lIrq);
+static void SimUpdateLine(void);
+static void SimDispatchIrq(void);
+static void SimDmaComplete(void);
+static void SimDmaWait(void);
+static uint64_t SimTransfer(uint8_t *pHeader, uint8_t *pBuff, uint16_t Length);
+static void SimCommand(uint8_t cCmd);
+static void SimStartTransition(uint8_t cTarget, uint32_t lDelayNs);
+static uint32_t SimSynthSetupNs(void);
+static void SimSynthLock(uint8_t bTx);
+static uint32_t SimBitsToNs(uint32_t lBits);
+static uint32_t SimSyncBits(void);
+static uint32_t SimHeaderBits(void);
+static uint32_t SimOverheadBits(void);
+static uint64_t SimTxByteTime(void);
+static uint64_t SimRxByteTime(const SimRxFrame *pxFrame);
+static uint16_t SimAddressBytes(void);
+static uint8_t SimStack(void);
+static void SimQueueFrame(const uint8_t *pcData, uint16_t nLen, int8_t cRssidBm, uint8_t cLqi,
+                          uint64_t lDelayNs, uint8_t cLlp);
+static void SimAccount(uint64_t lUntil);
+static uint8_t SimCarrierAt(uint64_t lTime);
+static uint64_t SimLdcPeriodNs(void);
+static uint64_t SimFastRxNs(void);
+static uint64_t SimRxTimerNs(void);
+static void SimLdcSleep(void);
+static uint8_t SimJamming(void);
+
+/* Private functions ---------------------------------------------------------*/
+
+/**
+  * @brief  Loads the register reset values relevant to the driver.
+  *         Registers not listed reset to 0x00.
+  */
+static void SimReset(void)
+{
+  memset(aRegs, 0, sizeof(aRegs));
+  aRegs[GPIO0_CONF_ADDR] = 0x0A;
+  aRegs[GPIO1_CONF_ADDR] = 0xA2;
+  aRegs[GPIO2_CONF_ADDR] = 0xA2;
+  aRegs[GPIO3_CONF_ADDR] = 0xA2;
+  aRegs[SYNT3_ADDR] = 0x42;
+  aRegs[SYNT2_ADDR] = 0x16;
+  aRegs[SYNT1_ADDR] = 0x27;
+  aRegs[SYNT0_ADDR] = 0x62;
+  aRegs[CH_SPACE_ADDR] = 0x3F;
+  aRegs[MOD4_ADDR] = 0x83;
+  aRegs[MOD3_ADDR] = 0x2B;
+  aRegs[MOD2_ADDR] = 0x77;
+  aRegs[MOD1_ADDR] = 0x03;
+  aRegs[MOD0_ADDR] = 0x93;
+  aRegs[PCKTCTRL6_ADDR] = 0x80;
+  aRegs[PCKTCTRL5_ADDR] = 0x10;
+  aRegs[PCKTCTRL3_ADDR] = 0x20;
+  aRegs[PCKTCTRL1_ADDR] = 0x2C;
+  aRegs[SYNC3_ADDR] = 0x88;
+  aRegs[SYNC2_ADDR] = 0x88;
+  aRegs[SYNC1_ADDR] = 0x88;
+  aRegs[SYNC0_ADDR] = 0x88;
+  aRegs[QI_ADDR] = 0x01;
+  aRegs[PROTOCOL0_ADDR] = 0x08;
+  aRegs[FIFO_CONFIG3_ADDR] = 0x30;
+  aRegs[FIFO_CONFIG2_ADDR] = 0x30;
+  aRegs[FIFO_CONFIG1_ADDR] = 0x30;
+  aRegs[FIFO_CONFIG0_ADDR] = 0x30;
+  aRegs[VCO_CONFIG_ADDR] = 0x02;
+  aRegs[VCO_CALIBR_IN2_ADDR] = 0x88;
+  aRegs[VCO_CALIBR_IN1_ADDR] = 0x40;
+  aRegs[VCO_CALIBR_IN0_ADDR] = 0x40;
+  aRegs[FAST_RX_TIMER_ADDR] = 0x28;
+  aRegs[XO_RCO_CONF1_ADDR] = 0x45;
+  aRegs[XO_RCO_CONF0_ADDR] = 0x30;
+  aRegs[DEVICE_INFO1_ADDR] = 0x03;
+  aRegs[DEVICE_INFO0_ADDR] = 0xC1;
+
+  cState = MC_STATE_READY;
+  lTransitionEnd = 0;
+  lLdcWake = 0;
+  lFastRxEnd = 0;
+  lRxTimerEnd = 0;
+  nTxFifo = 0;
+  lTxEnd = 0;
+  nRxFifo = 0;
+  lIrqStatus = 0;
+  cTxSeq = 0;
+  cTxLlp = 0;
+  nReTx = 0;
+  bAckWait = 0;
+  lAckTxEnd = 0;
+  SimUpdateLine();
+}
+
+/**
+  * @brief  Converts a number of over the air bits in nanoseconds.
+  */
+static uint32_t SimBitsToNs(uint32_t lBits)
+{
+  return (uint32_t)(((uint64_t)lBits * SIM_NS_PER_S) / xConfig.lDatarate);
+}
+
+/**
+  * @brief  Preamble and sync word bits.
+  */
+static uint32_t SimSyncBits(void)
+{
+  return 2 * ((((uint32_t)aRegs[PCKTCTRL6_ADDR] & PREAMBLE_LEN_9_8_REGMASK) << 8) | aRegs[PCKTCTRL5_ADDR]) +
+         ((aRegs[PCKTCTRL6_ADDR] & SYNC_LEN_REGMASK) >> 2);
+}
+
+/**
+  * @brief  Preamble bits programmed in PCKTCTRL6/PCKTCTRL5.
+  */
+static uint32_t SimPreambleBits(void)
+{
+  return 2 * ((((uint32_t)aRegs[PCKTCTRL6_ADDR] & PREAMBLE_LEN_9_8_REGMASK) << 8) | aRegs[PCKTCTRL5_ADDR]);
+}
+
+/**
+  * @brief  Length, address and STack control bits, sent between the sync
+  *         word and the payload.
+  */
+static uint32_t SimHeaderBits(void)
+{
+  uint32_t lBits;
+
+  lBits = (aRegs[PCKTCTRL4_ADDR] & LEN_WID_REGMASK) ? 16 : 8;
+  lBits += (aRegs[PCKTCTRL4_ADDR] & ADDRESS_LEN_REGMASK) ? 8 : 0;
+  lBits += SimStack() ? 8 : 0;
+
+  return lBits;
+}
+
+/**
+  * @brief  Preamble, sync, length, address and CRC bits as programmed in the
+  *         packet handler registers.
+  */
+static uint32_t SimOverheadBits(void)
+{
+  static const uint8_t aCrcBytes[8] = {0, 1, 2, 2, 3, 4, 0, 0};
+  uint32_t lBits;
+
+  lBits = SimSyncBits() + SimHeaderBits();
+  lBits += 8 * aCrcBytes[(aRegs[PCKTCTRL1_ADDR] & CRC_MODE_REGMASK) >> 5];
+
+  return lBits;
+}
+
+/**
+  * @brief  Time the next payload byte is taken from the TX FIFO, 0 if none.
+  */
+static uint64_t SimTxByteTime(void)
+{
+  if(!lTxEnd || nLastTx >= nTxLen)
+  {
+    return 0;
+  }
+  return lTxPayloadStart + SimBitsToNs(8 * (uint32_t)nLastTx);
+}
+
+/**
+  * @brief  Time the next payload byte of a frame is complete and pushed to
+  *         the RX FIFO, 0 if none.
+  */
+static uint64_t SimRxByteTime(const SimRxFrame *pxFrame)
+{
+  if(pxFrame == NULL || !pxFrame->bSynced || pxFrame->nDelivered >= pxFrame->nLen)
+  {
+    return 0;
+  }
+  return pxFrame->lPayloadStart + SimBitsToNs(8 * ((uint32_t)pxFrame->nDelivered + 1));
+}
+
+/**
+  * @brief  PCKTLEN and RX_PCKT_LEN count the address byte and the STack
+  *         control field, which are not part of the FIFO content.
+  */
+static uint16_t SimAddressBytes(void)
+{
+  return ((aRegs[PCKTCTRL4_ADDR] & ADDRESS_LEN_REGMASK) ? 1 : 0) + (SimStack() ? 1 : 0);
+}
+
+/**
+  * @brief  STack packet format: the LLP control field (sequence number,
+  *         NO_ACK, ACK) follows the address.
+  */
+static uint8_t SimStack(void)
+{
+  return (aRegs[PCKTCTRL3_ADDR] & PCKT_FRMT_REGMASK) == PCKT_FRMT_REGMASK;
+}
+
+/**
+  * @brief  Recomputes the level of the IRQ line (GPIO3, active low) and latches
+  *         a falling edge into the EXTI pending flag.
+  */
+static void SimUpdateLine(void)
+{
+  uint32_t lMask;
+  uint8_t bActive;
+  uint8_t cGpio = aRegs[GPIO3_CONF_ADDR];
+
+  lMask = ((uint32_t)aRegs[IRQ_MASK3_ADDR] << 24) | ((uint32_t)aRegs[IRQ_MASK2_ADDR] << 16) |
+          ((uint32_t)aRegs[IRQ_MASK1_ADDR] << 8) | aRegs[IRQ_MASK0_ADDR];
+
+  bActive = ((cGpio & GPIO_SELECT_REGMASK) == S2LP_GPIO_DIG_OUT_IRQ) &&
+            ((cGpio & GPIO_MODE_REGMASK) != 0) && ((lIrqStatus & lMask) != 0);
+
+  if(bActive && !bLineActive)
+  {
+    bExtiPending = 1;
+  }
+  bLineActive = bActive;
+}
+
+static void SimRaiseIrq(uint32_t lIrq)
+{
+  lIrqStatus |= lIrq;
+  SimUpdateLine();
+}
+
+/**
+  * @brief  Runs the registered handler as the EXTI ISR would, as long as the
+  *         line and the CPU interrupts are not masked and no SPI
+  *         transaction is in progress.
+  */
+static void SimDispatchIrq(void)
+{
+  SimDmaComplete();
+  while(bExtiPending && !bLineMasked && !bPrimask && !bInIsr && !bInTransaction && pfnIrqHandler)
+  {
+    bExtiPending = 0;
+    bInIsr = 1;
+    xStats.nIrqs++;
+    pfnIrqHandler();
+    bInIsr = 0;
+  }
+}
+
+/**
+  * @brief  Runs the DMA transfer complete interrupt: it has the highest
+  *         priority, so it also preempts the radio ISR.
+  */
+static void SimDmaComplete(void)
+{
+  void (*pfnCallback)(void) = pfnDmaCallback;
+
+  if(!bDmaDone || bInTransaction || bPrimask)
+  {
+    return;
+  }
+  bDmaDone = 0;
+  pfnDmaCallback = NULL;
+  if(xConfig.bWrapperReenablesIrq)
+  {
+    bLineMasked = 0;
+  }
+  if(pfnCallback)
+  {
+    pfnCallback();
+  }
+}
+
+/**
+  * @brief  Blocks the CPU until the asynchronous transfer in progress, if
+  *         any, is over, as the BSP wrapper does before a new transfer.
+  *         From an ISR the completion interrupt could not preempt the wait:
+  *         the BSP refuses the access, counted in nIsrBusWaits. With the
+  *         interrupts masked it would never end, counted there too.
+  */
+static void SimDmaWait(void)
+{
+  if((bDmaBusy || bDmaDone) && (bInIsr || bInOtherIsr || bPrimask))
+  {
+    xStats.nIsrBusWaits++;
+  }
+  if(bDmaBusy)
+  {
+    xStats.lBusCpuNs += lDmaEnd - lNow;
+    SimRunEvents(lDmaEnd);
+  }
+  SimDmaComplete();
+}
+
+static void SimStartTransition(uint8_t cTarget, uint32_t lDelayNs)
+{
+  cNextState = cTarget;
+  lTransitionEnd = lNow + (lDelayNs ? lDelayNs : 1);
+  if(cTarget == MC_STATE_TX || cTarget == MC_STATE_RX || cTarget == MC_STATE_LOCKON)
+  {
+    cState = MC_STATE_SYNTH_SETUP;
+  }
+}
+
+/**
+  * @brief  READY -> TX/RX/LOCK time: the VCO calibration is skipped when both
+  *         of its words are taken from the VCO_CALIBR_IN registers.
+  */
+static uint32_t SimSynthSetupNs(void)
+{
+  if((aRegs[VCO_CONFIG_ADDR] & SIM_VCO_EXT_CAL) == SIM_VCO_EXT_CAL)
+  {
+    return xConfig.lSynthSetupNs - xConfig.lVcoCalNs;
+  }
+  return xConfig.lSynthSetupNs;
+}
+
+/**
+  * @brief  The synthesizer locks: latches the carrier and, when the VCO is
+  *         calibrated internally, reports calibration words that depend on
+  *         the synth word (the values are a model, not the device ones).
+  */
+static void SimSynthLock(uint8_t bTx)
+{
+  uint32_t lSynth = (((uint32_t)aRegs[SYNT3_ADDR] & SYNT_27_24_REGMASK) << 24) |
+                    ((uint32_t)aRegs[SYNT2_ADDR] << 16) | ((uint32_t)aRegs[SYNT1_ADDR] << 8) |
+                    aRegs[SYNT0_ADDR];
+  uint32_t lDiv = (aRegs[SYNT3_ADDR] & BS_REGMASK) ? 8 : 4;
+
+  if(aRegs[XO_RCO_CONF0_ADDR] & REFDIV_REGMASK)
+  {
+    lDiv *= 2;
+  }
+  lTunedHz = (uint32_t)((((uint64_t)xConfig.lXtalHz * lSynth) >> 19) / lDiv) +
+             (uint32_t)(((uint64_t)xConfig.lXtalHz * aRegs[CH_SPACE_ADDR] * aRegs[CHNUM_ADDR]) >> 15);
+
+  if((aRegs[VCO_CONFIG_ADDR] & SIM_VCO_EXT_CAL) != SIM_VCO_EXT_CAL)
+  {
+    aRegs[VCO_CALIBR_OUT1_ADDR] = (uint8_t)((lSynth >> 12) + bTx) & VCO_CAL_AMP_OUT_REGMASK;
+    aRegs[VCO_CALIBR_OUT0_ADDR] = (uint8_t)((lSynth >> 16) + bTx) & VCO_CAL_FREQ_OUT_REGMASK;
+  }
+}
+
+/**
+  * @brief  A frame with an RSSI at or above the carrier sense threshold is on
+  *         air (preamble included).
+  */
+static uint8_t SimCarrierAt(uint64_t lTime)
+{
+  for(uint8_t i = 0; i < cRxCount; i++)
+  {
+    const SimRxFrame *pxFrame = &aRxQueue[(cRxHead + i) % S2LP_SIM_RX_QUEUE_LEN];
+    if(pxFrame->lCarrierStart <= lTime && lTime < pxFrame->lEndTime &&
+       (uint8_t)(pxFrame->cRssidBm + 146) >= aRegs[RSSI_TH_ADDR])
+    {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+  * @brief  The interferer is on air, within the receiver bandwidth.
+  */
+static uint8_t SimJamming(void)
+{
+  uint32_t lOffset = (lTunedHz > lJamHz) ? lTunedHz - lJamHz : lJamHz - lTunedHz;
+
+  return lJamHz != 0 && cState == MC_STATE_RX && lOffset < SIM_JAM_BANDWIDTH_HZ / 2 &&
+         (lNow % SIM_JAM_PERIOD_NS) < (SIM_JAM_PERIOD_NS / 100) * nJamDutyPct;
+}
+
+/**
+  * @brief  LDC wake-up period: (counter + 1) * (prescaler + 1) RCO cycles,
+  *         times the LDC_TIMER_MULT factor.
+  */
+static uint64_t SimLdcPeriodNs(void)
+{
+  uint64_t lCycles = ((uint64_t)aRegs[TIMERS2_ADDR] + 1) * ((uint64_t)aRegs[TIMERS3_ADDR] + 1);
+
+  lCycles <<= (aRegs[PROTOCOL2_ADDR] & LDC_TIMER_MULT_REGMASK);
+  return (lCycles * SIM_NS_PER_S) / xConfig.lRcoHz;
+}
+
+/**
+  * @brief  Carrier sense window of the fast RX termination: FAST_RX_TIMER
+  *         units of 24 * 2^CHFLT_E digital clock cycles.
+  */
+static uint64_t SimFastRxNs(void)
+{
+  uint64_t lDigHz = (xConfig.lXtalHz > S2LP_DIG_DOMAIN_XTAL_THRESH) ? xConfig.lXtalHz / 2 : xConfig.lXtalHz;
+  uint64_t lUnits = aRegs[FAST_RX_TIMER_ADDR] ? aRegs[FAST_RX_TIMER_ADDR] : 1;
+
+  return (lUnits * 24 * (1U << (aRegs[CHFLT_ADDR] & CHFLT_E_REGMASK)) * SIM_NS_PER_S) / lDigHz;
+}
+
+/**
+  * @brief  RX timer (TIMERS5 counter, TIMERS4 prescaler), 0 if infinite.
+  */
+static uint64_t SimRxTimerNs(void)
+{
+  uint64_t lDigHz = (xConfig.lXtalHz > S2LP_DIG_DOMAIN_XTAL_THRESH) ? xConfig.lXtalHz / 2 : xConfig.lXtalHz;
+
+  return ((uint64_t)aRegs[TIMERS5_ADDR] * ((uint64_t)aRegs[TIMERS4_ADDR] + 1) * 1210 * SIM_NS_PER_S) / lDigHz;
+}
+
+/**
+  * @brief  Ends an LDC wake up: back to SLEEP until the next one.
+  */
+static void SimLdcSleep(void)
+{
+  cState = MC_STATE_SLEEP;
+  lFastRxEnd = 0;
+  lRxTimerEnd = 0;
+}
+
+/**
+  * @brief  Time accounting up to lUntil: RX on time (synthesizer setup
+  *         included), as the supply current follows it.
+  */
+static void SimAccount(uint64_t lUntil)
+{
+  if(cState == MC_STATE_RX || (cState == MC_STATE_SYNTH_SETUP && cNextState == MC_STATE_RX))
+  {
+    xStats.lRxOnNs += lUntil - lNow;
+  }
+}
+
+/**
+  * @brief  Executes a command strobe. Commands not valid in the current state
+  *         are ignored, as the device does.
+  */
+static void SimCommand(uint8_t cCmd)
+{
+  uint8_t bValid = 1;
+
+  switch(cCmd)
+  {
+  case CMD_TX:
+    if(cState == MC_STATE_READY && !lTransitionEnd)
+    {
+      SimStartTransition(MC_STATE_TX, SimSynthSetupNs());
+      /* A new frame for the LLP */
+      cTxSeq = (uint8_t)((cTxSeq + 1) & S2LP_SIM_LLP_SEQ_MASK);
+      nReTx = 0;
+    }
+    else
+    {
+      bValid = 0;
+    }
+    break;
+  case CMD_RX:
+    if(cState == MC_STATE_READY && !lTransitionEnd)
+    {
+      SimStartTransition(MC_STATE_RX, SimSynthSetupNs());
+      /* In LDC mode the RX command also starts the wake-up timer */
+      lLdcWake = (aRegs[PROTOCOL1_ADDR] & LDC_MODE_REGMASK) ? lNow + SimLdcPeriodNs() : 0;
+    }
+    else if(cState != MC_STATE_RX)
+    {
+      bValid = 0;
+    }
+    break;
+  case CMD_LOCKRX:
+  case CMD_LOCKTX:
+    if(cState == MC_STATE_READY && !lTransitionEnd)
+    {
+      SimStartTransition(MC_STATE_LOCKON, SimSynthSetupNs());
+      bLockTx = (cCmd == CMD_LOCKTX);
+    }
+    else
+    {
+      bValid = 0;
+    }
+    break;
+  case CMD_READY:
+    if(cState == MC_STATE_STANDBY || cState == MC_STATE_SLEEP || cState == MC_STATE_SLEEP_NOFIFO)
+    {
+      SimStartTransition(MC_STATE_READY, xConfig.lXoSettleNs);
+    }
+    else if(cState == MC_STATE_LOCKON)
+    {
+      cState = MC_STATE_READY;
+    }
+    else if(cState != MC_STATE_READY)
+    {
+      bValid = 0;
+    }
+    break;
+  case CMD_STANDBY:
+  case CMD_SLEEP:
+    if(cState == MC_STATE_READY && !lTransitionEnd)
+    {
+      cState = (cCmd == CMD_STANDBY) ? MC_STATE_STANDBY : MC_STATE_SLEEP;
+      if(cCmd == CMD_SLEEP && !lLdcWake && (aRegs[PROTOCOL1_ADDR] & LDC_MODE_REGMASK))
+      {
+        lLdcWake = lNow + SimLdcPeriodNs();
+      }
+    }
+    else
+    {
+      bValid = 0;
+    }
+    break;
+  case CMD_SABORT:
+    if(cState == MC_STATE_TX || cState == MC_STATE_RX || cState == MC_STATE_SYNTH_SETUP ||
+       cState == MC_STATE_LOCKON)
+    {
+      cState = MC_STATE_READY;
+      lTransitionEnd = 0;
+      lTxEnd = 0;
+      lFastRxEnd = 0;
+      lRxTimerEnd = 0;
+      bAckWait = 0;
+      lAckTxEnd = 0;
+    }
+    else
+    {
+      bValid = 0;
+    }
+    break;
+  case CMD_SRES:
+    SimReset();
+    SimRaiseIrq(IRQ_BIT(POR));
+    break;
+  case CMD_FLUSHRXFIFO:
+    nRxFifo = 0;
+    break;
+  case CMD_FLUSHTXFIFO:
+    nTxFifo = 0;
+    break;
+  default:
+    break;
+  }
+
+  if(!bValid)
+  {
+    xStats.nInvalidCommands++;
+  }
+}
+
+/**
+  * @brief  Processes every radio event due before lUntil.
+  */
+static void SimRunEvents(uint64_t lUntil)
+{
+  for(;;)
+  {
+    uint64_t lNext = lUntil;
+    SimRxFrame *pxFrame = cRxCount ? &aRxQueue[cRxHead] : NULL;
+    uint64_t lTxByte = SimTxByteTime();
+    uint64_t lRxByte = SimRxByteTime(pxFrame);
+
+    if(bDmaBusy && lDmaEnd < lNext) lNext = lDmaEnd;
+    if(lTransitionEnd && lTransitionEnd < lNext) lNext = lTransitionEnd;
+    if(lTxByte && lTxByte < lNext) lNext = lTxByte;
+    if(lTxEnd && lTxEnd < lNext) lNext = lTxEnd;
+    if(lAckTxEnd && lAckTxEnd < lNext) lNext = lAckTxEnd;
+    if(lRxByte && lRxByte < lNext) lNext = lRxByte;
+    if(pxFrame && !pxFrame->bSynced && pxFrame->lSyncTime < lNext) lNext = pxFrame->lSyncTime;
+    if(pxFrame && pxFrame->lEndTime < lNext) lNext = pxFrame->lEndTime;
+    if(lLdcWake && lLdcWake < lNext) lNext = lLdcWake;
+    if(lFastRxEnd && lFastRxEnd < lNext) lNext = lFastRxEnd;
+    if(lRxTimerEnd && lRxTimerEnd < lNext) lNext = lRxTimerEnd;
+
+    if(lNext >= lUntil)
+    {
+      break;
+    }
+    SimAccount(lNext);
+    lNow = lNext;
+
+    if(bDmaBusy && lDmaEnd <= lNow)
+    {
+      bDmaBusy = 0;
+      bDmaDone = 1;
+    }
+    else if(lTransitionEnd && lTransitionEnd <= lNow)
+    {
+      lTransitionEnd = 0;
+      cState = cNextState;
+      if(cState == MC_STATE_TX || cState == MC_STATE_RX || cState == MC_STATE_LOCKON)
+      {
+        SimSynthLock(cState == MC_STATE_TX || (cState == MC_STATE_LOCKON && bLockTx));
+      }
+      if(cState == MC_STATE_RX && bAckWait)
+      {
+        /* The RX timer bounds the wait of the ACK */
+        lRxTimerEnd = SimRxTimerNs() ? lNow + SimRxTimerNs() : 0;
+      }
+      else if(cState == MC_STATE_RX && (aRegs[PROTOCOL1_ADDR] & LDC_MODE_REGMASK))
+      {
+        /* The wake up ends early without a carrier, else at the RX timer */
+        lFastRxEnd = (aRegs[PROTOCOL1_ADDR] & FAST_CS_TERM_EN_REGMASK) ? lNow + SimFastRxNs() : 0;
+        lRxTimerEnd = SimRxTimerNs() ? lNow + SimRxTimerNs() : 0;
+      }
+      if(cState == MC_STATE_TX)
+      {
+        uint16_t nLen = ((uint16_t)aRegs[PCKTLEN1_ADDR] << 8) | aRegs[PCKTLEN0_ADDR];
+        nLen -= (nLen >= SimAddressBytes()) ? SimAddressBytes() : 0;
+        lTxEnd = lNow + S2LP_SIM_FrameAirTimeNs(nLen);
+        lTxPayloadStart = lNow + SimBitsToNs(SimSyncBits() + SimHeaderBits());
+        lLastTxSyncTime = lNow + SimBitsToNs(SimSyncBits());
+        nLastTxPreambleBits = (uint16_t)SimPreambleBits();
+        nTxLen = nLen;
+        nLastTx = 0;
+        cTxLlp = cTxSeq | ((aRegs[PROTOCOL0_ADDR] & NACK_TX_REGMASK) ? S2LP_SIM_LLP_NO_ACK : 0);
+        aRegs[TX_PCKT_INFO_ADDR] = (uint8_t)((cTxSeq << 4) | nReTx);
+      }
+    }
+    else if(lLdcWake && lLdcWake <= lNow)
+    {
+      if(!(aRegs[PROTOCOL1_ADDR] & LDC_MODE_REGMASK))
+      {
+        lLdcWake = 0;
+        continue;
+      }
+      lLdcWake += SimLdcPeriodNs();
+      if(cState == MC_STATE_SLEEP && !lTransitionEnd)
+      {
+        xStats.nLdcWakeups++;
+        SimStartTransition(MC_STATE_RX, xConfig.lXoSettleNs + SimSynthSetupNs());
+      }
+    }
+    else if(lFastRxEnd && lFastRxEnd <= lNow)
+    {
+      lFastRxEnd = 0;
+      if(cState == MC_STATE_RX && !SimCarrierAt(lNow))
+      {
+        SimLdcSleep();
+      }
+    }
+    else if(lRxTimerEnd && lRxTimerEnd <= lNow)
+    {
+      lRxTimerEnd = 0;
+      if(cState == MC_STATE_RX && bAckWait)
+      {
+        /* No ACK: the LLP sends the frame again, up to NMAX_RETX times */
+        if(nReTx < (aRegs[PROTOCOL0_ADDR] >> 4))
+        {
+          nReTx++;
+          xStats.nRetransmissions++;
+          nTxFifo = (nLastTx < SIM_FIFO_SIZE) ? nLastTx : SIM_FIFO_SIZE;
+          memcpy(aTxFifo, aLastTx, nTxFifo);
+          SimStartTransition(MC_STATE_TX, SimSynthSetupNs());
+        }
+        else
+        {
+          bAckWait = 0;
+          cState = MC_STATE_READY;
+          SimRaiseIrq(IRQ_BIT(MAX_RE_TX_REACH));
+        }
+      }
+      else if(cState == MC_STATE_RX)
+      {
+        SimLdcSleep();
+        SimRaiseIrq(IRQ_BIT(RX_TIMEOUT));
+      }
+    }
+    else if(lTxByte && lTxByte <= lNow)
+    {
+      /* The packet handler takes the payload from the FIFO as it goes on air */
+      if(nTxFifo == 0)
+      {
+        xStats.nFifoErrors++;
+        lTxEnd = 0;
+        cState = MC_STATE_READY;
+        SimRaiseIrq(IRQ_BIT(TX_FIFO_ERROR));
+        continue;
+      }
+      aLastTx[nLastTx++] = aTxFifo[0];
+      memmove(aTxFifo, &aTxFifo[1], --nTxFifo);
+      if(nTxFifo == (aRegs[FIFO_CONFIG0_ADDR] & TX_AETHR_REGMASK))
+      {
+        SimRaiseIrq(IRQ_BIT(TX_FIFO_ALMOST_EMPTY));
+      }
+    }
+    else if(lTxEnd && lTxEnd <= lNow)
+    {
+      lTxEnd = 0;
+      nTxFifo = 0;
+      cState = MC_STATE_READY;
+      xStats.nFramesTx++;
+      if(SimStack() && !(cTxLlp & S2LP_SIM_LLP_NO_ACK))
+      {
+        /* TX_DATA_SENT is raised once the ACK is received */
+        bAckWait = 1;
+        SimStartTransition(MC_STATE_RX, SimSynthSetupNs());
+      }
+      else
+      {
+        SimRaiseIrq(IRQ_BIT(TX_DATA_SENT));
+      }
+      if(pfnTxHook)
+      {
+        pfnTxHook(aLastTx, nLastTx);
+      }
+    }
+    else if(lAckTxEnd && lAckTxEnd <= lNow)
+    {
+      lAckTxEnd = 0;
+      cState = (aRegs[PROTOCOL0_ADDR] & PERS_RX_REGMASK) ? MC_STATE_RX : MC_STATE_READY;
+      SimRaiseIrq(IRQ_BIT(TX_DATA_SENT));
+    }
+    else if(pxFrame && !pxFrame->bSynced && pxFrame->lSyncTime <= lNow)
+    {
+      /* While waiting for an ACK the LLP receives nothing else */
+      if(cState == MC_STATE_RX && (!bAckWait || (pxFrame->cLlp & S2LP_SIM_LLP_ACK)))
+      {
+        pxFrame->bSynced = 1;
+        lLastSyncTime = lNow;
+        pxFrame->lPayloadStart = lNow + SimBitsToNs(SimHeaderBits());
+        /* The RX timer stops at the sync word */
+        lFastRxEnd = 0;
+        lRxTimerEnd = 0;
+        SimRaiseIrq(IRQ_BIT(VALID_SYNC));
+      }
+      else
+      {
+        pxFrame->lSyncTime = UINT64_MAX;
+      }
+    }
+    else if(lRxByte && lRxByte <= lNow)
+    {
+      /* Each byte reaches the FIFO as soon as it is received: a frame that
+         leaves RX or overruns the FIFO is lost */
+      if(cState != MC_STATE_RX)
+      {
+        pxFrame->bSynced = 0;
+      }
+      else if(nRxFifo == SIM_FIFO_SIZE)
+      {
+        pxFrame->bSynced = 0;
+        xStats.nFifoErrors++;
+        SimRaiseIrq(IRQ_BIT(RX_FIFO_ERROR));
+      }
+      else
+      {
+        aRxFifo[nRxFifo++] = pxFrame->cData[pxFrame->nDelivered++];
+        if(nRxFifo == SIM_FIFO_SIZE - (aRegs[FIFO_CONFIG3_ADDR] & RX_AFTHR_REGMASK))
+        {
+          SimRaiseIrq(IRQ_BIT(RX_FIFO_ALMOST_FULL));
+        }
+      }
+    }
+    else if(pxFrame && pxFrame->lEndTime <= lNow)
+    {
+      if(pxFrame->bSynced && cState == MC_STATE_RX && SimStack() && (pxFrame->cLlp & S2LP_SIM_LLP_ACK))
+      {
+        /* ACKs are consumed by the LLP */
+        if(bAckWait && (pxFrame->cLlp & S2LP_SIM_LLP_SEQ_MASK) == (cTxLlp & S2LP_SIM_LLP_SEQ_MASK))
+        {
+          bAckWait = 0;
+          cState = MC_STATE_READY;
+          SimRaiseIrq(IRQ_BIT(TX_DATA_SENT));
+        }
+        else
+        {
+          lRxTimerEnd = (bAckWait && SimRxTimerNs()) ? lNow + SimRxTimerNs() : lRxTimerEnd;
+          xStats.nFramesLost++;
+        }
+      }
+      else if(pxFrame->bSynced && cState == MC_STATE_RX)
+      {
+        aRegs[RX_PCKT_LEN1_ADDR] = (uint8_t)((pxFrame->nLen + SimAddressBytes()) >> 8);
+        aRegs[RX_PCKT_LEN0_ADDR] = (uint8_t)(pxFrame->nLen + SimAddressBytes());
+        aRegs[RSSI_LEVEL_ADDR] = (uint8_t)(pxFrame->cRssidBm + 146);
+        aRegs[LINK_QUALIF2_ADDR] = (uint8_t)(pxFrame->cLqi << 4);
+        if(!(aRegs[PROTOCOL0_ADDR] & PERS_RX_REGMASK))
+        {
+          cState = MC_STATE_READY;
+        }
+        aRegs[RX_PCKT_INFO_ADDR] = pxFrame->cLlp & (NACK_RX_REGMASK | RX_SEQ_NUM_REGMASK);
+        xStats.nFramesRx++;
+        SimRaiseIrq(IRQ_BIT(RX_DATA_READY));
+        if(SimStack() && (aRegs[PROTOCOL0_ADDR] & AUTO_ACK_REGMASK) && !(pxFrame->cLlp & S2LP_SIM_LLP_NO_ACK))
+        {
+          /* The LLP sends the ACK at once, then resumes RX */
+          cState = MC_STATE_TX;
+          lAckTxEnd = lNow + SimSynthSetupNs() + S2LP_SIM_FrameAirTimeNs(0);
+          xStats.nAutoAcks++;
+        }
+      }
+      else
+      {
+        xStats.nFramesLost++;
+      }
+      cRxHead = (cRxHead + 1) % S2LP_SIM_RX_QUEUE_LEN;
+      cRxCount--;
+    }
+  }
+  SimAccount(lUntil);
+  lNow = lUntil;
+}
+
+/**
+  * @brief  Queues a frame on air starting lDelayNs from now, or right after
+  *         the frames already queued.
+  */
+static void SimQueueFrame(const uint8_t *pcData, uint16_t nLen, int8_t cRssidBm, uint8_t cLqi,
+                          uint64_t lDelayNs, uint8_t cLlp)
+{
+  SimRxFrame *pxFrame;
+  uint64_t lStart = lNow + lDelayNs;
+
+  if(cRxCount == S2LP_SIM_RX_QUEUE_LEN || nLen > S2LP_SIM_MAX_FRAME_LEN)
+  {
+    xStats.nFramesLost++;
+    return;
+  }
+  if(cRxCount)
+  {
+    uint64_t lPrevEnd = aRxQueue[(cRxHead + cRxCount - 1) % S2LP_SIM_RX_QUEUE_LEN].lEndTime;
+    if(lPrevEnd > lStart)
+    {
+      lStart = lPrevEnd;
+    }
+  }
+
+  pxFrame = &aRxQueue[(cRxHead + cRxCount) % S2LP_SIM_RX_QUEUE_LEN];
+  if(nLen)
+  {
+    memcpy(pxFrame->cData, pcData, nLen);
+  }
+  pxFrame->nLen = nLen;
+  pxFrame->cLlp = cLlp;
+  pxFrame->cRssidBm = cRssidBm;
+  pxFrame->cLqi = cLqi;
+  pxFrame->bSynced = 0;
+  pxFrame->nDelivered = 0;
+  pxFrame->lCarrierStart = lStart;
+  if(nPeerPreambleBits)
+  {
+    /* The peer preamble replaces the one programmed here */
+    lStart += SimBitsToNs(nPeerPreambleBits);
+    lStart -= SimBitsToNs(SimPreambleBits());
+  }
+  pxFrame->lSyncTime = lStart + SimBitsToNs(SimSyncBits());
+  pxFrame->lEndTime = lStart + S2LP_SIM_FrameAirTimeNs(nLen);
+  cRxCount++;
+}
+
+/* Exported functions --------------------------------------------------------*/
+
+/**
+  * @brief  Timing of a NUCLEO-F401RE (84 MHz, SPI1 at APB2/16) driving the
+  *         S2-LP at the Contiki-NG default datarate.
+  */
+void S2LP_SIM_GetDefaultConfig(S2LP_SIM_Config *pxConfig)
+{
+  pxConfig->lSpiClockHz = 84000000 / 16;
+  pxConfig->lTransactionOverheadNs = 3000;
+  pxConfig->lByteGapNs = 400;
+  pxConfig->lPollCostNs = 500;
+  pxConfig->lDatarate = 38400;
+  pxConfig->lSynthSetupNs = 60000;
+  pxConfig->lVcoCalNs = 20000;
+  pxConfig->lXtalHz = 50000000;
+  pxConfig->lXoSettleNs = 40000;
+  pxConfig->lRcoHz = 33300;
+  pxConfig->cNoiseFloordBm = -120;
+  pxConfig->bWrapperReenablesIrq = 1;
+}
+
+void S2LP_SIM_Init(const S2LP_SIM_Config *pxConfig)
+{
+  if(pxConfig)
+  {
+    xConfig = *pxConfig;
+  }
+  else
+  {
+    S2LP_SIM_GetDefaultConfig(&xConfig);
+  }
+  memset(&xStats, 0, sizeof(xStats));
+  lNow = 0;
+  lTunedHz = 0;
+  nPeerPreambleBits = 0;
+  bPeerAckRequest = 0;
+  cPeerSeq = 0;
+  lJamHz = 0;
+  cRxHead = 0;
+  cRxCount = 0;
+  nLastTx = 0;
+  bLineActive = 0;
+  bExtiPending = 0;
+  bLineMasked = 0;
+  bInIsr = 0;
+  bInTransaction = 0;
+  bDmaBusy = 0;
+  bDmaDone = 0;
+  pfnDmaCallback = NULL;
+  SimReset();
+}
+
+int32_t S2LP_SIM_BusInit(void)
+{
+  return 0;
+}
+
+int32_t S2LP_SIM_BusDeInit(void)
+{
+  return 0;
+}
+
+/**
+  * @brief  Applies one transaction to the model: header (2 bytes, replaced by
+  *         the MC_STATE status bytes) followed by Length data bytes.
+  * @retval Time the transaction takes on the bus
+  */
+static uint64_t SimTransfer(uint8_t *pHeader, uint8_t *pBuff, uint16_t Length)
+{
+  uint8_t cType = pHeader[0];
+  uint8_t cAddr = pHeader[1];
+  uint8_t bClearIrq = 0;
+  uint64_t lCost;
+
+  /* The status bytes are shifted out while the header is shifted in */
+  pHeader[0] = 0x50 | (nRxFifo == 0 ? 0x02 : 0x00) | (nTxFifo >= SIM_FIFO_SIZE ? 0x04 : 0x00);
+  pHeader[1] = (uint8_t)(cState << 1) | 0x01;
+
+  if(cType == COMMAND_HEADER)
+  {
+    xStats.nCommands++;
+    SimCommand(cAddr);
+  }
+  else if(cType == WRITE_HEADER && cAddr == LINEAR_FIFO_ADDRESS)
+  {
+    xStats.nFifoWrites++;
+    for(uint16_t i = 0; i < Length; i++)
+    {
+      if(nTxFifo < SIM_FIFO_SIZE)
+      {
+        aTxFifo[nTxFifo++] = pBuff[i];
+      }
+      else
+      {
+        xStats.nFifoErrors++;
+        SimRaiseIrq(IRQ_BIT(TX_FIFO_ERROR));
+        break;
+      }
+    }
+  }
+  else if(cType == READ_HEADER && cAddr == LINEAR_FIFO_ADDRESS)
+  {
+    uint16_t nCopy = (Length <= nRxFifo) ? Length : nRxFifo;
+    xStats.nFifoReads++;
+    memcpy(pBuff, aRxFifo, nCopy);
+    memset(&pBuff[nCopy], 0, Length - nCopy);
+    memmove(aRxFifo, &aRxFifo[nCopy], nRxFifo - nCopy);
+    nRxFifo -= nCopy;
+    if(nCopy < Length)
+    {
+      xStats.nFifoErrors++;
+      SimRaiseIrq(IRQ_BIT(RX_FIFO_ERROR));
+    }
+  }
+  else if(cType == WRITE_HEADER)
+  {
+    xStats.nRegWrites++;
+    for(uint16_t i = 0; i < Length && (cAddr + i) < 0x100; i++)
+    {
+      uint8_t cReg = (uint8_t)(cAddr + i);
+      if(cReg < MC_STATE1_ADDR)
+      {
+        aRegs[cReg] = pBuff[i];
+      }
+    }
+    SimUpdateLine();
+  }
+  else
+  {
+    xStats.nRegReads++;
+    for(uint16_t i = 0; i < Length; i++)
+    {
+      uint16_t nReg = (uint16_t)cAddr + i;
+      uint8_t cVal = 0;
+
+      if(nReg >= 0x100)
+      {
+        pBuff[i] = 0;
+        continue;
+      }
+      switch(nReg)
+      {
+      case MC_STATE0_ADDR:
+        cVal = (uint8_t)(cState << 1) | 0x01;
+        break;
+      case MC_STATE1_ADDR:
+        cVal = 0x50 | (nRxFifo == 0 ? 0x02 : 0x00);
+        break;
+      case TX_FIFO_STATUS_ADDR:
+        cVal = (uint8_t)(nTxFifo & NELEM_TXFIFO_REGMASK);
+        break;
+      case RX_FIFO_STATUS_ADDR:
+        cVal = (uint8_t)(nRxFifo & NELEM_RXFIFO_REGMASK);
+        break;
+      case RSSI_LEVEL_RUN_ADDR:
+      case RSSI_LEVEL_RUN_ADDR + 1:
+        {
+          int8_t cRssi = xConfig.cNoiseFloordBm;
+          if(cRxCount && aRxQueue[cRxHead].bSynced)
+          {
+            cRssi = aRxQueue[cRxHead].cRssidBm;
+          }
+          else if(SimJamming())
+          {
+            cRssi = cJamdBm;
+          }
+          cVal = (uint8_t)(cRssi + 146);
+        }
+        break;
+      case IRQ_STATUS3_ADDR:
+      case IRQ_STATUS2_ADDR:
+      case IRQ_STATUS1_ADDR:
+      case IRQ_STATUS0_ADDR:
+        cVal = (uint8_t)(lIrqStatus >> (8 * (IRQ_STATUS0_ADDR - nReg)));
+        bClearIrq = 1;
+        break;
+      default:
+        cVal = aRegs[nReg];
+        break;
+      }
+      pBuff[i] = cVal;
+    }
+  }
+
+  if(bClearIrq)
+  {
+    lIrqStatus = 0;
+    SimUpdateLine();
+  }
+
+  lCost = xConfig.lTransactionOverheadNs +
+          (uint64_t)(2 + Length) * ((8 * SIM_NS_PER_S) / xConfig.lSpiClockHz + xConfig.lByteGapNs);
+  xStats.nTransactions++;
+  xStats.nBytes += 2 + Length;
+  xStats.lBusTimeNs += lCost;
+  return lCost;
+}
+
+/**
+  * @brief  S2LPBus_WriteBuf_Func implementation: the CPU is blocked for the
+  *         whole transaction.
+  */
+int32_t S2LP_SIM_WriteBuffer(uint8_t *pHeader, uint8_t *pBuff, uint16_t Length)
+{
+  uint64_t lCost;
+
+  SimDmaWait();
+  bInTransaction = 1;
+  bLineMasked = 1;
+  lCost = SimTransfer(pHeader, pBuff, Length);
+  xStats.lBusCpuNs += lCost;
+  SimRunEvents(lNow + lCost);
+
+  bInTransaction = 0;
+  if(xConfig.bWrapperReenablesIrq)
+  {
+    bLineMasked = 0;
+  }
+  SimDispatchIrq();
+
+  return 0;
+}
+
+void S2LP_SIM_Delay(uint32_t lDelayMs)
+{
+  S2LP_SIM_Advance((uint64_t)lDelayMs * 1000000ULL);
+}
+
+/**
+  * @brief  S2LPBus_WriteBufAsync_Func implementation, modeling the DMA
+  *         wrapper: the transaction takes effect at once, while the bus and
+  *         the radio IRQ line stay busy until its completion interrupt.
+  */
+int32_t S2LP_SIM_WriteBufferAsync(uint8_t *pHeader, uint8_t *pBuff, uint16_t Length,
+                                  void (*pfnCallback)(void))
+{
+  SimDmaWait();
+  bLineMasked = 1;
+  lDmaEnd = lNow + SimTransfer(pHeader, pBuff, Length);
+  bDmaBusy = 1;
+  pfnDmaCallback = pfnCallback;
+  xStats.nAsyncTransfers++;
+  return 0;
+}
+
+uint8_t S2LP_SIM_IsBusBusy(void)
+{
+  return bInTransaction || bDmaBusy || bDmaDone;
+}
+
+void S2LP_SIM_SetIrqHandler(S2LP_SIM_IrqHandler pfnHandler)
+{
+  pfnIrqHandler = pfnHandler;
+}
+
+void S2LP_SIM_IrqLineEnable(void)
+{
+  bLineMasked = 0;
+  SimDispatchIrq();
+}
+
+void S2LP_SIM_IrqLineDisable(void)
+{
+  bLineMasked = 1;
+}
+
+/**
+  * @brief  Tells the model that the code running is an ISR other than the
+  *         radio one (e.g. an rtimer callback), for nIsrBusWaits.
+  */
+void S2LP_SIM_SetIsrContext(uint8_t bIsr)
+{
+  bInOtherIsr = bIsr;
+}
+
+/**
+  * @brief  PRIMASK of the host CPU: while set, neither the radio ISR nor
+  *         the DMA completion run. Clearing it runs the pending ones.
+  */
+void S2LP_SIM_SetPrimask(uint32_t lPrimask)
+{
+  bPrimask = (lPrimask & 1U) ? 1 : 0;
+  SimDispatchIrq();
+}
+
+uint32_t S2LP_SIM_GetPrimask(void)
+{
+  return bPrimask;
+}
+
+uint64_t S2LP_SIM_Now(void)
+{
+  return lNow;
+}
+
+/**
+  * @brief  Lets lNs nanoseconds of CPU time elapse without bus activity.
+  */
+void S2LP_SIM_Advance(uint64_t lNs)
+{
+  SimRunEvents(lNow + lNs);
+  SimDispatchIrq();
+}
+
+/**
+  * @brief  Charges the cost of one iteration of a busy-wait loop.
+  */
+void S2LP_SIM_ChargePoll(void)
+{
+  S2LP_SIM_Advance(xConfig.lPollCostNs);
+}
+
+/**
+  * @brief  Puts a frame on air starting now (or right after the frames
+  *         already queued). It reaches the RX FIFO only if the radio is in RX
+  *         when the sync word is detected.
+  */
+void S2LP_SIM_InjectFrame(const uint8_t *pcData, uint16_t nLen, int8_t cRssidBm, uint8_t cLqi)
+{
+  S2LP_SIM_InjectFrameAt(pcData, nLen, cRssidBm, cLqi, 0);
+}
+
+/**
+  * @brief  As S2LP_SIM_InjectFrame(), the frame starting lDelayNs from now.
+  *         In STack format it asks for an ACK if S2LP_SIM_SetPeerAckRequest()
+  *         says so.
+  */
+void S2LP_SIM_InjectFrameAt(const uint8_t *pcData, uint16_t nLen, int8_t cRssidBm, uint8_t cLqi,
+                            uint64_t lDelayNs)
+{
+  uint8_t cLlp = cPeerSeq | (bPeerAckRequest ? 0 : S2LP_SIM_LLP_NO_ACK);
+
+  cPeerSeq = (uint8_t)((cPeerSeq + 1) & S2LP_SIM_LLP_SEQ_MASK);
+  SimQueueFrame(pcData, nLen, cRssidBm, cLqi, lDelayNs, cLlp);
+}
+
+/**
+  * @brief  Puts the STack ACK of the frame with sequence number cSeq on air,
+  *         lDelayNs from now.
+  */
+void S2LP_SIM_InjectAckAt(uint8_t cSeq, int8_t cRssidBm, uint64_t lDelayNs)
+{
+  SimQueueFrame(NULL, 0, cRssidBm, 0, lDelayNs,
+                S2LP_SIM_LLP_ACK | S2LP_SIM_LLP_NO_ACK | (cSeq & S2LP_SIM_LLP_SEQ_MASK));
+}
+
+/**
+  * @brief  Puts on lFreqHz an unsynchronized carrier of cRssidBm, on air the
+  *         first nDutyPct % of every 10 ms. The running RSSI reports it when
+  *         the radio listens within 50 kHz of it. lFreqHz 0 removes it.
+  */
+void S2LP_SIM_SetInterferer(uint32_t lFreqHz, int8_t cRssidBm, uint8_t nDutyPct)
+{
+  lJamHz = lFreqHz;
+  cJamdBm = cRssidBm;
+  nJamDutyPct = nDutyPct;
+}
+
+/**
+  * @brief  Preamble of the frames injected from now on, in bits: the peer
+  *         sends wake-up preambles to a receiver in LDC mode. 0 restores the
+  *         preamble programmed in this radio.
+  */
+void S2LP_SIM_SetPeerPreamble(uint16_t nBits)
+{
+  nPeerPreambleBits = nBits;
+}
+
+/**
+  * @brief  In STack format, the injected frames ask for an ACK (NO_ACK
+  *         field cleared) if bEnable.
+  */
+void S2LP_SIM_SetPeerAckRequest(uint8_t bEnable)
+{
+  bPeerAckRequest = bEnable;
+}
+
+/**
+  * @brief  LLP control field (S2LP_SIM_LLP_*) of the frame on air or of the
+  *         last one sent, STack format only.
+  */
+uint8_t S2LP_SIM_GetTxLlpControl(void)
+{
+  return cTxLlp;
+}
+
+/**
+  * @brief  Preamble bits of the frame on air or of the last one sent.
+  */
+uint16_t S2LP_SIM_GetTxPreamble(void)
+{
+  return nLastTxPreambleBits;
+}
+
+uint16_t S2LP_SIM_GetLastTxFrame(uint8_t *pcData, uint16_t nSize)
+{
+  uint16_t nCopy = (nLastTx < nSize) ? nLastTx : nSize;
+  memcpy(pcData, aLastTx, nCopy);
+  return nLastTx;
+}
+
+void S2LP_SIM_SetTxHook(S2LP_SIM_TxHook pfnHook)
+{
+  pfnTxHook = pfnHook;
+}
+
+/**
+  * @brief  Air time of a frame with the current packet handler settings.
+  */
+uint32_t S2LP_SIM_FrameAirTimeNs(uint16_t nLen)
+{
+  return SimBitsToNs(SimOverheadBits() + 8 * (uint32_t)nLen);
+}
+
+uint8_t S2LP_SIM_PeekRegister(uint8_t cRegAddress)
+{
+  return aRegs[cRegAddress];
+}
+
+/**
+  * @brief  Time the sync word of the last frame received was detected.
+  */
+uint64_t S2LP_SIM_GetLastSyncTime(void)
+{
+  return lLastSyncTime;
+}
+
+/**
+  * @brief  Time the sync word of the last frame sent went out.
+  */
+uint64_t S2LP_SIM_GetLastTxSyncTime(void)
+{
+  return lLastTxSyncTime;
+}
+
+uint8_t S2LP_SIM_GetState(void)
+{
+  return cState;
+}
+
+uint32_t S2LP_SIM_GetTunedFrequency(void)
+{
+  return lTunedHz;
+}
+
+void S2LP_SIM_GetStats(S2LP_SIM_Stats *pxStats)
+{
+  *pxStats = xStats;
+}
+
+void S2LP_SIM_ResetStats(void)
+{
+  memset(&xStats, 0, sizeof(xStats));
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
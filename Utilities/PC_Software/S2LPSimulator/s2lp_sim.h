@@ -0,0 +1,162 @@
+/**
+  ******************************************************************************
+  * @file    s2lp_sim.h
+  * @author  SRA Application Team
+  * @brief   Host-side register level model of the S2-LP transceiver
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef S2LP_SIM_H
+#define S2LP_SIM_H
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @addtogroup S2LP_SIM
+ * @{
+ * The model sits behind the S2LP_IO_t WriteBuffer pointer registered through
+ * S2LP_RegisterBusIO(), so the S2-LP library and the Contiki-NG radio driver
+ * run unmodified on the host. It models the register file, the TX/RX FIFOs,
+ * the main controller state machine, the IRQ status/mask logic routed to a
+ * GPIO line, the STack link layer protocol (ACKs and retransmissions) and a
+ * cost model for every SPI transaction.
+ */
+
+/* Exported types ------------------------------------------------------------*/
+
+/**
+ * @brief  Timing model of the host MCU and of the radio.
+ */
+typedef struct
+{
+  uint32_t lSpiClockHz;            /*!< SCLK frequency */
+  uint32_t lTransactionOverheadNs; /*!< Fixed cost of one CS-low transaction (CS toggling, HAL calls) */
+  uint32_t lByteGapNs;             /*!< Extra time spent for every byte on top of the 8 SCLK periods */
+  uint32_t lPollCostNs;            /*!< CPU time charged every time the driver reads the rtimer */
+  uint32_t lDatarate;              /*!< Over the air bit rate in bps */
+  uint32_t lSynthSetupNs;          /*!< READY -> TX/RX/LOCK transition time */
+  uint32_t lVcoCalNs;              /*!< Part of it spent calibrating the VCO, saved with external calibration words */
+  uint32_t lXtalHz;                /*!< Crystal frequency, to report the tuned carrier */
+  uint32_t lXoSettleNs;            /*!< STANDBY/SLEEP -> READY transition time */
+  uint32_t lRcoHz;                 /*!< RC oscillator clocking the LDC wake-up timer */
+  int8_t   cNoiseFloordBm;         /*!< Running RSSI reported when no frame is on air */
+  uint8_t  bWrapperReenablesIrq;   /*!< Mirror the BSP SPI wrapper that re-enables the radio IRQ line after each transaction */
+} S2LP_SIM_Config;
+
+/**
+ * @brief  Counters collected by the model.
+ */
+typedef struct
+{
+  uint32_t nTransactions;    /*!< CS-low SPI transactions */
+  uint32_t nRegReads;        /*!< Register read transactions */
+  uint32_t nRegWrites;       /*!< Register write transactions */
+  uint32_t nCommands;        /*!< Command strobes */
+  uint32_t nFifoReads;       /*!< RX FIFO read transactions */
+  uint32_t nFifoWrites;      /*!< TX FIFO write transactions */
+  uint32_t nBytes;           /*!< Bytes clocked on the bus, header included */
+  uint64_t lBusTimeNs;       /*!< Modeled time the bus was busy */
+  uint64_t lBusCpuNs;        /*!< Part of it the CPU spent waiting for the bus */
+  uint32_t nAsyncTransfers;  /*!< Transactions run without blocking the CPU (DMA) */
+  uint32_t nIsrBusWaits;     /*!< Accesses from an ISR while a DMA transfer owned the bus: the BSP refuses them */
+  uint32_t nIrqs;            /*!< Radio IRQ handler invocations */
+  uint32_t nInvalidCommands; /*!< Command strobes not valid in the current state */
+  uint32_t nFramesTx;        /*!< Frames put on air */
+  uint32_t nFramesRx;        /*!< Frames delivered to the RX FIFO */
+  uint32_t nFramesLost;      /*!< Injected frames missed because the radio was not in RX */
+  uint32_t nFifoErrors;      /*!< TX/RX FIFO overflow or underflow */
+  uint64_t lRxOnNs;          /*!< Time spent in RX or setting up for it */
+  uint32_t nLdcWakeups;      /*!< Wake ups of the LDC mode */
+  uint32_t nRetransmissions; /*!< Frames sent again by the LLP for a missing ACK */
+  uint32_t nAutoAcks;        /*!< ACKs sent by the LLP */
+} S2LP_SIM_Stats;
+
+typedef void (*S2LP_SIM_IrqHandler)(void);
+typedef void (*S2LP_SIM_TxHook)(const uint8_t *pcData, uint16_t nLen);
+
+/* Exported constants --------------------------------------------------------*/
+#define S2LP_SIM_MAX_FRAME_LEN       2048
+#define S2LP_SIM_RX_QUEUE_LEN        8
+
+/* LLP control field of a STack frame */
+#define S2LP_SIM_LLP_SEQ_MASK        0x03
+#define S2LP_SIM_LLP_NO_ACK          0x04  /*!< The sender asks for no ACK */
+#define S2LP_SIM_LLP_ACK             0x08  /*!< The frame is an ACK */
+
+/* Exported functions --------------------------------------------------------*/
+void S2LP_SIM_GetDefaultConfig(S2LP_SIM_Config *pxConfig);
+void S2LP_SIM_Init(const S2LP_SIM_Config *pxConfig);
+
+/* Bus functions matching S2LP_IO_t */
+int32_t S2LP_SIM_BusInit(void);
+int32_t S2LP_SIM_BusDeInit(void);
+int32_t S2LP_SIM_WriteBuffer(uint8_t *pHeader, uint8_t *pBuff, uint16_t Length);
+int32_t S2LP_SIM_WriteBufferAsync(uint8_t *pHeader, uint8_t *pBuff, uint16_t Length,
+                                  void (*pfnCallback)(void));
+void S2LP_SIM_Delay(uint32_t lDelayMs);
+uint8_t S2LP_SIM_IsBusBusy(void);
+
+/* Radio IRQ line (EXTI) */
+void S2LP_SIM_SetIrqHandler(S2LP_SIM_IrqHandler pfnHandler);
+void S2LP_SIM_IrqLineEnable(void);
+void S2LP_SIM_IrqLineDisable(void);
+void S2LP_SIM_SetIsrContext(uint8_t bIsr);
+void S2LP_SIM_SetPrimask(uint32_t lPrimask);
+uint32_t S2LP_SIM_GetPrimask(void);
+
+/* Time */
+uint64_t S2LP_SIM_Now(void);
+void S2LP_SIM_Advance(uint64_t lNs);
+void S2LP_SIM_ChargePoll(void);
+
+/* Air interface */
+void S2LP_SIM_InjectFrame(const uint8_t *pcData, uint16_t nLen, int8_t cRssidBm, uint8_t cLqi);
+void S2LP_SIM_InjectFrameAt(const uint8_t *pcData, uint16_t nLen, int8_t cRssidBm, uint8_t cLqi,
+                            uint64_t lDelayNs);
+uint16_t S2LP_SIM_GetLastTxFrame(uint8_t *pcData, uint16_t nSize);
+void S2LP_SIM_SetTxHook(S2LP_SIM_TxHook pfnHook);
+uint32_t S2LP_SIM_FrameAirTimeNs(uint16_t nLen);
+void S2LP_SIM_SetPeerPreamble(uint16_t nBits);
+uint16_t S2LP_SIM_GetTxPreamble(void);
+void S2LP_SIM_SetPeerAckRequest(uint8_t bEnable);
+void S2LP_SIM_InjectAckAt(uint8_t cSeq, int8_t cRssidBm, uint64_t lDelayNs);
+uint8_t S2LP_SIM_GetTxLlpControl(void);
+void S2LP_SIM_SetInterferer(uint32_t lFreqHz, int8_t cRssidBm, uint8_t nDutyPct);
+
+/* Introspection (no bus cost) */
+uint8_t S2LP_SIM_PeekRegister(uint8_t cRegAddress);
+uint8_t S2LP_SIM_GetState(void);
+uint64_t S2LP_SIM_GetLastSyncTime(void);
+uint64_t S2LP_SIM_GetLastTxSyncTime(void);
+uint32_t S2LP_SIM_GetTunedFrequency(void);
+void S2LP_SIM_GetStats(S2LP_SIM_Stats *pxStats);
+void S2LP_SIM_ResetStats(void);
+
+/**
+ * @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* S2LP_SIM_H */
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
@@ -0,0 +1,158 @@
+/**
+  ******************************************************************************
+  * @file    s2lp_words_gen.c
+  * @author  SRA Application Team
+  * @brief   Precomputes the S2LP_RADIO_Init register words and the synthesizer
+  *          words of a set of channels for the radio settings of an example,
+  *          and checks them bit by bit against the runtime computation
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <string.h>
+#include "s2lp.h"
+#include "s2lp_sim.h"
+#include "radio_settings.h"   /* radio defines extracted from the settings file */
+
+/* Private define ------------------------------------------------------------*/
+#ifndef RADIO_WORDS_CHANNELS
+#define RADIO_WORDS_CHANNELS  16
+#endif
+
+/* Private variables ---------------------------------------------------------*/
+static SRadioInit xSettings = {
+  BASE_FREQUENCY,
+  MODULATION_SELECT,
+  DATARATE,
+  FREQ_DEVIATION,
+  BANDWIDTH
+};
+
+static SRadioInitWords xInitWords;
+static SRadioSynthWords aChannelWords[RADIO_WORDS_CHANNELS];
+static uint8_t aRuntime[S2LP_SHADOW_SIZE];
+static uint8_t aPrecomputed[S2LP_SHADOW_SIZE];
+static int nFailures;
+
+/* Private functions ---------------------------------------------------------*/
+static void words_reset(void)
+{
+  S2LP_IO_t xIO;
+
+  S2LP_SIM_Init(NULL);
+  xIO.Init = S2LP_SIM_BusInit;
+  xIO.DeInit = S2LP_SIM_BusDeInit;
+  xIO.WriteBuffer = S2LP_SIM_WriteBuffer;
+  xIO.Delay = S2LP_SIM_Delay;
+  S2LP_RegisterBusIO(&xIO);
+  S2LP_RADIO_SetXtalFrequency(XTAL_FREQUENCY);
+  S2LP_CMD_StrobeSres();
+}
+
+static void words_peek(uint8_t *pcRegs)
+{
+  for(uint16_t i = 0; i < S2LP_SHADOW_SIZE; i++)
+  {
+    pcRegs[i] = S2LP_SIM_PeekRegister((uint8_t)i);
+  }
+}
+
+static void words_compare(const char *pcWhat, uint16_t nIndex)
+{
+  for(uint16_t i = 0; i < S2LP_SHADOW_SIZE; i++)
+  {
+    if(aRuntime[i] != aPrecomputed[i])
+    {
+      fprintf(stderr, "s2lp_words_gen: %s %u: register 0x%02X is 0x%02X instead of 0x%02X\n",
+              pcWhat, nIndex, i, aPrecomputed[i], aRuntime[i]);
+      nFailures++;
+    }
+  }
+}
+
+static void words_print_synth(const SRadioSynthWords *pxWords)
+{
+  printf("{ %u, { 0x%02X, 0x%02X, 0x%02X, 0x%02X } }", pxWords->cPfdSplit,
+         pxWords->cSynt[0], pxWords->cSynt[1], pxWords->cSynt[2], pxWords->cSynt[3]);
+}
+
+int main(void)
+{
+  uint32_t lFrequency;
+
+  words_reset();
+  S2LP_RADIO_ComputeInitWords(&xSettings, &xInitWords);
+  for(uint16_t i = 0; i < RADIO_WORDS_CHANNELS; i++)
+  {
+    S2LP_RADIO_ComputeSynthWords((uint32_t)(BASE_FREQUENCY + i * CHANNEL_SPACE), &aChannelWords[i]);
+  }
+
+  /* The precomputed words must program the same registers as the runtime search */
+  words_reset();
+  S2LP_RADIO_Init(&xSettings);
+  words_peek(aRuntime);
+  words_reset();
+  S2LP_RADIO_InitWords(&xInitWords);
+  words_peek(aPrecomputed);
+  words_compare("init", 0);
+
+  for(uint16_t i = 0; i < RADIO_WORDS_CHANNELS; i++)
+  {
+    lFrequency = (uint32_t)(BASE_FREQUENCY + i * CHANNEL_SPACE);
+    words_reset();
+    S2LP_RADIO_SetFrequencyBase(lFrequency);
+    words_peek(aRuntime);
+    words_reset();
+    S2LP_RADIO_SetSynthWords(&aChannelWords[i]);
+    words_peek(aPrecomputed);
+    words_compare("channel", i);
+  }
+  if(nFailures)
+  {
+    return 1;
+  }
+
+  printf("/* Generated by s2lp_words_gen (Utilities/PC_Software/S2LPSimulator, \"make words\")\n");
+  printf(" * from the radio settings of p2p_demo_settings.h: do not edit.\n");
+  printf(" * Register words of S2LP_RADIO_Init and synthesizer words of channels\n");
+  printf(" * BASE_FREQUENCY + n * CHANNEL_SPACE, valid for RADIO_WORDS_XTAL_FREQUENCY only.\n");
+  printf(" */\n");
+  printf("#ifndef S2LP_RADIO_WORDS_H\n");
+  printf("#define S2LP_RADIO_WORDS_H\n\n");
+  printf("#define RADIO_WORDS_XTAL_FREQUENCY    %uU\n", (unsigned)XTAL_FREQUENCY);
+  printf("#define RADIO_WORDS_FREQUENCY_BASE    %uU\n", (unsigned)xSettings.lFrequencyBase);
+  printf("#define RADIO_WORDS_CHANNELS          %u\n\n", RADIO_WORDS_CHANNELS);
+  printf("/* SRadioInitWords initializer */\n");
+  printf("#define RADIO_INIT_WORDS  { 0x%02X, 0x%02X, { 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X, 0x%02X }, %u, %u, \\\n    ",
+         xInitWords.cIfOffsetAna, xInitWords.cIfOffsetDig,
+         xInitWords.cMod[0], xInitWords.cMod[1], xInitWords.cMod[2],
+         xInitWords.cMod[3], xInitWords.cMod[4], xInitWords.cMod[5],
+         xInitWords.cPaOok, xInitWords.cPaBessel);
+  words_print_synth(&xInitWords.xSynth);
+  printf(" }\n\n");
+  printf("/* SRadioSynthWords[RADIO_WORDS_CHANNELS] initializer */\n");
+  printf("#define RADIO_CHANNEL_WORDS  { \\\n");
+  for(uint16_t i = 0; i < RADIO_WORDS_CHANNELS; i++)
+  {
+    printf("    ");
+    words_print_synth(&aChannelWords[i]);
+    printf("%s \\\n", (i + 1 < RADIO_WORDS_CHANNELS) ? "," : "");
+  }
+  printf("  }\n\n");
+  printf("#endif /* S2LP_RADIO_WORDS_H */\n");
+  return 0;
+}
+
+/************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
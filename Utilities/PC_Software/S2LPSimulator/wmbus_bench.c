@@ -0,0 +1,314 @@
+/**
+  ******************************************************************************
+  * @file    wmbus_bench.c
+  * @author  SRA Application Team
+  * @brief   Checks the Wireless M-Bus codec of s2lp_wmbus_ll.c (block CRC,
+  *          3-out-of-6 chips, frame formats A and B) against bit by bit
+  *          references and measures its throughput on the host
+  ******************************************************************************
+  * @attention
+  *
+  * <h2><center>&copy; Copyright (c) 2021 STMicroelectronics.
+  * All rights reserved.</center></h2>
+  *
+  * This software component is licensed by ST under BSD 3-Clause license,
+  * the "License"; You may not use this file except in compliance with the
+  * License. You may obtain a copy of the License at:
+  *                        opensource.org/licenses/BSD-3-Clause
+  *
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "s2lp_wmbus_ll.h"
+
+/* Private define ------------------------------------------------------------*/
+#define BENCH_ROUNDS            20000
+#define BENCH_RANDOM_FRAMES     2000
+
+/* Private types -------------------------------------------------------------*/
+typedef struct {
+  const char*       pcName;
+  const char*       pcHex;          /* from the L field, without CRCs */
+  WMbusFrameFormat  xFormat;
+} BenchTelegram;
+
+/* Private variables ---------------------------------------------------------*/
+/* Telegrams as printed by the usual receivers, CRCs removed; the L field is
+ * set again by S2LP_WMBUS_BuildFrame. The last one is padded to need the 3rd
+ * block of format B. */
+static const BenchTelegram aTelegrams[] = {
+  {"water 7A", "2C446532821851582C067AE1000000046D1906D9180C1334120000426CBF1CCC081300000000C2086C9F1802FD1700002F2F", WMBUS_FRAME_A},
+  {"heat 72", "5E442D2C9643636013047296436363AC20110B9F0000000C0638160000046D310A9D2B0C1360801500426C9F2C4C0600000000CC100600000000C401FD172020020000000000000000000000000000000000000000000000", WMBUS_FRAME_A},
+  {"no CI", "0944EE4D785634120107", WMBUS_FRAME_A},
+  {"C mode B", "3D44EE4D1122334410377A0C0000000C13524800000B3B0000004C13000000004C6C9F2C0F0000000000000000000000000000000000000000002F2F2F", WMBUS_FRAME_B},
+  {"C mode B long", NULL, WMBUS_FRAME_B},
+};
+
+#define BENCH_TELEGRAMS   (sizeof(aTelegrams) / sizeof(aTelegrams[0]))
+
+static uint8_t aTelegram[BENCH_TELEGRAMS][256];
+static uint16_t aTelegramLen[BENCH_TELEGRAMS];
+static uint8_t aFrame[WMBUS_FRAME_MAX_LEN];
+static uint8_t aChips[WMBUS_FRAME_MAX_LEN * 3 / 2 + 1];
+static uint8_t aRefChips[sizeof(aChips)];
+static uint8_t aDecoded[WMBUS_FRAME_MAX_LEN];
+static int nFailures;
+
+static const uint8_t aNibbleCodes[16] = {
+  0x16, 0x0D, 0x0E, 0x0B, 0x1C, 0x19, 0x1A, 0x13,
+  0x2C, 0x25, 0x26, 0x23, 0x34, 0x31, 0x32, 0x29
+};
+
+/* Private functions ---------------------------------------------------------*/
+static void bench_fail(const char* pcWhat, const char* pcName)
+{
+  printf("FAIL %s: %s\n", pcName, pcWhat);
+  nFailures++;
+}
+
+static double bench_now_s(void)
+{
+  struct timespec xNow;
+
+  clock_gettime(CLOCK_MONOTONIC, &xNow);
+  return xNow.tv_sec + xNow.tv_nsec / 1e9;
+}
+
+/* EN 13757-4 CRC, one bit at a time */
+static uint16_t ref_crc(const uint8_t* pcData, uint16_t nLength)
+{
+  uint16_t nCrc = 0;
+  int i;
+
+  while(nLength--) {
+    nCrc ^= (uint16_t)(*pcData++) << 8;
+    for(i = 0; i < 8; i++) {
+      nCrc = (nCrc & 0x8000) ? (uint16_t)((nCrc << 1) ^ 0x3D65) : (uint16_t)(nCrc << 1);
+    }
+  }
+  return (uint16_t)~nCrc;
+}
+
+/* 3-out-of-6 coding, one chip at a time, the odd tail padded with "0101" */
+static uint16_t ref_encode(const uint8_t* pcData, uint16_t nLength, uint8_t* pcChips)
+{
+  uint32_t nBits = 0;
+  uint16_t i;
+  int b;
+
+  memset(pcChips, 0, (3 * nLength + 1) / 2);
+  for(i = 0; i < 2 * nLength; i++) {
+    uint8_t cNibble = (i & 1) ? (pcData[i / 2] & 0x0F) : (pcData[i / 2] >> 4);
+
+    for(b = 5; b >= 0; b--, nBits++) {
+      if(aNibbleCodes[cNibble] & (1 << b)) {
+        pcChips[nBits / 8] |= 0x80 >> (nBits % 8);
+      }
+    }
+  }
+  if(nBits % 8) {
+    pcChips[nBits / 8] |= 0x05;
+  }
+  return (uint16_t)((nBits + 7) / 8);
+}
+
+static uint8_t hex_parse(const char* pcHex, uint8_t* pcOut)
+{
+  uint8_t n = 0;
+
+  while(pcHex[0] && pcHex[1]) {
+    unsigned int x;
+
+    sscanf(pcHex, "%2x", &x);
+    pcOut[n++] = (uint8_t)x;
+    pcHex += 2;
+  }
+  return n;
+}
+
+/* Build, code, decode and parse a telegram; check the data read block by block */
+static void bench_roundtrip(const uint8_t* pcTelegram, uint16_t nLength, WMbusFrameFormat xFormat, const char* pcName)
+{
+  WMbusFrame xFrame;
+  const uint8_t* pcBlock;
+  uint16_t nFrameLength, nChips, nData;
+  uint8_t cIndex, cBlockLen;
+  int32_t lDecoded;
+
+  nFrameLength = S2LP_WMBUS_BuildFrame(pcTelegram, nLength, xFormat, aFrame);
+  if(nFrameLength == 0 || nFrameLength != S2LP_WMBUS_FrameLength(aFrame[0], xFormat)) {
+    bench_fail("frame length", pcName);
+    return;
+  }
+
+  nChips = S2LP_WMBUS_Encode3of6(aFrame, nFrameLength, aChips);
+  if(nChips != ref_encode(aFrame, nFrameLength, aRefChips) || memcmp(aChips, aRefChips, nChips)) {
+    bench_fail("3of6 chips differ from the reference", pcName);
+  }
+  lDecoded = S2LP_WMBUS_Decode3of6(aChips, nChips, aDecoded);
+  if(lDecoded != nFrameLength || memcmp(aDecoded, aFrame, nFrameLength)) {
+    bench_fail("3of6 decoding", pcName);
+    return;
+  }
+
+  if(S2LP_WMBUS_ParseFrame(aDecoded, (uint16_t)lDecoded, xFormat, &xFrame) != WMBUS_OK) {
+    bench_fail("parse", pcName);
+    return;
+  }
+  if(xFrame.cC != pcTelegram[1] || xFrame.cDevType != pcTelegram[9] ||
+     xFrame.nManufacturer != (pcTelegram[2] | (pcTelegram[3] << 8))) {
+    bench_fail("header fields", pcName);
+  }
+  if(nLength > WMBUS_BLOCK1_LEN && xFrame.cCI != pcTelegram[WMBUS_BLOCK1_LEN]) {
+    bench_fail("CI field", pcName);
+  }
+
+  /* The data segments, put back together, are the telegram after the CI field */
+  nData = 0;
+  for(cIndex = 0; (cBlockLen = S2LP_WMBUS_GetDataBlock(&xFrame, cIndex, &pcBlock)) != 0; cIndex++) {
+    if(nData + cBlockLen > nLength || memcmp(pcBlock, &pcTelegram[WMBUS_BLOCK1_LEN + 1 + nData], cBlockLen)) {
+      bench_fail("data blocks", pcName);
+      return;
+    }
+    nData += cBlockLen;
+  }
+  if(nData != xFrame.cDataLen || (nLength > WMBUS_BLOCK1_LEN && nData != nLength - WMBUS_BLOCK1_LEN - 1)) {
+    bench_fail("data length", pcName);
+  }
+
+  /* Any chip flipped breaks its code, any byte changed its block CRC */
+  aChips[nChips / 2] ^= 0x10;
+  if(S2LP_WMBUS_Decode3of6(aChips, nChips, aDecoded) != -1) {
+    bench_fail("invalid 3of6 code accepted", pcName);
+  }
+  memcpy(aDecoded, aFrame, nFrameLength);
+  aDecoded[nFrameLength - 3] ^= 0x01;
+  if(S2LP_WMBUS_ParseFrame(aDecoded, nFrameLength, xFormat, &xFrame) != WMBUS_ERR_CRC) {
+    bench_fail("CRC error accepted", pcName);
+  }
+  if(S2LP_WMBUS_ParseFrame(aFrame, nFrameLength - 1, xFormat, &xFrame) != WMBUS_ERR_LENGTH) {
+    bench_fail("truncated frame accepted", pcName);
+  }
+}
+
+static void bench_checks(void)
+{
+  static const uint8_t aCheck[] = "123456789";
+  uint8_t aRandom[256];
+  uint16_t i, n;
+  uint16_t nL;
+
+  if(S2LP_WMBUS_Crc(aCheck, 9) != 0xC2B7) {
+    bench_fail("CRC check value", "crc");
+  }
+
+  for(i = 0; i < BENCH_TELEGRAMS; i++) {
+    bench_roundtrip(aTelegram[i], aTelegramLen[i], aTelegrams[i].xFormat, aTelegrams[i].pcName);
+  }
+
+  srand(1);
+  for(i = 0; i < BENCH_RANDOM_FRAMES; i++) {
+    WMbusFrameFormat xFormat = (i & 1) ? WMBUS_FRAME_B : WMBUS_FRAME_A;
+    uint16_t nMax = (xFormat == WMBUS_FRAME_B) ? 252 : 256;
+
+    n = WMBUS_BLOCK1_LEN + rand() % (nMax - WMBUS_BLOCK1_LEN + 1);
+    for(nL = 0; nL < n; nL++) {
+      aRandom[nL] = (uint8_t)rand();
+    }
+    if(S2LP_WMBUS_Crc(aRandom, n) != ref_crc(aRandom, n)) {
+      bench_fail("CRC differs from the reference", "random");
+    }
+    bench_roundtrip(aRandom, n, xFormat, "random");
+  }
+
+  /* L fields the frame formats cannot have */
+  if(S2LP_WMBUS_FrameLength(8, WMBUS_FRAME_A) != 0 || S2LP_WMBUS_FrameLength(10, WMBUS_FRAME_B) != 0 ||
+     S2LP_WMBUS_FrameLength(128, WMBUS_FRAME_B) != 0 || S2LP_WMBUS_FrameLength(129, WMBUS_FRAME_B) != 0) {
+    bench_fail("L field out of range accepted", "length");
+  }
+  if(S2LP_WMBUS_FrameLength(255, WMBUS_FRAME_A) > WMBUS_FRAME_MAX_LEN) {
+    bench_fail("longest frame", "length");
+  }
+}
+
+static void bench_throughput(void)
+{
+  static uint8_t aFrames[BENCH_TELEGRAMS][WMBUS_FRAME_MAX_LEN];
+  static uint8_t aCoded[BENCH_TELEGRAMS][sizeof(aChips)];
+  uint16_t aFrameLen[BENCH_TELEGRAMS], aCodedLen[BENCH_TELEGRAMS];
+  WMbusFrame xFrame;
+  double t0, tEncode, tDecode, tParse;
+  unsigned long lBytes = 0, lOk = 0;
+  uint32_t i, k;
+
+  for(k = 0; k < BENCH_TELEGRAMS; k++) {
+    aFrameLen[k] = S2LP_WMBUS_BuildFrame(aTelegram[k], aTelegramLen[k], aTelegrams[k].xFormat, aFrames[k]);
+    lBytes += aFrameLen[k];
+  }
+  lBytes *= BENCH_ROUNDS;
+
+  t0 = bench_now_s();
+  for(i = 0; i < BENCH_ROUNDS; i++) {
+    for(k = 0; k < BENCH_TELEGRAMS; k++) {
+      aCodedLen[k] = S2LP_WMBUS_Encode3of6(aFrames[k], aFrameLen[k], aCoded[k]);
+    }
+  }
+  tEncode = bench_now_s() - t0;
+
+  t0 = bench_now_s();
+  for(i = 0; i < BENCH_ROUNDS; i++) {
+    for(k = 0; k < BENCH_TELEGRAMS; k++) {
+      lOk += S2LP_WMBUS_Decode3of6(aCoded[k], aCodedLen[k], aDecoded) == aFrameLen[k];
+    }
+  }
+  tDecode = bench_now_s() - t0;
+
+  t0 = bench_now_s();
+  for(i = 0; i < BENCH_ROUNDS; i++) {
+    for(k = 0; k < BENCH_TELEGRAMS; k++) {
+      lOk += S2LP_WMBUS_ParseFrame(aFrames[k], aFrameLen[k], aTelegrams[k].xFormat, &xFrame) == WMBUS_OK;
+    }
+  }
+  tParse = bench_now_s() - t0;
+
+  if(lOk != 2UL * BENCH_ROUNDS * BENCH_TELEGRAMS) {
+    bench_fail("throughput run", "bench");
+  }
+
+  printf("%-12s %12s %10s\n", "op", "telegrams/s", "MB/s");
+  printf("%-12s %12.0f %10.1f\n", "encode3of6", BENCH_ROUNDS * BENCH_TELEGRAMS / tEncode, lBytes / tEncode / 1e6);
+  printf("%-12s %12.0f %10.1f\n", "decode3of6", BENCH_ROUNDS * BENCH_TELEGRAMS / tDecode, lBytes / tDecode / 1e6);
+  printf("%-12s %12.0f %10.1f\n", "parse+crc", BENCH_ROUNDS * BENCH_TELEGRAMS / tParse, lBytes / tParse / 1e6);
+}
+
+int main(void)
+{
+  uint32_t k;
+
+  for(k = 0; k < BENCH_TELEGRAMS; k++) {
+    if(aTelegrams[k].pcHex != NULL) {
+      aTelegramLen[k] = hex_parse(aTelegrams[k].pcHex, aTelegram[k]);
+    }
+    else {
+      /* The telegram before, padded with idle filler up to 3 blocks */
+      memcpy(aTelegram[k], aTelegram[k - 1], aTelegramLen[k - 1]);
+      memset(&aTelegram[k][aTelegramLen[k - 1]], 0x2F, 200 - aTelegramLen[k - 1]);
+      aTelegramLen[k] = 200;
+    }
+  }
+
+  bench_checks();
+  bench_throughput();
+
+  if(nFailures) {
+    printf("%d check(s) failed\n", nFailures);
+    return 1;
+  }
+  printf("codec checks passed\n");
+  return 0;
+}